@@ -11,3 +11,4 @@
 
 for %%f in (shaders\*.vert) do %VULKAN_SDK%/Bin/glslc.exe %%f -o SPRV/%%~nfvert.spv
 for %%v in (shaders\*.frag) do %VULKAN_SDK%/Bin/glslc.exe %%v -o SPRV/%%~nvfrag.spv
+for %%c in (shaders\*.comp) do %VULKAN_SDK%/Bin/glslc.exe %%c -o SPRV/%%~nccomp.spv
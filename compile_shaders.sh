@@ -24,4 +24,10 @@ do
 	echo ../$dir/${v%.*}frag.spv
 done
 
+for c in *.comp
+do
+	glslc $c -o ../$dir/${c%.*}comp.spv
+	echo ../$dir/${c%.*}comp.spv
+done
+
 cd ..
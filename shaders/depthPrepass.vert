@@ -0,0 +1,25 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+    mat4 view;
+    mat4 proj;
+    vec3 viewPosition;
+
+    int global_size;
+    int point_size;
+    int spot_size;
+} ubo;
+
+//per instance data
+layout(location = 4) in mat4 instanceModel;
+
+layout(location = 0) in vec3 inPosition;
+
+// Has to match shaderLight.vert bit for bit, color pass tests depth for equality
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = ubo.proj * ubo.view * instanceModel * vec4(inPosition, 1.0);
+}
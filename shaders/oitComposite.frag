@@ -0,0 +1,19 @@
+#version 450
+
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput inAccum;
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput inRevealage;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    float revealage = subpassLoad(inRevealage).r;
+    // Nothing transparent covers the pixel
+    if (revealage >= 1.0)
+    {
+        discard;
+    }
+    vec4 accum = subpassLoad(inAccum);
+    // Blended as src alpha, so opaque color is kept by revealage
+    outColor = vec4(accum.rgb / max(accum.a, 1e-5), 1.0 - revealage);
+}
@@ -0,0 +1,30 @@
+#version 450
+
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInputMS inAccum;
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInputMS inRevealage;
+
+layout(push_constant) uniform CompositeConstant
+{
+    int sampleCount;
+} composite;
+
+layout(location = 0) out vec4 outColor;
+
+// Same as oitComposite.frag, samples are averaged to shade once per pixel
+void main()
+{
+    vec4 accum = vec4(0.0);
+    float revealage = 0.0;
+    for (int i = 0; i < composite.sampleCount; i++)
+    {
+        accum += subpassLoad(inAccum, i);
+        revealage += subpassLoad(inRevealage, i).r;
+    }
+    accum /= float(composite.sampleCount);
+    revealage /= float(composite.sampleCount);
+    if (revealage >= 1.0)
+    {
+        discard;
+    }
+    outColor = vec4(accum.rgb / max(accum.a, 1e-5), 1.0 - revealage);
+}
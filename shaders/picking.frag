@@ -0,0 +1,20 @@
+#version 450
+
+//push constants block
+layout( push_constant ) uniform constants
+{
+    mat4 model;
+
+    vec4 pushAmbient;
+    vec4 pushDiffusive;
+    vec4 pushSpecular;
+
+    int id;
+} pushModel;
+
+layout(location = 0) out int outId;
+
+void main()
+{
+    outId = pushModel.id;
+}
@@ -0,0 +1,27 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+    mat4 view;
+    mat4 proj;
+    vec3 viewPosition;
+} ubo;
+
+//push constants block
+layout( push_constant ) uniform constants
+{
+    mat4 model;
+
+    vec4 pushAmbient;
+    vec4 pushDiffusive;
+    vec4 pushSpecular;
+
+    int id;
+} pushModel;
+
+layout(location = 0) in vec3 inPosition;
+
+void main()
+{
+    gl_Position = ubo.proj * ubo.view * pushModel.model * vec4(inPosition, 1.0);
+}
@@ -1,8 +1,10 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uvec4 inTextures;
 
 layout(set = 0, binding = 1) uniform LightBufferObject
 {
@@ -15,27 +17,12 @@ layout(set = 0, binding = 1) uniform LightBufferObject
     float spec_str;
 } light;
 
-//push constants block
-layout( push_constant ) uniform constants
-{
-    mat4 model;
-
-    vec4 pushAmbient;
-    vec4 pushDiffusive;
-    vec4 pushSpecular;
-
-    int id;
-} pushModel;
-
-layout(set = 1, binding = 0) uniform sampler2D texSampler;
-layout(set = 1, binding = 1) uniform sampler2D diffMap;
-layout(set = 1, binding = 2) uniform sampler2D specMap;
+// Bindless array, instance data holds slots of texture, diffuse and specular maps
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
 layout(location = 0) out vec4 outColor;
-layout(location = 1) out int outId;
 
 void main()
 {
-    outColor = texture(texSampler, fragTexCoord) * vec4(fragColor, 1.0f);
-    outId = pushModel.id;
+    outColor = texture(textures[nonuniformEXT(inTextures.x)], fragTexCoord) * vec4(fragColor, 1.0f);
 }
\ No newline at end of file
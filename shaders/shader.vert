@@ -7,17 +7,13 @@ layout(set = 0, binding = 0) uniform UniformBufferObject
     vec3 viewPosition;
 } ubo;
 
-//push constants block
-layout( push_constant ) uniform constants
-{
-    mat4 model;
-
-    vec4 pushAmbient;
-    vec4 pushDiffusive;
-    vec4 pushSpecular;
-
-    int id;
-} pushModel;
+//per instance data
+layout(location = 4) in mat4 instanceModel;
+layout(location = 8) in vec4 instanceAmbient;
+layout(location = 9) in vec4 instanceDiffusive;
+layout(location = 10) in vec4 instanceSpecular;
+layout(location = 11) in int instanceId;
+layout(location = 12) in uvec4 instanceTextures;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -26,10 +22,12 @@ layout(location = 3) in vec3 inNormal;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uvec4 outTextures;
 
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * pushModel.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * instanceModel * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+    outTextures = instanceTextures;
 }
\ No newline at end of file
@@ -1,11 +1,16 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 layout(location = 2) in vec3 outNormal;
 layout(location = 3) in vec3 outPosition;
 layout(location = 4) in vec3 outViewPosition;
+layout(location = 5) flat in vec4 inAmbient;
+layout(location = 6) flat in vec4 inDiffusive;
+layout(location = 7) flat in vec4 inSpecular;
+layout(location = 8) flat in uvec4 inTextures;
 
 struct LightBufferObject
 {
@@ -80,52 +85,72 @@ layout(set = 0, binding = 3) readonly buffer SpotLightProxy
     SpotLightBuffer[] object;
 } spot_light;
 
-layout(set = 1, binding = 0) uniform sampler2D texSampler;
-layout(set = 1, binding = 1) uniform sampler2D diffMap;
-layout(set = 1, binding = 2) uniform sampler2D specMap;
-
-//push constants block
-layout( push_constant ) uniform constants
+// Lights binned into a froxel grid on cpu, grid size matches omp::LightClusters
+layout(set = 0, binding = 4) readonly buffer LightClusters
 {
-    mat4 model;
-
-    vec4 pushAmbient;
-    vec4 pushDiffusive;
-    vec4 pushSpecular;
-
-    int id;
-} pushModel;
+    uvec4 grid;
+    // near, far, scale and bias of the slice from log of view depth
+    vec4 depthParams;
+    vec4 screenSize;
+    // offset, point count, spot count, unused
+    uvec4 ranges[16 * 9 * 24];
+    // point lights of the cluster go first, spot lights after them
+    uint indices[];
+} clusters;
+
+// Bindless array, instance data holds slots of texture, diffuse and specular maps
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// Sampled once in main, shared by every light
+vec3 texColor;
+vec3 diffColor;
+vec3 specColor;
 
 layout(location = 0) out vec4 outColor;
-layout(location = 1) out int outId;
 
 vec3 calcDirLight(LightBufferObject light, vec3 normal, vec3 viewDir);
 vec3 calcPointLight(PointLightBuffer light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 calcSpotLight(SpotLightBuffer light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
+uint findCluster()
+{
+    float viewDepth = -(ubo.view * vec4(outPosition, 1.0)).z;
+    uint slice = uint(max(log(viewDepth) * clusters.depthParams.z + clusters.depthParams.w, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / clusters.screenSize.xy * vec2(clusters.grid.xy));
+    tile = min(tile, clusters.grid.xy - 1);
+    slice = min(slice, clusters.grid.z - 1);
+    return tile.x + clusters.grid.x * (tile.y + clusters.grid.y * slice);
+}
+
 void main()
 {
     vec3 norm = normalize(outNormal);
     vec3 viewDir = normalize(outViewPosition - outPosition);
 
-    vec3 result = vec3(texture(texSampler, fragTexCoord));
+    texColor = texture(textures[nonuniformEXT(inTextures.x)], fragTexCoord).xyz;
+    diffColor = texture(textures[nonuniformEXT(inTextures.y)], fragTexCoord).xyz;
+    specColor = texture(textures[nonuniformEXT(inTextures.z)], fragTexCoord).xyz;
+
+    vec3 result = texColor;
 
     if (bool(ubo.global_size))
     {
         result = calcDirLight(light_global.object, norm, viewDir);
     }
-    for (int i = 0; i < ubo.point_size; i++)
+    uvec4 range = clusters.ranges[findCluster()];
+    for (uint i = 0; i < range.y; i++)
     {
-        result += calcPointLight(point_light.object[i], norm, outPosition, viewDir);
+        uint light = clusters.indices[range.x + i];
+        result += calcPointLight(point_light.object[light], norm, outPosition, viewDir);
     }
-    for (int i = 0; i < ubo.spot_size; i++)
+    for (uint i = 0; i < range.z; i++)
     {
-        result += calcSpotLight(spot_light.object[i], norm, outPosition, viewDir);
+        uint light = clusters.indices[range.x + range.y + i];
+        result += calcSpotLight(spot_light.object[light], norm, outPosition, viewDir);
     }
 
     //result *= fragColor;
     outColor = vec4(result, 1.0f);
-    outId = pushModel.id;
 }
 
 vec3 calcDirLight(LightBufferObject light, vec3 normal, vec3 viewDir)
@@ -135,9 +160,9 @@ vec3 calcDirLight(LightBufferObject light, vec3 normal, vec3 viewDir)
     vec3 reflectDir = reflect(-LightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 64.0);
 
-    vec3 ambient = light.ambient * pushModel.pushAmbient.xyz * vec3(texture(texSampler, fragTexCoord));
-    vec3 diffuse = light.diffusive * diff * pushModel.pushDiffusive.xyz * vec3(texture(diffMap, fragTexCoord));
-    vec3 specular = light.specular * spec * pushModel.pushSpecular.xyz * vec3(texture(specMap, fragTexCoord));
+    vec3 ambient = light.ambient * inAmbient.xyz * texColor;
+    vec3 diffuse = light.diffusive * diff * inDiffusive.xyz * diffColor;
+    vec3 specular = light.specular * spec * inSpecular.xyz * specColor;
 
     return ambient + diffuse + specular;
 }
@@ -152,9 +177,9 @@ vec3 calcPointLight(PointLightBuffer light, vec3 normal, vec3 fragPos, vec3 view
     float distance = length(light.position - fragPos);
     float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
-    vec3 ambient = light.ambient * pushModel.pushAmbient.xyz * vec3(texture(texSampler, fragTexCoord));
-    vec3 diffuse = light.diffusive * diff * pushModel.pushDiffusive.xyz * vec3(texture(diffMap, fragTexCoord));
-    vec3 specular = light.specular * spec * pushModel.pushSpecular.xyz * vec3(texture(specMap, fragTexCoord));
+    vec3 ambient = light.ambient * inAmbient.xyz * texColor;
+    vec3 diffuse = light.diffusive * diff * inDiffusive.xyz * diffColor;
+    vec3 specular = light.specular * spec * inSpecular.xyz * specColor;
 
     ambient *= attenuation;
     diffuse *= attenuation;
@@ -177,9 +202,9 @@ vec3 calcSpotLight(SpotLightBuffer light, vec3 normal, vec3 fragPos, vec3 viewDi
     float epsilon = light.cut_off - light.outer_cutoff;
     float intensity = clamp((theta - light.outer_cutoff) / epsilon, 0.0, 1.0);
 
-    vec3 ambient = light.ambient * pushModel.pushAmbient.xyz * vec3(texture(texSampler, fragTexCoord));
-    vec3 diffuse = light.diffusive * diff * pushModel.pushDiffusive.xyz * vec3(texture(diffMap, fragTexCoord));
-    vec3 specular = light.specular * spec * pushModel.pushSpecular.xyz * vec3(texture(specMap, fragTexCoord));
+    vec3 ambient = light.ambient * inAmbient.xyz * texColor;
+    vec3 diffuse = light.diffusive * diff * inDiffusive.xyz * diffColor;
+    vec3 specular = light.specular * spec * inSpecular.xyz * specColor;
 
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
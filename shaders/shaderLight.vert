@@ -11,17 +11,13 @@ layout(set = 0, binding = 0) uniform UniformBufferObject
     int spot_size;
 } ubo;
 
-//push constants block
-layout( push_constant ) uniform constants
-{
-    mat4 model;
-
-    vec4 pushAmbient;
-    vec4 pushDiffusive;
-    vec4 pushSpecular;
-
-    int id;
-} pushModel;
+//per instance data
+layout(location = 4) in mat4 instanceModel;
+layout(location = 8) in vec4 instanceAmbient;
+layout(location = 9) in vec4 instanceDiffusive;
+layout(location = 10) in vec4 instanceSpecular;
+layout(location = 11) in int instanceId;
+layout(location = 12) in uvec4 instanceTextures;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -33,13 +29,24 @@ layout(location = 1) out vec2 fragTexCoord;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec3 outPosition;
 layout(location = 4) out vec3 outViewPosition;
+layout(location = 5) flat out vec4 outAmbient;
+layout(location = 6) flat out vec4 outDiffusive;
+layout(location = 7) flat out vec4 outSpecular;
+layout(location = 8) flat out uvec4 outTextures;
+
+// Depth pre-pass computes the same position, see depthPrepass.vert
+invariant gl_Position;
 
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * pushModel.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * instanceModel * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
     outNormal = inNormal;
-    outPosition = vec3(pushModel.model * vec4(inPosition, 1.0));
+    outPosition = vec3(instanceModel * vec4(inPosition, 1.0));
     outViewPosition = ubo.viewPosition;
-}
\ No newline at end of file
+    outAmbient = instanceAmbient;
+    outDiffusive = instanceDiffusive;
+    outSpecular = instanceSpecular;
+    outTextures = instanceTextures;
+}
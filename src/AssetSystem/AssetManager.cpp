@@ -5,6 +5,7 @@
 #include <future>
 #include "Rendering/TextureSrc.h"
 #include "Core/CoreLib.h"
+#include "Core/Profiler.h"
 #include "Rendering/Shader.h"
 #include "Scene.h"
 #include "Rendering/Model.h"
@@ -36,6 +37,7 @@ std::future<bool> omp::AssetManager::loadProject(const std::string& inPath)
 {
     return m_ThreadPool->submit([this, inPath]() -> bool
     {
+        PROFILE_SCOPE("Load project");
         loadAssetsFromDrive(inPath);
         return true;
     });
@@ -45,6 +47,7 @@ std::future<bool> omp::AssetManager::saveProject()
 {
     return m_ThreadPool->submit([this]() -> bool
     {
+        PROFILE_SCOPE("Save project");
         saveAssetsToDrive();
         return true;
     });
@@ -52,6 +55,7 @@ std::future<bool> omp::AssetManager::saveProject()
 
 void omp::AssetManager::saveAsset(AssetHandle assetHandle)
 {
+    PROFILE_SCOPE("Save asset");
     std::shared_ptr<omp::Asset> found_asset = m_AssetRegistry.value_for(assetHandle, nullptr);
     if (found_asset)
     {
@@ -163,6 +167,7 @@ void omp::AssetManager::loadAssetsFromDrive(const std::string& path)
 
 void omp::AssetManager::loadAsset_internal(const std::string& inPath)
 {
+    PROFILE_SCOPE("Load asset metadata");
     JsonParser<> file_data{};
     if (file_data.populateFromFile(inPath))
     {
@@ -189,6 +194,7 @@ std::future<std::weak_ptr<omp::Asset>> omp::AssetManager::loadAssetAsync(AssetHa
     {
         result = m_ThreadPool->submit([found_asset, this, assetHandle]()
         {
+            PROFILE_SCOPE("Load asset");
             auto metadata = found_asset->getMetaData();
             for (auto dependency_id : metadata.dependencies)
             {
@@ -220,6 +226,7 @@ std::future<bool> omp::AssetManager::loadAllAssets()
 {
     return m_ThreadPool->submit([this]() -> bool
     {
+        PROFILE_SCOPE("Load all assets");
         m_AssetRegistry.foreach([this](std::pair<AssetHandle, std::shared_ptr<omp::Asset>>& asset)
         {
             asset.second->loadAsset(m_Factory);
@@ -230,6 +237,7 @@ std::future<bool> omp::AssetManager::loadAllAssets()
 
 std::weak_ptr<omp::Asset> omp::AssetManager::loadAsset(AssetHandle assetHandle)
 {
+    PROFILE_SCOPE("Load asset");
     std::shared_ptr<Asset> found_asset = m_AssetRegistry.value_for(assetHandle, nullptr);
     std::weak_ptr<Asset> result;
     if (found_asset)
@@ -5,6 +5,7 @@
 #include <deque>
 #include <future>
 #include "threadsafe_queue.h"
+#include "Core/Profiler.h"
 
 namespace omp
 {
@@ -284,6 +285,7 @@ namespace omp
         {
             s_Index = inIndex;
             s_LocalQueue = m_Queues[s_Index].get();
+            omp::Profiler::getProfiler().setThreadName("Worker " + std::to_string(inIndex));
             while (!m_Done)
             {
                 runPendingTask();
@@ -381,6 +383,8 @@ namespace omp
             return result;
         }
 
+        size_t getThreadCount() const { return m_Threads.size(); }
+
         void runPendingTask()
         {
             TaskType task;
@@ -388,6 +392,7 @@ namespace omp
                 || popTaskFromPoolQueue(task)
                 || popTaskFromOtherThread(task))
             {
+                PROFILE_SCOPE("Task");
                 task();
             }
             else
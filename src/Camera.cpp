@@ -180,3 +180,12 @@ void omp::Camera::applyInputs(float deltaTime)
 
     m_InputData.reset();
 }
+
+void omp::Camera::lookAt(const glm::vec3& inPosition, const glm::vec3& inTarget)
+{
+    m_Position = inPosition;
+    const glm::vec3 front = glm::normalize(inTarget - inPosition);
+    m_Yaw = glm::degrees(std::atan2(front.z, front.x));
+    m_Pitch = glm::clamp(glm::degrees(std::asin(front.y)), -89.f, 89.f);
+    updateCameraVectors();
+}
@@ -66,6 +66,8 @@ namespace omp
         [[maybe_unused]] void processMouseScroll(float yOffset);
 
         void applyInputs(float deltaTime);
+        // Yaw and pitch are set from the direction, roll stays zero
+        void lookAt(const glm::vec3& inPosition, const glm::vec3& inTarget);
 
         float getViewAngle() const { return m_ViewAngle; }
 
@@ -0,0 +1,260 @@
+#include "AppFlags.h"
+#include <bit>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    uint64_t parseNumber(const std::string& name, const std::string& value, uint64_t max)
+    {
+        // stoull accepts leading spaces and signs, flags only take plain digits
+        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+        {
+            throw std::invalid_argument("Flag --" + name + " expects a number, got '" + value + "'");
+        }
+        uint64_t number = 0;
+        try
+        {
+            number = std::stoull(value);
+        }
+        catch (const std::out_of_range&)
+        {
+            number = max + 1;
+        }
+        if (number > max)
+        {
+            throw std::invalid_argument("Flag --" + name + " is out of range, got '" + value + "'");
+        }
+        return number;
+    }
+
+    bool parseSwitch(const std::string& name, const std::string& value)
+    {
+        if (value.empty() || value == "on" || value == "1" || value == "true")
+        {
+            return true;
+        }
+        if (value == "off" || value == "0" || value == "false")
+        {
+            return false;
+        }
+        throw std::invalid_argument("Flag --" + name + " expects on or off, got '" + value + "'");
+    }
+
+    VkPresentModeKHR parsePresentMode(const std::string& value)
+    {
+        if (value == "fifo")
+        {
+            return VK_PRESENT_MODE_FIFO_KHR;
+        }
+        if (value == "fifo-relaxed")
+        {
+            return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        }
+        if (value == "mailbox")
+        {
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        }
+        if (value == "immediate")
+        {
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        }
+        throw std::invalid_argument("Flag --present expects fifo, fifo-relaxed, mailbox or immediate, got '" +
+                                    value + "'");
+    }
+
+    omp::PresentPolicy parsePresentPolicy(const std::string& value)
+    {
+        if (value == "vsync")
+        {
+            return omp::PresentPolicy::VSync;
+        }
+        if (value == "low-latency")
+        {
+            return omp::PresentPolicy::LowLatency;
+        }
+        if (value == "uncapped")
+        {
+            return omp::PresentPolicy::Uncapped;
+        }
+        throw std::invalid_argument("Flag --present-policy expects vsync, low-latency or uncapped, got '" +
+                                    value + "'");
+    }
+
+    std::string requireValue(const std::string& name, const std::string& value)
+    {
+        if (value.empty())
+        {
+            throw std::invalid_argument("Flag --" + name + " expects a value");
+        }
+        return value;
+    }
+}
+
+std::unordered_map<std::string, std::string> omp::AppFlags::split(const std::string& commands)
+{
+    std::unordered_map<std::string, std::string> flags;
+    std::istringstream stream(commands);
+    std::string token;
+    while (stream >> token)
+    {
+        if (!token.starts_with("--") || token.size() == 2)
+        {
+            continue;
+        }
+        const size_t separator = token.find('=');
+        if (separator == std::string::npos)
+        {
+            flags[token.substr(2)] = "";
+        }
+        else
+        {
+            flags[token.substr(2, separator - 2)] = token.substr(separator + 1);
+        }
+    }
+    return flags;
+}
+
+omp::AppFlags omp::AppFlags::parse(const std::unordered_map<std::string, std::string>& flags)
+{
+    AppFlags parsed;
+    for (const auto& [name, value]: flags)
+    {
+        if (name == "width" || name == "height")
+        {
+            const auto size = static_cast<uint32_t>(parseNumber(name, value, 16384));
+            if (size == 0)
+            {
+                throw std::invalid_argument("Flag --" + name + " can not be zero");
+            }
+            (name == "width" ? parsed.width : parsed.height) = size;
+        }
+        else if (name == "threads")
+        {
+            parsed.thread_count = static_cast<int>(parseNumber(name, value, 256));
+        }
+        else if (name == "frame-limit")
+        {
+            parsed.frame_limit = static_cast<int>(parseNumber(name, value, 10000));
+        }
+        else if (name == "wait-before-input")
+        {
+            parsed.wait_before_input = parseSwitch(name, value);
+        }
+        else if (name == "present-policy")
+        {
+            parsed.present.policy = parsePresentPolicy(value);
+        }
+        else if (name == "present")
+        {
+            parsed.present.mode = parsePresentMode(value);
+        }
+        else if (name == "swapchain-images")
+        {
+            const auto count = static_cast<uint32_t>(parseNumber(name, value, 16));
+            if (count == 0)
+            {
+                throw std::invalid_argument("Flag --swapchain-images can not be zero");
+            }
+            parsed.present.image_count = count;
+        }
+        else if (name == "frames-in-flight")
+        {
+            const auto count = static_cast<uint32_t>(parseNumber(name, value, 2));
+            if (count == 0)
+            {
+                throw std::invalid_argument("Flag --frames-in-flight can not be zero");
+            }
+            parsed.frames_in_flight = count;
+        }
+        else if (name == "msaa")
+        {
+            const uint64_t samples = parseNumber(name, value, 64);
+            if (!std::has_single_bit(samples))
+            {
+                throw std::invalid_argument("Flag --msaa expects a power of two, got '" + value + "'");
+            }
+            parsed.msaa_samples = static_cast<VkSampleCountFlagBits>(samples);
+        }
+        else if (name == "validation")
+        {
+            parsed.validation = parseSwitch(name, value);
+        }
+        else if (name == "headless")
+        {
+            parsed.headless = parseSwitch(name, value);
+        }
+        else if (name == "scene")
+        {
+            parsed.scene_path = requireValue(name, value);
+        }
+        else if (name == "frames")
+        {
+            parsed.frame_count = parseNumber(name, value, UINT64_MAX - 1);
+        }
+        else if (name == "stats")
+        {
+            parsed.stats_path = requireValue(name, value);
+        }
+        else if (name == "profiler")
+        {
+            parsed.profiler = parseSwitch(name, value);
+        }
+        else if (name == "trace")
+        {
+            parsed.trace_path = requireValue(name, value);
+        }
+        else if (name == "trace-frames")
+        {
+            parsed.trace_frames = parseNumber(name, value, 100000);
+            if (parsed.trace_frames == 0)
+            {
+                throw std::invalid_argument("Flag --trace-frames can not be zero");
+            }
+        }
+        else if (name == "generate")
+        {
+            parsed.generate_scene = parseSwitch(name, value);
+        }
+        else if (name == "seed")
+        {
+            parsed.generator.seed = static_cast<uint32_t>(parseNumber(name, value, UINT32_MAX));
+        }
+        else if (name == "entities")
+        {
+            parsed.generator.entities = static_cast<uint32_t>(parseNumber(name, value, 1000000));
+        }
+        else if (name == "models" || name == "materials")
+        {
+            const auto count = static_cast<uint32_t>(parseNumber(name, value, 4096));
+            if (count == 0)
+            {
+                throw std::invalid_argument("Flag --" + name + " can not be zero");
+            }
+            (name == "models" ? parsed.generator.models : parsed.generator.materials) = count;
+        }
+        else if (name == "point-lights" || name == "spot-lights")
+        {
+            // Limit of the light system per type
+            const auto count = static_cast<uint32_t>(parseNumber(name, value, 512));
+            (name == "point-lights" ? parsed.generator.point_lights : parsed.generator.spot_lights) = count;
+        }
+        else if (name == "camera-path")
+        {
+            parsed.camera_path = parseSwitch(name, value);
+        }
+        else if (name == "bench")
+        {
+            parsed.bench_path = requireValue(name, value);
+        }
+        else if (name == "warmup")
+        {
+            parsed.warmup_frames = parseNumber(name, value, UINT64_MAX - 1);
+        }
+        else
+        {
+            parsed.unknown.push_back(name);
+        }
+    }
+    return parsed;
+}
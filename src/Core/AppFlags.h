@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "Core/SceneGenerator.h"
+#include "Rendering/PresentPolicy.h"
+
+namespace omp
+{
+    /**
+     * Runtime configuration of the application from the command line.
+     * Flags are space separated --name=value, flags without value are switches.
+     * Absent flags keep defaults, malformed values throw std::invalid_argument.
+     *
+     * --width=1280 --height=720   window or offscreen size
+     * --threads=5                 worker threads, 0 uses hardware concurrency
+     * --frame-limit=144           target fps, 0 is unlimited
+     * --wait-before-input         wait for the frame limit before input instead of after rendering
+     * --present-policy=low-latency vsync, low-latency or uncapped
+     * --present=mailbox           fifo, fifo-relaxed, mailbox or immediate, overrides mode of the policy
+     * --swapchain-images=3        swapchain image count, picked by the policy by default
+     * --frames-in-flight=2        frames the cpu may record ahead of the gpu, 1 or 2
+     * --msaa=4                    max sample count, highest supported one by default
+     * --validation=on             validation layers, on in debug builds by default
+     * --headless                  render offscreen without window and ui
+     * --scene=path                scene asset to load instead of the main one
+     * --frames=1000               exit after this many frames, 0 runs until closed
+     * --stats=path                csv with statistics of every frame
+     * --profiler                  record cpu scopes and gpu timings from the start
+     * --trace=path                chrome trace json of the first frames, turns the profiler on
+     * --trace-frames=300          frames written to the trace
+     * --generate                  generated benchmark scene instead of the scene asset
+     * --seed=1                    seed of the generated scene
+     * --entities=2000 --models=8 --materials=16 --point-lights=64 --spot-lights=16
+     *                             contents of the generated scene
+     * --camera-path               camera flies the benchmark path, one loop every --frames frames
+     * --bench=path                json with frame time percentiles and render statistics, written at exit
+     * --warmup=100                frames not counted by the benchmark
+     */
+    struct AppFlags
+    {
+        uint32_t width = 1280;
+        uint32_t height = 720;
+        int thread_count = 5;
+        int frame_limit = -1;
+        bool wait_before_input = false;
+        omp::PresentSettings present;
+        uint32_t frames_in_flight = 2;
+        std::optional<VkSampleCountFlagBits> msaa_samples;
+        std::optional<bool> validation;
+        bool headless = false;
+        std::string scene_path = "../assets/main_scene.json";
+        uint64_t frame_count = 0;
+        std::string stats_path;
+        bool profiler = false;
+        std::string trace_path;
+        uint64_t trace_frames = 300;
+        bool generate_scene = false;
+        omp::SceneGeneratorSettings generator;
+        bool camera_path = false;
+        std::string bench_path;
+        uint64_t warmup_frames = 100;
+
+        // Parsed names which are not known flags, left for the caller to report
+        std::vector<std::string> unknown;
+
+        // Name to value, switches have empty values, tokens not starting with -- are skipped
+        static std::unordered_map<std::string, std::string> split(const std::string& commands);
+        static AppFlags parse(const std::unordered_map<std::string, std::string>& flags);
+    };
+}
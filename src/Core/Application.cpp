@@ -1,34 +1,45 @@
 #include "Core/Application.h"
 #include <GLFW/glfw3.h>
-#include <chrono>
 #include <memory>
+#include "Core/SceneGenerator.h"
 
 void omp::Application::start()
 {
-    using namespace std::chrono;
-
     preInit();
     init();
 
-    float ms_limit = 1.f / m_FrameLimit;
-
-    time_point previous = steady_clock::now();
+    m_Pacer.setTargetFps(m_Config.frame_limit);
+    m_Pacer.setWaitBeforeInput(m_Config.wait_before_input);
     while (!m_RequestExit)
     {
-        time_point current_time = steady_clock::now();
-        float delta = static_cast<float>(duration_cast<milliseconds>(current_time - previous).count());
-        current_time = previous;
-
-        float delta_seconds = delta / 1000.f;
-        
-        tick(delta_seconds);
-
-        if (m_FrameLimit > 0)
+        const float delta = m_Pacer.beginFrame();
+        omp::Profiler::getProfiler().beginFrame();
+        writeTrace(false);
+        tick(delta);
+        writeFrameStats(delta * 1000.f);
+        if (!m_Config.bench_path.empty() && m_FrameIndex >= m_Config.warmup_frames)
         {
+            m_BenchReport.addFrame(delta * 1000.f, m_Renderer->getDrawStats().main_pass_ms,
+                                   m_Renderer->getRenderStats());
+        }
 
+        // Benchmark runs stop by themselves
+        m_FrameIndex++;
+        if (m_Config.frame_count > 0 && m_FrameIndex >= m_Config.frame_count)
+        {
+            requestExit();
         }
+
+        m_Pacer.endFrame();
     }
 
+    const omp::FramePacingStats stats = m_Pacer.getStats();
+    INFO(LogCore, "Last frames took {:.2f} ms, jitter {:.2f} ms, max {:.2f} ms", stats.frame_ms, stats.jitter_ms,
+         stats.max_frame_ms);
+    // Shorter runs still get what was captured
+    writeTrace(true);
+    writeBenchReport();
+
     preDestroy();
 }
 
@@ -44,9 +55,15 @@ omp::Application::Application(const std::string& flags)
 
 void omp::Application::preInit()
 {
-    if (m_ThreadCount > 0)
+    omp::Profiler::getProfiler().setThreadName("Main");
+    omp::Profiler::getProfiler().setEnabled(m_Config.profiler || !m_Config.trace_path.empty());
+    if (!m_Config.trace_path.empty())
+    {
+        omp::Profiler::getProfiler().startCapture(m_Config.trace_frames);
+    }
+    if (m_Config.thread_count > 0)
     {
-        m_ThreadPool = std::make_unique<omp::ThreadPool>(static_cast<unsigned int>(m_ThreadCount));
+        m_ThreadPool = std::make_unique<omp::ThreadPool>(static_cast<unsigned int>(m_Config.thread_count));
     }
     else
     {
@@ -59,15 +76,34 @@ void omp::Application::preInit()
     m_AssetManager = std::make_unique<omp::AssetManager>(m_ThreadPool.get(), m_Factory.get());
     std::future<bool> wait_assets = m_AssetManager->loadProject();
 
-    glfwInit();
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-    m_Window = glfwCreateWindow(m_Width, m_Height, "VulkanApplication", nullptr, nullptr);
-
-    glfwSetWindowUserPointer(m_Window, this);
-    glfwSetFramebufferSizeCallback(m_Window, windowResizeCallback);
-
     m_Renderer = std::make_unique<omp::Renderer>();
+    m_Renderer->setThreadPool(m_ThreadPool.get());
+    m_Renderer->setPresentSettings(m_Config.present);
+    m_Renderer->setFramesInFlight(m_Config.frames_in_flight);
+    if (m_Config.msaa_samples)
+    {
+        m_Renderer->setMaxMsaaSamples(m_Config.msaa_samples.value());
+    }
+    if (m_Config.validation)
+    {
+        m_Renderer->setValidationLayers(m_Config.validation.value());
+    }
+    if (m_Config.headless)
+    {
+        // Same scene and draws, only window, ui and presentation are missing
+        m_Renderer->setHeadless({m_Config.width, m_Config.height});
+    }
+    else
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+        m_Window = glfwCreateWindow(static_cast<int>(m_Config.width), static_cast<int>(m_Config.height),
+                                    "VulkanApplication", nullptr, nullptr);
+
+        glfwSetWindowUserPointer(m_Window, this);
+        glfwSetFramebufferSizeCallback(m_Window, windowResizeCallback);
+    }
     m_Renderer->initVulkan(m_Window);
 
     // TODO: maybe other stuff while assets loading
@@ -80,27 +116,72 @@ void omp::Application::init()
 {
     // debug_createSceneManually();
     //m_CurrentScene->setCurrentCamera(0);
-    m_CurrentScene = std::dynamic_pointer_cast<omp::Scene>(m_AssetManager->loadAsset("../assets/main_scene.json").lock());
+    omp::GeneratedScene generated;
+    if (m_Config.generate_scene)
+    {
+        generated = omp::generateScene(m_Config.generator);
+        createGeneratedScene(generated);
+    }
+    else
+    {
+        m_CurrentScene = std::dynamic_pointer_cast<omp::Scene>(
+                m_AssetManager->loadAsset(m_Config.scene_path).lock());
+        if (!m_CurrentScene)
+        {
+            throw std::runtime_error("Failed to load scene " + m_Config.scene_path);
+        }
+    }
     //
     // TODO: then load scene from asset manager
     m_Renderer->initResources(m_CurrentScene.get());
+    if (m_Config.generate_scene)
+    {
+        addGeneratedLights(generated);
+    }
+
+    if (!m_Config.stats_path.empty())
+    {
+        m_StatsFile.open(m_Config.stats_path);
+        if (!m_StatsFile.is_open())
+        {
+            throw std::runtime_error("Failed to open statistics file " + m_Config.stats_path);
+        }
+        m_StatsFile << "frame,frame_ms,main_pass_ms,draw_calls,indirect_draw_calls,indices,triangles,"
+                       "pipeline_binds,descriptor_set_binds,vertex_buffer_binds,index_buffer_binds,"
+                       "push_constant_bytes,visible_entities,culled_entities\n";
+    }
 }
 
 void omp::Application::preDestroy()
 {
     m_ThreadPool.reset();
 
-    glfwDestroyWindow(m_Window);
-    glfwTerminate();
+    if (!m_Config.headless)
+    {
+        glfwDestroyWindow(m_Window);
+        glfwTerminate();
+    }
 }
 
 void omp::Application::tick(float delta)
 {
-    glfwPollEvents();
-
-    // Renderer only when not minimized
-    int width, height;
-    glfwGetFramebufferSize(m_Window, &width, &height);
+    // Renderer only when not minimized, headless application has neither events nor window
+    int width = static_cast<int>(m_Config.width);
+    int height = static_cast<int>(m_Config.height);
+    if (!m_Config.headless)
+    {
+        PROFILE_SCOPE("Poll events");
+        glfwPollEvents();
+        glfwGetFramebufferSize(m_Window, &width, &height);
+    }
+    if (m_Config.camera_path && m_CurrentScene->getCurrentCamera())
+    {
+        // One loop over the whole run, runs without frame count loop every 1000 frames
+        const uint64_t path_frames = m_Config.frame_count > 0 ? m_Config.frame_count : 1000;
+        const omp::CameraPose pose = omp::getBenchmarkCameraPose(m_FrameIndex, path_frames,
+                                                                 m_Config.generator.extent);
+        m_CurrentScene->getCurrentCamera()->lookAt(pose.position, pose.target);
+    }
     if (width != 0 && height != 0)
     {
         // TODO: render stuff
@@ -112,9 +193,176 @@ void omp::Application::tick(float delta)
 
 }
 
-void omp::Application::parseFlags(const std::string& /*commands*/)
+void omp::Application::parseFlags(const std::string& commands)
+{
+    m_Flags = omp::AppFlags::split(commands);
+    m_Config = omp::AppFlags::parse(m_Flags);
+    for (const std::string& name: m_Config.unknown)
+    {
+        WARN(LogCore, "Unknown flag --{} is ignored", name);
+    }
+}
+
+void omp::Application::writeFrameStats(float delta)
+{
+    if (!m_StatsFile.is_open())
+    {
+        return;
+    }
+    const omp::DrawStats& draw_stats = m_Renderer->getDrawStats();
+    const omp::RenderStats& stats = m_Renderer->getRenderStats();
+    m_StatsFile << m_FrameIndex << ',' << delta << ',' << draw_stats.main_pass_ms << ',' << stats.draw_calls << ','
+                << stats.indirect_draw_calls << ',' << stats.indices << ',' << stats.triangles << ','
+                << stats.pipeline_binds << ',' << stats.descriptor_set_binds << ',' << stats.vertex_buffer_binds << ','
+                << stats.index_buffer_binds << ',' << stats.push_constant_bytes << ',' << stats.visible_entities << ','
+                << stats.culled_entities << '\n';
+}
+
+void omp::Application::writeBenchReport()
+{
+    if (m_Config.bench_path.empty())
+    {
+        return;
+    }
+    if (m_BenchReport.getFrameCount() == 0)
+    {
+        WARN(LogCore, "No frames after {} warmup frames, benchmark is not written", m_Config.warmup_frames);
+        return;
+    }
+
+    nlohmann::ordered_json json;
+    json["scene"] = m_Config.generate_scene ? "generated" : m_Config.scene_path;
+    if (m_Config.generate_scene)
+    {
+        const omp::SceneGeneratorSettings& generator = m_Config.generator;
+        json["generator"] = {{"seed", generator.seed}, {"entities", generator.entities},
+                             {"models", generator.models}, {"materials", generator.materials},
+                             {"point_lights", generator.point_lights}, {"spot_lights", generator.spot_lights}};
+    }
+    json["width"] = m_Config.width;
+    json["height"] = m_Config.height;
+    json["warmup_frames"] = m_Config.warmup_frames;
+    json["frames_in_flight"] = m_Renderer->getFramesInFlight();
+    json.update(m_BenchReport.toJson());
+
+    std::ofstream file(m_Config.bench_path);
+    if (!file.is_open())
+    {
+        WARN(LogCore, "Failed to write benchmark {}", m_Config.bench_path);
+        return;
+    }
+    file << json.dump(4) << '\n';
+    INFO(LogCore, "Benchmark of {} frames is written to {}", m_BenchReport.getFrameCount(), m_Config.bench_path);
+}
+
+void omp::Application::createGeneratedScene(const omp::GeneratedScene& generated)
+{
+    m_CurrentScene = std::make_shared<omp::Scene>();
+
+    for (size_t index = 0; index < generated.meshes.size(); index++)
+    {
+        const omp::GeneratedMesh& mesh = generated.meshes[index];
+        std::vector<omp::Vertex> vertices(mesh.positions.size());
+        for (size_t vertex = 0; vertex < vertices.size(); vertex++)
+        {
+            vertices[vertex].pos = mesh.positions[vertex];
+            vertices[vertex].color = glm::vec3(1.f);
+            vertices[vertex].tex_coord = mesh.tex_coords[vertex];
+            vertices[vertex].normal = mesh.normals[vertex];
+        }
+        auto model = std::make_shared<omp::Model>();
+        model->setName("generated_model_" + std::to_string(index));
+        model->addVertices(vertices);
+        model->addIndices(mesh.indices);
+        m_GeneratedModels.push_back(std::move(model));
+    }
+
+    // Entities of one material share its instance, so they batch together
+    std::vector<std::shared_ptr<omp::MaterialInstance>> material_instances;
+    for (const omp::GeneratedMaterial& generated_material: generated.materials)
+    {
+        auto material = std::make_shared<omp::Material>();
+        material->setShaderName("Light");
+        auto instance = std::make_shared<omp::MaterialInstance>(material);
+        instance->setAmbient(generated_material.ambient);
+        instance->setDiffusive(generated_material.diffuse);
+        instance->setSpecular(generated_material.specular);
+        material_instances.push_back(std::move(instance));
+        m_GeneratedMaterials.push_back(std::move(material));
+    }
+
+    for (size_t index = 0; index < generated.entities.size(); index++)
+    {
+        const omp::GeneratedEntity& generated_entity = generated.entities[index];
+        auto instance = std::make_shared<omp::ModelInstance>(m_GeneratedModels[generated_entity.model],
+                                                             material_instances[generated_entity.material]);
+        auto entity = std::make_unique<omp::SceneEntity>("generated_" + std::to_string(index), instance);
+        entity->setTranslation(generated_entity.position);
+        entity->setRotation(generated_entity.rotation);
+        entity->setScale(generated_entity.scale);
+        m_CurrentScene->addEntityToScene(std::move(entity));
+    }
+
+    const omp::CameraPose pose = omp::getBenchmarkCameraPose(0, 1, m_Config.generator.extent);
+    auto camera = std::make_unique<omp::Camera>();
+    camera->setName("bench_camera");
+    camera->lookAt(pose.position, pose.target);
+    m_CurrentScene->addCameraToScene(std::move(camera));
+
+    INFO(LogCore, "Generated scene with seed {}: {} entities, {} models, {} materials", m_Config.generator.seed,
+         generated.entities.size(), generated.meshes.size(), generated.materials.size());
+}
+
+void omp::Application::addGeneratedLights(const omp::GeneratedScene& generated)
 {
+    // Lights take position and direction from their instances every frame, instances are not drawn
+    omp::LightSystem* light_system = m_Renderer->getLightSystem();
+    auto global_instance = std::make_shared<omp::ModelInstance>();
+    global_instance->getPosition() = glm::vec3(0.f, m_Config.generator.extent, 0.f);
+    light_system->enableGlobalLight(global_instance);
+
+    for (size_t index = 0; index < generated.point_lights.size(); index++)
+    {
+        const omp::PointLight& point = generated.point_lights[index];
+        auto instance = std::make_shared<omp::ModelInstance>();
+        instance->getPosition() = glm::vec3(point.position);
+        auto light = std::make_shared<omp::LightObject<omp::PointLight>>("point_" + std::to_string(index),
+                                                                          instance);
+        light->getLight() = point;
+        light_system->addPointLight(light);
+    }
 
+    for (size_t index = 0; index < generated.spot_lights.size(); index++)
+    {
+        const omp::SpotLight& spot = generated.spot_lights[index];
+        auto instance = std::make_shared<omp::ModelInstance>();
+        instance->getPosition() = glm::vec3(spot.position);
+        instance->getRotation() = glm::vec3(spot.direction);
+        auto light = std::make_shared<omp::LightObject<omp::SpotLight>>("spot_" + std::to_string(index), instance);
+        light->getLight() = spot;
+        light_system->addSpotLight(light);
+    }
+}
+
+void omp::Application::writeTrace(bool force)
+{
+    omp::Profiler& profiler = omp::Profiler::getProfiler();
+    if (m_Config.trace_path.empty() || !profiler.isCapturing() || (!force && !profiler.isCaptureComplete()))
+    {
+        return;
+    }
+    if (profiler.getDroppedCount() > 0)
+    {
+        WARN(LogCore, "{} profiler scopes were dropped, rings were full", profiler.getDroppedCount());
+    }
+    if (profiler.writeCapture(m_Config.trace_path))
+    {
+        INFO(LogCore, "Trace of {} frames is written to {}", m_Config.trace_frames, m_Config.trace_path);
+    }
+    else
+    {
+        WARN(LogCore, "Failed to write trace {}", m_Config.trace_path);
+    }
 }
 
 void omp::Application::fillInFactoryClasses()
@@ -3,6 +3,11 @@
 #include "Renderer.h"
 #include "Scene.h"
 #include "AssetSystem/AssetManager.h"
+#include "Core/AppFlags.h"
+#include "Core/BenchmarkReport.h"
+#include "Core/FramePacer.h"
+#include "Core/Profiler.h"
+#include <fstream>
 
 namespace omp
 {
@@ -21,6 +26,7 @@ namespace omp
         omp::ObjectFactory* getObjectFactory() const { return m_Factory.get(); }
         omp::Scene* getCurrentScene() const { return m_CurrentScene.get(); }
         GLFWwindow* getWindow() const { return m_Window; }
+        const omp::FramePacer& getFramePacer() const { return m_Pacer; }
 
     private:
         virtual void preInit();
@@ -32,23 +38,37 @@ namespace omp
     // ==== //
     private:
         std::unordered_map<std::string, std::string> m_Flags;
+        omp::AppFlags m_Config;
 
         std::unique_ptr<Renderer> m_Renderer;
         std::unique_ptr<omp::AssetManager> m_AssetManager;
         std::unique_ptr<omp::ThreadPool> m_ThreadPool;
         std::unique_ptr<omp::ObjectFactory> m_Factory;
         std::shared_ptr<omp::Scene> m_CurrentScene;
-        GLFWwindow* m_Window;
+        // Null when headless
+        GLFWwindow* m_Window = nullptr;
 
-        uint32_t m_Width = 1280;
-        uint32_t m_Height = 720;
-        int m_FrameLimit = -1;
-        int m_ThreadCount = 5;//-1;
+        omp::FramePacer m_Pacer;
         bool m_RequestExit = false;
-        
+        uint64_t m_FrameIndex = 0;
+        // Open when statistics path is given, one row per frame
+        std::ofstream m_StatsFile;
+        omp::BenchmarkReport m_BenchReport;
+
+        // Instances hold models and materials weakly, generated ones are owned here
+        std::vector<std::shared_ptr<omp::Model>> m_GeneratedModels;
+        std::vector<std::shared_ptr<omp::Material>> m_GeneratedMaterials;
+
 
     private:
         void parseFlags(const std::string& commands);
+        void writeFrameStats(float delta);
+        void writeBenchReport();
+        // Scene has to exist before resources, lights need the light system created with them
+        void createGeneratedScene(const omp::GeneratedScene& generated);
+        void addGeneratedLights(const omp::GeneratedScene& generated);
+        // Once the capture of --trace is complete, or with whatever it has when forced
+        void writeTrace(bool force);
         void fillInFactoryClasses();
         inline static void windowResizeCallback(GLFWwindow* window, int width, int height);
 
@@ -0,0 +1,77 @@
+#include "BenchmarkReport.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    float getPercentile(const std::vector<float>& sorted, float percentile)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(percentile / 100.f * static_cast<float>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    nlohmann::ordered_json toJson(const omp::FrameTimeSummary& summary)
+    {
+        return {{"mean", summary.mean_ms}, {"min", summary.min_ms}, {"max", summary.max_ms},
+                {"p50", summary.p50_ms}, {"p95", summary.p95_ms}, {"p99", summary.p99_ms}};
+    }
+}
+
+void omp::BenchmarkReport::addFrame(float frameMs, float mainPassMs, const omp::RenderStats& stats)
+{
+    m_FrameMs.push_back(frameMs);
+    m_MainPassMs.push_back(mainPassMs);
+    m_Stats.push_back(stats);
+}
+
+omp::FrameTimeSummary omp::BenchmarkReport::summarize(std::vector<float> values)
+{
+    omp::FrameTimeSummary summary;
+    if (values.empty())
+    {
+        return summary;
+    }
+    std::sort(values.begin(), values.end());
+    const double sum = std::accumulate(values.begin(), values.end(), 0.0);
+    summary.mean_ms = static_cast<float>(sum / static_cast<double>(values.size()));
+    summary.min_ms = values.front();
+    summary.max_ms = values.back();
+    summary.p50_ms = getPercentile(values, 50.f);
+    summary.p95_ms = getPercentile(values, 95.f);
+    summary.p99_ms = getPercentile(values, 99.f);
+    return summary;
+}
+
+nlohmann::ordered_json omp::BenchmarkReport::toJson() const
+{
+    const double frames = static_cast<double>(std::max<size_t>(m_Stats.size(), 1));
+    auto average = [this, frames]<typename T>(T omp::RenderStats::* counter)
+    {
+        double total = 0.0;
+        for (const omp::RenderStats& stats: m_Stats)
+        {
+            total += static_cast<double>(stats.*counter);
+        }
+        return total / frames;
+    };
+
+    nlohmann::ordered_json json;
+    json["frames"] = m_FrameMs.size();
+    json["frame_ms"] = ::toJson(summarize(m_FrameMs));
+    // Zero without gpu timestamps
+    json["main_pass_ms"] = ::toJson(summarize(m_MainPassMs));
+    json["render_stats"] = {
+            {"draw_calls", average(&omp::RenderStats::draw_calls)},
+            {"indirect_draw_calls", average(&omp::RenderStats::indirect_draw_calls)},
+            {"indices", average(&omp::RenderStats::indices)},
+            {"triangles", average(&omp::RenderStats::triangles)},
+            {"pipeline_binds", average(&omp::RenderStats::pipeline_binds)},
+            {"descriptor_set_binds", average(&omp::RenderStats::descriptor_set_binds)},
+            {"vertex_buffer_binds", average(&omp::RenderStats::vertex_buffer_binds)},
+            {"index_buffer_binds", average(&omp::RenderStats::index_buffer_binds)},
+            {"push_constant_bytes", average(&omp::RenderStats::push_constant_bytes)},
+            {"visible_entities", average(&omp::RenderStats::visible_entities)},
+            {"culled_entities", average(&omp::RenderStats::culled_entities)}};
+    return json;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "Rendering/RenderStats.h"
+
+namespace omp
+{
+    struct FrameTimeSummary
+    {
+        float mean_ms = 0.f;
+        float min_ms = 0.f;
+        float max_ms = 0.f;
+        float p50_ms = 0.f;
+        float p95_ms = 0.f;
+        float p99_ms = 0.f;
+    };
+
+    /**
+     * Frame times and render statistics of a benchmark run, summarized as json.
+     * Percentiles are nearest rank, so every reported time is one some frame really took.
+     */
+    class BenchmarkReport
+    {
+    private:
+        // State //
+        // ===== //
+        std::vector<float> m_FrameMs;
+        std::vector<float> m_MainPassMs;
+        // Kept per frame, sums of counters over a long run do not fit their types
+        std::vector<omp::RenderStats> m_Stats;
+
+    public:
+        // Methods //
+        // ======= //
+        void addFrame(float frameMs, float mainPassMs, const omp::RenderStats& stats);
+        size_t getFrameCount() const { return m_FrameMs.size(); }
+
+        // Empty values give zero summary
+        static omp::FrameTimeSummary summarize(std::vector<float> values);
+        // Summaries of frame and main pass times, render statistics are averaged per frame
+        nlohmann::ordered_json toJson() const;
+    };
+}
@@ -0,0 +1,144 @@
+#include "ChromeTrace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+namespace
+{
+    // Lanes of frames and gpu, above any thread index
+    constexpr uint32_t g_FramesThread = 1000;
+    constexpr uint32_t g_GpuThread = 1001;
+
+    void writeString(std::ostream& out, std::string_view text)
+    {
+        out << '"';
+        for (const char symbol: text)
+        {
+            if (symbol == '"' || symbol == '\\')
+            {
+                out << '\\' << symbol;
+            }
+            else if (static_cast<unsigned char>(symbol) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(symbol));
+                out << escaped;
+            }
+            else
+            {
+                out << symbol;
+            }
+        }
+        out << '"';
+    }
+
+    class TraceWriter
+    {
+    private:
+        std::ostream& m_Out;
+        int64_t m_Origin;
+        bool m_First = true;
+
+    public:
+        TraceWriter(std::ostream& out, int64_t origin)
+            : m_Out(out)
+            , m_Origin(origin)
+        {
+        }
+
+        void threadName(uint32_t thread, std::string_view name, uint32_t sortIndex)
+        {
+            separate();
+            m_Out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread << R"(,"args":{"name":)";
+            writeString(m_Out, name);
+            m_Out << "}}";
+            separate();
+            m_Out << R"({"name":"thread_sort_index","ph":"M","pid":1,"tid":)" << thread
+                  << R"(,"args":{"sort_index":)" << sortIndex << "}}";
+        }
+
+        void complete(std::string_view name, const char* category, uint32_t thread, int64_t start, int64_t end)
+        {
+            separate();
+            m_Out << R"({"name":)";
+            writeString(m_Out, name);
+            m_Out << R"(,"cat":")" << category << R"(","ph":"X","pid":1,"tid":)" << thread << R"(,"ts":)";
+            writeMicroseconds(start - m_Origin);
+            m_Out << R"(,"dur":)";
+            writeMicroseconds(std::max<int64_t>(end - start, 0));
+            m_Out << '}';
+        }
+
+    private:
+        void separate()
+        {
+            m_Out << (m_First ? "\n" : ",\n");
+            m_First = false;
+        }
+
+        // Fixed point, stream state is left alone
+        void writeMicroseconds(int64_t nanoseconds)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%lld.%03lld", static_cast<long long>(nanoseconds / 1000),
+                          static_cast<long long>(std::abs(nanoseconds % 1000)));
+            if (nanoseconds < 0 && nanoseconds > -1000)
+            {
+                m_Out << '-';
+            }
+            m_Out << text;
+        }
+    };
+}
+
+void omp::writeChromeTrace(std::ostream& out, const std::vector<const omp::FrameProfile*>& inFrames,
+                           const std::vector<std::string>& inThreadNames)
+{
+    const int64_t origin = inFrames.empty() ? 0 : inFrames.front()->start_ns;
+    TraceWriter writer(out, origin);
+    out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+
+    writer.threadName(g_FramesThread, "Frames", 0);
+    for (size_t thread = 0; thread < inThreadNames.size(); thread++)
+    {
+        writer.threadName(static_cast<uint32_t>(thread), inThreadNames[thread], static_cast<uint32_t>(thread + 1));
+    }
+    writer.threadName(g_GpuThread, "GPU", static_cast<uint32_t>(inThreadNames.size() + 1));
+
+    for (const omp::FrameProfile* frame: inFrames)
+    {
+        writer.complete("Frame " + std::to_string(frame->index), "frame", g_FramesThread, frame->start_ns,
+                        frame->end_ns);
+        for (const omp::CpuProfileEvent& event: frame->cpu_events)
+        {
+            writer.complete(event.name, "cpu", event.thread, event.start_ns, event.end_ns);
+        }
+
+        if (frame->gpu_events.empty())
+        {
+            continue;
+        }
+        int64_t gpu_to_cpu = 0;
+        if (frame->gpu_to_cpu_ns)
+        {
+            gpu_to_cpu = *frame->gpu_to_cpu_ns;
+        }
+        else
+        {
+            uint64_t gpu_start = frame->gpu_events[0].start_ns;
+            for (const omp::GpuProfileEvent& event: frame->gpu_events)
+            {
+                gpu_start = std::min(gpu_start, event.start_ns);
+            }
+            gpu_to_cpu = frame->start_ns - static_cast<int64_t>(gpu_start);
+        }
+        for (const omp::GpuProfileEvent& event: frame->gpu_events)
+        {
+            writer.complete(event.name, "gpu", g_GpuThread, static_cast<int64_t>(event.start_ns) + gpu_to_cpu,
+                            static_cast<int64_t>(event.end_ns) + gpu_to_cpu);
+        }
+    }
+
+    out << "\n]}\n";
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Profiler.h"
+
+namespace omp
+{
+    /**
+     * Trace event json of profiled frames, opens in chrome://tracing and ui.perfetto.dev.
+     * Cpu scopes get a lane per thread, frames and gpu scopes get a lane each.
+     * Gpu scopes use the calibrated offset of their frame, without it they start with the frame.
+     * Times are microseconds from the start of the first frame.
+     */
+    void writeChromeTrace(std::ostream& out, const std::vector<const omp::FrameProfile*>& inFrames,
+                          const std::vector<std::string>& inThreadNames);
+}
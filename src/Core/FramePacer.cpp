@@ -0,0 +1,129 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <thread>
+
+omp::FramePacerClock omp::FramePacerClock::system()
+{
+    return {&Clock::now,
+            [](Clock::time_point time) { std::this_thread::sleep_until(time); },
+            [] { std::this_thread::yield(); }};
+}
+
+omp::FramePacer::FramePacer()
+    : FramePacer(FramePacerClock::system())
+{
+}
+
+omp::FramePacer::FramePacer(FramePacerClock inClock)
+    : m_Clock(std::move(inClock))
+{
+}
+
+void omp::FramePacer::setTargetFps(int fps)
+{
+    using namespace std::chrono;
+    m_Period = fps > 0 ? duration_cast<Clock::duration>(duration<double>(1.0 / fps)) : Clock::duration(0);
+    m_Deadline = m_Clock.now() + m_Period;
+}
+
+float omp::FramePacer::beginFrame()
+{
+    using namespace std::chrono;
+    if (m_WaitBeforeInput && m_Period > Clock::duration(0) && m_Started)
+    {
+        waitUntil(m_Deadline - getPredictedWork());
+    }
+
+    const Clock::time_point now = m_Clock.now();
+    float delta = 0.f;
+    // Previous frame is complete only now, including its wait
+    if (m_Started)
+    {
+        delta = duration<float>(now - m_FrameStart).count();
+        m_FrameMs[m_HistoryCursor] = delta * 1000.f;
+        m_WorkMs[m_HistoryCursor] = m_LastWorkMs;
+        m_HistoryCursor = (m_HistoryCursor + 1) % s_HistorySize;
+        m_HistoryCount = std::min(m_HistoryCount + 1, s_HistorySize);
+    }
+    m_FrameStart = now;
+    m_Started = true;
+    return delta;
+}
+
+void omp::FramePacer::endFrame()
+{
+    using namespace std::chrono;
+    const Clock::time_point now = m_Clock.now();
+    m_LastWorkMs = duration<float, std::milli>(now - m_FrameStart).count();
+    if (m_Period == Clock::duration(0))
+    {
+        return;
+    }
+
+    // Late frame does not make the next ones hurry, schedule starts over
+    if (now > m_Deadline)
+    {
+        m_Deadline = now;
+    }
+    if (!m_WaitBeforeInput)
+    {
+        waitUntil(m_Deadline);
+    }
+    m_Deadline += m_Period;
+}
+
+omp::FramePacingStats omp::FramePacer::getStats() const
+{
+    FramePacingStats stats;
+    if (m_HistoryCount == 0)
+    {
+        return stats;
+    }
+
+    const float count = static_cast<float>(m_HistoryCount);
+    for (size_t frame = 0; frame < m_HistoryCount; frame++)
+    {
+        stats.frame_ms += m_FrameMs[frame];
+        stats.work_ms += m_WorkMs[frame];
+        stats.max_frame_ms = std::max(stats.max_frame_ms, m_FrameMs[frame]);
+    }
+    stats.frame_ms /= count;
+    stats.work_ms /= count;
+
+    float variance = 0.f;
+    for (size_t frame = 0; frame < m_HistoryCount; frame++)
+    {
+        variance += (m_FrameMs[frame] - stats.frame_ms) * (m_FrameMs[frame] - stats.frame_ms);
+    }
+    stats.jitter_ms = std::sqrt(variance / count);
+    return stats;
+}
+
+void omp::FramePacer::waitUntil(Clock::time_point deadline) const
+{
+    const Clock::time_point wake_up = deadline - s_SpinThreshold;
+    if (m_Clock.now() < wake_up)
+    {
+        m_Clock.sleep_until(wake_up);
+    }
+    while (m_Clock.now() < deadline)
+    {
+        m_Clock.yield();
+    }
+}
+
+omp::FramePacer::Clock::duration omp::FramePacer::getPredictedWork() const
+{
+    using namespace std::chrono;
+    // Slowest recent work with a margin, being late costs a whole frame while early only costs latency
+    float work_ms = m_LastWorkMs;
+    const size_t recent = std::min<size_t>(m_HistoryCount, 8);
+    for (size_t frame = 0; frame < recent; frame++)
+    {
+        work_ms = std::max(work_ms, m_WorkMs[(m_HistoryCursor + s_HistorySize - 1 - frame) % s_HistorySize]);
+    }
+    const auto predicted = duration_cast<Clock::duration>(duration<float, std::milli>(work_ms * 1.2f + 0.5f));
+    return std::min(predicted, m_Period);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace omp
+{
+    // Over the last FramePacer::s_HistorySize frames
+    struct FramePacingStats
+    {
+        float frame_ms = 0.f;
+        // Part of the frame between beginFrame and endFrame
+        float work_ms = 0.f;
+        // Standard deviation of frame time
+        float jitter_ms = 0.f;
+        float max_frame_ms = 0.f;
+    };
+
+    // Time source of the pacer, tests replace it with a fake clock
+    struct FramePacerClock
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::function<Clock::time_point()> now;
+        // Coarse, may overshoot by a scheduler tick
+        std::function<void(Clock::time_point)> sleep_until;
+        // One step of spinning
+        std::function<void()> yield;
+
+        static FramePacerClock system();
+    };
+
+    /**
+     * Measures frame time and holds frames to a target rate.
+     * Waits sleep until shortly before the deadline and spin the rest, plain sleep overshoots by a scheduler tick.
+     * By default the wait goes after the work of a frame. With wait before input it goes before,
+     * shortened by predicted work, so input is sampled as late as possible and frame still ends on time.
+     */
+    class FramePacer
+    {
+    public:
+        using Clock = FramePacerClock::Clock;
+
+        FramePacer();
+        explicit FramePacer(FramePacerClock inClock);
+
+        static constexpr size_t s_HistorySize = 120;
+        // Sleep wakes up this early, the rest is spun
+        static constexpr Clock::duration s_SpinThreshold = std::chrono::milliseconds(2);
+
+    private:
+        // State //
+        // ===== //
+        FramePacerClock m_Clock;
+        Clock::duration m_Period{0};
+        bool m_WaitBeforeInput = false;
+
+        Clock::time_point m_FrameStart;
+        Clock::time_point m_Deadline;
+        bool m_Started = false;
+
+        float m_LastWorkMs = 0.f;
+        std::array<float, s_HistorySize> m_FrameMs{};
+        std::array<float, s_HistorySize> m_WorkMs{};
+        size_t m_HistoryCount = 0;
+        size_t m_HistoryCursor = 0;
+
+        // Methods //
+        // ======= //
+    public:
+        // Not positive is unlimited
+        void setTargetFps(int fps);
+        void setWaitBeforeInput(bool inEnabled) { m_WaitBeforeInput = inEnabled; }
+
+        // Waits if needed and starts the frame, returns seconds since start of the previous one
+        float beginFrame();
+        // Ends the work of the frame and waits for the deadline unless waiting before input
+        void endFrame();
+
+        FramePacingStats getStats() const;
+
+        void waitUntil(Clock::time_point deadline) const;
+
+    private:
+        Clock::duration getPredictedWork() const;
+    };
+}
@@ -0,0 +1,235 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include "ChromeTrace.h"
+
+namespace
+{
+    std::atomic<uint64_t> g_NextProfilerId = 0;
+}
+
+omp::Profiler::Profiler()
+    : m_Id(g_NextProfilerId.fetch_add(1))
+    , m_History(s_HistorySize)
+    , m_FrameStart(now())
+{
+}
+
+int64_t omp::Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+void omp::Profiler::setEnabled(bool inEnabled)
+{
+    if (inEnabled && !isEnabled())
+    {
+        m_HistoryCount = 0;
+        m_FrameStart = now();
+        std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+        for (auto& thread: m_Threads)
+        {
+            thread->tail.store(thread->head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+    }
+    m_Enabled.store(inEnabled, std::memory_order_relaxed);
+}
+
+void omp::Profiler::beginFrame()
+{
+    const int64_t frame_end = now();
+    if (isEnabled())
+    {
+        // Ring slot is reused with its capacity
+        FrameProfile& frame = m_History[m_HistoryCursor];
+        frame.index = m_FrameIndex;
+        frame.start_ns = m_FrameStart;
+        frame.end_ns = frame_end;
+        frame.cpu_events.clear();
+        frame.gpu_events.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+            for (auto& thread: m_Threads)
+            {
+                const uint64_t tail = thread->tail.load(std::memory_order_relaxed);
+                const uint64_t head = thread->head.load(std::memory_order_acquire);
+                for (uint64_t event = tail; event < head; event++)
+                {
+                    frame.cpu_events.push_back(thread->events[event % s_RingSize]);
+                }
+                // Slots are free for the owner again
+                thread->tail.store(head, std::memory_order_release);
+            }
+        }
+        std::sort(frame.cpu_events.begin(), frame.cpu_events.end(),
+                  [](const CpuProfileEvent& first, const CpuProfileEvent& second)
+                  {
+                      return first.start_ns < second.start_ns;
+                  });
+
+        m_HistoryCursor = (m_HistoryCursor + 1) % s_HistorySize;
+        m_HistoryCount = std::min(m_HistoryCount + 1, s_HistorySize);
+
+        if (isCapturing() && !isCaptureComplete())
+        {
+            m_Capture.push_back(frame);
+        }
+    }
+    m_FrameIndex++;
+    m_FrameStart = frame_end;
+}
+
+void omp::Profiler::setThreadName(const std::string& inName)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.name_mutex);
+    buffer.name = inName;
+}
+
+std::string omp::Profiler::getThreadName(uint32_t inThread) const
+{
+    std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+    if (inThread >= m_Threads.size())
+    {
+        return {};
+    }
+    std::lock_guard<std::mutex> thread_lock(m_Threads[inThread]->name_mutex);
+    return m_Threads[inThread]->name;
+}
+
+std::vector<std::string> omp::Profiler::getThreadNames() const
+{
+    std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+    std::vector<std::string> names;
+    names.reserve(m_Threads.size());
+    for (const auto& thread: m_Threads)
+    {
+        std::lock_guard<std::mutex> thread_lock(thread->name_mutex);
+        names.push_back(thread->name);
+    }
+    return names;
+}
+
+uint64_t omp::Profiler::getDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+    uint64_t dropped = 0;
+    for (const auto& thread: m_Threads)
+    {
+        dropped += thread->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void omp::Profiler::addGpuEvents(uint64_t inFrameIndex, std::vector<GpuProfileEvent>&& inEvents,
+                                 std::optional<int64_t> inGpuToCpuNs)
+{
+    // Capture keeps its own copy, it can outlive the history
+    for (FrameProfile& frame: m_Capture)
+    {
+        if (frame.index == inFrameIndex)
+        {
+            frame.gpu_events = inEvents;
+            frame.gpu_to_cpu_ns = inGpuToCpuNs;
+        }
+    }
+    for (size_t age = 0; age < m_HistoryCount; age++)
+    {
+        FrameProfile& frame = m_History[(m_HistoryCursor + s_HistorySize - 1 - age) % s_HistorySize];
+        if (frame.index == inFrameIndex)
+        {
+            frame.gpu_events = std::move(inEvents);
+            frame.gpu_to_cpu_ns = inGpuToCpuNs;
+            return;
+        }
+    }
+}
+
+const omp::FrameProfile& omp::Profiler::getFrame(size_t inAge) const
+{
+    return m_History[(m_HistoryCursor + s_HistorySize - 1 - inAge) % s_HistorySize];
+}
+
+void omp::Profiler::startCapture(size_t inFrameCount)
+{
+    m_Capture.clear();
+    m_Capture.reserve(inFrameCount + s_CaptureGpuLatency);
+    m_CaptureFrames = inFrameCount;
+}
+
+bool omp::Profiler::isCaptureComplete() const
+{
+    return isCapturing() && m_Capture.size() >= m_CaptureFrames + s_CaptureGpuLatency;
+}
+
+bool omp::Profiler::writeCapture(const std::string& inPath)
+{
+    std::vector<const FrameProfile*> frames;
+    for (size_t frame = 0; frame < std::min(m_CaptureFrames, m_Capture.size()); frame++)
+    {
+        frames.push_back(&m_Capture[frame]);
+    }
+    std::ofstream file(inPath);
+    if (file)
+    {
+        omp::writeChromeTrace(file, frames, getThreadNames());
+    }
+    m_Capture.clear();
+    m_CaptureFrames = 0;
+    return file.good();
+}
+
+bool omp::Profiler::writeHistory(const std::string& inPath) const
+{
+    std::vector<const FrameProfile*> frames;
+    for (size_t age = m_HistoryCount; age > 0; age--)
+    {
+        frames.push_back(&getFrame(age - 1));
+    }
+    std::ofstream file(inPath);
+    if (!file)
+    {
+        return false;
+    }
+    omp::writeChromeTrace(file, frames, getThreadNames());
+    return file.good();
+}
+
+int64_t omp::Profiler::pushScope()
+{
+    getThreadBuffer().depth++;
+    return now();
+}
+
+void omp::Profiler::popScope(const char* inName, int64_t inStart)
+{
+    const int64_t end = now();
+    ThreadBuffer& buffer = getThreadBuffer();
+    buffer.depth--;
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= s_RingSize)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[head % s_RingSize] = {inName, inStart, end, buffer.index, buffer.depth};
+    // Publishes the slot to the frame boundary
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+omp::Profiler::ThreadBuffer& omp::Profiler::getThreadBuffer()
+{
+    thread_local uint64_t t_ProfilerId = UINT64_MAX;
+    thread_local ThreadBuffer* t_Buffer = nullptr;
+    if (t_ProfilerId != m_Id)
+    {
+        std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->index = static_cast<uint32_t>(m_Threads.size());
+        buffer->name = "Thread " + std::to_string(buffer->index);
+        t_Buffer = buffer.get();
+        t_ProfilerId = m_Id;
+        m_Threads.push_back(std::move(buffer));
+    }
+    return *t_Buffer;
+}
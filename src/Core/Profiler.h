@@ -0,0 +1,189 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace omp
+{
+    // Names are not copied, string literals are expected
+    struct CpuProfileEvent
+    {
+        const char* name = nullptr;
+        // Nanoseconds of Profiler::Clock
+        int64_t start_ns = 0;
+        int64_t end_ns = 0;
+        uint32_t thread = 0;
+        // Number of scopes of the same thread it is nested in
+        uint32_t depth = 0;
+    };
+
+    // Nanoseconds of gpu clock, its origin is unrelated to cpu one
+    struct GpuProfileEvent
+    {
+        const char* name = nullptr;
+        uint64_t start_ns = 0;
+        uint64_t end_ns = 0;
+    };
+
+    struct FrameProfile
+    {
+        uint64_t index = 0;
+        int64_t start_ns = 0;
+        int64_t end_ns = 0;
+        // Events which ended during the frame, sorted by start
+        std::vector<CpuProfileEvent> cpu_events;
+        // Arrive frames in flight later than cpu events
+        std::vector<GpuProfileEvent> gpu_events;
+        // Added to gpu timestamps gives Profiler::Clock time, empty when clocks were not calibrated
+        std::optional<int64_t> gpu_to_cpu_ns;
+    };
+
+    /**
+     * Collects scoped cpu markers of every thread and gpu timings of every frame into a rolling history.
+     * Each thread writes into its own single producer ring without locks, frame boundary drains all rings.
+     * Events of a full ring are dropped and counted.
+     * Scope of disabled profiler costs one relaxed atomic load.
+     * History and capture are owned by the thread calling beginFrame and are read from it.
+     */
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr size_t s_HistorySize = 240;
+        // Events one thread can record between two frame boundaries
+        static constexpr uint64_t s_RingSize = 8192;
+        // Frames a capture waits after its last one for gpu results
+        static constexpr size_t s_CaptureGpuLatency = 4;
+
+    private:
+        struct ThreadBuffer
+        {
+            // Owning thread writes at head, frame boundary reads up to it and moves tail
+            std::unique_ptr<CpuProfileEvent[]> events = std::make_unique<CpuProfileEvent[]>(s_RingSize);
+            std::atomic<uint64_t> head = 0;
+            std::atomic<uint64_t> tail = 0;
+            std::atomic<uint64_t> dropped = 0;
+
+            std::mutex name_mutex;
+            std::string name;
+            // Only touched by the owning thread
+            uint32_t depth = 0;
+            uint32_t index = 0;
+        };
+
+        // State //
+        // ===== //
+        std::atomic<bool> m_Enabled = false;
+        // Thread locals remember buffers by id, address of a destroyed profiler can be taken by a new one
+        const uint64_t m_Id;
+
+        mutable std::mutex m_ThreadsMutex;
+        // Never removed, thread locals keep pointing at them
+        std::vector<std::unique_ptr<ThreadBuffer>> m_Threads;
+
+        std::vector<FrameProfile> m_History;
+        size_t m_HistoryCount = 0;
+        size_t m_HistoryCursor = 0;
+        uint64_t m_FrameIndex = 0;
+        int64_t m_FrameStart = 0;
+
+        // First frames after startCapture, kept whole until written
+        std::vector<FrameProfile> m_Capture;
+        size_t m_CaptureFrames = 0;
+
+        // Methods //
+        // ======= //
+    public:
+        Profiler();
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        static Profiler& getProfiler()
+        {
+            static Profiler single;
+            return single;
+        }
+
+        static int64_t now();
+
+        // Enabling starts a clean history
+        void setEnabled(bool inEnabled);
+        bool isEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+        // Closes collected events into a frame of history and starts the next frame
+        void beginFrame();
+        // Index of the frame in progress
+        uint64_t getFrameIndex() const { return m_FrameIndex; }
+
+        // Names calling thread, unnamed threads are numbered
+        void setThreadName(const std::string& inName);
+        std::string getThreadName(uint32_t inThread) const;
+        // Indexed by CpuProfileEvent::thread
+        std::vector<std::string> getThreadNames() const;
+        // Events lost to full rings since creation
+        uint64_t getDroppedCount() const;
+
+        // Dropped if the frame has already left history and capture
+        void addGpuEvents(uint64_t inFrameIndex, std::vector<GpuProfileEvent>&& inEvents,
+                          std::optional<int64_t> inGpuToCpuNs = std::nullopt);
+
+        size_t getHistoryCount() const { return m_HistoryCount; }
+        // Age zero is the latest complete frame
+        const FrameProfile& getFrame(size_t inAge) const;
+
+        // Keeps the next frames recorded while enabled, restarts a running capture
+        void startCapture(size_t inFrameCount);
+        bool isCapturing() const { return m_CaptureFrames > 0; }
+        // Captured frames and gpu results of them are in
+        bool isCaptureComplete() const;
+        // Chrome trace of the captured frames, ends the capture. False when the file can't be written
+        bool writeCapture(const std::string& inPath);
+        // Chrome trace of the whole history
+        bool writeHistory(const std::string& inPath) const;
+
+        // Used by ProfileScope
+        int64_t pushScope();
+        void popScope(const char* inName, int64_t inStart);
+
+    private:
+        ThreadBuffer& getThreadBuffer();
+    };
+
+    class ProfileScope
+    {
+    private:
+        omp::Profiler* m_Profiler = nullptr;
+        const char* m_Name = nullptr;
+        int64_t m_Start = 0;
+
+    public:
+        explicit ProfileScope(const char* inName, omp::Profiler& inProfiler = omp::Profiler::getProfiler())
+        {
+            if (inProfiler.isEnabled())
+            {
+                m_Profiler = &inProfiler;
+                m_Name = inName;
+                m_Start = inProfiler.pushScope();
+            }
+        }
+        ~ProfileScope()
+        {
+            if (m_Profiler)
+            {
+                m_Profiler->popScope(m_Name, m_Start);
+            }
+        }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(A, B) A##B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT_INNER(A, B)
+// Measures the rest of enclosing block on calling thread
+#define PROFILE_SCOPE(Name) omp::ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(Name)
@@ -0,0 +1,172 @@
+#include "SceneGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    constexpr float g_Pi = 3.14159265358979f;
+
+    class Random
+    {
+    private:
+        std::mt19937 m_Engine;
+
+    public:
+        explicit Random(uint32_t seed)
+            : m_Engine(seed)
+        {
+        }
+
+        // 24 bits fit float exactly
+        float unit() { return static_cast<float>(m_Engine() >> 8) / 16777216.f; }
+        float range(float min, float max) { return min + (max - min) * unit(); }
+        uint32_t index(uint32_t count) { return static_cast<uint32_t>(m_Engine() % count); }
+    };
+
+    // Noise fades out at the poles, so vertices of a pole still meet in one point
+    omp::GeneratedMesh generateMesh(Random& random)
+    {
+        const uint32_t segments = 8 + random.index(57);
+        const uint32_t rings = segments / 2;
+        const float amplitude = random.range(0.f, 0.3f);
+        const float theta_frequency = static_cast<float>(1 + random.index(5));
+        const float phi_frequency = static_cast<float>(1 + random.index(6));
+        const float phase = random.range(0.f, 2.f * g_Pi);
+
+        omp::GeneratedMesh mesh;
+        for (uint32_t ring = 0; ring <= rings; ring++)
+        {
+            const float v = static_cast<float>(ring) / static_cast<float>(rings);
+            const float theta = v * g_Pi;
+            for (uint32_t segment = 0; segment <= segments; segment++)
+            {
+                const float u = static_cast<float>(segment) / static_cast<float>(segments);
+                const float phi = u * 2.f * g_Pi;
+                const float radius = 1.f + amplitude * std::sin(theta) * std::sin(theta_frequency * theta + phase) *
+                                           std::sin(phi_frequency * phi);
+                mesh.positions.emplace_back(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta),
+                                            radius * std::sin(theta) * std::sin(phi));
+                mesh.tex_coords.emplace_back(u, v);
+            }
+        }
+
+        const uint32_t row = segments + 1;
+        for (uint32_t ring = 0; ring < rings; ring++)
+        {
+            for (uint32_t segment = 0; segment < segments; segment++)
+            {
+                const uint32_t first = ring * row + segment;
+                const uint32_t second = first + row;
+                mesh.indices.insert(mesh.indices.end(), {first, first + 1, second, second, first + 1, second + 1});
+            }
+        }
+
+        // Counter clockwise from outside, smooth normals are sums of area weighted face normals
+        mesh.normals.assign(mesh.positions.size(), glm::vec3(0.f));
+        for (size_t index = 0; index < mesh.indices.size(); index += 3)
+        {
+            const glm::vec3& a = mesh.positions[mesh.indices[index]];
+            const glm::vec3& b = mesh.positions[mesh.indices[index + 1]];
+            const glm::vec3& c = mesh.positions[mesh.indices[index + 2]];
+            const glm::vec3 face = glm::cross(b - a, c - a);
+            // Pole vertices differ by rounding only, such faces have no meaningful direction
+            if (glm::dot(face, face) < 1e-10f)
+            {
+                continue;
+            }
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                mesh.normals[mesh.indices[index + corner]] += face;
+            }
+        }
+        for (size_t vertex = 0; vertex < mesh.normals.size(); vertex++)
+        {
+            const float length = glm::length(mesh.normals[vertex]);
+            mesh.normals[vertex] = length > 0.f ? mesh.normals[vertex] / length
+                                                : glm::normalize(mesh.positions[vertex]);
+        }
+        return mesh;
+    }
+
+    glm::vec3 randomColor(Random& random)
+    {
+        return {random.range(0.3f, 1.f), random.range(0.3f, 1.f), random.range(0.3f, 1.f)};
+    }
+}
+
+omp::GeneratedScene omp::generateScene(const omp::SceneGeneratorSettings& settings)
+{
+    Random random(settings.seed);
+    omp::GeneratedScene scene;
+    const uint32_t models = std::max(settings.models, 1u);
+    const uint32_t materials = std::max(settings.materials, 1u);
+    const float half = settings.extent * 0.5f;
+
+    for (uint32_t model = 0; model < models; model++)
+    {
+        scene.meshes.push_back(generateMesh(random));
+    }
+
+    for (uint32_t material = 0; material < materials; material++)
+    {
+        const glm::vec3 color = randomColor(random);
+        scene.materials.push_back({glm::vec4(color * 0.2f, 1.f), glm::vec4(color, 1.f),
+                                   glm::vec4(glm::vec3(random.unit()), 1.f)});
+    }
+
+    scene.entities.reserve(settings.entities);
+    for (uint32_t entity = 0; entity < settings.entities; entity++)
+    {
+        omp::GeneratedEntity& generated = scene.entities.emplace_back();
+        generated.model = random.index(models);
+        generated.material = random.index(materials);
+        generated.position = {random.range(-half, half), random.range(0.f, settings.extent * 0.05f),
+                              random.range(-half, half)};
+        generated.rotation = {random.range(0.f, 360.f), random.range(0.f, 360.f), random.range(0.f, 360.f)};
+        generated.scale = glm::vec3(random.range(0.5f, 2.5f));
+    }
+
+    // Attenuation from range like the common constant, linear and quadratic tables
+    auto attenuate = [&random](auto& light)
+    {
+        const float range = random.range(10.f, 40.f);
+        light.constant = 1.f;
+        light.linear = 4.5f / range;
+        light.quadratic = 75.f / (range * range);
+    };
+
+    for (uint32_t light = 0; light < settings.point_lights; light++)
+    {
+        omp::PointLight& point = scene.point_lights.emplace_back();
+        point.position = {random.range(-half, half), random.range(1.f, 10.f), random.range(-half, half), 1.f};
+        point.diffuse = glm::vec4(randomColor(random), point.diffuse.w);
+        attenuate(point);
+    }
+
+    for (uint32_t light = 0; light < settings.spot_lights; light++)
+    {
+        omp::SpotLight& spot = scene.spot_lights.emplace_back();
+        spot.position = {random.range(-half, half), random.range(15.f, 30.f), random.range(-half, half), 1.f};
+        spot.direction = glm::vec4(
+                glm::normalize(glm::vec3(random.range(-0.5f, 0.5f), -1.f, random.range(-0.5f, 0.5f))), 0.f);
+        spot.diffuse = glm::vec4(randomColor(random), spot.diffuse.w);
+        attenuate(spot);
+    }
+    return scene;
+}
+
+omp::CameraPose omp::getBenchmarkCameraPose(uint64_t frame, uint64_t pathFrames, float extent)
+{
+    const uint64_t period = std::max<uint64_t>(pathFrames, 1);
+    const float t = static_cast<float>(frame % period) / static_cast<float>(period);
+    const float angle = 2.f * g_Pi * t;
+    const float radius = extent * 0.6f;
+    const float height = extent * (0.15f + 0.05f * std::sin(2.f * angle));
+
+    omp::CameraPose pose;
+    pose.position = {radius * std::cos(angle), height, radius * std::sin(angle)};
+    // Target leads the camera a bit, so the view sweeps over the scene instead of staring at its center
+    pose.target = {extent * 0.2f * std::cos(angle + 0.5f), 0.f, extent * 0.2f * std::sin(angle + 0.5f)};
+    return pose;
+}
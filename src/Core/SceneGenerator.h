@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Light.h"
+
+namespace omp
+{
+    struct SceneGeneratorSettings
+    {
+        uint32_t seed = 1;
+        uint32_t entities = 2000;
+        uint32_t models = 8;
+        uint32_t materials = 16;
+        uint32_t point_lights = 64;
+        uint32_t spot_lights = 16;
+        // Side of the square entities are scattered over, centered at origin
+        float extent = 200.f;
+    };
+
+    // Displaced sphere, indexed triangle list
+    struct GeneratedMesh
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> tex_coords;
+        std::vector<uint32_t> indices;
+    };
+
+    struct GeneratedMaterial
+    {
+        glm::vec4 ambient{1.f};
+        glm::vec4 diffuse{1.f};
+        glm::vec4 specular{1.f};
+    };
+
+    struct GeneratedEntity
+    {
+        uint32_t model = 0;
+        uint32_t material = 0;
+        glm::vec3 position{0.f};
+        // In degrees, as ModelInstance takes it
+        glm::vec3 rotation{0.f};
+        glm::vec3 scale{1.f};
+    };
+
+    struct GeneratedScene
+    {
+        std::vector<omp::GeneratedMesh> meshes;
+        std::vector<omp::GeneratedMaterial> materials;
+        std::vector<omp::GeneratedEntity> entities;
+        std::vector<omp::PointLight> point_lights;
+        std::vector<omp::SpotLight> spot_lights;
+    };
+
+    struct CameraPose
+    {
+        glm::vec3 position{0.f};
+        glm::vec3 target{0.f};
+    };
+
+    /**
+     * Scene of the benchmark, the same for the same settings on every platform and compiler.
+     * Numbers come straight from mt19937, whose sequence is fixed by the standard, distributions are not.
+     */
+    omp::GeneratedScene generateScene(const omp::SceneGeneratorSettings& settings);
+
+    // Orbit around the generated scene with a slow vertical swing, whole loop takes pathFrames frames.
+    // Driven by frame index instead of time, so every run sees the same views
+    omp::CameraPose getBenchmarkCameraPose(uint64_t frame, uint64_t pathFrames, float extent);
+}
@@ -1,43 +1,5 @@
 #include "LightSystem.h"
 
-omp::LightSystem::LightSystem(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t khrNum)
-    : m_VulkanContext(inVulkanContext)
-    , m_KHRnum(khrNum)
-{
-    recreate();
-}
-
-void omp::LightSystem::recreate()
-{
-    if (m_GlobalLight)
-    {
-        m_GlobalBuffer = std::make_unique<omp::UniformBuffer>(
-                m_VulkanContext,
-                m_KHRnum,
-                sizeof(GlobalLight),
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
-                );
-    }
-    if (!m_PointLights.empty())
-    {
-        m_PointBuffer = std::make_unique<omp::UniformBuffer>(
-                m_VulkanContext,
-                m_KHRnum,
-                sizeof(PointLight) * m_PointLights.size(),
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
-                );
-    }
-    if (!m_SpotLights.empty())
-    {
-        m_SpotBuffer = std::make_unique<omp::UniformBuffer>(
-                m_VulkanContext,
-                m_KHRnum,
-                sizeof(SpotLight) * m_SpotLights.size(),
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
-                );
-    }
-}
-
 void omp::LightSystem::update()
 {
     if (m_GlobalLight)
@@ -58,57 +20,61 @@ void omp::LightSystem::update()
     }
 }
 
-void omp::LightSystem::mapMemory(uint32_t khrImage)
+void omp::LightSystem::updateClusters(const omp::ClusterView& view)
 {
-    if (m_GlobalBuffer)
-    {
-        m_GlobalBuffer->mapMemory(m_GlobalLight->getLight(), khrImage);
-    }
-    else
+    m_PointSpheres.clear();
+    for (auto& light : m_PointLights)
     {
-        WARN(LogRendering, "Buffer for global light is null");
+        const PointLight& data = light->getLight();
+        m_PointSpheres.emplace_back(glm::vec3(data.position),
+                                    omp::LightClusters::getLightRange(data.constant, data.linear, data.quadratic));
     }
-
-    int offset = 0;
-    for (size_t index = 0; index < m_PointLights.size(); index++)
+    m_SpotSpheres.clear();
+    for (auto& light : m_SpotLights)
     {
-        m_PointBuffer->mapMemory(m_PointLights[index]->getLight(), khrImage, offset);
-        offset += sizeof(PointLight);
+        const SpotLight& data = light->getLight();
+        const float range = omp::LightClusters::getLightRange(data.constant, data.linear, data.quadratic);
+        m_SpotSpheres.push_back(omp::LightClusters::getSpotSphere(
+                glm::vec3(data.position), glm::vec3(data.direction), range, data.outer_cutoff));
     }
 
-    offset = 0;
-    for (size_t index = 0; index < m_SpotLights.size(); index++)
+    m_Clusters.build(view, m_PointSpheres, m_SpotSpheres);
+    if (m_Clusters.getDroppedCount() > 0 && !m_ClusterOverflowReported)
     {
-        m_SpotBuffer->mapMemory(m_SpotLights[index]->getLight(), khrImage, offset);
-        offset += sizeof(SpotLight);
+        WARN(LogRendering, "Light cluster indices overflowed, {} assignments dropped", m_Clusters.getDroppedCount());
+        m_ClusterOverflowReported = true;
     }
 }
 
-VkBuffer omp::LightSystem::getGlobalLightBuffer(uint32_t khr)
+omp::LightOffsets omp::LightSystem::writeToBuffer(omp::UniformRingBuffer& buffer)
 {
-    if (m_GlobalBuffer)
+    omp::LightOffsets offsets{};
+    void* data = nullptr;
+
+    offsets.global = buffer.allocate(getGlobalLightBufferSize(), &data);
+    if (m_GlobalLight)
     {
-        return m_GlobalBuffer->getBuffer(khr);
+        std::memcpy(data, &m_GlobalLight->getLight(), sizeof(GlobalLight));
     }
-    return 0;
-}
 
-VkBuffer omp::LightSystem::getPointLightBuffer(uint32_t khr)
-{
-    if (m_PointBuffer)
+    offsets.point = buffer.allocate(getPointLightBufferSize(), &data);
+    auto* point_data = static_cast<PointLight*>(data);
+    for (size_t index = 0; index < m_PointLights.size(); index++)
     {
-        return m_PointBuffer->getBuffer(khr);
+        point_data[index] = m_PointLights[index]->getLight();
     }
-    return 0;
-}
 
-VkBuffer omp::LightSystem::getSpotLightBuffer(uint32_t khr)
-{
-    if (m_SpotBuffer)
+    offsets.spot = buffer.allocate(getSpotLightBufferSize(), &data);
+    auto* spot_data = static_cast<SpotLight*>(data);
+    for (size_t index = 0; index < m_SpotLights.size(); index++)
     {
-        return m_SpotBuffer->getBuffer(khr);
+        spot_data[index] = m_SpotLights[index]->getLight();
     }
-    return 0;
+
+    offsets.clusters = buffer.allocate(getClusterBufferSize(), &data);
+    m_Clusters.writeTo(data);
+
+    return offsets;
 }
 
 std::shared_ptr<omp::LightObject<omp::GlobalLight>> omp::LightSystem::enableGlobalLight(const std::shared_ptr<omp::ModelInstance>& inModel)
@@ -120,10 +86,20 @@ std::shared_ptr<omp::LightObject<omp::GlobalLight>> omp::LightSystem::enableGlob
 
 void omp::LightSystem::addPointLight(const std::shared_ptr<LightObject<omp::PointLight>>& inLight)
 {
+    if (m_PointLights.size() >= s_MaxLightsPerType)
+    {
+        WARN(LogRendering, "Point light limit of {} reached, light is not added", s_MaxLightsPerType);
+        return;
+    }
     m_PointLights.push_back(inLight);
 }
 
 void omp::LightSystem::addSpotLight(const std::shared_ptr<LightObject<omp::SpotLight>>& inLight)
 {
+    if (m_SpotLights.size() >= s_MaxLightsPerType)
+    {
+        WARN(LogRendering, "Spot light limit of {} reached, light is not added", s_MaxLightsPerType);
+        return;
+    }
     m_SpotLights.push_back(inLight);
 }
@@ -1,26 +1,35 @@
 #pragma once
 #include "LightObject.h"
-#include "Rendering/UniformBuffer.h"
+#include "Rendering/UniformRingBuffer.h"
+#include "Rendering/LightClusters.h"
 
 namespace omp
 {
+    // Dynamic offsets of light data written for current frame
+    struct LightOffsets
+    {
+        uint32_t global = 0;
+        uint32_t point = 0;
+        uint32_t spot = 0;
+        uint32_t clusters = 0;
+
+        bool operator==(const LightOffsets& other) const = default;
+    };
+
     class LightSystem
     {
     public:
-        LightSystem(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t khrNum);
+        LightSystem() = default;
 
     private:
         std::shared_ptr<LightObject<GlobalLight>> m_GlobalLight{nullptr};
-        std::unique_ptr<omp::UniformBuffer> m_GlobalBuffer;
-
         std::vector<std::shared_ptr<LightObject<PointLight>>> m_PointLights;
-        std::unique_ptr<omp::UniformBuffer> m_PointBuffer;
-
         std::vector<std::shared_ptr<LightObject<SpotLight>>> m_SpotLights;
-        std::unique_ptr<omp::UniformBuffer> m_SpotBuffer;
 
-        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
-        uint32_t m_KHRnum = 0;
+        omp::LightClusters m_Clusters;
+        std::vector<glm::vec4> m_PointSpheres;
+        std::vector<glm::vec4> m_SpotSpheres;
+        bool m_ClusterOverflowReported = false;
 
         // METHODS //
         // ======= //
@@ -28,13 +37,12 @@ namespace omp
         size_t getPointLightSize() const { return m_PointLights.size(); }
         size_t getSpotLightSize() const { return m_SpotLights.size(); }
 
+        // Descriptor ranges are fixed at creation, so storage for lights is reserved up front
+        static constexpr size_t s_MaxLightsPerType = 512;
         size_t getGlobalLightBufferSize() const { return sizeof(GlobalLight); }
-        size_t getPointLightBufferSize() const { return m_PointLights.size() * sizeof(PointLight); }
-        size_t getSpotLightBufferSize() const { return m_SpotLights.size() * sizeof(SpotLight); }
-
-        VkBuffer getGlobalLightBuffer(uint32_t khr);
-        VkBuffer getPointLightBuffer(uint32_t khr);
-        VkBuffer getSpotLightBuffer(uint32_t khr);
+        size_t getPointLightBufferSize() const { return s_MaxLightsPerType * sizeof(PointLight); }
+        size_t getSpotLightBufferSize() const { return s_MaxLightsPerType * sizeof(SpotLight); }
+        size_t getClusterBufferSize() const { return omp::LightClusters::getBufferSize(); }
 
         std::shared_ptr<LightObject<GlobalLight>>& getGlobalLight() { return m_GlobalLight; }
         std::vector<std::shared_ptr<LightObject<PointLight>>>& getPointLight() { return m_PointLights; }
@@ -44,8 +52,9 @@ namespace omp
         void addPointLight(const std::shared_ptr<LightObject<PointLight>>& inLight);
         void addSpotLight(const std::shared_ptr<LightObject<SpotLight>>& inLight);
 
-        void recreate();
         void update();
-        void mapMemory(uint32_t khrImage);
+        // Bins lights for the frame camera, has to go after update and before writeToBuffer
+        void updateClusters(const omp::ClusterView& view);
+        omp::LightOffsets writeToBuffer(omp::UniformRingBuffer& buffer);
     };
 }
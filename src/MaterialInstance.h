@@ -26,10 +26,10 @@ namespace omp
         void setAmbient(glm::vec4 new_ambient){ m_Ambient = new_ambient; }
         glm::vec4 getAmbient() const { return m_Ambient; }
 
-        void setDiffusive(glm::vec4 new_diffusive){ m_Ambient = new_diffusive; }
+        void setDiffusive(glm::vec4 new_diffusive){ m_Diffusive = new_diffusive; }
         glm::vec4 getDiffusive() const { return m_Diffusive; }
 
-        void setSpecular(glm::vec4 new_specular){ m_Ambient = new_specular; }
+        void setSpecular(glm::vec4 new_specular){ m_Specular = new_specular; }
         glm::vec4 getSpecular() const { return m_Specular; }
 
         friend class MaterialPanel;
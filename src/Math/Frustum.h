@@ -0,0 +1,47 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <array>
+
+namespace omp
+{
+    /**
+     * Six planes of a view projection, normals point inside.
+     * Expects clip space depth in [0, 1] as used by vulkan.
+     */
+    struct Frustum
+    {
+        // xyz is normal, w is distance, inside when dot(normal, point) + w >= 0
+        std::array<glm::vec4, 6> planes{};
+
+        static Frustum fromMatrix(const glm::mat4& viewProjection)
+        {
+            const glm::vec4 row_x{viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]};
+            const glm::vec4 row_y{viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]};
+            const glm::vec4 row_z{viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]};
+            const glm::vec4 row_w{viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]};
+
+            Frustum frustum;
+            frustum.planes = {row_w + row_x, row_w - row_x,
+                              row_w + row_y, row_w - row_y,
+                              row_z, row_w - row_z};
+            // Normalized planes give real distances, so sphere radius can be compared directly
+            for (glm::vec4& plane: frustum.planes)
+            {
+                plane /= glm::length(glm::vec3(plane));
+            }
+            return frustum;
+        }
+
+        bool intersectsSphere(const glm::vec3& center, float radius) const
+        {
+            for (const glm::vec4& plane: planes)
+            {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
@@ -11,12 +11,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <chrono>
+#include <cmath>
 
 #include "IO/stb_image.h"
 #include "UI/CameraPanel.h"
 #include "UI/EntityPanel.h"
 #include "UI/GlobalLightPanel.h"
 #include "UI/MainLayer.h"
+#include "UI/MemoryPanel.h"
+#include "UI/ProfilerPanel.h"
+#include "UI/StatsOverlay.h"
 #include "UI/ScenePanel.h"
 #include "UI/ViewPort.h"
 #include "backends/imgui_impl_glfw.h"
@@ -25,6 +29,7 @@
 
 #include "ImGuizmo/ImGuizmo.h"
 #include "Logs.h"
+#include "Async/ThreadPool.h"
 #include "Rendering/ModelStatics.h"
 
 #ifdef NDEBUG
@@ -39,10 +44,13 @@ namespace
             "VK_LAYER_KHRONOS_validation"};
 
     const std::vector<const char*> g_DeviceExtensions{
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+            VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+            VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
 } // namespace
 
 omp::Renderer::Renderer()
+    : m_ValidationLayers(g_EnableValidationLayers)
 {
 }
 
@@ -51,7 +59,10 @@ void omp::Renderer::initVulkan(GLFWwindow* window)
     m_Window = window;
     createInstance();
     setupDebugMessenger();
-    createSurface(window);
+    if (!m_Headless)
+    {
+        createSurface(window);
+    }
     pickPhysicalDevice();
     createLogicalDevice();
     createSwapChain();
@@ -62,12 +73,20 @@ void omp::Renderer::initResources(omp::Scene* scene)
     m_CurrentScene = scene;
 
     createImguiWidgets();
+    if (m_Headless)
+    {
+        m_RenderViewport->setSize({static_cast<float>(m_HeadlessExtent.width),
+                                   static_cast<float>(m_HeadlessExtent.height)});
+    }
     postSwapChainInitialize();
     createLights();
     createImageViews();
     createRenderPass();
+    createPickingRenderPass();
     createDescriptorSetLayout();
+    createOitTargets();
     createGraphicsPipeline();
+    createGpuCulling();
     createMaterialManager();
     createColorResources();
     createViewportResources();
@@ -75,13 +94,17 @@ void omp::Renderer::initResources(omp::Scene* scene)
     createDepthResources();
     createFramebuffers();
     // TODO: need window, maybe separate imguie resources
-    initializeImgui(m_Window);
+    if (!m_Headless)
+    {
+        initializeImgui(m_Window);
+    }
 
     createUniformBuffers();
     createDescriptorPool();
     createDescriptorSets();
-    m_CommandBuffers.resize(m_PresentKHRImagesNum);
-    m_ImguiCommandBuffers.resize(m_PresentKHRImagesNum);
+    createFrameCommandPools();
+    createGpuProfiler();
+    createStatisticsQueries();
     createSyncObjects();
 
 }
@@ -91,14 +114,13 @@ void omp::Renderer::requestDrawFrame(float deltaTime)
     drawFrame();
     postFrame();
     tick(deltaTime);
-
-    vkDeviceWaitIdle(m_LogicalDevice);
 }
 
 void omp::Renderer::cleanup()
 {
-    vkFreeMemory(m_LogicalDevice, m_PixelReadMemory, nullptr);
-    vkDestroyBuffer(m_LogicalDevice, m_PixelReadBuffer, nullptr);
+    vkDeviceWaitIdle(m_LogicalDevice);
+
+    m_VulkanContext->destroyBuffer(m_PixelReadBuffer, m_PixelReadMemory);
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
@@ -108,38 +130,61 @@ void omp::Renderer::cleanup()
     }
 
     cleanupSwapChain();
+    m_OitTargets.reset();
+    destroyPickingResources();
+    destroyInstanceBuffers();
+    m_GpuCulling.reset();
+    m_GpuProfiler.reset();
+    vkDestroyQueryPool(m_LogicalDevice, m_StatisticsQueryPool, nullptr);
+    m_PickingRenderPass->destroyInnerState();
 
     destroyAllCommandBuffers();
     vkDestroyCommandPool(m_LogicalDevice, m_CommandPool, nullptr);
-    vkDestroyCommandPool(m_LogicalDevice, m_ImguiCommandPool, nullptr);
+    for (VkCommandPool pool: m_FrameCommandPools)
+    {
+        vkDestroyCommandPool(m_LogicalDevice, pool, nullptr);
+    }
+    // Secondary buffers are freed together with their pools
+    for (VkCommandPool pool: m_SecondaryCommandPools)
+    {
+        vkDestroyCommandPool(m_LogicalDevice, pool, nullptr);
+    }
 
-    if (g_EnableValidationLayers)
+    if (m_ValidationLayers)
     {
         DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, nullptr);
     }
 
-    m_UboBuffer.reset();
-    m_OutlineBuffer.reset();
+    m_UniformRing.reset();
     m_LightSystem.reset();
 
     vkDestroyDescriptorSetLayout(m_LogicalDevice, m_UboDescriptorSetLayout,
                                  nullptr);
     vkDestroyDescriptorSetLayout(m_LogicalDevice, m_OutlineSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(m_LogicalDevice, m_SkyboxSetLayout, nullptr);
-    vkDestroyDescriptorSetLayout(m_LogicalDevice, m_TexturesDescriptorSetLayout,
-                                 nullptr);
+    m_VulkanContext->destroyBindlessTextures();
     vkDestroyDescriptorPool(m_LogicalDevice, m_DescriptorPool, nullptr);
 
     //omp::MaterialManager::getMaterialManager().clearGpuState();
 
-    ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-    vkDestroyDescriptorPool(m_LogicalDevice, m_ImguiDescriptorPool, nullptr);
+    if (!m_Headless)
+    {
+        ImGui_ImplVulkan_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+        vkDestroyDescriptorPool(m_LogicalDevice, m_ImguiDescriptorPool, nullptr);
+    }
 
+    m_VulkanContext->destroyUploadManager();
+    // Models may outlive renderer, their geometry is released here
+    m_GeometryPool->destroy();
+    m_VulkanContext->destroyMemoryAllocator();
     vkDestroyDevice(m_LogicalDevice, nullptr);
 
-    vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+    if (m_Surface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+    }
 
     vkDestroyInstance(m_Instance, nullptr);
 
@@ -159,7 +204,7 @@ void omp::Renderer::createInstance()
     create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     create_info.pApplicationInfo = &app_info;
     VkDebugUtilsMessengerCreateInfoEXT debug_create_info;
-    if (g_EnableValidationLayers)
+    if (m_ValidationLayers)
     {
         create_info.enabledLayerCount =
                 static_cast<uint32_t>(g_ValidationLayers.size());
@@ -197,7 +242,7 @@ void omp::Renderer::createInstance()
         INFO(LogRendering, ext.extensionName);
     }
 
-    if (g_EnableValidationLayers && !checkValidationLayerSupport())
+    if (m_ValidationLayers && !checkValidationLayerSupport())
     {
         throw std::runtime_error("validation layers requested, but not available");
     }
@@ -233,22 +278,42 @@ bool omp::Renderer::checkValidationLayerSupport()
 
 std::vector<const char*> omp::Renderer::getRequiredExtensions()
 {
-    uint32_t glfw_extensions_count = 0;
-    const char** glfw_extensions;
+    std::vector<const char*> extensions;
+    // Surface extensions come from glfw, headless instance does not initialize it
+    if (!m_Headless)
+    {
+        uint32_t glfw_extensions_count = 0;
+        const char** glfw_extensions;
 
-    glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extensions_count);
-    std::vector<const char*> extensions(glfw_extensions,
-                                        glfw_extensions + glfw_extensions_count);
-    if (g_EnableValidationLayers)
+        glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extensions_count);
+        extensions.assign(glfw_extensions, glfw_extensions + glfw_extensions_count);
+    }
+    if (m_ValidationLayers)
     {
         extensions.push_back("VK_EXT_debug_utils");
     }
     return extensions;
 }
 
+std::vector<const char*> omp::Renderer::getDeviceExtensions() const
+{
+    std::vector<const char*> extensions = g_DeviceExtensions;
+    if (m_Headless)
+    {
+        // Only presentation needs a swapchain
+        extensions.erase(std::remove_if(extensions.begin(), extensions.end(),
+                                        [](const char* extension)
+                                        {
+                                            return std::string(extension) == VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+                                        }),
+                         extensions.end());
+    }
+    return extensions;
+}
+
 void omp::Renderer::setupDebugMessenger()
 {
-    if (!g_EnableValidationLayers)
+    if (!m_ValidationLayers)
     {
         return;
     }
@@ -290,12 +355,21 @@ void omp::Renderer::pickPhysicalDevice()
     std::vector<VkPhysicalDevice> devices(device_count);
     vkEnumeratePhysicalDevices(m_Instance, &device_count, devices.data());
 
+    // Discrete gpu is preferred, any other suitable device like lavapipe on CI is a fallback
     for (const auto& device: devices)
     {
-        if (isDeviceSuitable(device))
+        if (!isDeviceSuitable(device))
+        {
+            continue;
+        }
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (m_PhysDevice == VK_NULL_HANDLE || properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
         {
             m_PhysDevice = device;
-            m_MSAASamples = getMaxUsableSampleCount();
+        }
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+        {
             break;
         }
     }
@@ -303,23 +377,55 @@ void omp::Renderer::pickPhysicalDevice()
     {
         throw std::runtime_error("Failed to find suitable gpu");
     }
+    m_MSAASamples = getMaxUsableSampleCount();
     VkPhysicalDeviceProperties physical_device_properties;
     vkGetPhysicalDeviceProperties(m_PhysDevice, &physical_device_properties);
     m_DeviceLimits = physical_device_properties.limits;
+    INFO(LogRendering, "Picked physical device {}", physical_device_properties.deviceName);
+
+    // Optional for gpu driven rendering, culled draws fall back to plain indirect draws
+    uint32_t extension_count;
+    vkEnumerateDeviceExtensionProperties(m_PhysDevice, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(m_PhysDevice, nullptr, &extension_count, available_extensions.data());
+    m_DrawIndirectCountSupported = std::any_of(
+            available_extensions.begin(), available_extensions.end(),
+            [](const VkExtensionProperties& extension)
+            {
+                return std::string(extension.extensionName) == VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+            });
+    m_CalibratedTimestampsSupported = std::any_of(
+            available_extensions.begin(), available_extensions.end(),
+            [](const VkExtensionProperties& extension)
+            {
+                return std::string(extension.extensionName) == VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+            }) && omp::GpuProfiler::canCalibrate(m_Instance, m_PhysDevice);
+    m_MemoryBudgetSupported = std::any_of(
+            available_extensions.begin(), available_extensions.end(),
+            [](const VkExtensionProperties& extension)
+            {
+                return std::string(extension.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+            });
+    if (!m_MemoryBudgetSupported)
+    {
+        INFO(LogRendering, "VK_EXT_memory_budget is not supported, heap budgets are estimated from heap sizes");
+    }
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(m_PhysDevice, &supported_features);
+    m_MultiDrawIndirectSupported = supported_features.multiDrawIndirect;
+    m_PipelineStatisticsSupported = supported_features.pipelineStatisticsQuery && supported_features.inheritedQueries;
 }
 
 bool omp::Renderer::isDeviceSuitable(VkPhysicalDevice device)
 {
-    VkPhysicalDeviceProperties properties;
-    vkGetPhysicalDeviceProperties(device, &properties);
     VkPhysicalDeviceFeatures features;
     vkGetPhysicalDeviceFeatures(device, &features);
     auto indices = findQueueFamilies(device);
 
     bool extensions_supported = checkDeviceExtensionSupport(device);
 
-    bool swap_chain_adequate = false;
-    if (extensions_supported)
+    bool swap_chain_adequate = m_Headless;
+    if (extensions_supported && !m_Headless)
     {
         SwapChainSupportDetails swap_chain_support = querySwapChainSupport(device);
         swap_chain_adequate = !swap_chain_support.formats.empty() &&
@@ -329,10 +435,26 @@ bool omp::Renderer::isDeviceSuitable(VkPhysicalDevice device)
     VkPhysicalDeviceFeatures supported_features;
     vkGetPhysicalDeviceFeatures(device, &supported_features);
 
-    return properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
-           features.geometryShader && indices.IsComplete() &&
+    // Material textures are bindless
+    bool bindless_supported = false;
+    if (extensions_supported)
+    {
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features{};
+        indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &indexing_features;
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+        bindless_supported = indexing_features.runtimeDescriptorArray &&
+                             indexing_features.descriptorBindingPartiallyBound &&
+                             indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+                             indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+                             indexing_features.shaderSampledImageArrayNonUniformIndexing;
+    }
+
+    return features.geometryShader && indices.IsComplete() &&
            extensions_supported && swap_chain_adequate &&
-           supported_features.samplerAnisotropy;
+           supported_features.samplerAnisotropy && supported_features.independentBlend && bindless_supported;
 }
 
 omp::Renderer::QueueFamilyIndices
@@ -354,12 +476,20 @@ omp::Renderer::findQueueFamilies(VkPhysicalDevice device)
         {
             indices.graphics_family = i;
         }
-        VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface,
-                                             &present_support);
-        if (present_support)
+        if (m_Headless)
+        {
+            // Nothing is presented, present queue is just the graphics one
+            indices.present_family = indices.graphics_family;
+        }
+        else
         {
-            indices.present_family = i;
+            VkBool32 present_support = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface,
+                                                 &present_support);
+            if (present_support)
+            {
+                indices.present_family = i;
+            }
         }
         if (indices.IsComplete())
         {
@@ -368,6 +498,16 @@ omp::Renderer::findQueueFamilies(VkPhysicalDevice device)
         i++;
     }
 
+    for (uint32_t family = 0; family < queue_family_count; family++)
+    {
+        const VkQueueFlags flags = queue_families[family].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            indices.transfer_family = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -376,8 +516,10 @@ void omp::Renderer::createLogicalDevice()
     QueueFamilyIndices indices = findQueueFamilies(m_PhysDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
+    const uint32_t transfer_family = indices.transfer_family.value_or(indices.graphics_family.value());
     std::set<uint32_t> unique_queue_families = {indices.graphics_family.value(),
-                                                indices.present_family.value()};
+                                                indices.present_family.value(),
+                                                transfer_family};
 
     float queue_priority = 1.f;
     for (uint32_t queue_family: unique_queue_families)
@@ -392,19 +534,47 @@ void omp::Renderer::createLogicalDevice()
 
     VkPhysicalDeviceFeatures device_features{};
     device_features.samplerAnisotropy = VK_TRUE;
+    // Accumulation and revealage of transparency blend differently
+    device_features.independentBlend = VK_TRUE;
+    device_features.multiDrawIndirect = m_MultiDrawIndirectSupported ? VK_TRUE : VK_FALSE;
+    device_features.pipelineStatisticsQuery = m_PipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
+    device_features.inheritedQueries = m_PipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
+
+    std::vector<const char*> device_extensions = getDeviceExtensions();
+    if (m_DrawIndirectCountSupported)
+    {
+        device_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+    if (m_CalibratedTimestampsSupported)
+    {
+        device_extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    }
+    if (m_MemoryBudgetSupported)
+    {
+        device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features{};
+    indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    indexing_features.runtimeDescriptorArray = VK_TRUE;
+    indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+    indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
 
     VkDeviceCreateInfo create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    create_info.pNext = &indexing_features;
     create_info.queueCreateInfoCount =
             static_cast<uint32_t>(queue_create_infos.size());
     create_info.pQueueCreateInfos = queue_create_infos.data();
     create_info.pEnabledFeatures = &device_features;
 
     create_info.enabledExtensionCount =
-            static_cast<uint32_t>(g_DeviceExtensions.size());
-    create_info.ppEnabledExtensionNames = g_DeviceExtensions.data();
+            static_cast<uint32_t>(device_extensions.size());
+    create_info.ppEnabledExtensionNames = device_extensions.data();
 
-    if (g_EnableValidationLayers)
+    if (m_ValidationLayers)
     {
         create_info.enabledLayerCount =
                 static_cast<uint32_t>(g_ValidationLayers.size());
@@ -425,13 +595,18 @@ void omp::Renderer::createLogicalDevice()
                      &m_GraphicsQueue);
     vkGetDeviceQueue(m_LogicalDevice, indices.present_family.value(), 0,
                      &m_PresentQueue);
+    vkGetDeviceQueue(m_LogicalDevice, transfer_family, 0, &m_TransferQueue);
 
     createCommandPool();
     m_VulkanContext = std::make_shared<omp::VulkanContext>(
-            m_LogicalDevice, m_PhysDevice, m_CommandPool, m_GraphicsQueue);
+            m_LogicalDevice, m_PhysDevice, m_CommandPool, m_GraphicsQueue, m_MemoryBudgetSupported);
+    m_VulkanContext->setUploadManager(std::make_unique<omp::UploadManager>(
+            m_VulkanContext, m_TransferQueue, transfer_family, indices.graphics_family.value()));
+    m_GeometryPool = std::make_shared<omp::GeometryPool>(m_VulkanContext, MAX_FRAMES_IN_FLIGHT);
     //omp::MaterialManager::getMaterialManager().specifyVulkanContext(
     //        m_VulkanContext);
     m_RenderPass = std::make_shared<omp::RenderPass>(m_LogicalDevice);
+    m_PickingRenderPass = std::make_shared<omp::RenderPass>(m_LogicalDevice);
     m_ImguiRenderPass = std::make_shared<omp::RenderPass>(m_LogicalDevice);
 }
 
@@ -453,8 +628,9 @@ bool omp::Renderer::checkDeviceExtensionSupport(VkPhysicalDevice device)
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count,
                                          available_extensions.data());
 
-    std::set<std::string> required_extensions(g_DeviceExtensions.begin(),
-                                              g_DeviceExtensions.end());
+    const std::vector<const char*> device_extensions = getDeviceExtensions();
+    std::set<std::string> required_extensions(device_extensions.begin(),
+                                              device_extensions.end());
 
     for (const auto& extension: available_extensions)
     {
@@ -511,20 +687,6 @@ VkSurfaceFormatKHR omp::Renderer::chooseSwapSurfaceFormat(
     return availableFormats[0];
 }
 
-VkPresentModeKHR omp::Renderer::chooseSwapPresentMode(
-        const std::vector<VkPresentModeKHR>& availablePresentModes)
-{
-    for (const auto& available_presentation_mode: availablePresentModes)
-    {
-        if (available_presentation_mode == VK_PRESENT_MODE_MAILBOX_KHR)
-        {
-            return available_presentation_mode;
-        }
-    }
-
-    return VK_PRESENT_MODE_FIFO_KHR;
-}
-
 VkExtent2D
 omp::Renderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
 {
@@ -563,21 +725,27 @@ omp::Renderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
 
 void omp::Renderer::createSwapChain()
 {
+    if (m_Headless)
+    {
+        // Same format as a usual surface, so main pass stays the same as in windowed run
+        m_PresentKHRImagesNum = MAX_FRAMES_IN_FLIGHT;
+        m_SwapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+        m_SwapChainExtent = m_HeadlessExtent;
+        return;
+    }
+
     SwapChainSupportDetails swap_chain_support =
             querySwapChainSupport(m_PhysDevice);
 
     VkSurfaceFormatKHR surface_format =
             chooseSwapSurfaceFormat(swap_chain_support.formats);
-    VkPresentModeKHR present_mode =
-            chooseSwapPresentMode(swap_chain_support.present_modes);
+    const omp::PresentChoice presentation =
+            omp::choosePresentation(m_PresentSettings, swap_chain_support.present_modes,
+                                    swap_chain_support.capabilities.minImageCount,
+                                    swap_chain_support.capabilities.maxImageCount);
     VkExtent2D extent = chooseSwapExtent(swap_chain_support.capabilities);
 
-    m_PresentKHRImagesNum = swap_chain_support.capabilities.minImageCount + 1;
-    if (swap_chain_support.capabilities.maxImageCount > 0 &&
-        m_PresentKHRImagesNum > swap_chain_support.capabilities.maxImageCount)
-    {
-        m_PresentKHRImagesNum = swap_chain_support.capabilities.maxImageCount;
-    }
+    m_PresentKHRImagesNum = presentation.image_count;
 
     VkSwapchainCreateInfoKHR create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -607,15 +775,23 @@ void omp::Renderer::createSwapChain()
     }
     create_info.preTransform = swap_chain_support.capabilities.currentTransform;
     create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    create_info.presentMode = present_mode;
+    create_info.presentMode = presentation.mode;
     create_info.clipped = VK_TRUE;
-    create_info.oldSwapchain = VK_NULL_HANDLE;
+    // Old swapchain is retired, presents already queued to it still complete
+    create_info.oldSwapchain = m_SwapChain;
 
+    VkSwapchainKHR swap_chain = VK_NULL_HANDLE;
     if (vkCreateSwapchainKHR(m_LogicalDevice, &create_info, nullptr,
-                             &m_SwapChain) != VK_SUCCESS)
+                             &swap_chain) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create swap chain!");
     }
+    if (m_SwapChain != VK_NULL_HANDLE)
+    {
+        m_RetiredSwapChains.push_back({m_SwapChain, MAX_FRAMES_IN_FLIGHT});
+    }
+    m_SwapChain = swap_chain;
+    m_PresentMode = presentation.mode;
 
     vkGetSwapchainImagesKHR(m_LogicalDevice, m_SwapChain, &m_PresentKHRImagesNum,
                             nullptr);
@@ -625,17 +801,19 @@ void omp::Renderer::createSwapChain()
 
     m_SwapChainImageFormat = surface_format.format;
     m_SwapChainExtent = extent;
+    INFO(LogRendering, "Swapchain created with {} images and present mode {}", m_PresentKHRImagesNum,
+         static_cast<int>(m_PresentMode));
 }
 
 void omp::Renderer::postSwapChainInitialize()
 {
-    m_LightSystem = std::make_unique<omp::LightSystem>(m_VulkanContext,
-                                                       m_PresentKHRImagesNum);
+    m_LightSystem = std::make_unique<omp::LightSystem>();
 
     m_VulkanContext->createBuffer(sizeof(int32_t),
                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                  m_PixelReadBuffer, m_PixelReadMemory);
+                                  m_PixelReadBuffer, m_PixelReadMemory, omp::EMemoryCategory::Other);
 }
 
 void omp::Renderer::prepareSceneForRendering()
@@ -652,8 +830,8 @@ void omp::Renderer::prepareSceneForRendering()
 
 void omp::Renderer::createImageViews()
 {
-    m_SwapChainImageViews.resize(m_PresentKHRImagesNum);
-    for (size_t i = 0; i < m_PresentKHRImagesNum; i++)
+    m_SwapChainImageViews.resize(m_SwapChainImages.size());
+    for (size_t i = 0; i < m_SwapChainImages.size(); i++)
     {
         m_SwapChainImageViews[i] = m_VulkanContext->createImageView(
                 m_SwapChainImages[i], m_SwapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT,
@@ -706,18 +884,54 @@ void omp::Renderer::createGraphicsPipeline()
     std::unique_ptr<omp::GraphicsPipeline> light_pipe =
             std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
     light_pipe->startDefaultCreation();
-    light_pipe->addColorBlendingAttachment(color_blend_attachment);
+    light_pipe->createInstancedVertexInfo();
     light_pipe->addColorBlendingAttachment(color_blend_attachment);
     light_pipe->createMultisamplingInfo(m_MSAASamples);
     light_pipe->createViewport(m_SwapChainExtent);
-    light_pipe->definePushConstant<omp::ModelPushConstant>(
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
     light_pipe->addPipelineSetLayout(m_UboDescriptorSetLayout);
-    light_pipe->addPipelineSetLayout(m_TexturesDescriptorSetLayout);
+    light_pipe->addPipelineSetLayout(m_VulkanContext->getBindlessTextures()->getSetLayout());
     light_pipe->createShaders(light_shader);
     light_pipe->setDepthStencil(depth_stencil);
     light_pipe->confirmCreation(m_RenderPass);
 
+    // Depth pre-pass, position only and without fragment stage
+    std::shared_ptr<omp::Shader> depth_shader = std::make_shared<omp::Shader>(
+            m_VulkanContext, "../SPRV/depthPrepassvert.spv", "");
+    VkPipelineColorBlendAttachmentState depth_blend_attachment{};
+    depth_blend_attachment.colorWriteMask = 0;
+    depth_blend_attachment.blendEnable = VK_FALSE;
+    std::unique_ptr<omp::GraphicsPipeline> depth_pipe =
+            std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
+    depth_pipe->startDefaultCreation();
+    depth_pipe->createInstancedVertexInfo();
+    depth_pipe->addColorBlendingAttachment(depth_blend_attachment);
+    depth_pipe->createMultisamplingInfo(m_MSAASamples);
+    depth_pipe->createViewport(m_SwapChainExtent);
+    // Same layout as lit pipelines, so bound sets stay valid between them
+    depth_pipe->addPipelineSetLayout(m_UboDescriptorSetLayout);
+    depth_pipe->addPipelineSetLayout(m_VulkanContext->getBindlessTextures()->getSetLayout());
+    depth_pipe->createShaders(depth_shader);
+    depth_pipe->setDepthStencil(depth_stencil);
+    depth_pipe->confirmCreation(m_RenderPass);
+
+    // Light pipeline after the pre-pass, only the front fragment passes
+    std::unique_ptr<omp::GraphicsPipeline> light_equal_pipe =
+            std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
+    light_equal_pipe->startDefaultCreation();
+    light_equal_pipe->createInstancedVertexInfo();
+    light_equal_pipe->addColorBlendingAttachment(color_blend_attachment);
+    light_equal_pipe->createMultisamplingInfo(m_MSAASamples);
+    light_equal_pipe->createViewport(m_SwapChainExtent);
+    light_equal_pipe->addPipelineSetLayout(m_UboDescriptorSetLayout);
+    light_equal_pipe->addPipelineSetLayout(m_VulkanContext->getBindlessTextures()->getSetLayout());
+    light_equal_pipe->createShaders(light_shader);
+    depth_stencil.depthWriteEnable = VK_FALSE;
+    depth_stencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
+    light_equal_pipe->setDepthStencil(depth_stencil);
+    light_equal_pipe->confirmCreation(m_RenderPass);
+    depth_stencil.depthWriteEnable = VK_TRUE;
+    depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
     std::shared_ptr<omp::Shader> skybox_shader = std::make_shared<omp::Shader>(
             m_VulkanContext, "../SPRV/skyboxvert.spv", "../SPRV/skyboxfrag.spv");
 
@@ -725,14 +939,13 @@ void omp::Renderer::createGraphicsPipeline()
             std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
     skybox_pipe->startDefaultCreation();
     skybox_pipe->addColorBlendingAttachment(color_blend_attachment);
-    skybox_pipe->addColorBlendingAttachment(color_blend_attachment);
     skybox_pipe->createMultisamplingInfo(m_MSAASamples);
     skybox_pipe->createViewport(m_SwapChainExtent);
     // ?
     // skybox_pipe->definePushConstant<omp::ModelPushConstant>(VK_SHADER_STAGE_VERTEX_BIT
     // | VK_SHADER_STAGE_FRAGMENT_BIT);
     skybox_pipe->addPipelineSetLayout(m_SkyboxSetLayout);
-    // ? skybox_pipe->addPipelineSetLayout(m_TexturesDescriptorSetLayout);
+    // ? skybox_pipe->addPipelineSetLayout(m_BindlessTextures->getSetLayout());
     depth_stencil.depthTestEnable = VK_TRUE;
     skybox_pipe->setDepthStencil(depth_stencil);
     skybox_pipe->createShaders(skybox_shader);
@@ -746,14 +959,12 @@ void omp::Renderer::createGraphicsPipeline()
     std::unique_ptr<omp::GraphicsPipeline> pipe =
             std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
     pipe->startDefaultCreation();
-    pipe->addColorBlendingAttachment(color_blend_attachment);
+    pipe->createInstancedVertexInfo();
     pipe->addColorBlendingAttachment(color_blend_attachment);
     pipe->createMultisamplingInfo(m_MSAASamples);
     pipe->createViewport(m_SwapChainExtent);
-    pipe->definePushConstant<omp::ModelPushConstant>(
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
     pipe->addPipelineSetLayout(m_UboDescriptorSetLayout);
-    pipe->addPipelineSetLayout(m_TexturesDescriptorSetLayout);
+    pipe->addPipelineSetLayout(m_VulkanContext->getBindlessTextures()->getSetLayout());
     pipe->setDepthStencil(depth_stencil);
     pipe->createShaders(shader);
     pipe->confirmCreation(m_RenderPass);
@@ -774,37 +985,54 @@ void omp::Renderer::createGraphicsPipeline()
     rasterization_state.depthBiasConstantFactor = 0.0f;
     rasterization_state.depthBiasClamp = 0.0f;
     rasterization_state.depthBiasSlopeFactor = 0.0f;
+    // Blended materials accumulate in any order, color adds up and revealage multiplies down
+    VkPipelineColorBlendAttachmentState accum_blend_attachment{};
+    accum_blend_attachment.colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    accum_blend_attachment.blendEnable = VK_TRUE;
+    accum_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    accum_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    accum_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    accum_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    accum_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    accum_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    VkPipelineColorBlendAttachmentState revealage_blend_attachment = accum_blend_attachment;
+    revealage_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
+    revealage_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    revealage_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+
     std::unique_ptr<omp::GraphicsPipeline> grass_pipe =
             std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
     grass_pipe->startDefaultCreation();
-    color_blend_attachment.blendEnable = VK_TRUE;
-    grass_pipe->addColorBlendingAttachment(color_blend_attachment);
-    color_blend_attachment.blendEnable = VK_FALSE;
-    grass_pipe->addColorBlendingAttachment(color_blend_attachment);
+    grass_pipe->createInstancedVertexInfo();
+    grass_pipe->addColorBlendingAttachment(accum_blend_attachment);
+    grass_pipe->addColorBlendingAttachment(revealage_blend_attachment);
     grass_pipe->createMultisamplingInfo(m_MSAASamples);
     grass_pipe->createViewport(m_SwapChainExtent);
     grass_pipe->createRasterizer(rasterization_state);
-    grass_pipe->definePushConstant<omp::ModelPushConstant>(
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
     grass_pipe->addPipelineSetLayout(m_UboDescriptorSetLayout);
-    grass_pipe->addPipelineSetLayout(m_TexturesDescriptorSetLayout);
+    grass_pipe->addPipelineSetLayout(m_VulkanContext->getBindlessTextures()->getSetLayout());
+    // Hidden by opaque draws, but never hides anything itself
+    depth_stencil.depthTestEnable = VK_TRUE;
+    depth_stencil.depthWriteEnable = VK_FALSE;
     grass_pipe->setDepthStencil(depth_stencil);
+    depth_stencil.depthTestEnable = VK_FALSE;
+    depth_stencil.depthWriteEnable = VK_TRUE;
     grass_pipe->createShaders(blend_shader);
-    grass_pipe->confirmCreation(m_RenderPass);
+    grass_pipe->confirmCreation(m_RenderPass, g_TransparentSubpass);
 
     // LIGHT STENCIL
     color_blend_attachment.blendEnable = VK_FALSE;
     std::unique_ptr<omp::GraphicsPipeline> light_stencil =
             std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
     light_stencil->startDefaultCreation();
-    light_stencil->addColorBlendingAttachment(color_blend_attachment);
+    light_stencil->createInstancedVertexInfo();
     light_stencil->addColorBlendingAttachment(color_blend_attachment);
     light_stencil->createMultisamplingInfo(m_MSAASamples);
     light_stencil->createViewport(m_SwapChainExtent);
-    light_stencil->definePushConstant<omp::ModelPushConstant>(
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
     light_stencil->addPipelineSetLayout(m_UboDescriptorSetLayout);
-    light_stencil->addPipelineSetLayout(m_TexturesDescriptorSetLayout);
+    light_stencil->addPipelineSetLayout(m_VulkanContext->getBindlessTextures()->getSetLayout());
     light_stencil->createShaders(light_shader);
     depth_stencil.stencilTestEnable = VK_TRUE;
     light_stencil->setDepthStencil(depth_stencil);
@@ -817,7 +1045,6 @@ void omp::Renderer::createGraphicsPipeline()
             std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
     outline_pipe->startDefaultCreation();
     outline_pipe->addColorBlendingAttachment(color_blend_attachment);
-    outline_pipe->addColorBlendingAttachment(color_blend_attachment);
     outline_pipe->createMultisamplingInfo(m_MSAASamples);
     outline_pipe->createViewport(m_SwapChainExtent);
     outline_pipe->addPipelineSetLayout(m_OutlineSetLayout);
@@ -831,14 +1058,65 @@ void omp::Renderer::createGraphicsPipeline()
     depth_stencil.depthTestEnable = VK_FALSE;
     depth_stencil.stencilTestEnable = VK_TRUE;
     outline_pipe->setDepthStencil(depth_stencil);
-    outline_pipe->confirmCreation(m_RenderPass);
+    outline_pipe->confirmCreation(m_RenderPass, g_CompositeSubpass);
+
+    // Transparency composite, averaged transparent color goes over opaque one by revealage
+    std::shared_ptr<omp::Shader> composite_shader = std::make_shared<omp::Shader>(
+            m_VulkanContext, "../SPRV/oitCompositevert.spv",
+            m_OitTargets->isMultisampled() ? "../SPRV/oitCompositeMsfrag.spv" : "../SPRV/oitCompositefrag.spv");
+    std::unique_ptr<omp::GraphicsPipeline> composite_pipe =
+            std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
+    composite_pipe->startDefaultCreation();
+    composite_pipe->createEmptyVertexInfo();
+    color_blend_attachment.blendEnable = VK_TRUE;
+    composite_pipe->addColorBlendingAttachment(color_blend_attachment);
+    color_blend_attachment.blendEnable = VK_FALSE;
+    composite_pipe->createMultisamplingInfo(m_MSAASamples);
+    composite_pipe->createViewport(m_SwapChainExtent);
+    composite_pipe->createRasterizer(rasterization_state);
+    composite_pipe->definePushConstant<omp::OitTargets::CompositePushConstant>(VK_SHADER_STAGE_FRAGMENT_BIT);
+    composite_pipe->addPipelineSetLayout(m_OitTargets->getSetLayout());
+    composite_pipe->createShaders(composite_shader);
+    depth_stencil.stencilTestEnable = VK_FALSE;
+    composite_pipe->setDepthStencil(depth_stencil);
+    composite_pipe->confirmCreation(m_RenderPass, g_CompositeSubpass);
+
+    // Picking pipeline
+    std::shared_ptr<omp::Shader> picking_shader = std::make_shared<omp::Shader>(
+            m_VulkanContext, "../SPRV/pickingvert.spv", "../SPRV/pickingfrag.spv");
+    VkPipelineColorBlendAttachmentState picking_blend_attachment{};
+    picking_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
+    picking_blend_attachment.blendEnable = VK_FALSE;
+    std::unique_ptr<omp::GraphicsPipeline> picking_pipe =
+            std::make_unique<omp::GraphicsPipeline>(m_LogicalDevice);
+    picking_pipe->startDefaultCreation();
+    picking_pipe->addColorBlendingAttachment(picking_blend_attachment);
+    picking_pipe->createMultisamplingInfo(VK_SAMPLE_COUNT_1_BIT);
+    picking_pipe->createViewport(g_PickingExtent);
+    // both sides of quads should be pickable
+    picking_pipe->createRasterizer(rasterization_state);
+    picking_pipe->definePushConstant<omp::ModelPushConstant>(
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+    picking_pipe->addPipelineSetLayout(m_UboDescriptorSetLayout);
+    picking_pipe->createShaders(picking_shader);
+    depth_stencil.depthTestEnable = VK_TRUE;
+    depth_stencil.depthWriteEnable = VK_TRUE;
+    depth_stencil.stencilTestEnable = VK_FALSE;
+    picking_pipe->setDepthStencil(depth_stencil);
+    picking_pipe->confirmCreation(m_PickingRenderPass);
 
+    m_TransparentPipelines.insert(grass_pipe.get());
     m_Pipelines.insert({"Light", std::move(light_pipe)});
     m_Pipelines.insert({"Simple", std::move(pipe)});
     m_Pipelines.insert({"Outline", std::move(outline_pipe)});
     m_Pipelines.insert({"LightStencil", std::move(light_stencil)});
     m_Pipelines.insert({"Grass", std::move(grass_pipe)});
     m_Pipelines.insert({"Skybox", std::move(skybox_pipe)});
+    m_Pipelines.insert({"Picking", std::move(picking_pipe)});
+    m_Pipelines.insert({"DepthPrepass", std::move(depth_pipe)});
+    m_Pipelines.insert({"OitComposite", std::move(composite_pipe)});
+    m_DepthEqualPipelines.insert(light_equal_pipe.get());
+    m_Pipelines.insert({"Light" + g_DepthEqualSuffix, std::move(light_equal_pipe)});
 }
 
 void omp::Renderer::createRenderPass()
@@ -857,24 +1135,11 @@ void omp::Renderer::createRenderPass()
     color_attachment_ref.attachment = 0;
     color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-    VkAttachmentDescription picking_attachment{};
-    picking_attachment.format = VK_FORMAT_R32_SINT;
-    picking_attachment.samples = m_MSAASamples;
-    picking_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    picking_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    picking_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    picking_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    picking_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    picking_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference picking_attach_ref{};
-    picking_attach_ref.attachment = 1;
-    picking_attach_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
     VkAttachmentDescription depth_attachment{};
     depth_attachment.format = findDepthFormat();
     depth_attachment.samples = m_MSAASamples;
     depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    // Depth pyramid is built from it after the pass
     depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -883,7 +1148,7 @@ void omp::Renderer::createRenderPass()
             VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentReference depth_attach_ref{};
-    depth_attach_ref.attachment = 2;
+    depth_attach_ref.attachment = 1;
     depth_attach_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentDescription color_attachment_resolve{};
@@ -898,47 +1163,75 @@ void omp::Renderer::createRenderPass()
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
     VkAttachmentReference color_attachment_resolve_ref{};
-    color_attachment_resolve_ref.attachment = 3;
+    color_attachment_resolve_ref.attachment = 2;
     color_attachment_resolve_ref.layout =
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    VkAttachmentDescription pick_resolve{};
-    pick_resolve.format = VK_FORMAT_R32_SINT;
-    pick_resolve.samples = VK_SAMPLE_COUNT_1_BIT;
-    pick_resolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    pick_resolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    pick_resolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    pick_resolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    pick_resolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    pick_resolve.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference pick_resolve_ref{};
-    pick_resolve_ref.attachment = 4;
-    pick_resolve_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    std::array<VkAttachmentReference, 2> refs{color_attachment_ref,
-                                              picking_attach_ref};
-    std::array<VkAttachmentReference, 2> resolve_refs{
-            color_attachment_resolve_ref, pick_resolve_ref};
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = refs.size();
-    subpass.pColorAttachments = refs.data();
-    subpass.pDepthStencilAttachment = &depth_attach_ref;
-    subpass.pResolveAttachments = resolve_refs.data();
+    // Transparency targets live only inside of the pass
+    VkAttachmentDescription accum_attachment{};
+    accum_attachment.format = omp::OitTargets::s_AccumFormat;
+    accum_attachment.samples = m_MSAASamples;
+    accum_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    accum_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    accum_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    accum_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    accum_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    accum_attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkAttachmentDescription revealage_attachment = accum_attachment;
+    revealage_attachment.format = omp::OitTargets::s_RevealageFormat;
+
+    std::array<VkAttachmentReference, 2> oit_write_refs{};
+    oit_write_refs[0] = {3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    oit_write_refs[1] = {4, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    std::array<VkAttachmentReference, 2> oit_read_refs{};
+    oit_read_refs[0] = {3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    oit_read_refs[1] = {4, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    const uint32_t preserved_color = 0;
+
+    std::array<VkSubpassDescription, 3> subpasses{};
+    subpasses[g_OpaqueSubpass].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[g_OpaqueSubpass].colorAttachmentCount = 1;
+    subpasses[g_OpaqueSubpass].pColorAttachments = &color_attachment_ref;
+    subpasses[g_OpaqueSubpass].pDepthStencilAttachment = &depth_attach_ref;
+
+    // Depth is tested but not written by transparent pipelines
+    subpasses[g_TransparentSubpass].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[g_TransparentSubpass].colorAttachmentCount = static_cast<uint32_t>(oit_write_refs.size());
+    subpasses[g_TransparentSubpass].pColorAttachments = oit_write_refs.data();
+    subpasses[g_TransparentSubpass].pDepthStencilAttachment = &depth_attach_ref;
+    subpasses[g_TransparentSubpass].preserveAttachmentCount = 1;
+    subpasses[g_TransparentSubpass].pPreserveAttachments = &preserved_color;
+
+    // Composite and outline draw over opaque color, resolve happens at the end
+    subpasses[g_CompositeSubpass].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[g_CompositeSubpass].colorAttachmentCount = 1;
+    subpasses[g_CompositeSubpass].pColorAttachments = &color_attachment_ref;
+    subpasses[g_CompositeSubpass].pDepthStencilAttachment = &depth_attach_ref;
+    subpasses[g_CompositeSubpass].inputAttachmentCount = static_cast<uint32_t>(oit_read_refs.size());
+    subpasses[g_CompositeSubpass].pInputAttachments = oit_read_refs.data();
+    subpasses[g_CompositeSubpass].pResolveAttachments = &color_attachment_resolve_ref;
 
     // Use subpass dependencies for layout transitions
+    // Color, depth and viewport images are shared by frames in flight,
+    // so previous frame writes and depth pyramid reads should finish before this one clears them
     VkSubpassDependency dependencies[2]{};
     dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependencies[0].dstSubpass = 0;
-    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstSubpass = g_OpaqueSubpass;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                   VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                                   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
-    dependencies[1].srcSubpass = 0;
+    dependencies[1].srcSubpass = g_CompositeSubpass;
     dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
     dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
@@ -946,22 +1239,132 @@ void omp::Renderer::createRenderPass()
     dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
     dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+    // Transparency tests against opaque depth, all of it stays in the same pixel
+    std::array<VkSubpassDependency, 3> inner_dependencies{};
+    inner_dependencies[0].srcSubpass = g_OpaqueSubpass;
+    inner_dependencies[0].dstSubpass = g_TransparentSubpass;
+    inner_dependencies[0].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    inner_dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    inner_dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    inner_dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    inner_dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    // Composite blends over opaque color, outline tests stencil of the selected entity
+    inner_dependencies[1].srcSubpass = g_OpaqueSubpass;
+    inner_dependencies[1].dstSubpass = g_CompositeSubpass;
+    inner_dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    inner_dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    inner_dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    inner_dependencies[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                          VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    inner_dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    // Composite reads accumulated targets, outline stencil writes wait for transparent depth tests
+    inner_dependencies[2].srcSubpass = g_TransparentSubpass;
+    inner_dependencies[2].dstSubpass = g_CompositeSubpass;
+    inner_dependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    inner_dependencies[2].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    inner_dependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    inner_dependencies[2].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    inner_dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
     m_RenderPass->startConfiguration();
 
     m_RenderPass->addAttachment(std::move(color_attachment));
-    m_RenderPass->addAttachment(std::move(picking_attachment));
     m_RenderPass->addAttachment(std::move(depth_attachment));
     m_RenderPass->addAttachment(std::move(color_attachment_resolve));
-    m_RenderPass->addAttachment(std::move(pick_resolve));
+    m_RenderPass->addAttachment(std::move(accum_attachment));
+    m_RenderPass->addAttachment(std::move(revealage_attachment));
 
     // reference leak if render pass not created in this method
-    m_RenderPass->addSubpass(std::move(subpass));
+    for (const VkSubpassDescription& subpass: subpasses)
+    {
+        m_RenderPass->addSubpass(VkSubpassDescription(subpass));
+    }
     m_RenderPass->addDependency(std::move(dependencies[0]));
+    for (const VkSubpassDependency& dependency: inner_dependencies)
+    {
+        m_RenderPass->addDependency(VkSubpassDependency(dependency));
+    }
     m_RenderPass->addDependency(std::move(dependencies[1]));
 
     m_RenderPass->endConfiguration();
 }
 
+void omp::Renderer::createPickingRenderPass()
+{
+    VkAttachmentDescription picking_attachment{};
+    picking_attachment.format = VK_FORMAT_R32_SINT;
+    picking_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    picking_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    picking_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    picking_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    picking_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    picking_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    picking_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference picking_attach_ref{};
+    picking_attach_ref.attachment = 0;
+    picking_attach_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription depth_attachment{};
+    depth_attachment.format = findDepthFormat();
+    depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depth_attachment.finalLayout =
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depth_attach_ref{};
+    depth_attach_ref.attachment = 1;
+    depth_attach_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &picking_attach_ref;
+    subpass.pDepthStencilAttachment = &depth_attach_ref;
+
+    // Previous pick copy should finish before clear, and id is copied right after the pass
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    m_PickingRenderPass->startConfiguration();
+
+    m_PickingRenderPass->addAttachment(std::move(picking_attachment));
+    m_PickingRenderPass->addAttachment(std::move(depth_attachment));
+
+    m_PickingRenderPass->addSubpass(std::move(subpass));
+    m_PickingRenderPass->addDependency(std::move(dependencies[0]));
+    m_PickingRenderPass->addDependency(std::move(dependencies[1]));
+
+    m_PickingRenderPass->endConfiguration();
+}
+
 void omp::Renderer::createFramebuffers()
 {
     m_SwapChainFramebuffers.resize(m_PresentKHRImagesNum);
@@ -974,9 +1377,9 @@ void omp::Renderer::createFramebuffers()
 
 void omp::Renderer::createFramebufferAtImage(size_t index)
 {
-    std::vector<VkImageView> attachments{m_ColorImageView, m_PickingImageView,
-                                         m_DepthImageView, m_ViewportImageView,
-                                         m_PickingResolveView};
+    std::vector<VkImageView> attachments{m_ColorImageView, m_DepthImageView,
+                                         m_ViewportImageView, m_OitTargets->getAccumView(),
+                                         m_OitTargets->getRevealageView()};
     omp::FrameBuffer frame_buffer(
             m_LogicalDevice, attachments, m_RenderPass,
             static_cast<uint32_t>(m_RenderViewport->getSize().x),
@@ -1002,184 +1405,262 @@ void omp::Renderer::createCommandPool()
 
 void omp::Renderer::prepareFrameForImage(size_t KHRImageIndex)
 {
-    prepareCommandBuffer(m_ImguiCommandBuffers[KHRImageIndex],
-                         m_ImguiCommandPool);
-
-    std::vector<VkClearValue> clear_value{1};
-    clear_value[0].color = g_ClearColor;
-
+    PROFILE_SCOPE("Record frame");
+    // Framebuffers are per swapchain image, everything else is per frame in flight
     VkRect2D rect{};
     // Main Render pass
-    VkCommandBuffer& main_buffer = m_CommandBuffers[KHRImageIndex].buffer;
-    prepareCommandBuffer(m_CommandBuffers[KHRImageIndex], m_CommandPool);
+    VkCommandBuffer& main_buffer = m_CommandBuffers[m_CurrentFrame].buffer;
+    prepareCommandBuffer(m_CommandBuffers[m_CurrentFrame],
+                         m_FrameCommandPools[m_CurrentFrame]);
 
-    std::vector<VkClearValue> clear_values{3};
-    clear_values[0].color = g_ClearColor;
-    clear_values[1].color = g_ClearColor;
-    clear_values[2].depthStencil = {1.0f, 0};
+    // Fence of the frame is waited, its timestamps are ready
+    m_GpuProfiler->beginFrame(main_buffer, static_cast<uint32_t>(m_CurrentFrame));
+    m_DrawStats.main_pass_ms = m_GpuProfiler->getLastScopeMs("Main pass");
+    const uint32_t main_pass_scope = m_GpuProfiler->beginScope(main_buffer, "Main pass");
 
-    rect.offset.x = 0;
-    rect.offset.y = 0;
-    rect.extent.height = static_cast<uint32_t>(m_RenderViewport->getSize().y);
-    rect.extent.width = static_cast<uint32_t>(m_RenderViewport->getSize().x);
-    beginRenderPass(m_RenderPass.get(), main_buffer,
-                    m_SwapChainFramebuffers[KHRImageIndex], clear_values, rect);
-    setViewport(main_buffer);
+    const uint32_t statistics_query = static_cast<uint32_t>(m_CurrentFrame);
+    const bool count_fragments = m_OverdrawStatistics && m_StatisticsQueryPool != VK_NULL_HANDLE;
+    uint64_t fragment_invocations = 0;
+    if (m_StatisticsWritten[m_CurrentFrame] &&
+        vkGetQueryPoolResults(m_LogicalDevice, m_StatisticsQueryPool, statistics_query, 1,
+                              sizeof(fragment_invocations), &fragment_invocations, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        const float pixels = m_RenderViewport->getSize().x * m_RenderViewport->getSize().y;
+        m_DrawStats.fragment_invocations = fragment_invocations;
+        m_DrawStats.overdraw = pixels > 0.f ? static_cast<float>(fragment_invocations) / pixels : 0.f;
+    }
+    if (count_fragments)
+    {
+        vkCmdResetQueryPool(main_buffer, m_StatisticsQueryPool, statistics_query, 1);
+    }
+    else
+    {
+        m_DrawStats.fragment_invocations = 0;
+        m_DrawStats.overdraw = 0.f;
+    }
+    m_StatisticsWritten[m_CurrentFrame] = count_fragments;
+
+    // Uploads finished since last frame become visible to everything recorded below
+    omp::UploadManager* uploads = m_VulkanContext->getUploadManager();
+    uploads->acquireFinished(main_buffer);
+
+    // Becomes visible once the whole frame is recorded, ui reads the previous one meanwhile
+    omp::RenderStats frame_stats;
+    if (!m_MousePickingData.empty())
+    {
+        const uint32_t picking_scope = m_GpuProfiler->beginScope(main_buffer, "Picking");
+        recordPickingPass(main_buffer, frame_stats);
+        m_GpuProfiler->endScope(main_buffer, picking_scope);
+    }
+
+    // Color, depth, resolve, accumulation and revealage
+    std::vector<VkClearValue> clear_values{5};
+    clear_values[0].color = g_ClearColor;
+    clear_values[1].depthStencil = {1.0f, 0};
+    clear_values[3].color = {{0.0f, 0.0f, 0.0f, 0.0f}};
+    clear_values[4].color = {{1.0f, 0.0f, 0.0f, 0.0f}};
 
     omp::SceneEntity* outline_entity = nullptr;
-    VkDeviceSize offsets[] = {0};
 
-    std::vector<std::unique_ptr<omp::SceneEntity>>& scene_ref =
-            m_CurrentScene->getEntities();
-    std::sort(
-            scene_ref.begin(), scene_ref.end(),
-            [this](
-                    const std::unique_ptr<omp::SceneEntity>& inEnt,
-                    const std::unique_ptr<omp::SceneEntity>& inEnt2) -> bool
-            {
-                if (inEnt->getModelInstance()
-                            ->getMaterialInstance()
-                            ->getStaticMaterial()
-                            .lock()
-                            ->isBlendingEnabled() &&
-                    !inEnt2->getModelInstance()
-                            ->getMaterialInstance()
-                            ->getStaticMaterial()
-                            .lock()
-                            ->isBlendingEnabled())
-                {
-                    return false;
-                }
-                if (!inEnt->getModelInstance()
-                        ->getMaterialInstance()
-                        ->getStaticMaterial()
-                        .lock()
-                        ->isBlendingEnabled() &&
-                    inEnt2->getModelInstance()
-                            ->getMaterialInstance()
-                            ->getStaticMaterial()
-                            .lock()
-                            ->isBlendingEnabled())
-                {
-                    return true;
-                }
-                // TODO remove sqrt
-                return glm::distance(m_CurrentScene->getCurrentCamera()->getPosition(),
-                                     inEnt->getModelInstance()->getPosition()) >
-                       glm::distance(m_CurrentScene->getCurrentCamera()->getPosition(),
-                                     inEnt2->getModelInstance()->getPosition());
-                // return true;
-            });
-    for (size_t index = 0; index < scene_ref.size(); index++)
+    // Scene entity order is left as is, drawing order comes from the render queue
     {
-        auto& scene_entity = scene_ref[index];
-        auto& material_instance = scene_entity->getModelInstance()->getMaterialInstance();
-        auto material = material_instance->getStaticMaterial().lock();
-        if (!material)
+        PROFILE_SCOPE("Build render queue");
+        m_RenderQueue.clear();
+        const glm::vec3 camera_position = m_CurrentScene->getCurrentCamera()->getPosition();
+        for (auto& scene_entity: m_CurrentScene->getEntities())
         {
-            WARN(LogRendering, "Material is invalid in material instance");
-        }
+            auto material = scene_entity->getModelInstance()
+                    ->getMaterialInstance()
+                    ->getStaticMaterial()
+                    .lock();
+            if (!material)
+            {
+                WARN(LogRendering, "Material is invalid in material instance");
+                continue;
+            }
+            auto model = scene_entity->getModelInstance()->getModel().lock();
+            if (!model)
+            {
+                WARN(LogRendering, "Model is invalid in model instance");
+                continue;
+            }
+            // Geometry goes to the pool on first use, loaded and generated models alike
+            if (!model->getGeometry().isValid() && !model->getVertices().empty())
+            {
+                loadModelInMemory(model);
+            }
+            if (!uploads->isReady(model->getGeometry().upload_ticket))
+            {
+                continue;
+            }
 
-        VkPipeline model_pipeline{};
-        VkPipelineLayout model_pipeline_layout{};
-        if (scene_entity->getId() == m_CurrentScene->getCurrentId())
-        {
-            // TODO check this for valid shader, because light have simple shader, and
-            // should not have lightstencil layouts
-            outline_entity = scene_entity.get();
-            model_pipeline =
-                    findGraphicsPipeline("LightStencil")->getGraphicsPipeline();
-            model_pipeline_layout =
-                    findGraphicsPipeline("LightStencil")->getPipelineLayout();
-        }
-        else
-        {
-            model_pipeline = findGraphicsPipeline(material->getShaderName())
-                    ->getGraphicsPipeline();
-            model_pipeline_layout =
-                    findGraphicsPipeline(material->getShaderName())->getPipelineLayout();
+            // TODO: MATERIALS ARE TOTAL SHIT
+            if (!retrieveMaterialRenderState(material))
+            {
+                continue;
+            }
+
+            std::string pipeline_name = material->getShaderName();
+            if (scene_entity->getId() == m_CurrentScene->getCurrentId())
+            {
+                // TODO check this for valid shader, because light have simple shader, and
+                // should not have lightstencil layouts
+                outline_entity = scene_entity.get();
+                pipeline_name = "LightStencil";
+            }
+
+            // Subpass is fixed by the pipeline, blending flag alone can not move a draw there
+            omp::GraphicsPipeline* pipeline = findGraphicsPipeline(pipeline_name);
+            const bool transparent = m_TransparentPipelines.contains(pipeline);
+            if (m_DepthPrepass && !transparent && m_Pipelines.contains(pipeline_name + g_DepthEqualSuffix))
+            {
+                pipeline_name += g_DepthEqualSuffix;
+                pipeline = findGraphicsPipeline(pipeline_name);
+            }
+
+            const glm::vec3 to_camera = scene_entity->getModelInstance()->getPosition() - camera_position;
+            const uint64_t key = omp::RenderQueue::makeKey(
+                    transparent,
+                    m_RenderQueue.getPipelineId(pipeline_name),
+                    m_RenderQueue.getMaterialId(material.get()),
+                    m_RenderQueue.getModelId(model.get()),
+                    glm::dot(to_camera, to_camera));
+            m_RenderQueue.add(key, {scene_entity.get(), pipeline, material.get(), model.get()});
         }
-        vkCmdBindPipeline(main_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          model_pipeline);
-
-        vkCmdBindDescriptorSets(main_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                model_pipeline_layout, 0, 1,
-                                &m_UboDescriptorSets[KHRImageIndex], 0, nullptr);
-
-        vkCmdBindVertexBuffers(
-                main_buffer, 0, 1,
-                &scene_entity->getModelInstance()->getModel().lock()->getVertexBuffer(),
-                offsets);
-        vkCmdBindIndexBuffer(
-                main_buffer,
-                scene_entity->getModelInstance()->getModel().lock()->getIndexBuffer(), 0,
-                VK_INDEX_TYPE_UINT32);
+        m_RenderQueue.sort();
+    }
 
-        omp::ModelPushConstant constant{
+    // Per instance data in sorted order, so every batch is a contiguous range
+    ensureInstanceBufferCapacity(m_CurrentFrame, m_RenderQueue.size());
+    auto* instances = static_cast<omp::InstanceData*>(m_InstanceBuffersMapped[m_CurrentFrame]);
+    for (size_t index = 0; index < m_RenderQueue.size(); index++)
+    {
+        const omp::DrawItem& item = m_RenderQueue.getItem(index);
+        omp::SceneEntity* scene_entity = item.entity;
+        auto& material_instance = scene_entity->getModelInstance()->getMaterialInstance();
+        instances[index] = {
                 scene_entity->getModelInstance()->getTransform(),
                 material_instance->getAmbient(), material_instance->getDiffusive(),
-                material_instance->getSpecular(), scene_entity->getId()};
-        vkCmdPushConstants(main_buffer, model_pipeline_layout,
-                           VK_SHADER_STAGE_VERTEX_BIT |
-                           VK_SHADER_STAGE_FRAGMENT_BIT,
-                           0, sizeof(omp::ModelPushConstant), &constant);
+                material_instance->getSpecular(), scene_entity->getId(),
+                item.material->getTextureIndices()};
+    }
 
-        // TODO: MATERIALS ARE TOTAL SHIT
-        if (material)
-        {
-            retrieveMaterialRenderState(material);
-            vkCmdBindDescriptorSets(
-                    main_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, model_pipeline_layout,
-                    1, 1, &material->getDescriptorSet()[KHRImageIndex], 0, nullptr);
-        }
-        else
+    m_DrawStats.entities = static_cast<uint32_t>(m_RenderQueue.size());
+    frame_stats.visible_entities = m_DrawStats.entities;
+    m_MemoryStats = m_VulkanContext->getMemoryStats();
+    m_VulkanContext->updateMemoryBudget();
+
+    if (m_CurrentScene->isDirty())
+    {
+        invalidateRecordedCommands();
+        m_CurrentScene->confirmRendering();
+    }
+
+    RecordedMainPass& recorded = m_RecordedMainPasses[m_CurrentFrame];
+    const uint32_t frame = static_cast<uint32_t>(m_CurrentFrame);
+    if (isGpuDriven())
+    {
+        if (m_GpuCulling->prepare(frame, m_RenderQueue, m_InstanceBuffers[m_CurrentFrame], *m_DepthPyramid))
         {
-            // default material
-            vkCmdBindDescriptorSets(
-                    main_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, model_pipeline_layout,
-                    1, 1, &m_DefaultMaterial->getDescriptorSet()[KHRImageIndex], 0,
-                    nullptr);
+            recorded.valid = false;
         }
-        vkCmdDrawIndexed(
-                main_buffer,
-                static_cast<uint32_t>(
-                        scene_entity->getModelInstance()->getModel().lock()->getIndices().size()),
-                1, 0, 0, 0);
+        // Dispatches can not be recorded inside of render pass
+        const uint32_t culling_scope = m_GpuProfiler->beginScope(main_buffer, "Culling");
+        m_GpuCulling->recordCulling(main_buffer, frame, m_ViewFrustum, isOcclusionCulled());
+        m_GpuProfiler->endScope(main_buffer, culling_scope);
+
+        const omp::CullStats& cull_stats = m_GpuCulling->getStats(frame);
+        m_DrawStats.frustum_culled = cull_stats.frustum_culled;
+        m_DrawStats.occlusion_culled = cull_stats.occlusion_culled;
+        m_DrawStats.occluded_triangles = cull_stats.occluded_triangles;
+        frame_stats.culled_entities = std::min(m_DrawStats.entities,
+                                               cull_stats.frustum_culled + cull_stats.occlusion_culled);
+        frame_stats.visible_entities = m_DrawStats.entities - frame_stats.culled_entities;
     }
 
-    if (outline_entity)
+    rect.offset.x = 0;
+    rect.offset.y = 0;
+    rect.extent.height = static_cast<uint32_t>(m_RenderViewport->getSize().y);
+    rect.extent.width = static_cast<uint32_t>(m_RenderViewport->getSize().x);
+    // Outside of render pass, so it covers all of its subpasses
+    if (count_fragments)
     {
-        auto outline_pipeline = findGraphicsPipeline("Outline");
-        vkCmdBindVertexBuffers(
-                main_buffer, 0, 1,
-                &outline_entity->getModelInstance()->getModel().lock()->getVertexBuffer(),
-                offsets);
-        vkCmdBindIndexBuffer(
-                main_buffer,
-                outline_entity->getModelInstance()->getModel().lock()->getIndexBuffer(), 0,
-                VK_INDEX_TYPE_UINT32);
-        vkCmdBindPipeline(main_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          outline_pipeline->getGraphicsPipeline());
-        vkCmdBindDescriptorSets(main_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                outline_pipeline->getPipelineLayout(), 0, 1,
-                                &m_OutlineDescriptorSets[KHRImageIndex], 0,
-                                nullptr);
-        vkCmdDrawIndexed(
-                main_buffer,
-                static_cast<uint32_t>(
-                        outline_entity->getModelInstance()->getModel().lock()->getIndices().size()),
-                1, 0, 0, 0);
+        vkCmdBeginQuery(main_buffer, m_StatisticsQueryPool, statistics_query, 0);
+    }
+    const uint32_t scene_scope = m_GpuProfiler->beginScope(main_buffer, "Scene passes");
+    beginRenderPass(m_RenderPass.get(), main_buffer,
+                    m_SwapChainFramebuffers[KHRImageIndex], clear_values, rect,
+                    VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    // Camera and light changes only touch uniforms, instance data is already rewritten above
+    const bool reuse_recorded = m_CacheCommandBuffers && recorded.valid &&
+                                recorded.geometry_generation == m_GeometryPool->getGeneration() &&
+                                recorded.batches == m_RenderQueue.getBatches();
+    if (!reuse_recorded)
+    {
+        PROFILE_SCOPE("Record main pass");
+        recorded.stats = {};
+        recorded.chunk_count = recordMainPass(recorded.stats);
+        recorded.batches = m_RenderQueue.getBatches();
+        recorded.geometry_generation = m_GeometryPool->getGeneration();
+        recorded.valid = true;
     }
 
-    endRenderPass(m_RenderPass.get(), main_buffer);
+    const size_t frame_slots = m_CurrentFrame * m_RecordingSlots;
+    std::vector<VkCommandBuffer> secondary_buffers;
+    for (size_t chunk = 0; chunk < recorded.chunk_count; chunk++)
+    {
+        secondary_buffers.push_back(m_SecondaryCommandBuffers[frame_slots + chunk]);
+    }
+    secondary_buffers.push_back(m_SecondaryCommandBuffers[frame_slots + m_RecordingSlots - 1]);
+    vkCmdExecuteCommands(main_buffer, static_cast<uint32_t>(secondary_buffers.size()),
+                         secondary_buffers.data());
+
+    recordTransparency(main_buffer, outline_entity, frame_stats);
+    vkCmdEndRenderPass(main_buffer);
+    m_GpuProfiler->endScope(main_buffer, scene_scope);
+    if (count_fragments)
+    {
+        vkCmdEndQuery(main_buffer, m_StatisticsQueryPool, statistics_query);
+    }
+
+    // Between main and ui passes, culling of the next frame tests against this depth
+    if (isOcclusionCulled())
+    {
+        const uint32_t pyramid_scope = m_GpuProfiler->beginScope(main_buffer, "Depth pyramid");
+        m_DepthPyramid->recordBuild(main_buffer, m_ViewProjection);
+        m_GpuProfiler->endScope(main_buffer, pyramid_scope);
+    }
+    m_GpuProfiler->endScope(main_buffer, main_pass_scope);
+    if (vkEndCommandBuffer(main_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record command buffer");
+    }
+    frame_stats += recorded.stats;
+    m_DrawStats.draw_calls = frame_stats.draw_calls;
+
+    if (m_Headless)
+    {
+        m_RenderStats = frame_stats;
+        return;
+    }
 
     // UI RENDERPASS
+    prepareCommandBuffer(m_ImguiCommandBuffers[m_CurrentFrame],
+                         m_FrameCommandPools[m_CurrentFrame]);
+
+    std::vector<VkClearValue> clear_value{1};
+    clear_value[0].color = g_ClearColor;
+
     rect.extent.height = m_SwapChainExtent.height;
     rect.extent.width = m_SwapChainExtent.width;
     rect.offset.x = 0;
     rect.offset.y = 0;
+    PROFILE_SCOPE("Record ui");
+    const uint32_t ui_scope = m_GpuProfiler->beginScope(m_ImguiCommandBuffers[m_CurrentFrame].buffer, "UI pass");
     beginRenderPass(m_ImguiRenderPass.get(),
-                    m_ImguiCommandBuffers[KHRImageIndex].buffer,
+                    m_ImguiCommandBuffers[m_CurrentFrame].buffer,
                     m_ImguiFramebuffers[KHRImageIndex], clear_value, rect);
 
     ImGui_ImplVulkan_NewFrame();
@@ -1191,42 +1672,371 @@ void omp::Renderer::prepareFrameForImage(size_t KHRImageIndex)
 
     ImGui::Render();
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(),
-                                    m_ImguiCommandBuffers[KHRImageIndex].buffer);
+                                    m_ImguiCommandBuffers[m_CurrentFrame].buffer);
+    frame_stats += countUiCommands(ImGui::GetDrawData());
+    m_RenderStats = frame_stats;
+
+    endRenderPass(m_ImguiRenderPass.get(),
+                  m_ImguiCommandBuffers[m_CurrentFrame].buffer);
+    m_GpuProfiler->endScope(m_ImguiCommandBuffers[m_CurrentFrame].buffer, ui_scope);
+}
+
+size_t omp::Renderer::recordMainPass(omp::RenderStats& outStats)
+{
+    // Workers take equal chunks of opaque batches, main thread records the rest
+    const size_t opaque_batches = omp::GpuCulling::getOpaqueBatchCount(m_RenderQueue);
+    const bool gpu_driven = isGpuDriven();
+    size_t chunk_count = 0;
+    // Culled draws are only a few indirect calls, they stay on main thread
+    if (m_ThreadPool && !gpu_driven)
+    {
+        chunk_count = std::min(m_RecordingSlots - 1,
+                               opaque_batches / g_MinBatchesPerChunk);
+    }
+
+    const size_t frame_slots = m_CurrentFrame * m_RecordingSlots;
+    for (size_t slot = 0; slot < m_RecordingSlots; slot++)
+    {
+        vkResetCommandPool(m_LogicalDevice, m_SecondaryCommandPools[frame_slots + slot], 0);
+    }
+
+    std::vector<std::future<void>> recordings;
+    // Summed once workers are done, no counter is shared between threads
+    std::vector<omp::RenderStats> chunk_stats(chunk_count);
+    size_t first_batch = 0;
+    for (size_t chunk = 0; chunk < chunk_count; chunk++)
+    {
+        const size_t last_batch = opaque_batches * (chunk + 1) / chunk_count;
+        VkCommandBuffer secondary_buffer = m_SecondaryCommandBuffers[frame_slots + chunk];
+        omp::RenderStats* stats = &chunk_stats[chunk];
+        recordings.push_back(m_ThreadPool->submit(
+                [this, secondary_buffer, first_batch, last_batch, stats]()
+                {
+                    PROFILE_SCOPE("Record batches");
+                    beginSecondaryCommandBuffer(secondary_buffer);
+                    recordBatches(secondary_buffer, first_batch, last_batch, *stats);
+                    if (vkEndCommandBuffer(secondary_buffer) != VK_SUCCESS)
+                    {
+                        throw std::runtime_error("failed to record secondary command buffer");
+                    }
+                }));
+        first_batch = last_batch;
+    }
+
+    VkCommandBuffer main_secondary_buffer = m_SecondaryCommandBuffers[frame_slots + m_RecordingSlots - 1];
+    beginSecondaryCommandBuffer(main_secondary_buffer);
+    if (gpu_driven)
+    {
+        recordCulledBatches(main_secondary_buffer, outStats);
+    }
+    else
+    {
+        recordBatches(main_secondary_buffer, first_batch, opaque_batches, outStats);
+    }
+    if (vkEndCommandBuffer(main_secondary_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record secondary command buffer");
+    }
+
+    // Rethrows recording errors of workers
+    for (std::future<void>& recording: recordings)
+    {
+        recording.get();
+    }
+    for (const omp::RenderStats& stats: chunk_stats)
+    {
+        outStats += stats;
+    }
+    return chunk_count;
+}
+
+void omp::Renderer::recordTransparency(VkCommandBuffer inCommandBuffer, omp::SceneEntity* outlineEntity,
+                                       omp::RenderStats& outStats)
+{
+    // Recorded inline every frame, transparent batches are few once they are instanced.
+    // Opaque subpass takes secondary buffers only, so dynamic state waits for the next one
+    vkCmdNextSubpass(inCommandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    setViewport(inCommandBuffer);
+    const size_t first_transparent = omp::GpuCulling::getOpaqueBatchCount(m_RenderQueue);
+    const size_t batch_count = m_RenderQueue.getBatches().size();
+    recordBatches(inCommandBuffer, first_transparent, batch_count, outStats);
+
+    vkCmdNextSubpass(inCommandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    if (first_transparent < batch_count)
+    {
+        omp::GraphicsPipeline* composite_pipeline = findGraphicsPipeline("OitComposite");
+        const VkDescriptorSet composite_set = m_OitTargets->getDescriptorSet();
+        const omp::OitTargets::CompositePushConstant constant = m_OitTargets->getCompositeConstant();
+        vkCmdBindPipeline(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          composite_pipeline->getGraphicsPipeline());
+        vkCmdBindDescriptorSets(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                composite_pipeline->getPipelineLayout(), 0, 1, &composite_set, 0, nullptr);
+        vkCmdPushConstants(inCommandBuffer, composite_pipeline->getPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, sizeof(constant), &constant);
+        vkCmdDraw(inCommandBuffer, 3, 1, 0, 0);
+        outStats.pipeline_binds++;
+        outStats.descriptor_set_binds++;
+        outStats.push_constant_bytes += sizeof(constant);
+        outStats.addDraw(3, 1);
+    }
+
+    if (outlineEntity)
+    {
+        auto outline_pipeline = findGraphicsPipeline("Outline");
+        const omp::GeometryAllocation& geometry =
+                outlineEntity->getModelInstance()->getModel().lock()->getGeometry();
+        bindGeometryPage(inCommandBuffer, geometry.page, outStats);
+        vkCmdBindPipeline(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          outline_pipeline->getGraphicsPipeline());
+        vkCmdBindDescriptorSets(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                outline_pipeline->getPipelineLayout(), 0, 1,
+                                &m_OutlineDescriptorSets[m_CurrentFrame], 1,
+                                &m_FrameUniformOffsets[m_CurrentFrame].outline);
+        vkCmdDrawIndexed(inCommandBuffer, geometry.index_count, 1, geometry.first_index,
+                         static_cast<int32_t>(geometry.first_vertex), 0);
+        outStats.pipeline_binds++;
+        outStats.descriptor_set_binds++;
+        outStats.addIndexedDraw(geometry.index_count, 1);
+    }
+}
+
+void omp::Renderer::invalidateRecordedCommands()
+{
+    for (RecordedMainPass& recorded: m_RecordedMainPasses)
+    {
+        recorded.valid = false;
+    }
+}
+
+void omp::Renderer::recordBatches(VkCommandBuffer inCommandBuffer, size_t firstBatch, size_t lastBatch,
+                                  omp::RenderStats& outStats)
+{
+    VkDeviceSize offsets[] = {0};
+    VkBuffer instance_buffer = m_InstanceBuffers[m_CurrentFrame];
+    vkCmdBindVertexBuffers(inCommandBuffer, 1, 1, &instance_buffer, offsets);
+    outStats.vertex_buffer_binds++;
+
+    // Pre-pass of a chunk only covers its own batches, chunks go front to back anyway
+    recordDepthPrepass(inCommandBuffer, firstBatch, lastBatch, outStats);
+
+    omp::GraphicsPipeline* bound_pipeline = nullptr;
+    std::optional<uint32_t> bound_page;
+    for (size_t index = firstBatch; index < lastBatch; index++)
+    {
+        const omp::DrawBatch& batch = m_RenderQueue.getBatches()[index];
+        const omp::DrawItem& item = m_RenderQueue.getItem(batch.first);
+
+        if (item.pipeline != bound_pipeline)
+        {
+            bindMaterialPipeline(inCommandBuffer, item.pipeline, outStats);
+            bound_pipeline = item.pipeline;
+        }
+
+        // Models share pool pages, buffers are rebound only when page changes
+        const omp::GeometryAllocation& geometry = item.model->getGeometry();
+        if (bound_page != geometry.page)
+        {
+            bindGeometryPage(inCommandBuffer, geometry.page, outStats);
+            bound_page = geometry.page;
+        }
+
+        vkCmdDrawIndexed(inCommandBuffer, geometry.index_count, batch.count, geometry.first_index,
+                         static_cast<int32_t>(geometry.first_vertex), batch.first);
+        outStats.addIndexedDraw(geometry.index_count, batch.count);
+    }
+}
+
+void omp::Renderer::recordCulledBatches(VkCommandBuffer inCommandBuffer, omp::RenderStats& outStats)
+{
+    const uint32_t frame = static_cast<uint32_t>(m_CurrentFrame);
+    VkDeviceSize offsets[] = {0};
+    VkBuffer instance_buffer = m_GpuCulling->getCulledInstances(frame);
+    vkCmdBindVertexBuffers(inCommandBuffer, 1, 1, &instance_buffer, offsets);
+    outStats.vertex_buffer_binds++;
+
+    const std::vector<omp::CullDrawGroup>& groups = m_GpuCulling->getDrawGroups(frame);
+    // Visible instance counts stay on gpu, indices are counted as if nothing was culled
+    const auto count_indices = [this](const omp::CullDrawGroup& group)
+    {
+        uint64_t indices = 0;
+        for (uint32_t index = group.first_batch; index < group.first_batch + group.batch_count; index++)
+        {
+            const omp::DrawBatch& batch = m_RenderQueue.getBatches()[index];
+            indices += uint64_t{batch.model->getGeometry().index_count} * batch.count;
+        }
+        return indices;
+    };
+    omp::GraphicsPipeline* depth_pipeline = findGraphicsPipeline("DepthPrepass");
+    bool prepass_bound = false;
+    for (size_t group = 0; group < groups.size(); group++)
+    {
+        if (!m_DepthEqualPipelines.contains(groups[group].pipeline))
+        {
+            continue;
+        }
+        if (!prepass_bound)
+        {
+            bindMaterialPipeline(inCommandBuffer, depth_pipeline, outStats);
+            prepass_bound = true;
+        }
+        bindGeometryPage(inCommandBuffer, groups[group].page, outStats);
+        outStats.addIndirectDraws(m_GpuCulling->recordDrawGroup(inCommandBuffer, frame, group),
+                                  count_indices(groups[group]));
+    }
+
+    omp::GraphicsPipeline* bound_pipeline = nullptr;
+    for (size_t group = 0; group < groups.size(); group++)
+    {
+        if (groups[group].pipeline != bound_pipeline)
+        {
+            bindMaterialPipeline(inCommandBuffer, groups[group].pipeline, outStats);
+            bound_pipeline = groups[group].pipeline;
+        }
+        // Groups are split on page change
+        bindGeometryPage(inCommandBuffer, groups[group].page, outStats);
+        outStats.addIndirectDraws(m_GpuCulling->recordDrawGroup(inCommandBuffer, frame, group),
+                                  count_indices(groups[group]));
+    }
+}
+
+void omp::Renderer::recordDepthPrepass(VkCommandBuffer inCommandBuffer, size_t firstBatch, size_t lastBatch,
+                                       omp::RenderStats& outStats)
+{
+    omp::GraphicsPipeline* depth_pipeline = nullptr;
+    std::optional<uint32_t> bound_page;
+    for (size_t index = firstBatch; index < lastBatch; index++)
+    {
+        const omp::DrawBatch& batch = m_RenderQueue.getBatches()[index];
+        if (!m_DepthEqualPipelines.contains(batch.pipeline))
+        {
+            continue;
+        }
+        if (!depth_pipeline)
+        {
+            depth_pipeline = findGraphicsPipeline("DepthPrepass");
+            bindMaterialPipeline(inCommandBuffer, depth_pipeline, outStats);
+        }
+
+        const omp::GeometryAllocation& geometry = batch.model->getGeometry();
+        if (bound_page != geometry.page)
+        {
+            bindGeometryPage(inCommandBuffer, geometry.page, outStats);
+            bound_page = geometry.page;
+        }
+        vkCmdDrawIndexed(inCommandBuffer, geometry.index_count, batch.count, geometry.first_index,
+                         static_cast<int32_t>(geometry.first_vertex), batch.first);
+        outStats.addIndexedDraw(geometry.index_count, batch.count);
+    }
+}
+
+void omp::Renderer::bindGeometryPage(VkCommandBuffer inCommandBuffer, uint32_t page, omp::RenderStats& outStats)
+{
+    m_GeometryPool->bind(inCommandBuffer, page);
+    outStats.vertex_buffer_binds++;
+    outStats.index_buffer_binds++;
+}
+
+omp::RenderStats omp::Renderer::countUiCommands(const ImDrawData* drawData)
+{
+    omp::RenderStats stats;
+    if (!drawData || drawData->TotalVtxCount == 0)
+    {
+        return stats;
+    }
+    // Pipeline, buffers and scale with translation are set up once, texture set is bound per command
+    stats.pipeline_binds = 1;
+    stats.vertex_buffer_binds = 1;
+    stats.index_buffer_binds = 1;
+    stats.push_constant_bytes = 4 * sizeof(float);
+    for (int list = 0; list < drawData->CmdListsCount; list++)
+    {
+        for (const ImDrawCmd& command: drawData->CmdLists[list]->CmdBuffer)
+        {
+            if (command.UserCallback == nullptr)
+            {
+                stats.descriptor_set_binds++;
+                stats.addIndexedDraw(command.ElemCount, 1);
+            }
+        }
+    }
+    return stats;
+}
 
-    endRenderPass(m_ImguiRenderPass.get(),
-                  m_ImguiCommandBuffers[KHRImageIndex].buffer);
+void omp::Renderer::bindMaterialPipeline(VkCommandBuffer inCommandBuffer, omp::GraphicsPipeline* inPipeline,
+                                         omp::RenderStats& outStats)
+{
+    vkCmdBindPipeline(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, inPipeline->getGraphicsPipeline());
+    // Textures of every material are in the bindless set, nothing is bound per material
+    const std::array<uint32_t, 5> ubo_offsets = m_FrameUniformOffsets[m_CurrentFrame].getUboSetOffsets();
+    std::array<VkDescriptorSet, 2> sets{m_UboDescriptorSets[m_CurrentFrame],
+                                        m_VulkanContext->getBindlessTextures()->getDescriptorSet()};
+    vkCmdBindDescriptorSets(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            inPipeline->getPipelineLayout(), 0, static_cast<uint32_t>(sets.size()), sets.data(),
+                            static_cast<uint32_t>(ubo_offsets.size()), ubo_offsets.data());
+    outStats.pipeline_binds++;
+    outStats.descriptor_set_binds += static_cast<uint32_t>(sets.size());
 }
 
 void omp::Renderer::drawFrame()
 {
-    vkWaitForFences(m_LogicalDevice, 1, &m_InFlightFences[m_CurrentFrame],
-                    VK_TRUE, UINT64_MAX);
-
-    uint32_t image_index;
-    VkResult result = vkAcquireNextImageKHR(
-            m_LogicalDevice, m_SwapChain, UINT64_MAX,
-            m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &image_index);
-
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || m_FramebufferResized)
-    {
-        recreateSwapChain();
-        m_FramebufferResized = false;
-        return;
-    }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
     {
-        throw std::runtime_error("Failed to acquire swap chain image!");
+        PROFILE_SCOPE("Wait for frame");
+        if (m_FramesInFlight == 1)
+        {
+            vkWaitForFences(m_LogicalDevice, static_cast<uint32_t>(m_InFlightFences.size()), m_InFlightFences.data(),
+                            VK_TRUE, UINT64_MAX);
+        }
+        else
+        {
+            vkWaitForFences(m_LogicalDevice, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+        }
     }
+    m_GeometryPool->beginFrame(static_cast<uint32_t>(m_CurrentFrame));
+    m_VulkanContext->getBindlessTextures()->beginFrame(static_cast<uint32_t>(m_CurrentFrame));
 
-    if (m_ImagesInFlight[image_index] != VK_NULL_HANDLE)
+    // Headless framebuffers belong to frames in flight, their fence is already waited
+    uint32_t image_index = static_cast<uint32_t>(m_CurrentFrame);
+    if (!m_Headless)
     {
-        vkWaitForFences(m_LogicalDevice, 1, &m_ImagesInFlight[image_index], VK_TRUE,
-                        UINT64_MAX);
+        destroyRetiredSwapChains(false);
+        // Before acquire, semaphore of an image acquired for a dropped frame would stay signaled
+        if (m_FramebufferResized || m_PresentSettingsChanged)
+        {
+            m_FramebufferResized = false;
+            m_PresentSettingsChanged = false;
+            recreateSwapChain();
+        }
+
+        VkResult result = VK_SUCCESS;
+        {
+            PROFILE_SCOPE("Acquire image");
+            result = vkAcquireNextImageKHR(
+                    m_LogicalDevice, m_SwapChain, UINT64_MAX,
+                    m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &image_index);
+        }
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            recreateSwapChain();
+            return;
+        }
+        else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        {
+            throw std::runtime_error("Failed to acquire swap chain image!");
+        }
+
+        if (m_ImagesInFlight[image_index] != VK_NULL_HANDLE)
+        {
+            vkWaitForFences(m_LogicalDevice, 1, &m_ImagesInFlight[image_index], VK_TRUE,
+                            UINT64_MAX);
+        }
+        m_ImagesInFlight[image_index] = m_InFlightFences[m_CurrentFrame];
     }
-    m_ImagesInFlight[image_index] = m_InFlightFences[m_CurrentFrame];
 
     onViewportResize(image_index);
-    updateUniformBuffer(image_index);
+    updateUniformBuffer(m_CurrentFrame);
+    // Fence above guarantees that gpu is done with buffers of this frame
+    vkResetCommandPool(m_LogicalDevice, m_FrameCommandPools[m_CurrentFrame], 0);
     prepareFrameForImage(image_index);
 
     VkSubmitInfo submit_info{};
@@ -1235,22 +2045,24 @@ void omp::Renderer::drawFrame()
     VkSemaphore wait_semaphores[] = {m_ImageAvailableSemaphores[m_CurrentFrame]};
     VkPipelineStageFlags wait_stages[] = {
             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = wait_semaphores;
-    submit_info.pWaitDstStageMask = wait_stages;
+    VkSemaphore signal_semaphores[] = {
+            m_RenderFinishedSemaphores[m_CurrentFrame]};
 
-    std::array<VkCommandBuffer, 2> command_buffers{
-            m_CommandBuffers[image_index].buffer,
-            m_ImguiCommandBuffers[image_index].buffer};
+    // Headless frame is only the main pass, nothing but the fence waits for it
+    std::vector<VkCommandBuffer> command_buffers{m_CommandBuffers[m_CurrentFrame].buffer};
+    if (!m_Headless)
+    {
+        submit_info.waitSemaphoreCount = 1;
+        submit_info.pWaitSemaphores = wait_semaphores;
+        submit_info.pWaitDstStageMask = wait_stages;
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = signal_semaphores;
+        command_buffers.push_back(m_ImguiCommandBuffers[m_CurrentFrame].buffer);
+    }
     submit_info.commandBufferCount =
             static_cast<uint32_t>(command_buffers.size());
     submit_info.pCommandBuffers = command_buffers.data();
 
-    VkSemaphore signal_semaphores[] = {
-            m_RenderFinishedSemaphores[m_CurrentFrame]};
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = signal_semaphores;
-
     vkResetFences(m_LogicalDevice, 1, &m_InFlightFences[m_CurrentFrame]);
 
     if (vkQueueSubmit(m_GraphicsQueue, 1, &submit_info,
@@ -1259,6 +2071,13 @@ void omp::Renderer::drawFrame()
         throw std::runtime_error("failed to submit draw command buffer");
     }
 
+    if (m_Headless)
+    {
+        m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        return;
+    }
+
+    PROFILE_SCOPE("Present");
     VkPresentInfoKHR present_info{};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     present_info.waitSemaphoreCount = 1;
@@ -1270,12 +2089,15 @@ void omp::Renderer::drawFrame()
     present_info.pImageIndices = &image_index;
     present_info.pResults = nullptr;
 
-    result = vkQueuePresentKHR(m_PresentQueue, &present_info);
-    if (result != VK_SUCCESS)
+    const VkResult result = vkQueuePresentKHR(m_PresentQueue, &present_info);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    {
+        m_FramebufferResized = true;
+    }
+    else if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to present swap chain image!");
     }
-    vkQueueWaitIdle(m_PresentQueue);
 
     m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
@@ -1310,17 +2132,65 @@ void omp::Renderer::createSyncObjects()
 
 void omp::Renderer::recreateSwapChain()
 {
+    PROFILE_SCOPE("Recreate swapchain");
+    const SwapChainSupportDetails swap_chain_support = querySwapChainSupport(m_PhysDevice);
+    if (chooseSwapSurfaceFormat(swap_chain_support.formats).format != m_SwapChainImageFormat)
+    {
+        recreateSwapChainResources();
+        return;
+    }
+
+    // Only frames of this renderer use swapchain images and ui framebuffers, no need to idle the device
+    vkWaitForFences(m_LogicalDevice, static_cast<uint32_t>(m_InFlightFences.size()), m_InFlightFences.data(),
+                    VK_TRUE, UINT64_MAX);
+    for (VkImageView image_view: m_SwapChainImageViews)
+    {
+        vkDestroyImageView(m_LogicalDevice, image_view, nullptr);
+    }
+    for (auto& framebuffer: m_ImguiFramebuffers)
+    {
+        framebuffer.destroyInnerState();
+    }
+
+    const uint32_t previous_image_count = m_PresentKHRImagesNum;
+    createSwapChain();
+    m_ImagesInFlight.assign(m_PresentKHRImagesNum, VK_NULL_HANDLE);
+    createImageViews();
+    createImguiFramebuffers();
+    if (m_PresentKHRImagesNum != previous_image_count)
+    {
+        ImGui_ImplVulkan_SetMinImageCount(std::max<uint32_t>(m_PresentKHRImagesNum, 2));
+    }
+
+    // Main pass framebuffers follow image count only, attachments are the same for every image
+    const size_t previous_count = m_SwapChainFramebuffers.size();
+    for (size_t index = m_PresentKHRImagesNum; index < previous_count; index++)
+    {
+        m_SwapChainFramebuffers[index].destroyInnerState();
+    }
+    m_SwapChainFramebuffers.resize(m_PresentKHRImagesNum);
+    for (size_t index = previous_count; index < m_PresentKHRImagesNum; index++)
+    {
+        createFramebufferAtImage(index);
+    }
+    invalidateRecordedCommands();
+}
+
+void omp::Renderer::recreateSwapChainResources()
+{
+    PROFILE_SCOPE("Recreate swapchain resources");
     vkDeviceWaitIdle(m_LogicalDevice);
 
     cleanupSwapChain();
 
     createSwapChain();
+    // Old fences associations are meaningless after device idle, image count may change
+    m_ImagesInFlight.assign(m_PresentKHRImagesNum, VK_NULL_HANDLE);
     createImageViews();
     createRenderPass();
     createGraphicsPipeline();
     createColorResources();
     createViewportResources();
-    createPickingResources();
     createDepthResources();
     createFramebuffers();
     createUniformBuffers();
@@ -1338,7 +2208,8 @@ void omp::Renderer::recreateSwapChain()
     createImguiRenderPass();
     createImguiFramebuffers();
 
-    ImGui_ImplVulkan_SetMinImageCount(2);
+    ImGui_ImplVulkan_SetMinImageCount(std::max<uint32_t>(m_PresentKHRImagesNum, 2));
+    invalidateRecordedCommands();
 }
 
 void omp::Renderer::cleanupSwapChain()
@@ -1346,13 +2217,20 @@ void omp::Renderer::cleanupSwapChain()
     destroyMainRenderPassResources();
 
     m_Pipelines.clear();
+    m_DepthEqualPipelines.clear();
+    m_TransparentPipelines.clear();
     m_RenderPass->destroyInnerState();
 
     for (size_t i = 0; i < m_SwapChainImageViews.size(); i++)
     {
         vkDestroyImageView(m_LogicalDevice, m_SwapChainImageViews[i], nullptr);
     }
-    vkDestroySwapchainKHR(m_LogicalDevice, m_SwapChain, nullptr);
+    if (m_SwapChain != VK_NULL_HANDLE)
+    {
+        vkDestroySwapchainKHR(m_LogicalDevice, m_SwapChain, nullptr);
+        m_SwapChain = VK_NULL_HANDLE;
+    }
+    destroyRetiredSwapChains(true);
 
     /* Unique ptr will destory on recreate
     for (size_t i = 0; i < m_SwapChainImages.size(); i++)
@@ -1373,16 +2251,6 @@ void omp::Renderer::cleanupSwapChain()
         framebuffer.destroyInnerState();
     }
 
-    // sus, why reset materials?
-    vkFreeDescriptorSets(m_LogicalDevice, m_DescriptorPool, m_MaterialSets.size(),
-                         m_MaterialSets.data());
-    m_MaterialSets.clear();
-    /* for (auto& [u, material]:
-            omp::MaterialManager::getMaterialManager().getMaterials())
-    {
-        material->clearDescriptorSets();
-    } */
-
     vkFreeDescriptorSets(m_LogicalDevice, m_DescriptorPool,
                          m_UboDescriptorSets.size(), m_UboDescriptorSets.data());
     vkFreeDescriptorSets(m_LogicalDevice, m_DescriptorPool,
@@ -1392,6 +2260,31 @@ void omp::Renderer::cleanupSwapChain()
     m_ImguiRenderPass->destroyInnerState();
 }
 
+void omp::Renderer::destroyRetiredSwapChains(bool inForce)
+{
+    // Called once per frame after its fence, so every call another frame in flight is done
+    std::erase_if(m_RetiredSwapChains, [this, inForce](RetiredSwapChain& retired)
+    {
+        if (!inForce && retired.frames_left > 0)
+        {
+            retired.frames_left--;
+            return false;
+        }
+        vkDestroySwapchainKHR(m_LogicalDevice, retired.swap_chain, nullptr);
+        return true;
+    });
+}
+
+void omp::Renderer::setPresentSettings(const omp::PresentSettings& inSettings)
+{
+    // Before initVulkan settings are just taken by the first swapchain
+    if (m_SwapChain != VK_NULL_HANDLE && inSettings != m_PresentSettings)
+    {
+        m_PresentSettingsChanged = true;
+    }
+    m_PresentSettings = inSettings;
+}
+
 void omp::Renderer::onWindowResize(
         int width,
         int height)
@@ -1401,6 +2294,17 @@ void omp::Renderer::onWindowResize(
     m_FramebufferResized = true;
 }
 
+void omp::Renderer::createGpuCulling()
+{
+    m_GpuCulling = std::make_unique<omp::GpuCulling>(
+            m_VulkanContext, MAX_FRAMES_IN_FLIGHT, m_DrawIndirectCountSupported, m_MultiDrawIndirectSupported);
+}
+
+void omp::Renderer::createOitTargets()
+{
+    m_OitTargets = std::make_unique<omp::OitTargets>(m_VulkanContext, m_MSAASamples);
+}
+
 void omp::Renderer::createDescriptorSetLayout()
 {
     // TODO: need abstraction
@@ -1408,7 +2312,7 @@ void omp::Renderer::createDescriptorSetLayout()
     {
         VkDescriptorSetLayoutBinding skybox_layout_binding{};
         skybox_layout_binding.binding = 0;
-        skybox_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        skybox_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         skybox_layout_binding.descriptorCount = 1;
         skybox_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         skybox_layout_binding.pImmutableSamplers = nullptr;
@@ -1438,7 +2342,7 @@ void omp::Renderer::createDescriptorSetLayout()
     {
         VkDescriptorSetLayoutBinding ubo_layout_binding{};
         ubo_layout_binding.binding = 0;
-        ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         ubo_layout_binding.descriptorCount = 1;
         ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         ubo_layout_binding.pImmutableSamplers = nullptr;
@@ -1464,7 +2368,7 @@ void omp::Renderer::createDescriptorSetLayout()
     {
         VkDescriptorSetLayoutBinding ubo_layout_binding{};
         ubo_layout_binding.binding = 0;
-        ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         ubo_layout_binding.descriptorCount = 1;
         ubo_layout_binding.stageFlags =
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -1473,7 +2377,7 @@ void omp::Renderer::createDescriptorSetLayout()
         VkDescriptorSetLayoutBinding global_light_layout_binding{};
         global_light_layout_binding.binding = 1;
         global_light_layout_binding.descriptorType =
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         global_light_layout_binding.descriptorCount = 1;
         global_light_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         global_light_layout_binding.pImmutableSamplers = nullptr;
@@ -1481,7 +2385,7 @@ void omp::Renderer::createDescriptorSetLayout()
         VkDescriptorSetLayoutBinding point_light_layout_binding{};
         point_light_layout_binding.binding = 2;
         point_light_layout_binding.descriptorType =
-                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
         point_light_layout_binding.descriptorCount = 1;
         point_light_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         point_light_layout_binding.pImmutableSamplers = nullptr;
@@ -1489,14 +2393,23 @@ void omp::Renderer::createDescriptorSetLayout()
         VkDescriptorSetLayoutBinding spot_light_layout_binding{};
         spot_light_layout_binding.binding = 3;
         spot_light_layout_binding.descriptorType =
-                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
         spot_light_layout_binding.descriptorCount = 1;
         spot_light_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         spot_light_layout_binding.pImmutableSamplers = nullptr;
 
-        std::array<VkDescriptorSetLayoutBinding, 4> ubo_bindings = {
+        VkDescriptorSetLayoutBinding clusters_layout_binding{};
+        clusters_layout_binding.binding = 4;
+        clusters_layout_binding.descriptorType =
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        clusters_layout_binding.descriptorCount = 1;
+        clusters_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        clusters_layout_binding.pImmutableSamplers = nullptr;
+
+        std::array<VkDescriptorSetLayoutBinding, 5> ubo_bindings = {
                 ubo_layout_binding, global_light_layout_binding,
-                point_light_layout_binding, spot_light_layout_binding};
+                point_light_layout_binding, spot_light_layout_binding,
+                clusters_layout_binding};
 
         VkDescriptorSetLayoutCreateInfo ubo_layout_info{};
         ubo_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -1511,65 +2424,31 @@ void omp::Renderer::createDescriptorSetLayout()
     }
 
     // TEXTURES LAYOUT
-    VkDescriptorSetLayoutBinding sampler_layout_binding{};
-    sampler_layout_binding.binding = 0;
-    sampler_layout_binding.descriptorCount = 1;
-    sampler_layout_binding.descriptorType =
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    sampler_layout_binding.pImmutableSamplers = nullptr;
-    sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    VkDescriptorSetLayoutBinding diffusive_layout_binding{};
-    diffusive_layout_binding.binding = 1;
-    diffusive_layout_binding.descriptorCount = 1;
-    diffusive_layout_binding.descriptorType =
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    diffusive_layout_binding.pImmutableSamplers = nullptr;
-    diffusive_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    VkDescriptorSetLayoutBinding specular_layout_binding{};
-    specular_layout_binding.binding = 2;
-    specular_layout_binding.descriptorCount = 1;
-    specular_layout_binding.descriptorType =
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    specular_layout_binding.pImmutableSamplers = nullptr;
-    specular_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    std::array<VkDescriptorSetLayoutBinding, 3> texture_bindings = {
-            sampler_layout_binding, diffusive_layout_binding,
-            specular_layout_binding};
-
-    VkDescriptorSetLayoutCreateInfo texture_layout_info{};
-    texture_layout_info.sType =
-            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    texture_layout_info.bindingCount =
-            static_cast<uint32_t>(texture_bindings.size());
-    texture_layout_info.pBindings = texture_bindings.data();
-
-    if (vkCreateDescriptorSetLayout(m_LogicalDevice, &texture_layout_info,
-                                    nullptr, &m_TexturesDescriptorSetLayout) !=
-        VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create texture descriptor set layout!");
-    }
+    m_VulkanContext->setBindlessTextures(
+            std::make_unique<omp::BindlessTextures>(m_VulkanContext, MAX_FRAMES_IN_FLIGHT));
 }
 
 void omp::Renderer::createUniformBuffers()
 {
-    VkDeviceSize buffer_size = sizeof(UniformBufferObject);
-    m_UboBuffer = std::make_unique<omp::UniformBuffer>(
-            m_VulkanContext, m_PresentKHRImagesNum, buffer_size,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-
-    m_OutlineBuffer = std::make_unique<omp::UniformBuffer>(
-            m_VulkanContext, m_PresentKHRImagesNum, sizeof(OutlineUniformBuffer),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    // Storage buffers with lights share the ring, so both alignments apply
+    const VkDeviceSize alignment = std::max(m_DeviceLimits.minUniformBufferOffsetAlignment,
+                                            m_DeviceLimits.minStorageBufferOffsetAlignment);
+    auto aligned = [alignment](VkDeviceSize size) { return (size + alignment - 1) & ~(alignment - 1); };
 
-    m_LightSystem->recreate();
+    const VkDeviceSize frame_size = aligned(sizeof(UniformBufferObject)) +
+                                    aligned(sizeof(OutlineUniformBuffer)) +
+                                    aligned(m_LightSystem->getGlobalLightBufferSize()) +
+                                    aligned(m_LightSystem->getPointLightBufferSize()) +
+                                    aligned(m_LightSystem->getSpotLightBufferSize()) +
+                                    aligned(m_LightSystem->getClusterBufferSize());
+    m_UniformRing = std::make_unique<omp::UniformRingBuffer>(
+            m_VulkanContext, MAX_FRAMES_IN_FLIGHT, frame_size, alignment);
+    m_FrameUniformOffsets.assign(MAX_FRAMES_IN_FLIGHT, FrameUniformOffsets());
 }
 
-void omp::Renderer::updateUniformBuffer(uint32_t currentImage)
+void omp::Renderer::updateUniformBuffer(uint32_t currentFrame)
 {
+    PROFILE_SCOPE("Update uniforms");
     UniformBufferObject ubo{};
     ubo.view = m_CurrentScene->getCurrentCamera()->getViewMatrix();
     ubo.proj = glm::perspective(
@@ -1579,11 +2458,16 @@ void omp::Renderer::updateUniformBuffer(uint32_t currentImage)
             m_CurrentScene->getCurrentCamera()->getNearClipping(),
             m_CurrentScene->getCurrentCamera()->getFarClipping());
     ubo.proj[1][1] *= -1;
+    m_ViewProjection = ubo.proj * ubo.view;
+    m_ViewFrustum = omp::Frustum::fromMatrix(m_ViewProjection);
     ubo.view_position = m_CurrentScene->getCurrentCamera()->getPosition();
     ubo.global_light_enabled = m_LightSystem->getGlobalLight() ? 1 : 0;
     ubo.point_light_size = m_LightSystem->getPointLightSize();
     ubo.spot_light_size = m_LightSystem->getSpotLightSize();
-    m_UboBuffer->mapMemory(ubo, currentImage);
+
+    m_UniformRing->beginFrame(currentFrame);
+    FrameUniformOffsets offsets{};
+    offsets.ubo = m_UniformRing->push(ubo);
 
     OutlineUniformBuffer outline_buffer{};
     outline_buffer.projection = ubo.proj;
@@ -1594,15 +2478,32 @@ void omp::Renderer::updateUniformBuffer(uint32_t currentImage)
                 glm::scale(entity->getModelInstance()->getTransform(), glm::vec3{1.2f});
     }
     outline_buffer.view = m_CurrentScene->getCurrentCamera()->getViewMatrix();
-    m_OutlineBuffer->mapMemory(outline_buffer, currentImage);
+    offsets.outline = m_UniformRing->push(outline_buffer);
 
     m_LightSystem->update();
-    m_LightSystem->mapMemory(currentImage);
+    omp::ClusterView cluster_view{};
+    cluster_view.view = ubo.view;
+    cluster_view.projection = ubo.proj;
+    cluster_view.near_plane = m_CurrentScene->getCurrentCamera()->getNearClipping();
+    cluster_view.far_plane = m_CurrentScene->getCurrentCamera()->getFarClipping();
+    cluster_view.screen_size = {m_RenderViewport->getSize().x, m_RenderViewport->getSize().y};
+    m_LightSystem->updateClusters(cluster_view);
+    offsets.lights = m_LightSystem->writeToBuffer(*m_UniformRing);
+
+    // Offsets are baked into recorded command buffers
+    if (!(offsets == m_FrameUniformOffsets[currentFrame]))
+    {
+        m_FrameUniformOffsets[currentFrame] = offsets;
+        if (currentFrame < m_RecordedMainPasses.size())
+        {
+            m_RecordedMainPasses[currentFrame].valid = false;
+        }
+    }
 }
 
 void omp::Renderer::createDescriptorPool()
 {
-    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    std::array<VkDescriptorPoolSize, 4> pool_sizes{};
     pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     // TODO think about size
     pool_sizes[0].descriptorCount = 100;
@@ -1610,6 +2511,12 @@ void omp::Renderer::createDescriptorPool()
     pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     pool_sizes[1].descriptorCount = 100;
 
+    pool_sizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_sizes[2].descriptorCount = 100;
+
+    pool_sizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    pool_sizes[3].descriptorCount = 100;
+
     VkDescriptorPoolCreateInfo pool_info{};
     pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
@@ -1628,26 +2535,26 @@ void omp::Renderer::createDescriptorSets()
 {
     // Skybox
     {
-        std::vector<VkDescriptorSetLayout> layouts(m_PresentKHRImagesNum,
+        std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT,
                                                    m_SkyboxSetLayout);
 
         VkDescriptorSetAllocateInfo allocate_info{};
         allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         allocate_info.descriptorPool = m_DescriptorPool;
-        allocate_info.descriptorSetCount = m_PresentKHRImagesNum;
+        allocate_info.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
         allocate_info.pSetLayouts = layouts.data();
 
-        m_SkyboxDescriptorSets.resize(m_PresentKHRImagesNum);
+        m_SkyboxDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
         if (vkAllocateDescriptorSets(m_LogicalDevice, &allocate_info,
                                      m_SkyboxDescriptorSets.data()) != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to allocate descriptor sets!");
         }
-        for (size_t i = 0; i < m_PresentKHRImagesNum; i++)
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
             // Same ubo for outline, so use the same
             VkDescriptorBufferInfo buffer_info{};
-            buffer_info.buffer = m_OutlineBuffer->getBuffer(i);
+            buffer_info.buffer = m_UniformRing->getBuffer();
             buffer_info.offset = 0;
             buffer_info.range = sizeof(OutlineUniformBuffer);
 
@@ -1656,7 +2563,7 @@ void omp::Renderer::createDescriptorSets()
             descriptor_writes[0].dstSet = m_SkyboxDescriptorSets[i];
             descriptor_writes[0].dstBinding = 0;
             descriptor_writes[0].dstArrayElement = 0;
-            descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
             descriptor_writes[0].descriptorCount = 1;
             descriptor_writes[0].pBufferInfo = &buffer_info;
             vkUpdateDescriptorSets(m_LogicalDevice,
@@ -1667,26 +2574,26 @@ void omp::Renderer::createDescriptorSets()
 
     // OUTLINE
     {
-        std::vector<VkDescriptorSetLayout> layouts(m_PresentKHRImagesNum,
+        std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT,
                                                    m_OutlineSetLayout);
 
         VkDescriptorSetAllocateInfo allocate_info{};
         allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         allocate_info.descriptorPool = m_DescriptorPool;
-        allocate_info.descriptorSetCount = m_PresentKHRImagesNum;
+        allocate_info.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
         allocate_info.pSetLayouts = layouts.data();
 
-        m_OutlineDescriptorSets.resize(m_PresentKHRImagesNum);
+        m_OutlineDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
         if (vkAllocateDescriptorSets(m_LogicalDevice, &allocate_info,
                                      m_OutlineDescriptorSets.data()) !=
             VK_SUCCESS)
         {
             throw std::runtime_error("Failed to allocate descriptor sets!");
         }
-        for (size_t i = 0; i < m_PresentKHRImagesNum; i++)
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
             VkDescriptorBufferInfo buffer_info{};
-            buffer_info.buffer = m_OutlineBuffer->getBuffer(i);
+            buffer_info.buffer = m_UniformRing->getBuffer();
             buffer_info.offset = 0;
             buffer_info.range = sizeof(OutlineUniformBuffer);
 
@@ -1695,7 +2602,7 @@ void omp::Renderer::createDescriptorSets()
             descriptor_writes[0].dstSet = m_OutlineDescriptorSets[i];
             descriptor_writes[0].dstBinding = 0;
             descriptor_writes[0].dstArrayElement = 0;
-            descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
             descriptor_writes[0].descriptorCount = 1;
             descriptor_writes[0].pBufferInfo = &buffer_info;
             vkUpdateDescriptorSets(m_LogicalDevice,
@@ -1704,50 +2611,55 @@ void omp::Renderer::createDescriptorSets()
         }
     }
     // UBO
-    std::vector<VkDescriptorSetLayout> layouts(m_PresentKHRImagesNum,
+    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT,
                                                m_UboDescriptorSetLayout);
 
     VkDescriptorSetAllocateInfo allocate_info{};
     allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     allocate_info.descriptorPool = m_DescriptorPool;
-    allocate_info.descriptorSetCount = m_PresentKHRImagesNum;
+    allocate_info.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
     allocate_info.pSetLayouts = layouts.data();
 
-    m_UboDescriptorSets.resize(m_PresentKHRImagesNum);
+    m_UboDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
     if (vkAllocateDescriptorSets(m_LogicalDevice, &allocate_info,
                                  m_UboDescriptorSets.data()) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to allocate descriptor sets!");
     }
 
-    for (size_t i = 0; i < m_PresentKHRImagesNum; i++)
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
         VkDescriptorBufferInfo buffer_info{};
-        buffer_info.buffer = m_UboBuffer->getBuffer(i);
+        buffer_info.buffer = m_UniformRing->getBuffer();
         buffer_info.offset = 0;
         buffer_info.range = sizeof(UniformBufferObject);
 
         VkDescriptorBufferInfo global_light_info{};
-        global_light_info.buffer = m_LightSystem->getGlobalLightBuffer(i);
+        global_light_info.buffer = m_UniformRing->getBuffer();
         global_light_info.offset = 0;
         global_light_info.range = m_LightSystem->getGlobalLightBufferSize();
 
         VkDescriptorBufferInfo point_light_info{};
-        point_light_info.buffer = m_LightSystem->getPointLightBuffer(i);
+        point_light_info.buffer = m_UniformRing->getBuffer();
         point_light_info.offset = 0;
         point_light_info.range = m_LightSystem->getPointLightBufferSize();
 
         VkDescriptorBufferInfo spot_light_info{};
-        spot_light_info.buffer = m_LightSystem->getSpotLightBuffer(i);
+        spot_light_info.buffer = m_UniformRing->getBuffer();
         spot_light_info.offset = 0;
         spot_light_info.range = m_LightSystem->getSpotLightBufferSize();
 
-        std::array<VkWriteDescriptorSet, 4> descriptor_writes{};
+        VkDescriptorBufferInfo clusters_info{};
+        clusters_info.buffer = m_UniformRing->getBuffer();
+        clusters_info.offset = 0;
+        clusters_info.range = m_LightSystem->getClusterBufferSize();
+
+        std::array<VkWriteDescriptorSet, 5> descriptor_writes{};
         descriptor_writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptor_writes[0].dstSet = m_UboDescriptorSets[i];
         descriptor_writes[0].dstBinding = 0;
         descriptor_writes[0].dstArrayElement = 0;
-        descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         descriptor_writes[0].descriptorCount = 1;
         descriptor_writes[0].pBufferInfo = &buffer_info;
 
@@ -1755,7 +2667,7 @@ void omp::Renderer::createDescriptorSets()
         descriptor_writes[1].dstSet = m_UboDescriptorSets[i];
         descriptor_writes[1].dstBinding = 1;
         descriptor_writes[1].dstArrayElement = 0;
-        descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         descriptor_writes[1].descriptorCount = 1;
         descriptor_writes[1].pBufferInfo = &global_light_info;
 
@@ -1763,7 +2675,7 @@ void omp::Renderer::createDescriptorSets()
         descriptor_writes[2].dstSet = m_UboDescriptorSets[i];
         descriptor_writes[2].dstBinding = 2;
         descriptor_writes[2].dstArrayElement = 0;
-        descriptor_writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptor_writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
         descriptor_writes[2].descriptorCount = 1;
         descriptor_writes[2].pBufferInfo = &point_light_info;
 
@@ -1771,88 +2683,56 @@ void omp::Renderer::createDescriptorSets()
         descriptor_writes[3].dstSet = m_UboDescriptorSets[i];
         descriptor_writes[3].dstBinding = 3;
         descriptor_writes[3].dstArrayElement = 0;
-        descriptor_writes[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptor_writes[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
         descriptor_writes[3].descriptorCount = 1;
         descriptor_writes[3].pBufferInfo = &spot_light_info;
 
+        descriptor_writes[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_writes[4].dstSet = m_UboDescriptorSets[i];
+        descriptor_writes[4].dstBinding = 4;
+        descriptor_writes[4].dstArrayElement = 0;
+        descriptor_writes[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        descriptor_writes[4].descriptorCount = 1;
+        descriptor_writes[4].pBufferInfo = &clusters_info;
+
         vkUpdateDescriptorSets(m_LogicalDevice,
                                static_cast<uint32_t>(descriptor_writes.size()),
                                descriptor_writes.data(), 0, nullptr);
     }
 }
 
-void omp::Renderer::retrieveMaterialRenderState(
+bool omp::Renderer::retrieveMaterialRenderState(
         const std::shared_ptr<omp::Material>& material)
 {
     if (!material)
     {
         VWARN(LogRendering, "Material is invalid");
-        return;
+        return false;
     }
     if (material->isPotentiallyReadyForRendering())
     {
-        return;
-    }
-
-    std::vector<VkDescriptorSet> ds;
-    std::vector<VkDescriptorSetLayout> layouts(m_PresentKHRImagesNum,
-                                               m_TexturesDescriptorSetLayout);
-
-    VkDescriptorSetAllocateInfo allocate_info{};
-    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocate_info.descriptorPool = m_DescriptorPool;
-    allocate_info.descriptorSetCount = m_PresentKHRImagesNum;
-    allocate_info.pSetLayouts = layouts.data();
-
-    ds.resize(m_PresentKHRImagesNum);
-    auto err =
-            vkAllocateDescriptorSets(m_LogicalDevice, &allocate_info, ds.data());
-    if (err != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to allocate descriptor sets!");
+        return true;
     }
 
+    // Slots end up in instance data, recorded command buffers do not depend on them
+    glm::uvec4 indices{0};
     const omp::MaterialRenderInfo* const material_render_info =
             material->getRenderInfo();
-
-    // TODO performance
-    for (size_t index = 0; index < ds.size(); index++)
+    for (auto& data: material_render_info->textures)
     {
-        std::vector<VkWriteDescriptorSet> descriptor_writes{};
-        descriptor_writes.reserve(ds.size());
-
-        std::vector<VkDescriptorImageInfo> image_infos;
-        image_infos.reserve(material_render_info->textures.size());
-
-        for (auto& data: material_render_info->textures)
+        if (!data.texture || data.binding_index >= omp::MaterialRenderInfo::MAX_TEXTURES)
         {
-            VkDescriptorImageInfo image_info{};
-            auto& texture = data.texture;
-            image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            image_info.imageView = texture->getImageView();
-            image_info.sampler = texture->getSampler();
-            image_infos.push_back(image_info);
-
-            VkWriteDescriptorSet descriptor_write{};
-            descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptor_write.dstSet = ds[index];
-            descriptor_write.dstBinding = data.binding_index;
-            descriptor_write.dstArrayElement = 0;
-            descriptor_write.descriptorType =
-                    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptor_write.descriptorCount = 1;
-            descriptor_write.pImageInfo = &image_infos.at(data.binding_index);
-
-            descriptor_writes.push_back(descriptor_write);
+            continue;
         }
-
-        vkUpdateDescriptorSets(m_LogicalDevice,
-                               static_cast<uint32_t>(descriptor_writes.size()),
-                               descriptor_writes.data(), 0, nullptr);
+        // Slot is written only for uploaded images, so the array never points at an image in transfer
+        if (!data.texture->isReadyForSampling())
+        {
+            return false;
+        }
+        indices[data.binding_index] = m_VulkanContext->getBindlessTextures()->registerTexture(*data.texture);
     }
-    m_MaterialSets.insert(m_MaterialSets.begin(), ds.begin(), ds.end());
-
-    material->setDescriptorSet(ds);
+    material->setTextureIndices(indices);
+    return true;
 }
 
 VkCommandBuffer omp::Renderer::beginSingleTimeCommands()
@@ -1894,16 +2774,24 @@ void omp::Renderer::createDepthResources()
     m_VulkanContext->createImage(
             static_cast<uint32_t>(m_RenderViewport->getSize().x),
             static_cast<uint32_t>(m_RenderViewport->getSize().y), 1, depth_format,
-            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_DepthImage, m_DepthImageMemory,
-            m_MSAASamples);
+            m_MSAASamples, omp::EMemoryCategory::RenderTargets);
     m_DepthImageView = m_VulkanContext->createImageView(
             m_DepthImage, depth_format,
             VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 1);
+    m_DepthSampleView = m_VulkanContext->createImageView(
+            m_DepthImage, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 
     m_VulkanContext->transitionImageLayout(
             m_DepthImage, depth_format, VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
+
+    // Previous pyramid has other size, next frame starts without occlusion
+    const VkExtent2D depth_extent{static_cast<uint32_t>(m_RenderViewport->getSize().x),
+                                  static_cast<uint32_t>(m_RenderViewport->getSize().y)};
+    m_DepthPyramid = std::make_unique<omp::DepthPyramid>(
+            m_VulkanContext, m_DepthImage, m_DepthSampleView, depth_format, depth_extent, m_MSAASamples);
 }
 
 VkFormat omp::Renderer::findSupportedFormat(
@@ -1934,7 +2822,8 @@ VkFormat omp::Renderer::findDepthFormat()
     return findSupportedFormat(
             {VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT,
              VK_FORMAT_D32_SFLOAT},
-            VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 }
 
 void omp::Renderer::createImguiContext()
@@ -1990,7 +2879,7 @@ void omp::Renderer::initializeImgui(GLFWwindow* window)
     init_info.DescriptorPool = m_ImguiDescriptorPool;
     init_info.Allocator = VK_NULL_HANDLE;
     init_info.MinImageCount = 2;
-    init_info.ImageCount = m_PresentKHRImagesNum;
+    init_info.ImageCount = std::max(m_PresentKHRImagesNum, init_info.MinImageCount);
 
     // Imgui render pass should be created before call of this method
     ImGui_ImplVulkan_Init(&init_info, m_ImguiRenderPass->getRenderPass());
@@ -1998,7 +2887,6 @@ void omp::Renderer::initializeImgui(GLFWwindow* window)
     ImGui_ImplVulkan_CreateFontsTexture();
 
     createImguiFramebuffers();
-    createImguiCommandPools();
 }
 
 void omp::Renderer::createImguiRenderPass()
@@ -2037,18 +2925,104 @@ void omp::Renderer::createImguiRenderPass()
     m_ImguiRenderPass->endConfiguration();
 }
 
-void omp::Renderer::createImguiCommandPools()
+void omp::Renderer::createFrameCommandPools()
 {
     VkCommandPoolCreateInfo pool_info{};
     pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     pool_info.queueFamilyIndex =
             findQueueFamilies(m_PhysDevice).graphics_family.value();
-    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    // Pools are reset as a whole each frame, buffers are rerecorded
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-    if (vkCreateCommandPool(m_LogicalDevice, &pool_info, nullptr,
-                            &m_ImguiCommandPool))
+    m_FrameCommandPools.resize(MAX_FRAMES_IN_FLIGHT);
+    m_CommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    m_ImguiCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        if (vkCreateCommandPool(m_LogicalDevice, &pool_info, nullptr,
+                                &m_FrameCommandPools[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create frame command pool");
+        }
+
+        VkCommandBufferAllocateInfo buffer_info{};
+        buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        buffer_info.commandPool = m_FrameCommandPools[i];
+        buffer_info.commandBufferCount = 1;
+        m_CommandBuffers[i].reAllocate(m_LogicalDevice, m_FrameCommandPools[i],
+                                       buffer_info);
+        m_ImguiCommandBuffers[i].reAllocate(m_LogicalDevice, m_FrameCommandPools[i],
+                                            buffer_info);
+    }
+
+    m_RecordingSlots = (m_ThreadPool ? m_ThreadPool->getThreadCount() : 0) + 1;
+    m_RecordedMainPasses.assign(MAX_FRAMES_IN_FLIGHT, RecordedMainPass());
+    // Secondary buffers can be executed again in later frames
+    pool_info.flags = 0;
+    m_SecondaryCommandPools.resize(MAX_FRAMES_IN_FLIGHT * m_RecordingSlots);
+    m_SecondaryCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT * m_RecordingSlots);
+    for (size_t i = 0; i < m_SecondaryCommandPools.size(); i++)
+    {
+        if (vkCreateCommandPool(m_LogicalDevice, &pool_info, nullptr,
+                                &m_SecondaryCommandPools[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create secondary command pool");
+        }
+
+        VkCommandBufferAllocateInfo buffer_info{};
+        buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        buffer_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        buffer_info.commandPool = m_SecondaryCommandPools[i];
+        buffer_info.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(m_LogicalDevice, &buffer_info,
+                                     &m_SecondaryCommandBuffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate secondary command buffer");
+        }
+    }
+}
+
+void omp::Renderer::createGpuProfiler()
+{
+    // Valid bits are what tells whether the queue writes timestamps at all
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_PhysDevice, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_PhysDevice, &family_count, families.data());
+    const uint32_t graphics_family = findQueueFamilies(m_PhysDevice).graphics_family.value();
+    const uint32_t valid_bits = families[graphics_family].timestampValidBits;
+    if (valid_bits == 0)
+    {
+        WARN(LogRendering, "Timestamps are not supported, gpu time is not measured");
+    }
+    else if (!m_CalibratedTimestampsSupported)
+    {
+        INFO(LogRendering, "Calibrated timestamps are not supported, gpu scopes of traces start with their frame");
+    }
+
+    m_GpuProfiler = std::make_unique<omp::GpuProfiler>(m_VulkanContext, MAX_FRAMES_IN_FLIGHT,
+                                                       m_DeviceLimits.timestampPeriod, valid_bits,
+                                                       m_CalibratedTimestampsSupported);
+}
+
+void omp::Renderer::createStatisticsQueries()
+{
+    m_StatisticsWritten.assign(MAX_FRAMES_IN_FLIGHT, false);
+    if (!m_PipelineStatisticsSupported)
+    {
+        INFO(LogRendering, "Pipeline statistics are not supported, overdraw is not measured");
+        return;
+    }
+
+    VkQueryPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    pool_info.queryCount = MAX_FRAMES_IN_FLIGHT;
+    pool_info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+    if (vkCreateQueryPool(m_LogicalDevice, &pool_info, nullptr, &m_StatisticsQueryPool) != VK_SUCCESS)
     {
-        throw std::runtime_error("Failed to create imgui command pool");
+        throw std::runtime_error("Failed to create pipeline statistics query pool");
     }
 }
 
@@ -2072,6 +3046,8 @@ VkSampleCountFlagBits omp::Renderer::getMaxUsableSampleCount()
     VkSampleCountFlags counts =
             physical_device_properties.limits.framebufferColorSampleCounts &
             physical_device_properties.limits.framebufferDepthSampleCounts;
+    // Counts above requested maximum are dropped, one sample is always supported
+    counts &= (static_cast<VkSampleCountFlags>(m_MaxMsaaSamples) << 1) - 1;
 
     if (counts & VK_SAMPLE_COUNT_64_BIT)
     {
@@ -2111,9 +3087,12 @@ void omp::Renderer::createColorResources()
             VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT |
             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_ColorImage, m_ColorImageMemory,
-            m_MSAASamples);
+            m_MSAASamples, omp::EMemoryCategory::RenderTargets);
     m_ColorImageView = m_VulkanContext->createImageView(
             m_ColorImage, color_format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+    m_OitTargets->resize({static_cast<uint32_t>(m_RenderViewport->getSize().x),
+                          static_cast<uint32_t>(m_RenderViewport->getSize().y)});
 }
 
 void omp::Renderer::createViewportResources()
@@ -2126,7 +3105,7 @@ void omp::Renderer::createViewportResources()
             VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_ViewportImage,
-            m_ViewportImageMemory, VK_SAMPLE_COUNT_1_BIT);
+            m_ViewportImageMemory, VK_SAMPLE_COUNT_1_BIT, omp::EMemoryCategory::RenderTargets);
     m_ViewportImageView = m_VulkanContext->createImageView(
             m_ViewportImage, color_format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 
@@ -2153,26 +3132,192 @@ void omp::Renderer::createViewportResources()
 
 void omp::Renderer::createPickingResources()
 {
+    // Picking target does not depend on viewport size, so it lives until cleanup
     VkFormat image_format = VK_FORMAT_R32_SINT;
 
     m_VulkanContext->createImage(
-            static_cast<uint32_t>(m_RenderViewport->getSize().x),
-            static_cast<uint32_t>(m_RenderViewport->getSize().y), 1, image_format,
-            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_PickingImage, m_PickingMemory,
-            m_MSAASamples);
+            g_PickingExtent.width, g_PickingExtent.height, 1, image_format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_PickingImage, m_PickingMemory,
+            VK_SAMPLE_COUNT_1_BIT, omp::EMemoryCategory::RenderTargets);
     m_PickingImageView = m_VulkanContext->createImageView(
             m_PickingImage, image_format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 
+    VkFormat depth_format = findDepthFormat();
     m_VulkanContext->createImage(
-            static_cast<uint32_t>(m_RenderViewport->getSize().x),
-            static_cast<uint32_t>(m_RenderViewport->getSize().y), 1, image_format,
-            VK_IMAGE_TILING_LINEAR,
-            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_PickingResolve,
-            m_PickingResolveMemory, VK_SAMPLE_COUNT_1_BIT);
-    m_PickingResolveView = m_VulkanContext->createImageView(
-            m_PickingResolve, image_format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+            g_PickingExtent.width, g_PickingExtent.height, 1, depth_format,
+            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_PickingDepthImage,
+            m_PickingDepthMemory, VK_SAMPLE_COUNT_1_BIT, omp::EMemoryCategory::RenderTargets);
+    m_PickingDepthImageView = m_VulkanContext->createImageView(
+            m_PickingDepthImage, depth_format,
+            VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 1);
+
+    m_PickingFramebuffer = omp::FrameBuffer(
+            m_LogicalDevice, {m_PickingImageView, m_PickingDepthImageView},
+            m_PickingRenderPass, g_PickingExtent.width, g_PickingExtent.height);
+}
+
+void omp::Renderer::destroyPickingResources()
+{
+    m_PickingFramebuffer.destroyInnerState();
+
+    vkDestroyImageView(m_LogicalDevice, m_PickingImageView, nullptr);
+    m_VulkanContext->destroyImage(m_PickingImage, m_PickingMemory);
+    vkDestroyImageView(m_LogicalDevice, m_PickingDepthImageView, nullptr);
+    m_VulkanContext->destroyImage(m_PickingDepthImage, m_PickingDepthMemory);
+}
+
+void omp::Renderer::ensureInstanceBufferCapacity(uint32_t currentFrame, size_t instanceCount)
+{
+    if (m_InstanceBuffers.empty())
+    {
+        m_InstanceBuffers.resize(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+        m_InstanceBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+        m_InstanceBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT, nullptr);
+        m_InstanceBuffersCapacity.resize(MAX_FRAMES_IN_FLIGHT, 0);
+    }
+    if (m_InstanceBuffersCapacity[currentFrame] >= instanceCount && m_InstanceBuffers[currentFrame] != VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Fence of this frame is already waited, old buffer is not in use anymore
+    if (m_InstanceBuffers[currentFrame] != VK_NULL_HANDLE)
+    {
+        m_RecordedMainPasses[currentFrame].valid = false;
+        m_VulkanContext->destroyBuffer(m_InstanceBuffers[currentFrame], m_InstanceBuffersMemory[currentFrame]);
+    }
+
+    size_t capacity = std::max<size_t>(64, m_InstanceBuffersCapacity[currentFrame]);
+    while (capacity < instanceCount)
+    {
+        capacity *= 2;
+    }
+
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(omp::InstanceData),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            m_InstanceBuffers[currentFrame], m_InstanceBuffersMemory[currentFrame], omp::EMemoryCategory::Uniforms);
+    m_InstanceBuffersMapped[currentFrame] = m_InstanceBuffersMemory[currentFrame].mapped;
+    m_InstanceBuffersCapacity[currentFrame] = capacity;
+}
+
+void omp::Renderer::destroyInstanceBuffers()
+{
+    for (size_t i = 0; i < m_InstanceBuffers.size(); i++)
+    {
+        if (m_InstanceBuffers[i] == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+        m_VulkanContext->destroyBuffer(m_InstanceBuffers[i], m_InstanceBuffersMemory[i]);
+    }
+    m_InstanceBuffers.clear();
+    m_InstanceBuffersMemory.clear();
+    m_InstanceBuffersMapped.clear();
+    m_InstanceBuffersCapacity.clear();
+}
+
+void omp::Renderer::recordPickingPass(VkCommandBuffer inCommandBuffer, omp::RenderStats& outStats)
+{
+    // Only the latest click matters
+    ImVec2 mouse_data = m_MousePickingData.back();
+    m_MousePickingData = {};
+
+    std::vector<VkClearValue> clear_values{2};
+    clear_values[0].color.int32[0] = -1;
+    clear_values[1].depthStencil = {1.0f, 0};
+
+    VkRect2D rect{};
+    rect.offset = {0, 0};
+    rect.extent = g_PickingExtent;
+    beginRenderPass(m_PickingRenderPass.get(), inCommandBuffer,
+                    m_PickingFramebuffer, clear_values, rect);
+
+    // Shift the whole viewport so the clicked pixel lands on the 1x1 target
+    VkViewport viewport;
+    viewport.x = -std::floor(mouse_data.x);
+    viewport.y = -std::floor(mouse_data.y);
+    viewport.height = m_RenderViewport->getSize().y;
+    viewport.width = m_RenderViewport->getSize().x;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(inCommandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(inCommandBuffer, 0, 1, &rect);
+
+    omp::GraphicsPipeline* picking_pipeline = findGraphicsPipeline("Picking");
+    vkCmdBindPipeline(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      picking_pipeline->getGraphicsPipeline());
+    const std::array<uint32_t, 5> ubo_offsets = m_FrameUniformOffsets[m_CurrentFrame].getUboSetOffsets();
+    vkCmdBindDescriptorSets(inCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            picking_pipeline->getPipelineLayout(), 0, 1,
+                            &m_UboDescriptorSets[m_CurrentFrame],
+                            static_cast<uint32_t>(ubo_offsets.size()), ubo_offsets.data());
+    outStats.pipeline_binds++;
+    outStats.descriptor_set_binds++;
+
+    std::optional<uint32_t> bound_page;
+    for (auto& scene_entity: m_CurrentScene->getEntities())
+    {
+        auto model = scene_entity->getModelInstance()->getModel().lock();
+        if (!model || !m_VulkanContext->getUploadManager()->isReady(model->getGeometry().upload_ticket))
+        {
+            continue;
+        }
+        const omp::GeometryAllocation& geometry = model->getGeometry();
+        if (bound_page != geometry.page)
+        {
+            bindGeometryPage(inCommandBuffer, geometry.page, outStats);
+            bound_page = geometry.page;
+        }
+
+        omp::ModelPushConstant constant{
+                scene_entity->getModelInstance()->getTransform(), glm::vec4{},
+                glm::vec4{}, glm::vec4{}, scene_entity->getId()};
+        vkCmdPushConstants(inCommandBuffer, picking_pipeline->getPipelineLayout(),
+                           VK_SHADER_STAGE_VERTEX_BIT |
+                           VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, sizeof(omp::ModelPushConstant), &constant);
+        vkCmdDrawIndexed(inCommandBuffer, geometry.index_count, 1, geometry.first_index,
+                         static_cast<int32_t>(geometry.first_vertex), 0);
+        outStats.push_constant_bytes += sizeof(omp::ModelPushConstant);
+        outStats.addIndexedDraw(geometry.index_count, 1);
+    }
+    vkCmdEndRenderPass(inCommandBuffer);
+
+    VkImageSubresourceLayers subres{};
+    subres.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subres.mipLevel = 0;
+    subres.baseArrayLayer = 0;
+    subres.layerCount = 1;
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = subres;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {g_PickingExtent.width, g_PickingExtent.height, 1};
+    vkCmdCopyImageToBuffer(inCommandBuffer, m_PickingImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           m_PixelReadBuffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = m_PixelReadBuffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(inCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0,
+                         nullptr);
+
+    m_PickingFrame = m_CurrentFrame;
 }
 
 void omp::Renderer::renderAllUi()
@@ -2211,10 +3356,14 @@ void omp::Renderer::createImguiWidgets()
     // ORDER IS IMPORTANT DOCK NODES GO FIRST
 
     m_RenderViewport = std::make_shared<omp::ViewPort>();
-    // TODO: camera ui m_RenderViewport->setCamera(m_CurrentScene->getCurrentCamera());
+    m_RenderViewport->setCamera(m_CurrentScene->getCurrentCamera());
+    m_RenderViewport->setMouseClickCallback([this](ImVec2 pos)
+                                            { m_MousePickingData.push(pos); });
     auto material_panel = std::make_shared<omp::MaterialPanel>();
     auto entity = std::make_shared<omp::EntityPanel>();
     m_ScenePanel = std::make_shared<omp::ScenePanel>(entity, material_panel);
+    m_ScenePanel->setDrawStats(&m_DrawStats);
+    m_ScenePanel->setMemoryStats(&m_MemoryStats);
     // TODO: remake ui m_ScenePanel->setScene(m_CurrentScene);
     auto camera_panel =
             std::make_shared<omp::CameraPanel>(m_CurrentScene->getCurrentCamera());
@@ -2226,31 +3375,26 @@ void omp::Renderer::createImguiWidgets()
     m_Widgets.push_back(std::move(material_panel));
     m_Widgets.push_back(m_ScenePanel);
     m_Widgets.push_back(std::move(camera_panel));
+    m_Widgets.push_back(std::make_shared<omp::ProfilerPanel>(&omp::Profiler::getProfiler()));
+    m_Widgets.push_back(std::make_shared<omp::StatsOverlay>(&m_RenderStats));
+    m_Widgets.push_back(std::make_shared<omp::MemoryPanel>(&m_MemoryStats, &m_VulkanContext->getBudgetMonitor()));
     // TODO: light ui
     // m_Widgets.push_back(std::move(light_panel));
 }
 
 void omp::Renderer::destroyMainRenderPassResources()
 {
+    m_DepthPyramid.reset();
+    vkDestroyImageView(m_LogicalDevice, m_DepthSampleView, nullptr);
     vkDestroyImageView(m_LogicalDevice, m_DepthImageView, nullptr);
-    vkDestroyImage(m_LogicalDevice, m_DepthImage, nullptr);
-    vkFreeMemory(m_LogicalDevice, m_DepthImageMemory, nullptr);
+    m_VulkanContext->destroyImage(m_DepthImage, m_DepthImageMemory);
 
     vkDestroyImageView(m_LogicalDevice, m_ColorImageView, nullptr);
-    vkDestroyImage(m_LogicalDevice, m_ColorImage, nullptr);
-    vkFreeMemory(m_LogicalDevice, m_ColorImageMemory, nullptr);
+    m_VulkanContext->destroyImage(m_ColorImage, m_ColorImageMemory);
 
     vkDestroySampler(m_LogicalDevice, m_ViewportSampler, nullptr);
     vkDestroyImageView(m_LogicalDevice, m_ViewportImageView, nullptr);
-    vkDestroyImage(m_LogicalDevice, m_ViewportImage, nullptr);
-    vkFreeMemory(m_LogicalDevice, m_ViewportImageMemory, nullptr);
-
-    vkDestroyImageView(m_LogicalDevice, m_PickingImageView, nullptr);
-    vkDestroyImage(m_LogicalDevice, m_PickingImage, nullptr);
-    vkFreeMemory(m_LogicalDevice, m_PickingMemory, nullptr);
-    vkDestroyImageView(m_LogicalDevice, m_PickingResolveView, nullptr);
-    vkDestroyImage(m_LogicalDevice, m_PickingResolve, nullptr);
-    vkFreeMemory(m_LogicalDevice, m_PickingResolveMemory, nullptr);
+    m_VulkanContext->destroyImage(m_ViewportImage, m_ViewportImageMemory);
 
     for (auto& frame_buffer: m_SwapChainFramebuffers)
     {
@@ -2273,12 +3417,14 @@ void omp::Renderer::onViewportResize(size_t /*imageIndex*/)
             return;
         }
 
+        PROFILE_SCOPE("Resize viewport");
+        // Attachments can still be used by previous frame in flight
+        vkDeviceWaitIdle(m_LogicalDevice);
         destroyMainRenderPassResources();
 
         createColorResources();
         createDepthResources();
         createViewportResources();
-        createPickingResources();
 
         for (size_t index = 0; index < m_SwapChainFramebuffers.size(); index++)
         {
@@ -2292,6 +3438,8 @@ void omp::Renderer::onViewportResize(size_t /*imageIndex*/)
                 ImGui_ImplVulkan_AddTexture(m_ViewportSampler, m_ViewportImageView,
                                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
         m_RenderViewport->setImageId((ImTextureID) m_ViewportDescriptor);
+        // Viewport size is baked into recorded buffers
+        invalidateRecordedCommands();
     }
 }
 
@@ -2316,7 +3464,8 @@ void omp::Renderer::beginRenderPass(
         VkCommandBuffer inCommandBuffer,
         omp::FrameBuffer& inFrameBuffer,
         const std::vector<VkClearValue>& clearValues,
-        VkRect2D rect)
+        VkRect2D rect,
+        VkSubpassContents contents)
 {
     VkRenderPassBeginInfo render_pass_begin_info{};
     render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -2328,8 +3477,35 @@ void omp::Renderer::beginRenderPass(
             static_cast<uint32_t>(clearValues.size());
     render_pass_begin_info.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(inCommandBuffer, &render_pass_begin_info,
-                         VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(inCommandBuffer, &render_pass_begin_info, contents);
+}
+
+void omp::Renderer::beginSecondaryCommandBuffer(VkCommandBuffer inCommandBuffer)
+{
+    // Framebuffer is left unknown, recorded buffers are executed for any swapchain image
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = m_RenderPass->getRenderPass();
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = VK_NULL_HANDLE;
+    // Statistics query may be active in the primary buffer, recorded buffers are valid either way
+    if (m_PipelineStatisticsSupported)
+    {
+        inheritance_info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+    }
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    if (vkBeginCommandBuffer(inCommandBuffer, &begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to begin recording secondary command buffer!");
+    }
+
+    // Dynamic state is not inherited from the primary buffer
+    setViewport(inCommandBuffer);
 }
 
 void omp::Renderer::endRenderPass(
@@ -2347,16 +3523,19 @@ void omp::Renderer::prepareCommandBuffer(
         CommandBufferScope& bufferScope,
         VkCommandPool inCommandPool)
 {
-    VkCommandBufferAllocateInfo buffer_info{};
-    buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    buffer_info.commandPool = inCommandPool;
-    buffer_info.commandBufferCount = 1;
-    bufferScope.reAllocate(m_LogicalDevice, inCommandPool, buffer_info);
+    if (!bufferScope.is_allocated)
+    {
+        VkCommandBufferAllocateInfo buffer_info{};
+        buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        buffer_info.commandPool = inCommandPool;
+        buffer_info.commandBufferCount = 1;
+        bufferScope.reAllocate(m_LogicalDevice, inCommandPool, buffer_info);
+    }
 
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    begin_info.flags = 0;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     begin_info.pInheritanceInfo = nullptr;
 
     if (vkBeginCommandBuffer(bufferScope.buffer, &begin_info) != VK_SUCCESS)
@@ -2376,28 +3555,25 @@ void omp::Renderer::setViewport(VkCommandBuffer inCommandBuffer)
     viewport.maxDepth = 1.0f;
 
     vkCmdSetViewport(inCommandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.extent = {static_cast<uint32_t>(viewport.width), static_cast<uint32_t>(viewport.height)};
+    vkCmdSetScissor(inCommandBuffer, 0, 1, &scissor);
 }
 
 void omp::Renderer::destroyAllCommandBuffers()
 {
-    for (auto& scope: m_CommandBuffers)
-    {
-        scope.clearBuffer(m_LogicalDevice, m_CommandPool);
-    }
-    for (auto& scope: m_ImguiCommandBuffers)
+    for (size_t i = 0; i < m_FrameCommandPools.size(); i++)
     {
-        scope.clearBuffer(m_LogicalDevice, m_ImguiCommandPool);
+        m_CommandBuffers[i].clearBuffer(m_LogicalDevice, m_FrameCommandPools[i]);
+        m_ImguiCommandBuffers[i].clearBuffer(m_LogicalDevice, m_FrameCommandPools[i]);
     }
 }
 
 void omp::Renderer::initializeScene()
 {
     // TODO: should go to asset initialization
-    /* auto lambda = [this](ImVec2 pos)
-    { m_MousePickingData.push(pos); };
-    m_RenderViewport->setMouseClickCallback(lambda);
-
-    m_RenderViewport->setTranslationChangeCallback([this](float inVec[3])
+    /* m_RenderViewport->setTranslationChangeCallback([this](float inVec[3])
     {
         if (m_CurrentScene->getCurrentEntity())
         {
@@ -2500,59 +3676,28 @@ void omp::Renderer::initializeScene()
 
 void omp::Renderer::postFrame()
 {
-    while (!m_MousePickingData.empty())
-    {
-        ImVec2 mouse_data = m_MousePickingData.back();
-
-        // read mouse coordinate pixel from image
-        VkImageSubresourceLayers subres{};
-        subres.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        subres.mipLevel = 0;
-        subres.baseArrayLayer = 0;
-        subres.layerCount = 1;
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 1;
-        region.bufferImageHeight = 1;
-        region.imageSubresource = subres;
-        VkOffset3D offset{};
-        offset.x = static_cast<uint32_t>(m_RenderViewport->getLocalCursorPos().x);
-        offset.y = static_cast<uint32_t>(m_RenderViewport->getLocalCursorPos().y);
-        offset.z = 0;
-        region.imageOffset = offset;
-        VkExtent3D extent{};
-        extent.height = 1;
-        extent.width = 1;
-        extent.depth = 1;
-        region.imageExtent = extent;
-
-        m_VulkanContext->transitionImageLayout(
-                m_PickingResolve, VK_FORMAT_R32_SINT,
-                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 1);
-
-        VkCommandBuffer buffer = beginSingleTimeCommands();
-        vkCmdCopyImageToBuffer(buffer, m_PickingResolve,
-                               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                               m_PixelReadBuffer, 1, &region);
-        endSingleTimeCommands(buffer);
-
-        int32_t pixel_value = -1;
-        void* data;
-        vkMapMemory(m_VulkanContext->logical_device, m_PixelReadMemory, 0,
-                    sizeof(int32_t), 0, &data);
-        memcpy(&pixel_value, data, sizeof(int32_t));
-        vkUnmapMemory(m_VulkanContext->logical_device, m_PixelReadMemory);
-
-        m_CurrentScene->setCurrentId(pixel_value);
-        INFO(LogRendering, "value {}", pixel_value);
-
-        m_MousePickingData.pop();
+    PROFILE_SCOPE("Post frame");
+    if (!m_PickingFrame.has_value())
+    {
+        return;
     }
+
+    PROFILE_SCOPE("Picking readback");
+    // Wait only for the frame that has picking pass recorded
+    vkWaitForFences(m_LogicalDevice, 1, &m_InFlightFences[m_PickingFrame.value()],
+                    VK_TRUE, UINT64_MAX);
+    m_PickingFrame.reset();
+
+    int32_t pixel_value = -1;
+    memcpy(&pixel_value, m_PixelReadMemory.mapped, sizeof(int32_t));
+
+    m_CurrentScene->setCurrentId(pixel_value);
+    INFO(LogRendering, "value {}", pixel_value);
 }
 
 void omp::Renderer::tick(float deltaTime)
 {
+    PROFILE_SCOPE("Renderer tick");
     glm::mat4 projection = glm::perspective(
             glm::radians(m_CurrentScene->getCurrentCamera()->getViewAngle()),
             (float) m_RenderViewport->getSize().x /
@@ -2569,10 +3714,6 @@ void omp::Renderer::tick(float deltaTime)
     }
     m_RenderViewport->sendPickingData({id, projection, model});
 
-    // m_CurrentScene->getEntity("1-1")->getRotation().x += 1*deltaTime;
-    m_CurrentScene->getEntity("2-1")->getModelInstance()->getRotation().x +=
-            1 * deltaTime;
-    // m_CurrentScene->getEntity("dfasdf")->getRotation().x += 1*deltaTime;
     m_CurrentScene->getCurrentCamera()->applyInputs(deltaTime);
 }
 
@@ -2610,8 +3751,7 @@ omp::Renderer::addModelToScene(
 
 void omp::Renderer::loadModelInMemory(const std::shared_ptr<omp::Model>& inModel)
 {
-    inModel->loadIndexToMemory(m_VulkanContext);
-    inModel->loadVertexToMemory(m_VulkanContext);
+    inModel->loadToGeometryPool(m_GeometryPool);
 }
 
 void omp::Renderer::createLights()
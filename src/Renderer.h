@@ -5,6 +5,7 @@
 #define GLFW_INCLUDE_VULKAN
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 
 #define GLM_ENABLE_EXPERIMENTAL
 
@@ -15,6 +16,7 @@
 #include <cstdlib>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <optional>
 #include "array"
 #include <glm/glm.hpp>
@@ -33,6 +35,16 @@
 #include "Logs.h"
 #include "LightSystem.h"
 #include "Rendering/ModelStatics.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/RenderStats.h"
+#include "Rendering/GeometryPool.h"
+#include "Rendering/BindlessTextures.h"
+#include "Rendering/GpuCulling.h"
+#include "Rendering/DepthPyramid.h"
+#include "Rendering/OitTargets.h"
+#include "Rendering/PresentPolicy.h"
+#include "Rendering/GpuProfiler.h"
+#include "Math/Frustum.h"
 
 namespace
 {
@@ -71,6 +83,7 @@ namespace
 namespace omp
 {
     class ScenePanel;
+    class ThreadPool;
 
     class ViewPort;
 
@@ -92,6 +105,22 @@ namespace omp
         glm::mat4 view;
     };
 
+    // Dynamic offsets into uniform ring buffer for one frame in flight
+    struct FrameUniformOffsets
+    {
+        uint32_t ubo = 0;
+        uint32_t outline = 0;
+        omp::LightOffsets lights;
+
+        bool operator==(const FrameUniformOffsets& other) const = default;
+
+        // Ordered by bindings of ubo set
+        std::array<uint32_t, 5> getUboSetOffsets() const
+        {
+            return {ubo, lights.global, lights.point, lights.spot, lights.clusters};
+        }
+    };
+
     struct CommandBufferScope
     {
         VkCommandBuffer buffer;
@@ -123,6 +152,16 @@ namespace omp
     const std::string g_ModelPath = "../models/cube2.obj";
     const std::string g_TexturePath = "../textures/container.png";
     const VkClearColorValue g_ClearColor = {0.82f, 0.48f, 0.52f, 1.0f};
+    // Picking renders only the clicked pixel, viewport is shifted onto it
+    const VkExtent2D g_PickingExtent = {1, 1};
+    // Smaller chunks cost more in task overhead than they save in recording
+    const size_t g_MinBatchesPerChunk = 64;
+    // Opaque pipelines having a variant with this suffix are drawn after the depth pre-pass
+    const std::string g_DepthEqualSuffix = "DepthEqual";
+    // Subpasses of main and late passes, transparency accumulates after opaque draws and is composited last
+    const uint32_t g_OpaqueSubpass = 0;
+    const uint32_t g_TransparentSubpass = 1;
+    const uint32_t g_CompositeSubpass = 2;
 
     class Renderer
     {
@@ -130,6 +169,8 @@ namespace omp
         {
             std::optional<uint32_t> graphics_family;
             std::optional<uint32_t> present_family;
+            // Family without graphics, uploads fall back to graphics family when absent
+            std::optional<uint32_t> transfer_family;
 
             bool IsComplete() const
             {
@@ -150,6 +191,56 @@ namespace omp
         Renderer();
 
         void initVulkan(GLFWwindow* window);
+        // Has to be set before initVulkan, window is then null. Main pass renders into offscreen
+        // images of the given size, there is no surface, swapchain, presentation or ui
+        void setHeadless(VkExtent2D inExtent)
+        {
+            m_Headless = true;
+            m_HeadlessExtent = inExtent;
+        }
+        bool isHeadless() const { return m_Headless; }
+        // Have to be set before initVulkan
+        void setValidationLayers(bool inEnabled) { m_ValidationLayers = inEnabled; }
+        // Highest sample count the main pass may use, lower one is picked if device does not support it
+        void setMaxMsaaSamples(VkSampleCountFlagBits inSamples) { m_MaxMsaaSamples = inSamples; }
+        // Can change at runtime, swapchain is recreated before the next frame. Ignored when headless
+        void setPresentSettings(const omp::PresentSettings& inSettings);
+        const omp::PresentSettings& getPresentSettings() const { return m_PresentSettings; }
+        // What the surface actually gave for the settings
+        VkPresentModeKHR getPresentMode() const { return m_PresentMode; }
+        uint32_t getSwapChainImageCount() const { return m_PresentKHRImagesNum; }
+        // One makes every frame wait for the previous one, as before frames were pipelined.
+        // Kept to measure what pipelining gives, resources are still allocated for the maximum
+        void setFramesInFlight(uint32_t inCount) { m_FramesInFlight = std::clamp(inCount, 1u, MAX_FRAMES_IN_FLIGHT); }
+        uint32_t getFramesInFlight() const { return m_FramesInFlight; }
+        // Optional, has to be set before initResources to record the main pass on workers
+        void setThreadPool(omp::ThreadPool* inThreadPool) { m_ThreadPool = inThreadPool; }
+        // Reuse recorded main pass while batches stay the same, only uniforms and instances are updated
+        void setCommandBufferCaching(bool inEnabled) { m_CacheCommandBuffers = inEnabled; }
+        // Opaque batches are frustum culled in compute and drawn indirectly
+        void setGpuDrivenRendering(bool inEnabled)
+        {
+            m_GpuDrivenRendering = inEnabled;
+            invalidateRecordedCommands();
+        }
+        // Culled opaque batches are also tested against the depth pyramid, needs gpu driven rendering
+        void setOcclusionCulling(bool inEnabled)
+        {
+            m_OcclusionCulling = inEnabled;
+            // Pyramid is not rebuilt while disabled, its depth is stale
+            if (m_DepthPyramid)
+            {
+                m_DepthPyramid->invalidate();
+            }
+        }
+        // Opaque lit draws write depth first, then shade only the front fragment under equal depth test
+        void setDepthPrepass(bool inEnabled)
+        {
+            m_DepthPrepass = inEnabled;
+            invalidateRecordedCommands();
+        }
+        // Debug, counts fragment shader invocations of the main pass if pipeline statistics are supported
+        void setOverdrawStatistics(bool inEnabled) { m_OverdrawStatistics = inEnabled; }
         void initResources(omp::Scene* scene);
         // TODO: void initNewScene(omp::Scene* scene);
         
@@ -163,6 +254,13 @@ namespace omp
 
         void onWindowResize(int width, int height);
 
+        const omp::DrawStats& getDrawStats() const { return m_DrawStats; }
+        // Of the latest recorded frame, ui pass included
+        const omp::RenderStats& getRenderStats() const { return m_RenderStats; }
+        const omp::GpuMemoryStats& getMemoryStats() const { return m_MemoryStats; }
+        // Created with resources, null before initResources
+        omp::LightSystem* getLightSystem() const { return m_LightSystem.get(); }
+
     private:
 
         void pickPhysicalDevice();
@@ -190,6 +288,7 @@ namespace omp
         void createImageViews();
 
         void createRenderPass();
+        void createPickingRenderPass();
 
         void createGraphicsPipeline();
 
@@ -205,12 +304,31 @@ namespace omp
                 VkCommandBuffer inCommandBuffer,
                 omp::FrameBuffer& inFrameBuffer,
                 const std::vector<VkClearValue>& clearValues,
-                VkRect2D rect = VkRect2D());
+                VkRect2D rect = VkRect2D(),
+                VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        void beginSecondaryCommandBuffer(VkCommandBuffer inCommandBuffer);
+        // Recording functions add what they record to the stats, every thread has its own
+        void recordBatches(VkCommandBuffer inCommandBuffer, size_t firstBatch, size_t lastBatch,
+                           omp::RenderStats& outStats);
+        void recordCulledBatches(VkCommandBuffer inCommandBuffer, omp::RenderStats& outStats);
+        void recordDepthPrepass(VkCommandBuffer inCommandBuffer, size_t firstBatch, size_t lastBatch,
+                                omp::RenderStats& outStats);
+        void bindMaterialPipeline(VkCommandBuffer inCommandBuffer, omp::GraphicsPipeline* inPipeline,
+                                  omp::RenderStats& outStats);
+        void bindGeometryPage(VkCommandBuffer inCommandBuffer, uint32_t page, omp::RenderStats& outStats);
+        bool isGpuDriven() const { return m_GpuDrivenRendering && m_GpuCulling; }
+        bool isOcclusionCulled() const { return isGpuDriven() && m_OcclusionCulling; }
+        size_t recordMainPass(omp::RenderStats& outStats);
+        void recordTransparency(VkCommandBuffer inCommandBuffer, omp::SceneEntity* outlineEntity,
+                                omp::RenderStats& outStats);
+        // Counted from draw data the way the vulkan backend of imgui records it
+        static omp::RenderStats countUiCommands(const ImDrawData* drawData);
+        void invalidateRecordedCommands();
         void endRenderPass(omp::RenderPass* inRenderPass, VkCommandBuffer inCommandBuffer);
 
         void createUniformBuffers();
 
-        void updateUniformBuffer(uint32_t currentImage);
+        void updateUniformBuffer(uint32_t currentFrame);
 
         void prepareFrameForImage(size_t KHRImageIndex);
 
@@ -221,10 +339,18 @@ namespace omp
         void createColorResources();
         void createViewportResources();
         void createPickingResources();
+        void destroyPickingResources();
+        void recordPickingPass(VkCommandBuffer inCommandBuffer, omp::RenderStats& outStats);
+        void ensureInstanceBufferCapacity(uint32_t currentFrame, size_t instanceCount);
+        void destroyInstanceBuffers();
 
         void createSyncObjects();
 
         void createDescriptorSetLayout();
+        void createGpuCulling();
+        void createOitTargets();
+        void createGpuProfiler();
+        void createStatisticsQueries();
         void createDescriptorPool();
 
         void createDescriptorSets();
@@ -233,9 +359,14 @@ namespace omp
         std::shared_ptr<omp::ModelInstance> addModelToScene(const std::string& inName, const std::string& inPath);
         void loadModelInMemory(const std::shared_ptr<omp::Model>& inModel);
 
-        void retrieveMaterialRenderState(const std::shared_ptr<omp::Material>& material);
+        // False while any of material textures is still uploading, such materials are not drawn
+        bool retrieveMaterialRenderState(const std::shared_ptr<omp::Material>& material);
 
+        // Main pass does not depend on swapchain, only ui framebuffers are recreated unless format changes
         void recreateSwapChain();
+        // Everything built for the swapchain format, waits for device idle
+        void recreateSwapChainResources();
+        void destroyRetiredSwapChains(bool inForce);
 
         void cleanupSwapChain();
 
@@ -243,7 +374,7 @@ namespace omp
         void initializeImgui(GLFWwindow* window);
         void createImguiRenderPass();
 
-        void createImguiCommandPools();
+        void createFrameCommandPools();
         void renderAllUi();
         void createImguiWidgets();
         void createImguiFramebuffers();
@@ -263,7 +394,6 @@ namespace omp
 
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 
-        VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
@@ -282,6 +412,7 @@ namespace omp
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         std::vector<const char*> getRequiredExtensions();
+        std::vector<const char*> getDeviceExtensions() const;
 
         VkSampleCountFlagBits getMaxUsableSampleCount();
 
@@ -332,63 +463,119 @@ namespace omp
 
         // State //
         // ===== //
-        VkSurfaceKHR m_Surface;
+        VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
 
         VkInstance m_Instance;
 
-        VkPhysicalDevice m_PhysDevice;
+        VkPhysicalDevice m_PhysDevice = VK_NULL_HANDLE;
         VkPhysicalDeviceLimits m_DeviceLimits;
 
         VkDevice m_LogicalDevice;
 
-        VkSwapchainKHR m_SwapChain;
+        VkSwapchainKHR m_SwapChain = VK_NULL_HANDLE;
+        // Replaced swapchains, can still have pending presents. Destroyed once frames in flight have passed
+        struct RetiredSwapChain
+        {
+            VkSwapchainKHR swap_chain;
+            uint32_t frames_left;
+        };
+        std::vector<RetiredSwapChain> m_RetiredSwapChains;
 
         VkQueue m_GraphicsQueue;
 
         VkQueue m_PresentQueue;
 
+        VkQueue m_TransferQueue;
+
         uint32_t m_PresentKHRImagesNum;
 
         VkDescriptorSetLayout m_UboDescriptorSetLayout;
-        VkDescriptorSetLayout m_TexturesDescriptorSetLayout;
         VkDescriptorSetLayout m_OutlineSetLayout;
         VkDescriptorSetLayout m_SkyboxSetLayout;
 
         std::shared_ptr<omp::RenderPass> m_RenderPass;
+        std::shared_ptr<omp::RenderPass> m_PickingRenderPass;
 
         std::unordered_map<std::string, std::unique_ptr<omp::GraphicsPipeline>> m_Pipelines;
+        omp::RenderQueue m_RenderQueue;
+        omp::DrawStats m_DrawStats;
+        omp::RenderStats m_RenderStats;
+        omp::GpuMemoryStats m_MemoryStats;
 
         VkCommandPool m_CommandPool;
         VkDescriptorPool m_DescriptorPool;
         std::vector<VkDescriptorSet> m_UboDescriptorSets;
-        std::vector<VkDescriptorSet> m_MaterialSets;
         std::vector<VkDescriptorSet> m_OutlineDescriptorSets;
         std::vector<VkDescriptorSet> m_SkyboxDescriptorSets;
 
         std::shared_ptr<omp::Material> m_DefaultMaterial;
 
         VkImage m_ColorImage;
-        VkDeviceMemory m_ColorImageMemory;
+        omp::GpuAllocation m_ColorImageMemory;
         VkImageView m_ColorImageView;
 
         VkImage m_ViewportImage;
         VkImageView m_ViewportImageView;
         VkSampler m_ViewportSampler = VK_NULL_HANDLE;
-        VkDeviceMemory m_ViewportImageMemory;
+        omp::GpuAllocation m_ViewportImageMemory;
         VkDescriptorSet m_ViewportDescriptor = VK_NULL_HANDLE;
 
         VkImage m_PickingImage;
         VkImageView m_PickingImageView;
-        VkDeviceMemory m_PickingMemory;
-        VkImage m_PickingResolve;
-        VkImageView m_PickingResolveView;
-        VkDeviceMemory m_PickingResolveMemory;
+        omp::GpuAllocation m_PickingMemory;
+        VkImage m_PickingDepthImage;
+        VkImageView m_PickingDepthImageView;
+        omp::GpuAllocation m_PickingDepthMemory;
+        omp::FrameBuffer m_PickingFramebuffer;
+        // Frame which has recorded picking pass, result is read after its fence
+        std::optional<size_t> m_PickingFrame;
 
         VkBuffer m_PixelReadBuffer;
-        VkDeviceMemory m_PixelReadMemory;
-
-        std::unique_ptr<omp::UniformBuffer> m_UboBuffer;
-        std::unique_ptr<omp::UniformBuffer> m_OutlineBuffer;
+        omp::GpuAllocation m_PixelReadMemory;
+
+        // Per frame in flight, persistently mapped, grows with the render queue
+        std::vector<VkBuffer> m_InstanceBuffers;
+        std::vector<omp::GpuAllocation> m_InstanceBuffersMemory;
+        std::vector<void*> m_InstanceBuffersMapped;
+        std::vector<size_t> m_InstanceBuffersCapacity;
+
+        bool m_DrawIndirectCountSupported = false;
+        bool m_MultiDrawIndirectSupported = false;
+        bool m_GpuDrivenRendering = true;
+        std::unique_ptr<omp::GpuCulling> m_GpuCulling;
+        // Off by default, no measured win yet and disoccluded objects appear a frame late
+        bool m_OcclusionCulling = false;
+        // From the same matrices as the frame ubo
+        omp::Frustum m_ViewFrustum;
+        glm::mat4 m_ViewProjection{1.f};
+        // Built from main pass depth, culling of the next frame tests against it
+        std::unique_ptr<omp::DepthPyramid> m_DepthPyramid;
+        // Accumulation and revealage attachments of both passes, resized with color resources
+        std::unique_ptr<omp::OitTargets> m_OitTargets;
+
+        // Begin and end of the main pass per frame in flight
+        std::unique_ptr<omp::GpuProfiler> m_GpuProfiler;
+        // Puts gpu scopes onto the cpu timeline of traces
+        bool m_CalibratedTimestampsSupported = false;
+        // Real heap budgets and usage of the whole process, estimated without it
+        bool m_MemoryBudgetSupported = false;
+
+        bool m_DepthPrepass = false;
+        // Variants of opaque pipelines under equal depth test, their batches are also drawn in the pre-pass
+        std::unordered_set<omp::GraphicsPipeline*> m_DepthEqualPipelines;
+        // Pipelines of the accumulation subpass, their batches are drawn after every opaque one
+        std::unordered_set<omp::GraphicsPipeline*> m_TransparentPipelines;
+
+        // Fragment shader invocations of the main pass per frame in flight,
+        // query stays active over secondary buffers, so inherited queries are needed too
+        bool m_PipelineStatisticsSupported = false;
+        bool m_OverdrawStatistics = false;
+        VkQueryPool m_StatisticsQueryPool = VK_NULL_HANDLE;
+        std::vector<bool> m_StatisticsWritten;
+
+        // Ubo, outline and light data of all frames, written once per frame without remapping
+        std::unique_ptr<omp::UniformRingBuffer> m_UniformRing;
+        std::vector<FrameUniformOffsets> m_FrameUniformOffsets;
 
         std::vector<VkImage> m_SwapChainImages;
 
@@ -396,8 +583,33 @@ namespace omp
 
         std::vector<omp::FrameBuffer> m_SwapChainFramebuffers;
 
+        // Per frame in flight, reset as a whole when frame fence is signaled
+        std::vector<VkCommandPool> m_FrameCommandPools;
         std::vector<CommandBufferScope> m_CommandBuffers;
 
+        omp::ThreadPool* m_ThreadPool = nullptr;
+        // Secondary buffers of the main pass, indexed by frame * m_RecordingSlots + slot.
+        // Every slot has its own pool, so slots can be recorded in parallel,
+        // the last slot is recorded on the main thread
+        size_t m_RecordingSlots = 1;
+        std::vector<VkCommandPool> m_SecondaryCommandPools;
+        std::vector<VkCommandBuffer> m_SecondaryCommandBuffers;
+
+        // Only opaque subpass is recorded ahead, transparency and outline are recorded every frame
+        struct RecordedMainPass
+        {
+            bool valid = false;
+            std::vector<omp::DrawBatch> batches;
+            // Batches hold model pointers, their geometry ranges may have moved since
+            uint64_t geometry_generation = 0;
+            size_t chunk_count = 0;
+            // Of its secondary buffers, counted again every frame they are executed
+            omp::RenderStats stats;
+        };
+        bool m_CacheCommandBuffers = true;
+        // Per frame in flight, what its secondary buffers were recorded with
+        std::vector<RecordedMainPass> m_RecordedMainPasses;
+
         std::vector<VkSemaphore> m_ImageAvailableSemaphores;
         std::vector<VkSemaphore> m_RenderFinishedSemaphores;
 
@@ -405,14 +617,19 @@ namespace omp
         std::vector<VkFence> m_ImagesInFlight;
 
         VkImage m_DepthImage;
-        VkDeviceMemory m_DepthImageMemory;
+        omp::GpuAllocation m_DepthImageMemory;
         VkImageView m_DepthImageView;
+        // Depth aspect only, read by the depth pyramid
+        VkImageView m_DepthSampleView;
 
         omp::Scene* m_CurrentScene;
         std::shared_ptr<omp::ViewPort> m_RenderViewport;
         std::shared_ptr<omp::ScenePanel> m_ScenePanel;
 
         GLFWwindow* m_Window;
+        // Frames in flight stand in for swapchain images, nothing is presented
+        bool m_Headless = false;
+        VkExtent2D m_HeadlessExtent{};
 
         std::unique_ptr<omp::LightSystem> m_LightSystem;
 
@@ -429,20 +646,28 @@ namespace omp
         VkDebugUtilsMessengerEXT m_DebugMessenger;
 
         std::shared_ptr<omp::RenderPass> m_ImguiRenderPass;
-        VkCommandPool m_ImguiCommandPool;
         std::vector<CommandBufferScope> m_ImguiCommandBuffers;
         std::vector<omp::FrameBuffer> m_ImguiFramebuffers;
         VkDescriptorPool m_ImguiDescriptorPool;
 
         std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        // Vertices and indices of every loaded model
+        std::shared_ptr<omp::GeometryPool> m_GeometryPool;
 
         std::queue<ImVec2> m_MousePickingData{};
 
         VkSampleCountFlagBits m_MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+        VkSampleCountFlagBits m_MaxMsaaSamples = VK_SAMPLE_COUNT_64_BIT;
+        omp::PresentSettings m_PresentSettings;
+        bool m_PresentSettingsChanged = false;
+        VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
+        // Build default unless set
+        bool m_ValidationLayers;
 
         int m_CurrentWidth = 0;
         int m_CurrentHeight = 0;
-        const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+        uint32_t m_FramesInFlight = MAX_FRAMES_IN_FLIGHT;
 
     };
 }
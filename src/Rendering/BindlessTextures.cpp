@@ -0,0 +1,155 @@
+#include "BindlessTextures.h"
+#include <algorithm>
+#include <stdexcept>
+#include "Texture.h"
+#include "VulkanContext.h"
+#include "Logs.h"
+
+omp::BindlessTextures::BindlessTextures(const std::shared_ptr<omp::VulkanContext>& inVulkanContext,
+                                        uint32_t framesInFlight)
+    : m_VulkanContext(inVulkanContext)
+    , m_PendingSlots(std::max(framesInFlight, 1u))
+{
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties{};
+    indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexing_properties;
+    vkGetPhysicalDeviceProperties2(m_VulkanContext->phys_device, &properties);
+
+    m_Capacity = std::min({s_MaxTextures,
+                           indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+                           indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+                           indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                           indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = m_Capacity;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // Unwritten slots are never sampled, new slots are written while older frames are in flight
+    VkDescriptorBindingFlagsEXT binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_info{};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    binding_flags_info.bindingCount = 1;
+    binding_flags_info.pBindingFlags = &binding_flags;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.pNext = &binding_flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(m_VulkanContext->logical_device, &layout_info, nullptr, &m_SetLayout) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create bindless texture set layout");
+    }
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_size.descriptorCount = m_Capacity;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(m_VulkanContext->logical_device, &pool_info, nullptr, &m_DescriptorPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create bindless texture pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = m_DescriptorPool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &m_SetLayout;
+
+    if (vkAllocateDescriptorSets(m_VulkanContext->logical_device, &allocate_info, &m_DescriptorSet) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate bindless texture set");
+    }
+
+    INFO(LogRendering, "Bindless texture array created with {} slots", m_Capacity);
+}
+
+omp::BindlessTextures::~BindlessTextures()
+{
+    // Set is freed with the pool
+    vkDestroyDescriptorPool(m_VulkanContext->logical_device, m_DescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_VulkanContext->logical_device, m_SetLayout, nullptr);
+}
+
+uint32_t omp::BindlessTextures::registerTexture(omp::Texture& texture)
+{
+    if (texture.getBindlessIndex() != s_InvalidIndex)
+    {
+        return texture.getBindlessIndex();
+    }
+
+    uint32_t index;
+    if (!m_FreeSlots.empty())
+    {
+        index = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else if (m_NextSlot < m_Capacity)
+    {
+        index = m_NextSlot++;
+    }
+    else
+    {
+        // Any slot handed out here would alias a live texture
+        ERROR(LogRendering, "Bindless texture array is full, {} slots", m_Capacity);
+        throw std::runtime_error("Bindless texture array is full");
+    }
+
+    VkDescriptorImageInfo image_info{};
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    image_info.imageView = texture.getImageView();
+    image_info.sampler = texture.getSampler();
+
+    VkWriteDescriptorSet descriptor_write{};
+    descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptor_write.dstSet = m_DescriptorSet;
+    descriptor_write.dstBinding = 0;
+    descriptor_write.dstArrayElement = index;
+    descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptor_write.descriptorCount = 1;
+    descriptor_write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(m_VulkanContext->logical_device, 1, &descriptor_write, 0, nullptr);
+
+    m_Count++;
+    texture.setBindlessIndex(index);
+    return index;
+}
+
+void omp::BindlessTextures::releaseTexture(omp::Texture& texture)
+{
+    if (texture.getBindlessIndex() == s_InvalidIndex)
+    {
+        return;
+    }
+    // Frames in flight and materials that cached the slot may still sample it
+    m_PendingSlots[m_CurrentFrame].push_back(texture.getBindlessIndex());
+    m_Count--;
+    texture.setBindlessIndex(s_InvalidIndex);
+}
+
+void omp::BindlessTextures::beginFrame(uint32_t frame)
+{
+    m_CurrentFrame = frame % static_cast<uint32_t>(m_PendingSlots.size());
+    std::vector<uint32_t>& pending = m_PendingSlots[m_CurrentFrame];
+    m_FreeSlots.insert(m_FreeSlots.end(), pending.begin(), pending.end());
+    pending.clear();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <vector>
+
+namespace omp
+{
+    class Texture;
+    class VulkanContext;
+
+    /**
+     * One descriptor set with a large sampler2D array shared by every material pipeline.
+     * Textures get a slot on first use and shaders index the array with slots from instance data.
+     * Slots are written with update after bind, so recorded command buffers stay valid.
+     * Released slots are reused only once frames that could still sample them are finished.
+     */
+    class BindlessTextures
+    {
+    public:
+        static constexpr uint32_t s_MaxTextures = 4096;
+        static constexpr uint32_t s_InvalidIndex = UINT32_MAX;
+
+        BindlessTextures(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesInFlight);
+        BindlessTextures(const BindlessTextures&) = delete;
+        BindlessTextures& operator=(const BindlessTextures&) = delete;
+        ~BindlessTextures();
+
+    private:
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+        VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+
+        uint32_t m_Capacity = 0;
+        // Slots from here on were never written
+        uint32_t m_NextSlot = 0;
+        uint32_t m_Count = 0;
+        std::vector<uint32_t> m_FreeSlots;
+        // Per frame in flight, slots released while it was recorded
+        std::vector<std::vector<uint32_t>> m_PendingSlots;
+        uint32_t m_CurrentFrame = 0;
+
+        // Methods //
+        // ======= //
+    public:
+        // Same texture keeps its slot until it is released, throws once the array is full
+        uint32_t registerTexture(omp::Texture& texture);
+        // Slot goes back after the current frame's fence is waited again
+        void releaseTexture(omp::Texture& texture);
+        // Fence of the frame has to be waited, frees slots released while it was recorded last time
+        void beginFrame(uint32_t frame);
+
+        VkDescriptorSetLayout getSetLayout() const { return m_SetLayout; }
+        VkDescriptorSet getDescriptorSet() const { return m_DescriptorSet; }
+        uint32_t getCount() const { return m_Count; }
+        uint32_t getCapacity() const { return m_Capacity; }
+    };
+}
@@ -21,10 +21,14 @@ void omp::Cubemap::destroyVkObjects()
 {
     if (hasVulkanContext() && hasFlags(LOADED_TO_GPU))
     {
+        // Transfer queue must not write into a destroyed image, returns at once for finished uploads
+        if (omp::UploadManager* uploads = m_VulkanContext.lock()->getUploadManager())
+        {
+            uploads->wait(m_UploadTicket);
+        }
         vkDestroySampler(m_VulkanContext.lock()->logical_device, m_TextureSampler, nullptr);
         vkDestroyImageView(m_VulkanContext.lock()->logical_device, m_TextureImageView, nullptr);
-        vkDestroyImage(m_VulkanContext.lock()->logical_device, m_TextureImage, nullptr);
-        vkFreeMemory(m_VulkanContext.lock()->logical_device, m_TextureImageMemory, nullptr);
+        m_VulkanContext.lock()->destroyImage(m_TextureImage, m_TextureImageMemory);
     }
 }
 
@@ -93,28 +97,19 @@ void omp::Cubemap::createSampler()
 
 void omp::Cubemap::createImage()
 {
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
     size_t size = getFirstTextureSize();
     size_t mip_level = getFirstTextureMipMap();
     size_t width = getFirstTextureWidth();
     size_t height = getFirstTextureHeight();
 
     size_t size_to_alloc = getFirstTextureSize() * m_LayerAmount;
-    m_VulkanContext.lock()->createBuffer(size_to_alloc, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                         staging_buffer, staging_buffer_memory);
-
-    char* data;
-    vkMapMemory(m_VulkanContext.lock()->logical_device, staging_buffer_memory, 0, size_to_alloc, 0,
-                reinterpret_cast<void**>(&data));
+    std::vector<char> data(size_to_alloc);
     size_t offset = 0;
     for (auto& texture : m_Textures)
     {
-        memcpy(data + offset, texture->getPixels(), size);
+        memcpy(data.data() + offset, texture->getPixels(), size);
         offset += size;
     }
-    vkUnmapMemory(m_VulkanContext.lock()->logical_device, staging_buffer_memory);
 
     VkImageCreateFlags flags = 0;
     uint32_t array_layers = 1;
@@ -128,12 +123,9 @@ void omp::Cubemap::createImage()
                                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                                         VK_IMAGE_USAGE_SAMPLED_BIT,
                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_TextureImage, m_TextureImageMemory,
-                                        VK_SAMPLE_COUNT_1_BIT,
+                                        VK_SAMPLE_COUNT_1_BIT, omp::EMemoryCategory::Textures,
                                         flags, array_layers);
 
-    m_VulkanContext.lock()->transitionImageLayout(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-                                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_level);
-
     offset = 0;
     std::vector<VkBufferImageCopy> buffer_copy_regions{};
     buffer_copy_regions.reserve(m_LayerAmount);
@@ -151,14 +143,12 @@ void omp::Cubemap::createImage()
         buffer_copy_regions.push_back(buffer_copy_region);
         offset += size;
     }
-    m_VulkanContext.lock()->copyBufferToImage(staging_buffer, m_TextureImage, buffer_copy_regions);
-
-    //transitionImageLayout(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-    //                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
-    m_VulkanContext.lock()->generateMipmaps(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, width, height, mip_level);
 
-    vkDestroyBuffer(m_VulkanContext.lock()->logical_device, staging_buffer, nullptr);
-    vkFreeMemory(m_VulkanContext.lock()->logical_device, staging_buffer_memory, nullptr);
+    omp::UploadManager* uploads = m_VulkanContext.lock()->getUploadManager();
+    m_UploadTicket = uploads->uploadImage(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB,
+                                          data.data(), size_to_alloc, buffer_copy_regions,
+                                          mip_level, array_layers,
+                                          static_cast<int32_t>(width), static_cast<int32_t>(height));
 }
 
 void omp::Cubemap::createImageView()
@@ -317,3 +307,11 @@ void omp::Cubemap::setTextures(const std::vector<std::shared_ptr<omp::TextureSrc
     m_LayerAmount = m_Textures.size();
 }
 
+bool omp::Cubemap::isReadyForSampling()
+{
+    if (!hasFlags(LOADED_TO_GPU))
+    {
+        loadToGpu();
+    }
+    return hasFlags(LOADED_TO_GPU) && m_VulkanContext.lock()->getUploadManager()->isReady(m_UploadTicket);
+}
@@ -23,7 +23,7 @@ namespace omp
         // Vulkan //
         // ====== //
         VkImage m_TextureImage;
-        VkDeviceMemory m_TextureImageMemory;
+        omp::GpuAllocation m_TextureImageMemory;
         VkImageView m_TextureImageView;
         VkSampler m_TextureSampler;
 
@@ -31,6 +31,8 @@ namespace omp
 
         uint16_t m_Flags = 0;
         size_t m_LayerAmount = 1;
+        // Faces must not be sampled before the upload manager reports the ticket ready
+        omp::UploadTicket m_UploadTicket = 0;
 
     public:
         Cubemap() = default;
@@ -53,6 +55,8 @@ namespace omp
         VkImageView getImageView();
         VkImage getImage();
         VkSampler getSampler();
+        // Starts the upload on first call, true once the faces can be sampled by a frame
+        bool isReadyForSampling();
 
     protected:
         // Subroutines //
@@ -0,0 +1,247 @@
+#include "DepthPyramid.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include "Logs.h"
+
+namespace
+{
+    constexpr uint32_t g_PyramidGroupSize = 8;
+}
+
+omp::DepthPyramid::DepthPyramid(const std::shared_ptr<omp::VulkanContext>& inVulkanContext,
+                                VkImage depthImage, VkImageView depthView, VkFormat depthFormat,
+                                VkExtent2D depthExtent, VkSampleCountFlagBits depthSamples)
+    : m_VulkanContext(inVulkanContext)
+    , m_DepthImage(depthImage)
+    , m_DepthAspects(VK_IMAGE_ASPECT_DEPTH_BIT)
+    , m_DepthExtent(depthExtent)
+{
+    if (m_VulkanContext->hasStencilComponent(depthFormat))
+    {
+        m_DepthAspects |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    // Power of two keeps reduction exact, only depth to level 0 has a fractional footprint
+    m_Size = {std::bit_floor(std::max(depthExtent.width, 1u)), std::bit_floor(std::max(depthExtent.height, 1u))};
+    m_MipCount = static_cast<uint32_t>(std::bit_width(std::max(m_Size.x, m_Size.y)));
+
+    m_VulkanContext->createImage(
+            m_Size.x, m_Size.y, m_MipCount, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_Image, m_ImageMemory, VK_SAMPLE_COUNT_1_BIT, omp::EMemoryCategory::RenderTargets);
+    m_View = m_VulkanContext->createImageView(m_Image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, m_MipCount);
+    // Culling sets reference the pyramid before the first build
+    m_VulkanContext->transitionImageLayout(m_Image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED,
+                                           VK_IMAGE_LAYOUT_GENERAL, m_MipCount);
+
+    m_MipViews.resize(m_MipCount);
+    for (uint32_t mip = 0; mip < m_MipCount; mip++)
+    {
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = m_Image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = VK_FORMAT_R32_SFLOAT;
+        view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1};
+        if (vkCreateImageView(m_VulkanContext->logical_device, &view_info, nullptr, &m_MipViews[mip]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create depth pyramid mip view");
+        }
+    }
+
+    VkSamplerCreateInfo sampler_info{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = static_cast<float>(m_MipCount);
+    if (vkCreateSampler(m_VulkanContext->logical_device, &sampler_info, nullptr, &m_Sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create depth pyramid sampler");
+    }
+
+    // Source is fetched texel by texel, destination is written as storage image
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(m_VulkanContext->logical_device, &layout_info, nullptr, &m_SetLayout) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create depth pyramid set layout");
+    }
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_MipCount};
+    pool_sizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_MipCount};
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = m_MipCount;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    if (vkCreateDescriptorPool(m_VulkanContext->logical_device, &pool_info, nullptr, &m_DescriptorPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create depth pyramid descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> set_layouts(m_MipCount, m_SetLayout);
+    m_DescriptorSets.resize(m_MipCount);
+    VkDescriptorSetAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = m_DescriptorPool;
+    allocate_info.descriptorSetCount = m_MipCount;
+    allocate_info.pSetLayouts = set_layouts.data();
+    if (vkAllocateDescriptorSets(m_VulkanContext->logical_device, &allocate_info, m_DescriptorSets.data()) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate depth pyramid descriptor sets");
+    }
+
+    for (uint32_t mip = 0; mip < m_MipCount; mip++)
+    {
+        VkDescriptorImageInfo src_info{};
+        src_info.sampler = m_Sampler;
+        src_info.imageView = mip == 0 ? depthView : m_MipViews[mip - 1];
+        src_info.imageLayout = mip == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo dst_info{};
+        dst_info.imageView = m_MipViews[mip];
+        dst_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = m_DescriptorSets[mip];
+        writes[0].dstBinding = 0;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].descriptorCount = 1;
+        writes[0].pImageInfo = &src_info;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = m_DescriptorSets[mip];
+        writes[1].dstBinding = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].descriptorCount = 1;
+        writes[1].pImageInfo = &dst_info;
+        vkUpdateDescriptorSets(m_VulkanContext->logical_device, static_cast<uint32_t>(writes.size()), writes.data(),
+                               0, nullptr);
+    }
+
+    VkPushConstantRange push_constant{};
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_SetLayout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant;
+    if (vkCreatePipelineLayout(m_VulkanContext->logical_device, &pipeline_layout_info, nullptr, &m_PipelineLayout) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create depth pyramid pipeline layout");
+    }
+
+    // Multisampled depth needs its own fetch, every level after the first is a plain reduction
+    m_DepthPipeline = m_VulkanContext->createComputePipeline(
+            depthSamples == VK_SAMPLE_COUNT_1_BIT ? "../SPRV/hizReducecomp.spv" : "../SPRV/hizReduceMscomp.spv",
+            m_PipelineLayout);
+    m_ReducePipeline = m_VulkanContext->createComputePipeline("../SPRV/hizReducecomp.spv", m_PipelineLayout);
+
+    INFO(LogRendering, "Depth pyramid created: {}x{}, {} mips", m_Size.x, m_Size.y, m_MipCount);
+}
+
+omp::DepthPyramid::~DepthPyramid()
+{
+    VkDevice device = m_VulkanContext->logical_device;
+    vkDestroyPipeline(device, m_DepthPipeline, nullptr);
+    vkDestroyPipeline(device, m_ReducePipeline, nullptr);
+    vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+    // Sets are freed with the pool
+    vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, m_SetLayout, nullptr);
+    vkDestroySampler(device, m_Sampler, nullptr);
+    for (VkImageView view: m_MipViews)
+    {
+        vkDestroyImageView(device, view, nullptr);
+    }
+    vkDestroyImageView(device, m_View, nullptr);
+    m_VulkanContext->destroyImage(m_Image, m_ImageMemory);
+}
+
+void omp::DepthPyramid::recordBuild(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection)
+{
+    std::array<VkImageMemoryBarrier, 2> barriers{};
+    // Depth writes of the pass have to land before the first fetch
+    barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image = m_DepthImage;
+    barriers[0].subresourceRange = {m_DepthAspects, 0, 1, 0, 1};
+    // Previous content was already consumed by culling earlier in this frame
+    barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].image = m_Image;
+    barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_MipCount, 0, 1};
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    glm::uvec2 src_size{m_DepthExtent.width, m_DepthExtent.height};
+    for (uint32_t mip = 0; mip < m_MipCount; mip++)
+    {
+        const glm::uvec2 dst_size = glm::max(m_Size >> mip, glm::uvec2(1));
+        const PushConstants push_constants{src_size, dst_size};
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mip == 0 ? m_DepthPipeline : m_ReducePipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1,
+                                &m_DescriptorSets[mip], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants),
+                           &push_constants);
+        vkCmdDispatch(commandBuffer, (dst_size.x + g_PyramidGroupSize - 1) / g_PyramidGroupSize,
+                      (dst_size.y + g_PyramidGroupSize - 1) / g_PyramidGroupSize, 1);
+
+        // Next level reads this one, culling reads all of them
+        VkImageMemoryBarrier mip_barrier{};
+        mip_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        mip_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        mip_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        mip_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        mip_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        mip_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        mip_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        mip_barrier.image = m_Image;
+        mip_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &mip_barrier);
+        src_size = dst_size;
+    }
+
+    m_Built = true;
+    m_ViewProjection = viewProjection;
+}
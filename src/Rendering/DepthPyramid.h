@@ -0,0 +1,76 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <vector>
+#include "glm/glm.hpp"
+#include "VulkanContext.h"
+
+namespace omp
+{
+    /**
+     * Max depth mip chain of the main pass depth attachment, built by compute.
+     * Level 0 is the largest power of two that fits the depth image,
+     * so every texel of a level covers exactly four texels of the previous one.
+     * Image stays in general layout and is sampled with nearest filtering.
+     */
+    class DepthPyramid
+    {
+    public:
+        DepthPyramid(const std::shared_ptr<omp::VulkanContext>& inVulkanContext,
+                     VkImage depthImage, VkImageView depthView, VkFormat depthFormat,
+                     VkExtent2D depthExtent, VkSampleCountFlagBits depthSamples);
+        DepthPyramid(const DepthPyramid&) = delete;
+        DepthPyramid& operator=(const DepthPyramid&) = delete;
+        ~DepthPyramid();
+
+    private:
+        struct PushConstants
+        {
+            glm::uvec2 src_size;
+            glm::uvec2 dst_size;
+        };
+
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        VkImage m_DepthImage;
+        VkImageAspectFlags m_DepthAspects;
+        VkExtent2D m_DepthExtent;
+
+        VkImage m_Image = VK_NULL_HANDLE;
+        omp::GpuAllocation m_ImageMemory;
+        VkImageView m_View = VK_NULL_HANDLE;
+        std::vector<VkImageView> m_MipViews;
+        VkSampler m_Sampler = VK_NULL_HANDLE;
+        glm::uvec2 m_Size{1};
+        uint32_t m_MipCount = 1;
+
+        VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+        // First set reads depth attachment, every next one reads previous mip
+        std::vector<VkDescriptorSet> m_DescriptorSets;
+        VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_DepthPipeline = VK_NULL_HANDLE;
+        VkPipeline m_ReducePipeline = VK_NULL_HANDLE;
+
+        bool m_Built = false;
+        glm::mat4 m_ViewProjection{1.f};
+
+        // Methods //
+        // ======= //
+    public:
+        // Depth is expected in attachment layout after the pass and is left in read only layout
+        void recordBuild(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection);
+
+        // False until first build, its content is garbage before
+        bool isBuilt() const { return m_Built; }
+        // Culling ignores the pyramid until it is built again
+        void invalidate() { m_Built = false; }
+        // Camera the pyramid was built with
+        const glm::mat4& getViewProjection() const { return m_ViewProjection; }
+
+        VkImageView getView() const { return m_View; }
+        VkSampler getSampler() const { return m_Sampler; }
+        const glm::uvec2& getSize() const { return m_Size; }
+    };
+}
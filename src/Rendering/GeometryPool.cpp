@@ -0,0 +1,165 @@
+#include "GeometryPool.h"
+#include <algorithm>
+#include "VulkanContext.h"
+#include "Model.h"
+#include "Logs.h"
+
+omp::GeometryPool::GeometryPool(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesInFlight,
+                                uint32_t pageVertexCapacity, uint32_t pageIndexCapacity)
+    : m_VulkanContext(inVulkanContext)
+    , m_PageVertexCapacity(pageVertexCapacity)
+    , m_PageIndexCapacity(pageIndexCapacity)
+    , m_PendingFrees(std::max(framesInFlight, 1u))
+{
+
+}
+
+omp::GeometryPool::~GeometryPool()
+{
+    destroy();
+}
+
+void omp::GeometryPool::destroy()
+{
+    for (auto& page: m_Pages)
+    {
+        m_VulkanContext->destroyBuffer(page->vertex_buffer, page->vertex_memory);
+        m_VulkanContext->destroyBuffer(page->index_buffer, page->index_memory);
+    }
+    m_Pages.clear();
+    for (auto& pending: m_PendingFrees)
+    {
+        pending.clear();
+    }
+}
+
+uint32_t omp::GeometryPool::createPage(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    auto page = std::make_unique<Page>(Page{
+            VK_NULL_HANDLE, {}, VK_NULL_HANDLE, {},
+            omp::MemoryBlockMetadata(vertexCapacity, 1),
+            omp::MemoryBlockMetadata(indexCapacity, 1)});
+
+    m_VulkanContext->createBuffer(
+            static_cast<VkDeviceSize>(vertexCapacity) * sizeof(omp::Vertex),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            page->vertex_buffer, page->vertex_memory, omp::EMemoryCategory::Geometry);
+    m_VulkanContext->createBuffer(
+            static_cast<VkDeviceSize>(indexCapacity) * sizeof(uint32_t),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            page->index_buffer, page->index_memory, omp::EMemoryCategory::Geometry);
+
+    INFO(LogRendering, "Geometry pool page {} created: {} vertices, {} indices",
+         m_Pages.size(), vertexCapacity, indexCapacity);
+    m_Pages.push_back(std::move(page));
+    return static_cast<uint32_t>(m_Pages.size() - 1);
+}
+
+omp::GeometryAllocation omp::GeometryPool::upload(const std::vector<omp::Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    omp::GeometryAllocation allocation{};
+    if (vertices.empty() || indices.empty())
+    {
+        WARN(LogRendering, "Trying to upload empty geometry");
+        return allocation;
+    }
+
+    const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+    const uint32_t index_count = static_cast<uint32_t>(indices.size());
+
+    auto place = [&](uint32_t pageIndex) -> bool
+    {
+        Page& page = *m_Pages[pageIndex];
+        std::optional<VkDeviceSize> first_vertex = page.vertices.allocate(vertex_count, 1, omp::EAllocationKind::Linear);
+        if (!first_vertex)
+        {
+            return false;
+        }
+        std::optional<VkDeviceSize> first_index = page.indices.allocate(index_count, 1, omp::EAllocationKind::Linear);
+        if (!first_index)
+        {
+            page.vertices.free(*first_vertex);
+            return false;
+        }
+        allocation = {pageIndex, static_cast<uint32_t>(*first_vertex), vertex_count,
+                      static_cast<uint32_t>(*first_index), index_count};
+        return true;
+    };
+
+    bool placed = false;
+    for (uint32_t page = 0; page < m_Pages.size() && !placed; page++)
+    {
+        placed = place(page);
+    }
+    if (!placed)
+    {
+        // Oversized models get a page of their own
+        place(createPage(std::max(m_PageVertexCapacity, vertex_count),
+                         std::max(m_PageIndexCapacity, index_count)));
+    }
+
+    const Page& page = *m_Pages[allocation.page];
+    omp::UploadManager* uploads = m_VulkanContext->getUploadManager();
+
+    // Tickets grow in submission order, so index ticket covers the vertices too
+    uploads->uploadBuffer(page.vertex_buffer, sizeof(omp::Vertex) * static_cast<VkDeviceSize>(allocation.first_vertex),
+                          vertices.data(), sizeof(omp::Vertex) * vertices.size(),
+                          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    allocation.upload_ticket = uploads->uploadBuffer(
+            page.index_buffer, sizeof(uint32_t) * static_cast<VkDeviceSize>(allocation.first_index),
+            indices.data(), sizeof(uint32_t) * indices.size(),
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+
+    m_Generation++;
+    return allocation;
+}
+
+void omp::GeometryPool::free(omp::GeometryAllocation& allocation)
+{
+    if (!allocation.isValid() || allocation.page >= m_Pages.size())
+    {
+        return;
+    }
+    // Frames in flight and recorded command buffers may still draw the range
+    m_PendingFrees[m_CurrentFrame].push_back(allocation);
+    m_Generation++;
+    allocation = {};
+}
+
+void omp::GeometryPool::beginFrame(uint32_t frame)
+{
+    m_CurrentFrame = frame % static_cast<uint32_t>(m_PendingFrees.size());
+    std::vector<omp::GeometryAllocation>& pending = m_PendingFrees[m_CurrentFrame];
+    if (pending.empty())
+    {
+        return;
+    }
+
+    // Transfer queue may still write a range whose upload is not finished
+    omp::UploadManager* uploads = m_VulkanContext->getUploadManager();
+    std::erase_if(pending, [this, uploads](const omp::GeometryAllocation& allocation)
+    {
+        if (!uploads->isReady(allocation.upload_ticket))
+        {
+            return false;
+        }
+        release(allocation);
+        return true;
+    });
+}
+
+void omp::GeometryPool::release(const omp::GeometryAllocation& allocation)
+{
+    Page& page = *m_Pages[allocation.page];
+    page.vertices.free(allocation.first_vertex);
+    page.indices.free(allocation.first_index);
+}
+
+void omp::GeometryPool::bind(VkCommandBuffer commandBuffer, uint32_t page) const
+{
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_Pages[page]->vertex_buffer, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, m_Pages[page]->index_buffer, 0, VK_INDEX_TYPE_UINT32);
+}
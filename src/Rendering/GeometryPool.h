@@ -0,0 +1,89 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <vector>
+#include "GpuMemoryAllocator.h"
+#include "UploadManager.h"
+
+namespace omp
+{
+    class VulkanContext;
+    struct Vertex;
+
+    // Where model geometry lives inside the pool, offsets are in elements
+    struct GeometryAllocation
+    {
+        uint32_t page = 0;
+        uint32_t first_vertex = 0;
+        uint32_t vertex_count = 0;
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+        // Geometry must not be drawn before the upload manager reports the ticket ready
+        omp::UploadTicket upload_ticket = 0;
+
+        bool isValid() const { return vertex_count > 0; }
+    };
+
+    /**
+     * Vertices and indices of all models, sub-allocated from a few large device local buffers.
+     * Draws use firstIndex and vertexOffset, buffers are rebound only when page changes.
+     * Pages never move or grow, so recorded command buffers stay valid when models are added.
+     * Freed ranges are reused only once frames that could still draw them are finished.
+     */
+    class GeometryPool
+    {
+    public:
+        GeometryPool(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesInFlight,
+                     uint32_t pageVertexCapacity = 1 << 20, uint32_t pageIndexCapacity = 1 << 22);
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+        ~GeometryPool();
+
+    private:
+        struct Page
+        {
+            VkBuffer vertex_buffer = VK_NULL_HANDLE;
+            omp::GpuAllocation vertex_memory;
+            VkBuffer index_buffer = VK_NULL_HANDLE;
+            omp::GpuAllocation index_memory;
+
+            // Free lists, in vertices and indices
+            omp::MemoryBlockMetadata vertices;
+            omp::MemoryBlockMetadata indices;
+        };
+
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        uint32_t m_PageVertexCapacity;
+        uint32_t m_PageIndexCapacity;
+        std::vector<std::unique_ptr<Page>> m_Pages;
+
+        // Per frame in flight, frees requested while it was recorded
+        std::vector<std::vector<omp::GeometryAllocation>> m_PendingFrees;
+        uint32_t m_CurrentFrame = 0;
+        // Changes with every upload and free, draws recorded with another one may point at stale ranges
+        uint64_t m_Generation = 0;
+
+        // Methods //
+        // ======= //
+    public:
+        omp::GeometryAllocation upload(const std::vector<omp::Vertex>& vertices, const std::vector<uint32_t>& indices);
+        // Range goes back to the pool after the current frame's fence is waited again
+        void free(omp::GeometryAllocation& allocation);
+        // Fence of the frame has to be waited, releases what was freed while it was recorded last time
+        void beginFrame(uint32_t frame);
+        uint64_t getGeneration() const { return m_Generation; }
+
+        // Binds vertex binding 0 and index buffer of the page
+        void bind(VkCommandBuffer commandBuffer, uint32_t page) const;
+        size_t getPageCount() const { return m_Pages.size(); }
+
+        // Gpu must be idle, frees after destroy are ignored
+        void destroy();
+
+    private:
+        uint32_t createPage(uint32_t vertexCapacity, uint32_t indexCapacity);
+        void release(const omp::GeometryAllocation& allocation);
+    };
+}
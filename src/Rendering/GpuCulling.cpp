@@ -0,0 +1,417 @@
+#include "GpuCulling.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include "RenderQueue.h"
+#include "Model.h"
+#include "DepthPyramid.h"
+#include "Logs.h"
+
+namespace
+{
+    constexpr uint32_t g_CullGroupSize = 64;
+    constexpr uint32_t g_CullBufferCount = 9;
+    // Depth pyramid goes after the buffers
+    constexpr uint32_t g_PyramidBinding = g_CullBufferCount;
+}
+
+omp::GpuCulling::GpuCulling(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t frameCount,
+                            bool drawIndirectCount, bool multiDrawIndirect)
+    : m_VulkanContext(inVulkanContext)
+    , m_DrawIndirectCount(drawIndirectCount)
+    , m_MultiDrawIndirect(multiDrawIndirect)
+{
+    if (m_DrawIndirectCount)
+    {
+        m_CmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(m_VulkanContext->logical_device, "vkCmdDrawIndexedIndirectCountKHR"));
+        m_DrawIndirectCount = m_CmdDrawIndexedIndirectCount != nullptr;
+    }
+
+    // batches, batch ids, instances, culled instances, visible counts, commands, draw counts,
+    // view, stats and the depth pyramid
+    std::array<VkDescriptorSetLayoutBinding, g_CullBufferCount + 1> bindings{};
+    for (uint32_t binding = 0; binding < bindings.size(); binding++)
+    {
+        bindings[binding].binding = binding;
+        bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[g_PyramidBinding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(m_VulkanContext->logical_device, &layout_info, nullptr, &m_SetLayout) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create culling set layout");
+    }
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, g_CullBufferCount * frameCount};
+    pool_sizes[1] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount};
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = frameCount;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    if (vkCreateDescriptorPool(m_VulkanContext->logical_device, &pool_info, nullptr, &m_DescriptorPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create culling descriptor pool");
+    }
+
+    VkPushConstantRange push_constant{};
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_SetLayout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant;
+    if (vkCreatePipelineLayout(m_VulkanContext->logical_device, &pipeline_layout_info, nullptr, &m_PipelineLayout) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create culling pipeline layout");
+    }
+
+    m_CullPipeline = m_VulkanContext->createComputePipeline("../SPRV/cullcomp.spv", m_PipelineLayout);
+    m_CompactPipeline = m_VulkanContext->createComputePipeline("../SPRV/compactcomp.spv", m_PipelineLayout);
+
+    m_Frames.resize(frameCount);
+    std::vector<VkDescriptorSetLayout> set_layouts(frameCount, m_SetLayout);
+    std::vector<VkDescriptorSet> sets(frameCount);
+    VkDescriptorSetAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = m_DescriptorPool;
+    allocate_info.descriptorSetCount = frameCount;
+    allocate_info.pSetLayouts = set_layouts.data();
+    if (vkAllocateDescriptorSets(m_VulkanContext->logical_device, &allocate_info, sets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate culling descriptor sets");
+    }
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        FrameResources& resources = m_Frames[frame];
+        resources.descriptor_set = sets[frame];
+        // Both are small and touched by cpu every frame
+        m_VulkanContext->createBuffer(
+                sizeof(CullView), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                resources.view, resources.view_memory, omp::EMemoryCategory::Culling);
+        m_VulkanContext->createBuffer(
+                sizeof(omp::CullStats), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                resources.stats, resources.stats_memory, omp::EMemoryCategory::Culling);
+    }
+
+    INFO(LogRendering, "Gpu culling created, draw indirect count {}, multi draw indirect {}",
+         m_DrawIndirectCount, m_MultiDrawIndirect);
+}
+
+omp::GpuCulling::~GpuCulling()
+{
+    for (FrameResources& resources: m_Frames)
+    {
+        destroyFrameResources(resources);
+    }
+    vkDestroyPipeline(m_VulkanContext->logical_device, m_CullPipeline, nullptr);
+    vkDestroyPipeline(m_VulkanContext->logical_device, m_CompactPipeline, nullptr);
+    vkDestroyPipelineLayout(m_VulkanContext->logical_device, m_PipelineLayout, nullptr);
+    // Sets are freed with the pool
+    vkDestroyDescriptorPool(m_VulkanContext->logical_device, m_DescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_VulkanContext->logical_device, m_SetLayout, nullptr);
+}
+
+size_t omp::GpuCulling::getOpaqueBatchCount(const omp::RenderQueue& queue)
+{
+    const std::vector<omp::DrawBatch>& batches = queue.getBatches();
+    size_t count = 0;
+    while (count < batches.size() && (queue.getKey(batches[count].first) >> 63) == 0)
+    {
+        count++;
+    }
+    return count;
+}
+
+bool omp::GpuCulling::prepare(uint32_t frame, const omp::RenderQueue& queue, VkBuffer instances,
+                              const omp::DepthPyramid& pyramid)
+{
+    FrameResources& resources = m_Frames[frame];
+    if (resources.culled)
+    {
+        resources.last_stats = *static_cast<const omp::CullStats*>(resources.stats_memory.mapped);
+        resources.culled = false;
+    }
+
+    const std::vector<omp::DrawBatch>& batches = queue.getBatches();
+    const size_t batch_count = getOpaqueBatchCount(queue);
+    const size_t instance_count = batch_count > 0 ? batches[batch_count - 1].first + batches[batch_count - 1].count : 0;
+
+    // Fence of this frame is already waited, neither buffers nor the set are in use anymore
+    bool recreated = ensureBatchCapacity(resources, batch_count);
+    recreated = ensureInstanceCapacity(resources, instance_count) || recreated;
+    writeDescriptorSet(resources, instances, pyramid);
+    resources.pyramid = &pyramid;
+
+    resources.batch_count = static_cast<uint32_t>(batch_count);
+    resources.instance_count = static_cast<uint32_t>(instance_count);
+    resources.groups.clear();
+
+    auto* cull_batches = static_cast<CullBatch*>(resources.batches_memory.mapped);
+    auto* batch_ids = static_cast<uint32_t*>(resources.batch_ids_memory.mapped);
+    for (uint32_t index = 0; index < batch_count; index++)
+    {
+        const omp::DrawBatch& batch = batches[index];
+        const omp::GeometryAllocation& geometry = batch.model->getGeometry();
+
+        // Same pipeline and pool page can be drawn without rebinding anything
+        if (resources.groups.empty() || resources.groups.back().pipeline != batch.pipeline ||
+            resources.groups.back().page != geometry.page)
+        {
+            resources.groups.push_back({index, 0, batch.pipeline, geometry.page});
+        }
+        resources.groups.back().batch_count++;
+
+        cull_batches[index] = {batch.model->getBoundingSphere(),
+                               geometry.index_count, geometry.first_index,
+                               static_cast<int32_t>(geometry.first_vertex), batch.first,
+                               static_cast<uint32_t>(resources.groups.size() - 1),
+                               resources.groups.back().first_batch, {0, 0}};
+        std::fill_n(batch_ids + batch.first, batch.count, index);
+    }
+    return recreated;
+}
+
+void omp::GpuCulling::recordCulling(VkCommandBuffer commandBuffer, uint32_t frame, const omp::Frustum& frustum,
+                                    bool occlusion)
+{
+    FrameResources& resources = m_Frames[frame];
+    resources.occlusion = occlusion;
+    if (resources.batch_count == 0)
+    {
+        return;
+    }
+
+    // Pyramid of the previous frame is tested with the camera it was built with
+    auto* view = static_cast<CullView*>(resources.view_memory.mapped);
+    for (size_t plane = 0; plane < frustum.planes.size(); plane++)
+    {
+        view->planes[plane] = frustum.planes[plane];
+    }
+    view->pyramid_view_projection = resources.pyramid->getViewProjection();
+    view->pyramid_size = glm::vec2(resources.pyramid->getSize());
+    view->pyramid_valid = resources.pyramid->isBuilt() ? 1 : 0;
+
+    vkCmdFillBuffer(commandBuffer, resources.visible_counts, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(commandBuffer, resources.draw_counts, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(commandBuffer, resources.stats, 0, VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+
+    PushConstants push_constants{};
+    push_constants.instance_count = resources.instance_count;
+    push_constants.batch_count = resources.batch_count;
+    push_constants.instance_stride = sizeof(omp::InstanceData) / sizeof(uint32_t);
+    push_constants.compact = m_DrawIndirectCount ? 1 : 0;
+    push_constants.occlusion = resources.occlusion ? 1 : 0;
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1,
+                            &resources.descriptor_set, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants),
+                       &push_constants);
+
+    // One thread per instance, visible ones are appended to their batch
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+    vkCmdDispatch(commandBuffer, (resources.instance_count + g_CullGroupSize - 1) / g_CullGroupSize, 1, 1);
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+
+    // One thread per batch, writes its draw command
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CompactPipeline);
+    vkCmdDispatch(commandBuffer, (resources.batch_count + g_CullGroupSize - 1) / g_CullGroupSize, 1, 1);
+
+    // Stats are read on cpu after the fence
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                            VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                         VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+    resources.culled = true;
+}
+
+uint32_t omp::GpuCulling::recordDrawGroup(VkCommandBuffer commandBuffer, uint32_t frame, size_t group) const
+{
+    const FrameResources& resources = m_Frames[frame];
+    const omp::CullDrawGroup& draw_group = resources.groups[group];
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    const VkDeviceSize offset = draw_group.first_batch * stride;
+
+    if (m_DrawIndirectCount)
+    {
+        m_CmdDrawIndexedIndirectCount(commandBuffer, resources.commands, offset,
+                                      resources.draw_counts, sizeof(uint32_t) * group,
+                                      draw_group.batch_count, stride);
+        return 1;
+    }
+    if (m_MultiDrawIndirect)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, resources.commands, offset, draw_group.batch_count, stride);
+        return 1;
+    }
+    for (uint32_t index = 0; index < draw_group.batch_count; index++)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, resources.commands, offset + index * stride, 1, stride);
+    }
+    return draw_group.batch_count;
+}
+
+bool omp::GpuCulling::ensureBatchCapacity(FrameResources& resources, size_t batchCount)
+{
+    if (resources.batches != VK_NULL_HANDLE && resources.batch_capacity >= batchCount)
+    {
+        return false;
+    }
+
+    size_t capacity = std::max<size_t>(64, resources.batch_capacity);
+    while (capacity < batchCount)
+    {
+        capacity *= 2;
+    }
+
+    if (resources.batches != VK_NULL_HANDLE)
+    {
+        m_VulkanContext->destroyBuffer(resources.batches, resources.batches_memory);
+        m_VulkanContext->destroyBuffer(resources.visible_counts, resources.visible_counts_memory);
+        m_VulkanContext->destroyBuffer(resources.commands, resources.commands_memory);
+        m_VulkanContext->destroyBuffer(resources.draw_counts, resources.draw_counts_memory);
+    }
+
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(CullBatch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            resources.batches, resources.batches_memory, omp::EMemoryCategory::Culling);
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            resources.visible_counts, resources.visible_counts_memory, omp::EMemoryCategory::Culling);
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            resources.commands, resources.commands_memory, omp::EMemoryCategory::Culling);
+    // There are never more groups than batches
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            resources.draw_counts, resources.draw_counts_memory, omp::EMemoryCategory::Culling);
+    resources.batch_capacity = capacity;
+    return true;
+}
+
+bool omp::GpuCulling::ensureInstanceCapacity(FrameResources& resources, size_t instanceCount)
+{
+    if (resources.batch_ids != VK_NULL_HANDLE && resources.instance_capacity >= instanceCount)
+    {
+        return false;
+    }
+
+    size_t capacity = std::max<size_t>(64, resources.instance_capacity);
+    while (capacity < instanceCount)
+    {
+        capacity *= 2;
+    }
+
+    if (resources.batch_ids != VK_NULL_HANDLE)
+    {
+        m_VulkanContext->destroyBuffer(resources.batch_ids, resources.batch_ids_memory);
+        m_VulkanContext->destroyBuffer(resources.culled_instances, resources.culled_instances_memory);
+    }
+
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            resources.batch_ids, resources.batch_ids_memory, omp::EMemoryCategory::Culling);
+    m_VulkanContext->createBuffer(
+            capacity * sizeof(omp::InstanceData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            resources.culled_instances, resources.culled_instances_memory, omp::EMemoryCategory::Culling);
+    resources.instance_capacity = capacity;
+    return true;
+}
+
+void omp::GpuCulling::writeDescriptorSet(const FrameResources& resources, VkBuffer instances,
+                                         const omp::DepthPyramid& pyramid) const
+{
+    const std::array<VkBuffer, g_CullBufferCount> buffers{
+            resources.batches, resources.batch_ids, instances, resources.culled_instances,
+            resources.visible_counts, resources.commands, resources.draw_counts,
+            resources.view, resources.stats};
+
+    std::array<VkDescriptorBufferInfo, g_CullBufferCount> buffer_infos{};
+    std::array<VkWriteDescriptorSet, g_CullBufferCount + 1> writes{};
+    for (uint32_t binding = 0; binding < g_CullBufferCount; binding++)
+    {
+        buffer_infos[binding].buffer = buffers[binding];
+        buffer_infos[binding].offset = 0;
+        buffer_infos[binding].range = VK_WHOLE_SIZE;
+
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet = resources.descriptor_set;
+        writes[binding].dstBinding = binding;
+        writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].descriptorCount = 1;
+        writes[binding].pBufferInfo = &buffer_infos[binding];
+    }
+
+    // Pyramid is recreated with the depth image, so it is rewritten together with buffers
+    VkDescriptorImageInfo pyramid_info{};
+    pyramid_info.sampler = pyramid.getSampler();
+    pyramid_info.imageView = pyramid.getView();
+    pyramid_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    writes[g_PyramidBinding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[g_PyramidBinding].dstSet = resources.descriptor_set;
+    writes[g_PyramidBinding].dstBinding = g_PyramidBinding;
+    writes[g_PyramidBinding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[g_PyramidBinding].descriptorCount = 1;
+    writes[g_PyramidBinding].pImageInfo = &pyramid_info;
+    vkUpdateDescriptorSets(m_VulkanContext->logical_device, static_cast<uint32_t>(writes.size()), writes.data(),
+                           0, nullptr);
+}
+
+void omp::GpuCulling::destroyFrameResources(FrameResources& resources)
+{
+    if (resources.batches != VK_NULL_HANDLE)
+    {
+        m_VulkanContext->destroyBuffer(resources.batches, resources.batches_memory);
+        m_VulkanContext->destroyBuffer(resources.visible_counts, resources.visible_counts_memory);
+        m_VulkanContext->destroyBuffer(resources.commands, resources.commands_memory);
+        m_VulkanContext->destroyBuffer(resources.draw_counts, resources.draw_counts_memory);
+    }
+    if (resources.batch_ids != VK_NULL_HANDLE)
+    {
+        m_VulkanContext->destroyBuffer(resources.batch_ids, resources.batch_ids_memory);
+        m_VulkanContext->destroyBuffer(resources.culled_instances, resources.culled_instances_memory);
+    }
+    m_VulkanContext->destroyBuffer(resources.view, resources.view_memory);
+    m_VulkanContext->destroyBuffer(resources.stats, resources.stats_memory);
+    resources = {};
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <vector>
+#include "glm/glm.hpp"
+#include "VulkanContext.h"
+#include "Math/Frustum.h"
+
+namespace omp
+{
+    class RenderQueue;
+    class GraphicsPipeline;
+    class DepthPyramid;
+
+    // Run of opaque batches drawn with one indirect call
+    struct CullDrawGroup
+    {
+        uint32_t first_batch = 0;
+        uint32_t batch_count = 0;
+
+        omp::GraphicsPipeline* pipeline = nullptr;
+        uint32_t page = 0;
+
+        bool operator==(const CullDrawGroup& other) const = default;
+    };
+
+    // Counted by culling shaders, read back once the frame is finished
+    struct CullStats
+    {
+        uint32_t frustum_culled = 0;
+        uint32_t occlusion_culled = 0;
+        uint32_t occluded_triangles = 0;
+    };
+
+    /**
+     * Frustum culls opaque instances of the render queue in a compute shader.
+     * Visible instances are compacted per batch into a separate instance buffer
+     * and every batch gets a VkDrawIndexedIndirectCommand with its visible count.
+     * With draw indirect count empty batches are dropped and every group is a single draw,
+     * otherwise commands with zero instances stay in place.
+     *
+     * With occlusion instances are also tested against the depth pyramid of the previous frame,
+     * reprojected with the camera it was built with. Disoccluded objects show up one frame late.
+     */
+    class GpuCulling
+    {
+    public:
+        GpuCulling(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t frameCount,
+                   bool drawIndirectCount, bool multiDrawIndirect);
+        GpuCulling(const GpuCulling&) = delete;
+        GpuCulling& operator=(const GpuCulling&) = delete;
+        ~GpuCulling();
+
+    private:
+        // Matches CullBatch in cull.comp and compact.comp
+        struct CullBatch
+        {
+            glm::vec4 sphere;
+            uint32_t index_count;
+            uint32_t first_index;
+            int32_t vertex_offset;
+            uint32_t first_instance;
+            uint32_t draw_group;
+            uint32_t first_command;
+            uint32_t padding[2];
+        };
+
+        // Matches CullView in cull.comp
+        struct CullView
+        {
+            glm::vec4 planes[6];
+            // Camera the tested pyramid was built with
+            glm::mat4 pyramid_view_projection;
+            glm::vec2 pyramid_size;
+            uint32_t pyramid_valid;
+            uint32_t padding;
+        };
+
+        struct PushConstants
+        {
+            uint32_t instance_count;
+            uint32_t batch_count;
+            // In 32 bit words, instances are copied without knowing their layout
+            uint32_t instance_stride;
+            uint32_t compact;
+            uint32_t occlusion;
+        };
+
+        struct FrameResources
+        {
+            VkBuffer batches = VK_NULL_HANDLE;
+            omp::GpuAllocation batches_memory;
+            VkBuffer visible_counts = VK_NULL_HANDLE;
+            omp::GpuAllocation visible_counts_memory;
+            VkBuffer commands = VK_NULL_HANDLE;
+            omp::GpuAllocation commands_memory;
+            VkBuffer draw_counts = VK_NULL_HANDLE;
+            omp::GpuAllocation draw_counts_memory;
+            size_t batch_capacity = 0;
+
+            VkBuffer batch_ids = VK_NULL_HANDLE;
+            omp::GpuAllocation batch_ids_memory;
+            VkBuffer culled_instances = VK_NULL_HANDLE;
+            omp::GpuAllocation culled_instances_memory;
+            size_t instance_capacity = 0;
+
+            VkBuffer view = VK_NULL_HANDLE;
+            omp::GpuAllocation view_memory;
+            VkBuffer stats = VK_NULL_HANDLE;
+            omp::GpuAllocation stats_memory;
+
+            VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+
+            uint32_t batch_count = 0;
+            uint32_t instance_count = 0;
+            std::vector<omp::CullDrawGroup> groups;
+            const omp::DepthPyramid* pyramid = nullptr;
+            bool occlusion = false;
+
+            // Stats buffer holds results only after culling was submitted with this frame
+            bool culled = false;
+            omp::CullStats last_stats;
+        };
+
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        bool m_DrawIndirectCount;
+        bool m_MultiDrawIndirect;
+        PFN_vkCmdDrawIndexedIndirectCountKHR m_CmdDrawIndexedIndirectCount = nullptr;
+
+        VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+        VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_CullPipeline = VK_NULL_HANDLE;
+        VkPipeline m_CompactPipeline = VK_NULL_HANDLE;
+
+        std::vector<FrameResources> m_Frames;
+
+        // Methods //
+        // ======= //
+    public:
+        // Opaque batches form the front of the queue, transparent ones are drawn on cpu in their own subpass
+        static size_t getOpaqueBatchCount(const omp::RenderQueue& queue);
+
+        // Writes batches of the frame, returns true if buffers were recreated and recorded draws are stale
+        bool prepare(uint32_t frame, const omp::RenderQueue& queue, VkBuffer instances,
+                     const omp::DepthPyramid& pyramid);
+        // Culling is recorded outside of render pass, before the draws
+        void recordCulling(VkCommandBuffer commandBuffer, uint32_t frame, const omp::Frustum& frustum, bool occlusion);
+        // Returns the number of indirect calls recorded
+        uint32_t recordDrawGroup(VkCommandBuffer commandBuffer, uint32_t frame, size_t group) const;
+
+        const std::vector<omp::CullDrawGroup>& getDrawGroups(uint32_t frame) const { return m_Frames[frame].groups; }
+        VkBuffer getCulledInstances(uint32_t frame) const { return m_Frames[frame].culled_instances; }
+        bool usesDrawIndirectCount() const { return m_DrawIndirectCount; }
+        // Results of the previous submission of the frame
+        const omp::CullStats& getStats(uint32_t frame) const { return m_Frames[frame].last_stats; }
+
+    private:
+        // Return true if buffers were recreated
+        bool ensureBatchCapacity(FrameResources& resources, size_t batchCount);
+        bool ensureInstanceCapacity(FrameResources& resources, size_t instanceCount);
+        void writeDescriptorSet(const FrameResources& resources, VkBuffer instances,
+                                const omp::DepthPyramid& pyramid) const;
+        void destroyFrameResources(FrameResources& resources);
+    };
+}
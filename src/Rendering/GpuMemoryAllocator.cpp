@@ -0,0 +1,657 @@
+#include "GpuMemoryAllocator.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "Logs.h"
+
+namespace
+{
+    constexpr VkDeviceSize g_DefaultBlockSize = 64ull * 1024 * 1024;
+    constexpr VkDeviceSize g_SmallHeapSize = 1024ull * 1024 * 1024;
+    // Budget assumed without VK_EXT_memory_budget, the rest is left to other processes and the driver
+    constexpr double g_FallbackBudgetRatio = 0.8;
+
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+const char* omp::getMemoryCategoryName(EMemoryCategory category)
+{
+    switch (category)
+    {
+        case EMemoryCategory::Geometry: return "Geometry";
+        case EMemoryCategory::Textures: return "Textures";
+        case EMemoryCategory::RenderTargets: return "Render targets";
+        case EMemoryCategory::Uniforms: return "Uniforms";
+        case EMemoryCategory::Staging: return "Staging";
+        case EMemoryCategory::Culling: return "Culling";
+        case EMemoryCategory::Other:
+        case EMemoryCategory::Count: break;
+    }
+    return "Other";
+}
+
+omp::MemoryBlockMetadata::MemoryBlockMetadata(VkDeviceSize size, VkDeviceSize granularity)
+    : m_Size(size)
+    , m_Granularity(granularity > 0 ? granularity : 1)
+{
+    m_FreeLists.fill(s_NoRange);
+    linkFree(m_Ranges.insert({0, Range{size, true}}).first);
+}
+
+size_t omp::MemoryBlockMetadata::getList(VkDeviceSize size)
+{
+    if (size < s_SubClassCount)
+    {
+        return static_cast<size_t>(size);
+    }
+    const auto top_bit = static_cast<size_t>(std::bit_width(size) - 1);
+    const auto sub_class = static_cast<size_t>(size >> (top_bit - s_SubClassBits)) & (s_SubClassCount - 1);
+    return (top_bit - s_SubClassBits + 1) * s_SubClassCount + sub_class;
+}
+
+VkDeviceSize omp::MemoryBlockMetadata::getListMinSize(size_t list)
+{
+    if (list < s_SubClassCount)
+    {
+        return list;
+    }
+    const size_t top_bit = list / s_SubClassCount + s_SubClassBits - 1;
+    const VkDeviceSize sub_class = list % s_SubClassCount;
+    return (VkDeviceSize(1) << top_bit) + (sub_class << (top_bit - s_SubClassBits));
+}
+
+size_t omp::MemoryBlockMetadata::findList(size_t first) const
+{
+    if (first >= s_ListCount)
+    {
+        return s_ListCount;
+    }
+    size_t size_class = first / s_SubClassCount;
+    const uint32_t sub_mask = m_SubClassMasks[size_class] & (0xffffu << (first % s_SubClassCount));
+    if (sub_mask != 0)
+    {
+        return size_class * s_SubClassCount + static_cast<size_t>(std::countr_zero(sub_mask));
+    }
+
+    const uint64_t class_mask = size_class + 1 < 64 ? m_ClassMask & (~uint64_t(0) << (size_class + 1)) : 0;
+    if (class_mask == 0)
+    {
+        return s_ListCount;
+    }
+    size_class = static_cast<size_t>(std::countr_zero(class_mask));
+    return size_class * s_SubClassCount + static_cast<size_t>(std::countr_zero(m_SubClassMasks[size_class]));
+}
+
+void omp::MemoryBlockMetadata::linkFree(RangeIterator it)
+{
+    const size_t list = getList(it->second.size);
+    it->second.previous_free = s_NoRange;
+    it->second.next_free = m_FreeLists[list];
+    if (m_FreeLists[list] != s_NoRange)
+    {
+        m_Ranges.find(m_FreeLists[list])->second.previous_free = it->first;
+    }
+    m_FreeLists[list] = it->first;
+
+    const size_t size_class = list / s_SubClassCount;
+    m_SubClassMasks[size_class] |= static_cast<uint16_t>(1u << (list % s_SubClassCount));
+    m_ClassMask |= uint64_t(1) << size_class;
+    m_FreeRangeCount++;
+}
+
+void omp::MemoryBlockMetadata::unlinkFree(RangeIterator it)
+{
+    const size_t list = getList(it->second.size);
+    if (it->second.previous_free != s_NoRange)
+    {
+        m_Ranges.find(it->second.previous_free)->second.next_free = it->second.next_free;
+    }
+    else
+    {
+        m_FreeLists[list] = it->second.next_free;
+    }
+    if (it->second.next_free != s_NoRange)
+    {
+        m_Ranges.find(it->second.next_free)->second.previous_free = it->second.previous_free;
+    }
+
+    if (m_FreeLists[list] == s_NoRange)
+    {
+        const size_t size_class = list / s_SubClassCount;
+        m_SubClassMasks[size_class] &= static_cast<uint16_t>(~(1u << (list % s_SubClassCount)));
+        if (m_SubClassMasks[size_class] == 0)
+        {
+            m_ClassMask &= ~(uint64_t(1) << size_class);
+        }
+    }
+    m_FreeRangeCount--;
+}
+
+bool omp::MemoryBlockMetadata::onSamePage(VkDeviceSize lastByteOfFirst, VkDeviceSize firstByteOfSecond) const
+{
+    const VkDeviceSize page_mask = ~(m_Granularity - 1);
+    return (lastByteOfFirst & page_mask) == (firstByteOfSecond & page_mask);
+}
+
+std::optional<VkDeviceSize> omp::MemoryBlockMetadata::fitInto(
+        std::map<VkDeviceSize, Range>::const_iterator it,
+        VkDeviceSize size, VkDeviceSize alignment, EAllocationKind kind) const
+{
+    VkDeviceSize offset = alignUp(it->first, alignment);
+
+    if (it != m_Ranges.begin())
+    {
+        auto previous = std::prev(it);
+        if (!previous->second.free && previous->second.kind != kind
+            && onSamePage(previous->first + previous->second.size - 1, offset))
+        {
+            offset = alignUp(offset, std::max(alignment, m_Granularity));
+        }
+    }
+
+    const VkDeviceSize end = offset + size;
+    if (end > it->first + it->second.size)
+    {
+        return std::nullopt;
+    }
+
+    auto next = std::next(it);
+    if (next != m_Ranges.end() && !next->second.free && next->second.kind != kind
+        && onSamePage(end - 1, next->first))
+    {
+        return std::nullopt;
+    }
+    return offset;
+}
+
+bool omp::MemoryBlockMetadata::findInList(size_t list, VkDeviceSize size, VkDeviceSize alignment,
+                                          EAllocationKind kind, RangeIterator& outRange, VkDeviceSize& outOffset)
+{
+    // Usually the head fits, alignment and granularity padding can make it too small
+    for (VkDeviceSize range_offset = m_FreeLists[list]; range_offset != s_NoRange;)
+    {
+        auto it = m_Ranges.find(range_offset);
+        if (it->second.size >= size)
+        {
+            std::optional<VkDeviceSize> offset = fitInto(it, size, alignment, kind);
+            if (offset)
+            {
+                outRange = it;
+                outOffset = *offset;
+                return true;
+            }
+        }
+        range_offset = it->second.next_free;
+    }
+    return false;
+}
+
+std::optional<VkDeviceSize> omp::MemoryBlockMetadata::allocate(VkDeviceSize size, VkDeviceSize alignment, EAllocationKind kind)
+{
+    alignment = std::max<VkDeviceSize>(alignment, 1);
+    if (size > m_Size)
+    {
+        return std::nullopt;
+    }
+
+    // Lists from the next class up only hold ranges big enough, the own class is the last resort
+    const size_t own_list = getList(size);
+    const size_t first_list = getListMinSize(own_list) < size ? own_list + 1 : own_list;
+
+    RangeIterator best = m_Ranges.end();
+    VkDeviceSize best_offset = 0;
+    bool found = false;
+    for (size_t list = findList(first_list); !found && list < s_ListCount; list = findList(list + 1))
+    {
+        found = findInList(list, size, alignment, kind, best, best_offset);
+    }
+    if (!found && first_list != own_list)
+    {
+        found = findInList(own_list, size, alignment, kind, best, best_offset);
+    }
+    if (!found)
+    {
+        return std::nullopt;
+    }
+
+    const VkDeviceSize range_offset = best->first;
+    const VkDeviceSize range_end = best->first + best->second.size;
+    unlinkFree(best);
+    m_Ranges.erase(best);
+
+    // Padding before keeps a used neighbour, so nothing to merge with
+    if (best_offset > range_offset)
+    {
+        linkFree(m_Ranges.insert({range_offset, Range{best_offset - range_offset, true}}).first);
+    }
+    m_Ranges.insert({best_offset, Range{size, false, kind}});
+    if (best_offset + size < range_end)
+    {
+        linkFree(m_Ranges.insert({best_offset + size, Range{range_end - best_offset - size, true}}).first);
+    }
+
+    m_Used += size;
+    m_AllocationCount++;
+    return best_offset;
+}
+
+void omp::MemoryBlockMetadata::free(VkDeviceSize offset)
+{
+    auto it = m_Ranges.find(offset);
+    if (it == m_Ranges.end() || it->second.free)
+    {
+        WARN(LogRendering, "Trying to free unknown memory range at offset {}", offset);
+        return;
+    }
+
+    m_Used -= it->second.size;
+    m_AllocationCount--;
+    it->second.free = true;
+
+    auto next = std::next(it);
+    if (next != m_Ranges.end() && next->second.free)
+    {
+        unlinkFree(next);
+        it->second.size += next->second.size;
+        m_Ranges.erase(next);
+    }
+    if (it != m_Ranges.begin())
+    {
+        auto previous = std::prev(it);
+        if (previous->second.free)
+        {
+            unlinkFree(previous);
+            previous->second.size += it->second.size;
+            m_Ranges.erase(it);
+            it = previous;
+        }
+    }
+    linkFree(it);
+}
+
+VkDeviceSize omp::MemoryBlockMetadata::getLargestFreeRange() const
+{
+    if (m_ClassMask == 0)
+    {
+        return 0;
+    }
+    // Only the top non empty list can hold the largest range
+    const auto size_class = static_cast<size_t>(std::bit_width(m_ClassMask) - 1);
+    const auto sub_class = static_cast<size_t>(std::bit_width(m_SubClassMasks[size_class]) - 1);
+
+    VkDeviceSize largest = 0;
+    for (VkDeviceSize range_offset = m_FreeLists[size_class * s_SubClassCount + sub_class]; range_offset != s_NoRange;)
+    {
+        const Range& range = m_Ranges.find(range_offset)->second;
+        largest = std::max(largest, range.size);
+        range_offset = range.next_free;
+    }
+    return largest;
+}
+
+std::vector<uint32_t> omp::MemoryBudgetMonitor::update(const std::vector<GpuHeapBudget>& heaps)
+{
+    m_Heaps = heaps;
+    m_Pressure.resize(heaps.size(), EBudgetPressure::Normal);
+
+    std::vector<uint32_t> rising;
+    for (uint32_t heap = 0; heap < heaps.size(); heap++)
+    {
+        const auto usage = static_cast<double>(heaps[heap].usage);
+        const auto budget = static_cast<double>(heaps[heap].budget);
+        EBudgetPressure pressure = m_Pressure[heap];
+        if (budget <= 0.0)
+        {
+            pressure = EBudgetPressure::Normal;
+        }
+        else if (usage > budget)
+        {
+            pressure = EBudgetPressure::Over;
+        }
+        else if (usage > budget * s_NearRatio)
+        {
+            pressure = EBudgetPressure::Near;
+        }
+        else if (usage < budget * s_ReleaseRatio)
+        {
+            pressure = EBudgetPressure::Normal;
+        }
+        else if (pressure == EBudgetPressure::Over)
+        {
+            // Between release and near ratio the heap stays near until it drops below release one
+            pressure = EBudgetPressure::Near;
+        }
+
+        if (pressure > m_Pressure[heap])
+        {
+            rising.push_back(heap);
+        }
+        m_Pressure[heap] = pressure;
+    }
+    return rising;
+}
+
+omp::EBudgetPressure omp::MemoryBudgetMonitor::getPressure(uint32_t heap) const
+{
+    return heap < m_Pressure.size() ? m_Pressure[heap] : EBudgetPressure::Normal;
+}
+
+VkDeviceSize omp::MemoryBudgetMonitor::getEvictionBytes(uint32_t heap) const
+{
+    if (heap >= m_Heaps.size())
+    {
+        return 0;
+    }
+    const auto target = static_cast<VkDeviceSize>(static_cast<double>(m_Heaps[heap].budget) * s_NearRatio);
+    return m_Heaps[heap].usage > target ? m_Heaps[heap].usage - target : 0;
+}
+
+bool omp::MemoryBudgetMonitor::isUnderPressure() const
+{
+    return std::any_of(m_Pressure.begin(), m_Pressure.end(),
+                       [](EBudgetPressure pressure) { return pressure != EBudgetPressure::Normal; });
+}
+
+omp::GpuMemoryAllocator::GpuMemoryAllocator(
+        VkDevice inLogicalDevice, VkPhysicalDevice inPhysDevice, bool inMemoryBudget)
+    : m_LogicalDevice(inLogicalDevice)
+    , m_PhysDevice(inPhysDevice)
+    , m_MemoryBudget(inMemoryBudget)
+{
+    vkGetPhysicalDeviceMemoryProperties(inPhysDevice, &m_MemoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(inPhysDevice, &properties);
+    m_Granularity = properties.limits.bufferImageGranularity;
+}
+
+omp::GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+    for (const MemoryPool& pool: m_Pools)
+    {
+        for (const auto& block: pool.blocks)
+        {
+            if (!block->metadata.empty())
+            {
+                WARN(LogRendering, "Memory block is destroyed with {} live allocations", block->metadata.getAllocationCount());
+            }
+            freeDeviceMemory(block->memory, block->mapped != nullptr);
+        }
+    }
+    if (m_DedicatedCount > 0)
+    {
+        WARN(LogRendering, "{} dedicated allocations were not freed", m_DedicatedCount);
+    }
+}
+
+omp::GpuAllocation omp::GpuMemoryAllocator::allocate(
+        const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EAllocationKind kind,
+        EMemoryCategory category)
+{
+    const uint32_t memory_type = findMemoryType(requirements.memoryTypeBits, properties);
+    const VkDeviceSize block_size = getBlockSize(memory_type);
+
+    omp::GpuAllocation allocation{};
+    allocation.size = requirements.size;
+    allocation.category = category;
+    allocation.memory_type = memory_type;
+
+    if (requirements.size > block_size / 2)
+    {
+        allocation.memory = allocateDeviceMemory(requirements.size, memory_type, &allocation.mapped);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_DedicatedCount++;
+            m_DedicatedBytes += requirements.size;
+            m_DedicatedHeapBytes[getHeapIndex(memory_type)] += requirements.size;
+        }
+        addToCategory(allocation);
+        return allocation;
+    }
+
+    auto place = [&](omp::GpuMemoryBlock* block) -> bool
+    {
+        std::optional<VkDeviceSize> offset = block->metadata.allocate(requirements.size, requirements.alignment, kind);
+        if (!offset)
+        {
+            return false;
+        }
+        allocation.memory = block->memory;
+        allocation.offset = *offset;
+        allocation.mapped = block->mapped ? block->mapped + *offset : nullptr;
+        allocation.block = block;
+        return true;
+    };
+
+    {
+        MemoryPool& pool = m_Pools[memory_type];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+
+        bool placed = std::any_of(pool.blocks.begin(), pool.blocks.end(),
+                                  [&place](const auto& block) { return place(block.get()); });
+        if (!placed)
+        {
+            void* mapped = nullptr;
+            VkDeviceMemory memory = allocateDeviceMemory(block_size, memory_type, &mapped);
+            pool.blocks.push_back(std::make_unique<omp::GpuMemoryBlock>(omp::GpuMemoryBlock{
+                    memory, memory_type, static_cast<uint8_t*>(mapped), MemoryBlockMetadata(block_size, m_Granularity)}));
+            place(pool.blocks.back().get());
+        }
+    }
+    addToCategory(allocation);
+    return allocation;
+}
+
+void omp::GpuMemoryAllocator::free(omp::GpuAllocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const auto category = static_cast<size_t>(allocation.category);
+        m_CategoryBytes[category] -= allocation.size;
+        m_CategoryCount[category]--;
+
+        if (!allocation.block)
+        {
+            m_DedicatedCount--;
+            m_DedicatedBytes -= allocation.size;
+            m_DedicatedHeapBytes[getHeapIndex(allocation.memory_type)] -= allocation.size;
+        }
+    }
+
+    if (!allocation.block)
+    {
+        freeDeviceMemory(allocation.memory, allocation.mapped != nullptr);
+        allocation = {};
+        return;
+    }
+
+    MemoryPool& pool = m_Pools[allocation.memory_type];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    omp::GpuMemoryBlock* block = allocation.block;
+    block->metadata.free(allocation.offset);
+    allocation = {};
+
+    // One empty block per memory type is kept to avoid churn on load and unload
+    if (block->metadata.empty())
+    {
+        const auto empty_blocks = static_cast<size_t>(std::count_if(
+                pool.blocks.begin(), pool.blocks.end(), [](const auto& other) { return other->metadata.empty(); }));
+        if (empty_blocks > 1)
+        {
+            freeDeviceMemory(block->memory, block->mapped != nullptr);
+            std::erase_if(pool.blocks, [block](const auto& other) { return other.get() == block; });
+        }
+    }
+}
+
+size_t omp::GpuMemoryAllocator::releaseEmptyBlocks()
+{
+    size_t released = 0;
+    for (MemoryPool& pool: m_Pools)
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        released += std::erase_if(pool.blocks, [this](const auto& block)
+        {
+            if (!block->metadata.empty())
+            {
+                return false;
+            }
+            freeDeviceMemory(block->memory, block->mapped != nullptr);
+            return true;
+        });
+    }
+    return released;
+}
+
+omp::GpuMemoryStats omp::GpuMemoryAllocator::getStats() const
+{
+    omp::GpuMemoryStats stats{};
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        stats.dedicated_count = m_DedicatedCount;
+        stats.allocation_count = m_DedicatedCount;
+        stats.reserved_bytes = m_DedicatedBytes;
+        stats.used_bytes = m_DedicatedBytes;
+        stats.category_bytes = m_CategoryBytes;
+        stats.category_count = m_CategoryCount;
+    }
+
+    for (const MemoryPool& pool: m_Pools)
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        stats.block_count += static_cast<uint32_t>(pool.blocks.size());
+        for (const auto& block: pool.blocks)
+        {
+            stats.allocation_count += static_cast<uint32_t>(block->metadata.getAllocationCount());
+            stats.reserved_bytes += block->metadata.getSize();
+            stats.used_bytes += block->metadata.getUsed();
+            stats.free_range_count += static_cast<uint32_t>(block->metadata.getFreeRangeCount());
+            stats.largest_free_range = std::max(stats.largest_free_range, block->metadata.getLargestFreeRange());
+        }
+    }
+    return stats;
+}
+
+std::vector<omp::GpuHeapBudget> omp::GpuMemoryAllocator::getHeapBudgets() const
+{
+    std::vector<omp::GpuHeapBudget> heaps(m_MemoryProperties.memoryHeapCount);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (uint32_t heap = 0; heap < m_MemoryProperties.memoryHeapCount; heap++)
+        {
+            heaps[heap].size = m_MemoryProperties.memoryHeaps[heap].size;
+            heaps[heap].device_local = m_MemoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+            heaps[heap].reserved = m_DedicatedHeapBytes[heap];
+        }
+    }
+    for (uint32_t memory_type = 0; memory_type < m_MemoryProperties.memoryTypeCount; memory_type++)
+    {
+        std::lock_guard<std::mutex> lock(m_Pools[memory_type].mutex);
+        for (const auto& block: m_Pools[memory_type].blocks)
+        {
+            heaps[getHeapIndex(memory_type)].reserved += block->metadata.getSize();
+        }
+    }
+
+    if (m_MemoryBudget)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties{};
+        budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget_properties;
+        vkGetPhysicalDeviceMemoryProperties2(m_PhysDevice, &properties);
+        for (uint32_t heap = 0; heap < heaps.size(); heap++)
+        {
+            heaps[heap].budget = budget_properties.heapBudget[heap];
+            heaps[heap].usage = budget_properties.heapUsage[heap];
+        }
+        return heaps;
+    }
+
+    for (omp::GpuHeapBudget& heap: heaps)
+    {
+        heap.budget = static_cast<VkDeviceSize>(static_cast<double>(heap.size) * g_FallbackBudgetRatio);
+        heap.usage = heap.reserved;
+    }
+    return heaps;
+}
+
+uint32_t omp::GpuMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1 << i))
+            && (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type");
+}
+
+VkDeviceSize omp::GpuMemoryAllocator::getBlockSize(uint32_t memoryType) const
+{
+    const uint32_t heap_index = m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+    const VkDeviceSize heap_size = m_MemoryProperties.memoryHeaps[heap_index].size;
+    // Small heaps, like the host visible part of vram, should not be taken by one block
+    return heap_size <= g_SmallHeapSize ? heap_size / 8 : g_DefaultBlockSize;
+}
+
+void omp::GpuMemoryAllocator::addToCategory(const omp::GpuAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto category = static_cast<size_t>(allocation.category);
+    m_CategoryBytes[category] += allocation.size;
+    m_CategoryCount[category]++;
+}
+
+uint32_t omp::GpuMemoryAllocator::getHeapIndex(uint32_t memoryType) const
+{
+    return m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+}
+
+bool omp::GpuMemoryAllocator::isHostVisible(uint32_t memoryType) const
+{
+    return m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+VkDeviceMemory omp::GpuMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** outMapped)
+{
+    VkMemoryAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = size;
+    allocate_info.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(m_LogicalDevice, &allocate_info, nullptr, &memory) != VK_SUCCESS)
+    {
+        ERROR(LogRendering, "Failed to allocate {} bytes of memory type {}", size, memoryType);
+        throw std::runtime_error("Failed to allocate device memory");
+    }
+
+    *outMapped = nullptr;
+    if (isHostVisible(memoryType))
+    {
+        vkMapMemory(m_LogicalDevice, memory, 0, VK_WHOLE_SIZE, 0, outMapped);
+    }
+    return memory;
+}
+
+void omp::GpuMemoryAllocator::freeDeviceMemory(VkDeviceMemory memory, bool mapped)
+{
+    if (mapped)
+    {
+        vkUnmapMemory(m_LogicalDevice, memory);
+    }
+    vkFreeMemory(m_LogicalDevice, memory, nullptr);
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace omp
+{
+    // Buffers and linear images must not share a granularity page with optimal images
+    enum class EAllocationKind : uint8_t
+    {
+        Linear,
+        Optimal
+    };
+
+    // What memory is used for, every category is accounted separately
+    enum class EMemoryCategory : uint8_t
+    {
+        Geometry,
+        Textures,
+        RenderTargets,
+        // Uniforms and other per frame data written by cpu
+        Uniforms,
+        Staging,
+        Culling,
+        Other,
+        Count
+    };
+    constexpr size_t g_MemoryCategoryCount = static_cast<size_t>(EMemoryCategory::Count);
+    const char* getMemoryCategoryName(EMemoryCategory category);
+
+    /**
+     * Bookkeeping of one memory block, no vulkan calls.
+     * Ranges cover the whole block, free neighbours are always merged.
+     * Free ranges are linked into segregated lists by size class, two levels like TLSF,
+     * so placement checks a few candidates from the smallest class that fits instead of every range.
+     * Placement honors bufferImageGranularity between different kinds.
+     */
+    class MemoryBlockMetadata
+    {
+    public:
+        MemoryBlockMetadata(VkDeviceSize size, VkDeviceSize granularity);
+
+        std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment, EAllocationKind kind);
+        void free(VkDeviceSize offset);
+
+        VkDeviceSize getSize() const { return m_Size; }
+        VkDeviceSize getUsed() const { return m_Used; }
+        size_t getAllocationCount() const { return m_AllocationCount; }
+        size_t getFreeRangeCount() const { return m_FreeRangeCount; }
+        VkDeviceSize getLargestFreeRange() const;
+        bool empty() const { return m_AllocationCount == 0; }
+
+    private:
+        // Power of two classes split into 16 linear sub classes, sizes below 16 get a list each
+        static constexpr size_t s_SubClassBits = 4;
+        static constexpr size_t s_SubClassCount = size_t(1) << s_SubClassBits;
+        static constexpr size_t s_ClassCount = 64 - s_SubClassBits + 1;
+        static constexpr size_t s_ListCount = s_ClassCount * s_SubClassCount;
+        static constexpr VkDeviceSize s_NoRange = ~VkDeviceSize(0);
+
+        struct Range
+        {
+            VkDeviceSize size = 0;
+            bool free = true;
+            EAllocationKind kind = EAllocationKind::Linear;
+            // Offsets of neighbours in the free list of the same size class
+            VkDeviceSize previous_free = s_NoRange;
+            VkDeviceSize next_free = s_NoRange;
+        };
+        using RangeIterator = std::map<VkDeviceSize, Range>::iterator;
+
+        // State //
+        // ===== //
+        VkDeviceSize m_Size;
+        VkDeviceSize m_Granularity;
+        VkDeviceSize m_Used = 0;
+        size_t m_AllocationCount = 0;
+        size_t m_FreeRangeCount = 0;
+
+        // Keyed by offset
+        std::map<VkDeviceSize, Range> m_Ranges;
+
+        std::array<VkDeviceSize, s_ListCount> m_FreeLists;
+        // Bit per class with any free range, and bit per non empty sub class list
+        uint64_t m_ClassMask = 0;
+        std::array<uint16_t, s_ClassCount> m_SubClassMasks{};
+
+        static size_t getList(VkDeviceSize size);
+        static VkDeviceSize getListMinSize(size_t list);
+        // First non empty list starting from given one, s_ListCount if there is none
+        size_t findList(size_t first) const;
+        void linkFree(RangeIterator it);
+        void unlinkFree(RangeIterator it);
+        bool findInList(size_t list, VkDeviceSize size, VkDeviceSize alignment, EAllocationKind kind,
+                        RangeIterator& outRange, VkDeviceSize& outOffset);
+
+        bool onSamePage(VkDeviceSize lastByteOfFirst, VkDeviceSize firstByteOfSecond) const;
+        std::optional<VkDeviceSize> fitInto(std::map<VkDeviceSize, Range>::const_iterator it,
+                                            VkDeviceSize size, VkDeviceSize alignment, EAllocationKind kind) const;
+    };
+
+    struct GpuMemoryBlock
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint32_t memory_type = 0;
+        // Host visible blocks stay mapped while they live
+        uint8_t* mapped = nullptr;
+        MemoryBlockMetadata metadata;
+    };
+
+    struct GpuAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Null for device local memory
+        void* mapped = nullptr;
+        // Null for dedicated allocations
+        omp::GpuMemoryBlock* block = nullptr;
+        omp::EMemoryCategory category = omp::EMemoryCategory::Other;
+        uint32_t memory_type = 0;
+    };
+
+    struct GpuMemoryStats
+    {
+        uint32_t block_count = 0;
+        uint32_t dedicated_count = 0;
+        uint32_t allocation_count = 0;
+        VkDeviceSize reserved_bytes = 0;
+        VkDeviceSize used_bytes = 0;
+        // Fragmentation, many small free ranges mean block space is wasted
+        uint32_t free_range_count = 0;
+        VkDeviceSize largest_free_range = 0;
+        // Indexed by EMemoryCategory, sizes of allocations without block padding
+        std::array<VkDeviceSize, g_MemoryCategoryCount> category_bytes{};
+        std::array<uint32_t, g_MemoryCategoryCount> category_count{};
+    };
+
+    struct GpuHeapBudget
+    {
+        VkDeviceSize size = 0;
+        // Without VK_EXT_memory_budget it is a share of heap size
+        VkDeviceSize budget = 0;
+        // Of the whole process, without VK_EXT_memory_budget only what this allocator reserved
+        VkDeviceSize usage = 0;
+        // Blocks and dedicated allocations of this allocator
+        VkDeviceSize reserved = 0;
+        bool device_local = false;
+    };
+
+    enum class EBudgetPressure : uint8_t
+    {
+        Normal,
+        Near,
+        Over
+    };
+
+    /**
+     * Pressure of every heap from its usage and budget, no vulkan calls.
+     * Pressure drops back only well below the near threshold, so a heap hovering around it reports once.
+     */
+    class MemoryBudgetMonitor
+    {
+    public:
+        static constexpr double s_NearRatio = 0.9;
+        static constexpr double s_ReleaseRatio = 0.8;
+
+        // Returns heaps whose pressure rose since the previous update
+        std::vector<uint32_t> update(const std::vector<GpuHeapBudget>& heaps);
+
+        EBudgetPressure getPressure(uint32_t heap) const;
+        // Bytes an eviction policy has to free to get the heap below the near threshold
+        VkDeviceSize getEvictionBytes(uint32_t heap) const;
+        bool isUnderPressure() const;
+        const std::vector<GpuHeapBudget>& getHeaps() const { return m_Heaps; }
+
+    private:
+        std::vector<GpuHeapBudget> m_Heaps;
+        std::vector<EBudgetPressure> m_Pressure;
+    };
+
+    /**
+     * Sub-allocates resources from large blocks per memory type, so resource count
+     * is not bound by maxMemoryAllocationCount. Large resources get dedicated memory.
+     */
+    class GpuMemoryAllocator
+    {
+    public:
+        // Memory budget tells whether VK_EXT_memory_budget is enabled on the device
+        GpuMemoryAllocator(VkDevice inLogicalDevice, VkPhysicalDevice inPhysDevice, bool inMemoryBudget);
+        GpuMemoryAllocator(const GpuMemoryAllocator&) = delete;
+        GpuMemoryAllocator& operator=(const GpuMemoryAllocator&) = delete;
+        ~GpuMemoryAllocator();
+
+    private:
+        // State //
+        // ===== //
+        VkDevice m_LogicalDevice;
+        VkPhysicalDevice m_PhysDevice;
+        bool m_MemoryBudget;
+        VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+        VkDeviceSize m_Granularity = 1;
+
+        // Blocks of one memory type, types are placed into independently
+        struct MemoryPool
+        {
+            mutable std::mutex mutex;
+            std::vector<std::unique_ptr<omp::GpuMemoryBlock>> blocks;
+        };
+        std::array<MemoryPool, VK_MAX_MEMORY_TYPES> m_Pools;
+
+        uint32_t m_DedicatedCount = 0;
+        VkDeviceSize m_DedicatedBytes = 0;
+        std::array<VkDeviceSize, g_MemoryCategoryCount> m_CategoryBytes{};
+        std::array<uint32_t, g_MemoryCategoryCount> m_CategoryCount{};
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_DedicatedHeapBytes{};
+
+        // Guards dedicated and category counters, never taken before a pool mutex
+        mutable std::mutex m_Mutex;
+
+        // Methods //
+        // ======= //
+    public:
+        omp::GpuAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                                    EAllocationKind kind, EMemoryCategory category);
+        void free(omp::GpuAllocation& allocation);
+
+        // Gives back blocks kept empty after frees, live allocations are never moved
+        size_t releaseEmptyBlocks();
+        omp::GpuMemoryStats getStats() const;
+        // Per memory heap
+        std::vector<omp::GpuHeapBudget> getHeapBudgets() const;
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+    private:
+        VkDeviceSize getBlockSize(uint32_t memoryType) const;
+        bool isHostVisible(uint32_t memoryType) const;
+        // Takes the counter mutex
+        void addToCategory(const omp::GpuAllocation& allocation);
+        uint32_t getHeapIndex(uint32_t memoryType) const;
+        VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** outMapped);
+        void freeDeviceMemory(VkDeviceMemory memory, bool mapped);
+    };
+}
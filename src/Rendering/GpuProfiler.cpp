@@ -0,0 +1,174 @@
+#include "GpuProfiler.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace
+{
+    // Steady clock of msvc is performance counter scaled to nanoseconds the same way
+    int64_t hostToProfilerNs(uint64_t hostTime)
+    {
+#ifdef _WIN32
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const auto ticks_per_second = static_cast<uint64_t>(frequency.QuadPart);
+        return static_cast<int64_t>(hostTime / ticks_per_second * 1000000000 +
+                                    hostTime % ticks_per_second * 1000000000 / ticks_per_second);
+#else
+        return static_cast<int64_t>(hostTime);
+#endif
+    }
+}
+
+omp::GpuProfiler::GpuProfiler(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesInFlight,
+                              float timestampPeriod, uint32_t timestampValidBits, bool calibratedTimestamps)
+    : m_VulkanContext(inVulkanContext)
+    , m_TimestampPeriod(timestampPeriod)
+    , m_TimestampMask(timestampValidBits >= 64 ? UINT64_MAX : (uint64_t{1} << timestampValidBits) - 1)
+    , m_Frames(framesInFlight)
+{
+    if (timestampValidBits == 0)
+    {
+        return;
+    }
+
+    VkQueryPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = 2 * s_MaxScopes * framesInFlight;
+    if (vkCreateQueryPool(m_VulkanContext->logical_device, &pool_info, nullptr, &m_QueryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timestamp query pool");
+    }
+
+    if (calibratedTimestamps)
+    {
+        m_GetCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+                vkGetDeviceProcAddr(m_VulkanContext->logical_device, "vkGetCalibratedTimestampsEXT"));
+    }
+}
+
+bool omp::GpuProfiler::canCalibrate(VkInstance instance, VkPhysicalDevice physicalDevice)
+{
+    const auto get_time_domains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+            vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    if (!get_time_domains)
+    {
+        return false;
+    }
+    uint32_t domain_count = 0;
+    get_time_domains(physicalDevice, &domain_count, nullptr);
+    std::vector<VkTimeDomainEXT> domains(domain_count);
+    get_time_domains(physicalDevice, &domain_count, domains.data());
+    return std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end() &&
+           std::find(domains.begin(), domains.end(), s_HostTimeDomain) != domains.end();
+}
+
+omp::GpuProfiler::~GpuProfiler()
+{
+    vkDestroyQueryPool(m_VulkanContext->logical_device, m_QueryPool, nullptr);
+}
+
+void omp::GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+    if (!isSupported())
+    {
+        return;
+    }
+    m_CurrentFrame = frame;
+    if (m_GetCalibratedTimestamps && (!m_GpuToCpuNs || ++m_FramesSinceCalibration >= s_CalibrationInterval))
+    {
+        calibrate();
+    }
+    FrameQueries& queries = m_Frames[frame];
+    const uint32_t first_query = 2 * s_MaxScopes * frame;
+
+    if (!queries.names.empty())
+    {
+        std::vector<uint64_t> timestamps(2 * queries.names.size());
+        if (vkGetQueryPoolResults(m_VulkanContext->logical_device, m_QueryPool, first_query,
+                                  static_cast<uint32_t>(timestamps.size()), timestamps.size() * sizeof(uint64_t),
+                                  timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+        {
+            m_LastEvents.clear();
+            for (size_t scope = 0; scope < queries.names.size(); scope++)
+            {
+                const uint64_t start = timestamps[2 * scope] & m_TimestampMask;
+                const uint64_t ticks = ((timestamps[2 * scope + 1] & m_TimestampMask) - start) & m_TimestampMask;
+                const auto start_ns = static_cast<uint64_t>(static_cast<double>(start) * m_TimestampPeriod);
+                const auto duration_ns = static_cast<uint64_t>(static_cast<double>(ticks) * m_TimestampPeriod);
+                m_LastEvents.push_back({queries.names[scope], start_ns, start_ns + duration_ns});
+            }
+            omp::Profiler& profiler = omp::Profiler::getProfiler();
+            if (profiler.isEnabled())
+            {
+                profiler.addGpuEvents(queries.profiler_frame, std::vector<omp::GpuProfileEvent>(m_LastEvents),
+                                      m_GpuToCpuNs);
+            }
+        }
+    }
+
+    queries.names.clear();
+    queries.profiler_frame = omp::Profiler::getProfiler().getFrameIndex();
+    vkCmdResetQueryPool(commandBuffer, m_QueryPool, first_query, 2 * s_MaxScopes);
+}
+
+uint32_t omp::GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name)
+{
+    FrameQueries& queries = m_Frames[m_CurrentFrame];
+    if (!isSupported() || queries.names.size() >= s_MaxScopes)
+    {
+        return s_InvalidScope;
+    }
+    const auto scope = static_cast<uint32_t>(queries.names.size());
+    queries.names.push_back(name);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool,
+                        2 * (s_MaxScopes * m_CurrentFrame + scope));
+    return scope;
+}
+
+void omp::GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+    if (scope == s_InvalidScope)
+    {
+        return;
+    }
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool,
+                        2 * (s_MaxScopes * m_CurrentFrame + scope) + 1);
+}
+
+float omp::GpuProfiler::getLastScopeMs(std::string_view name) const
+{
+    for (const omp::GpuProfileEvent& event: m_LastEvents)
+    {
+        if (event.name == name)
+        {
+            return static_cast<float>(event.end_ns - event.start_ns) / 1e6f;
+        }
+    }
+    return 0.f;
+}
+
+void omp::GpuProfiler::calibrate()
+{
+    std::array<VkCalibratedTimestampInfoEXT, 2> infos{};
+    infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+    infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[1].timeDomain = s_HostTimeDomain;
+    std::array<uint64_t, 2> timestamps{};
+    uint64_t max_deviation = 0;
+    m_FramesSinceCalibration = 0;
+    if (m_GetCalibratedTimestamps(m_VulkanContext->logical_device, static_cast<uint32_t>(infos.size()), infos.data(),
+                                  timestamps.data(), &max_deviation) != VK_SUCCESS)
+    {
+        return;
+    }
+    // Same conversion as query results, so offsets apply to them as they are
+    const auto gpu_ns = static_cast<int64_t>(static_cast<double>(timestamps[0] & m_TimestampMask) * m_TimestampPeriod);
+    m_GpuToCpuNs = hostToProfilerNs(timestamps[1]) - gpu_ns;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "VulkanContext.h"
+#include "Core/Profiler.h"
+
+namespace omp
+{
+    /**
+     * Timestamp scopes of command buffers, every frame in flight has its own range of queries.
+     * Results of a frame are read when it comes around again, after its fence,
+     * and handed to the cpu profiler with the profiler frame that recorded them.
+     * With calibrated timestamps the gpu clock is mapped onto Profiler::Clock, recalibrated periodically.
+     * Without timestamp support on the graphics queue every call does nothing.
+     */
+    class GpuProfiler
+    {
+    public:
+        // Per frame in flight, scopes above it are not measured
+        static constexpr uint32_t s_MaxScopes = 32;
+        static constexpr uint32_t s_InvalidScope = UINT32_MAX;
+        // Clock behind Profiler::Clock, steady clock of the platform
+#ifdef _WIN32
+        static constexpr VkTimeDomainEXT s_HostTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+        static constexpr VkTimeDomainEXT s_HostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+        // Frames between calibrations, clocks drift apart slowly
+        static constexpr uint32_t s_CalibrationInterval = 240;
+
+    private:
+        struct FrameQueries
+        {
+            std::vector<const char*> names;
+            uint64_t profiler_frame = 0;
+        };
+
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+        // Nanoseconds per tick
+        float m_TimestampPeriod;
+        uint64_t m_TimestampMask;
+
+        std::vector<FrameQueries> m_Frames;
+        uint32_t m_CurrentFrame = 0;
+        std::vector<omp::GpuProfileEvent> m_LastEvents;
+
+        PFN_vkGetCalibratedTimestampsEXT m_GetCalibratedTimestamps = nullptr;
+        std::optional<int64_t> m_GpuToCpuNs;
+        uint32_t m_FramesSinceCalibration = 0;
+
+        // Methods //
+        // ======= //
+    public:
+        // Calibration needs VK_EXT_calibrated_timestamps enabled and canCalibrate of the device
+        GpuProfiler(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesInFlight,
+                    float timestampPeriod, uint32_t timestampValidBits, bool calibratedTimestamps);
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+        ~GpuProfiler();
+
+        // Device and host time domains are both calibrateable
+        static bool canCalibrate(VkInstance instance, VkPhysicalDevice physicalDevice);
+
+        bool isSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+        bool isCalibrated() const { return m_GpuToCpuNs.has_value(); }
+
+        // Fence of the frame has to be waited. Reads its previous results and resets its queries,
+        // buffer has to be submitted before any other buffer with scopes of the frame
+        void beginFrame(VkCommandBuffer commandBuffer, uint32_t frame);
+        // Not inside of a subpass with secondary command buffers
+        uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+        void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+        // Of the latest frame with results, gpu clock
+        const std::vector<omp::GpuProfileEvent>& getLastEvents() const { return m_LastEvents; }
+        // Zero when scope was not measured
+        float getLastScopeMs(std::string_view name) const;
+
+    private:
+        void calibrate();
+    };
+}
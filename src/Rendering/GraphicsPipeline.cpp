@@ -1,3 +1,4 @@
+#include <iterator>
 #include <stdexcept>
 #include "GraphicsPipeline.h"
 #include "Model.h"
@@ -47,6 +48,38 @@ void omp::GraphicsPipeline::createVertexInfo()
     m_VertexInputInfo = vertex_input_info;
 }
 
+void omp::GraphicsPipeline::createInstancedVertexInfo()
+{
+    static auto binding_descriptions = std::array<VkVertexInputBindingDescription, 2>{
+            omp::Vertex::GetBindingDescription(),
+            omp::InstanceData::GetBindingDescription()};
+    static auto attribute_descriptions = []()
+    {
+        auto vertex_attributes = omp::Vertex::GetAttributeDescriptions();
+        auto instance_attributes = omp::InstanceData::GetAttributeDescriptions();
+        std::vector<VkVertexInputAttributeDescription> attributes(vertex_attributes.begin(), vertex_attributes.end());
+        attributes.insert(attributes.end(), instance_attributes.begin(), instance_attributes.end());
+        return attributes;
+    }();
+
+    VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
+    vertex_input_info.pVertexBindingDescriptions = binding_descriptions.data();
+    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
+
+    m_VertexInputInfo = vertex_input_info;
+}
+
+void omp::GraphicsPipeline::createEmptyVertexInfo()
+{
+    VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    m_VertexInputInfo = vertex_input_info;
+}
+
 void omp::GraphicsPipeline::createInputAssembly()
 {
     VkPipelineInputAssemblyStateCreateInfo input_assembly{};
@@ -183,7 +216,7 @@ void omp::GraphicsPipeline::createShaders(const std::shared_ptr<class Shader>& s
     m_Shader = std::move(shader);
 }
 
-void omp::GraphicsPipeline::confirmCreation(const std::shared_ptr<omp::RenderPass>& renderPass)
+void omp::GraphicsPipeline::confirmCreation(const std::shared_ptr<omp::RenderPass>& renderPass, uint32_t subpass)
 {
     if (m_PipelineLayoutInfo.setLayoutCount == 0)
     {
@@ -195,18 +228,20 @@ void omp::GraphicsPipeline::confirmCreation(const std::shared_ptr<omp::RenderPas
         throw std::runtime_error("Failed to create pipeline layout");
     }
 
+    // Render targets follow the viewport, so pipelines outlive resizes
     VkDynamicState dynamic_states[] = {
             VK_DYNAMIC_STATE_LINE_WIDTH,
-            VK_DYNAMIC_STATE_VIEWPORT
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR
     };
     VkPipelineDynamicStateCreateInfo dynamic_state{};
     dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(std::size(dynamic_states));
     dynamic_state.pDynamicStates = dynamic_states;
 
     VkGraphicsPipelineCreateInfo pipeline_info{};
     pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipeline_info.stageCount = m_Shader->getStagesCount();
+    pipeline_info.stageCount = static_cast<uint32_t>(m_Shader->getShaderStages().size());
     pipeline_info.pStages = m_Shader->getShaderStages().data();
 
     pipeline_info.pVertexInputState = &m_VertexInputInfo;
@@ -220,7 +255,7 @@ void omp::GraphicsPipeline::confirmCreation(const std::shared_ptr<omp::RenderPas
 
     pipeline_info.layout = m_PipelineLayout;
     pipeline_info.renderPass = renderPass->getRenderPass();
-    pipeline_info.subpass = 0;
+    pipeline_info.subpass = subpass;
 
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_info.basePipelineIndex = -1;
@@ -16,6 +16,9 @@ namespace omp
         void startCreation();
         void startDefaultCreation();
         void createVertexInfo();
+        void createInstancedVertexInfo();
+        // Fullscreen passes generate vertices in shader
+        void createEmptyVertexInfo();
         void createInputAssembly();
         void createViewport(VkExtent2D scissorExtent);
         void createRasterizer();
@@ -29,7 +32,7 @@ namespace omp
         void createShaders(const std::shared_ptr<class Shader>& shader);
         void setDepthStencil();
         void setDepthStencil(VkPipelineDepthStencilStateCreateInfo info);
-        void confirmCreation(const std::shared_ptr<omp::RenderPass>& renderPass);
+        void confirmCreation(const std::shared_ptr<omp::RenderPass>& renderPass, uint32_t subpass = 0);
 
         VkPipeline getGraphicsPipeline() { return m_GraphicsPipeline; }
 
@@ -0,0 +1,193 @@
+#include "LightClusters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    uint32_t toTile(float uv, uint32_t tiles)
+    {
+        // Clamped first, huge lights project to infinity
+        const float clamped = std::clamp(uv, 0.f, 1.f);
+        return std::min(static_cast<uint32_t>(clamped * static_cast<float>(tiles)), tiles - 1);
+    }
+}
+
+void omp::LightClusters::build(const omp::ClusterView& view, std::span<const glm::vec4> pointSpheres,
+                               std::span<const glm::vec4> spotSpheres)
+{
+    const float log_ratio = std::log(view.far_plane / view.near_plane);
+    const float scale = static_cast<float>(s_Slices) / log_ratio;
+    m_Header.grid = {s_TilesX, s_TilesY, s_Slices, s_MaxIndices};
+    m_Header.depth_params = {view.near_plane, view.far_plane, scale, -std::log(view.near_plane) * scale};
+    m_Header.screen_size = {view.screen_size, 0.f, 0.f};
+
+    m_PointAssignments.clear();
+    m_SpotAssignments.clear();
+    for (uint32_t light = 0; light < pointSpheres.size(); light++)
+    {
+        assignSphere(view, pointSpheres[light], light, m_PointAssignments);
+    }
+    for (uint32_t light = 0; light < spotSpheres.size(); light++)
+    {
+        assignSphere(view, spotSpheres[light], light, m_SpotAssignments);
+    }
+
+    std::fill(m_Ranges.begin(), m_Ranges.end(), Range());
+    for (const Assignment& assignment: m_PointAssignments)
+    {
+        m_Ranges[assignment.cluster].point_count++;
+    }
+    for (const Assignment& assignment: m_SpotAssignments)
+    {
+        m_Ranges[assignment.cluster].spot_count++;
+    }
+
+    // Clusters past capacity lose their lights, spot lights first
+    uint32_t offset = 0;
+    m_DroppedCount = 0;
+    for (Range& range: m_Ranges)
+    {
+        const uint32_t requested = range.point_count + range.spot_count;
+        const uint32_t available = s_MaxIndices - offset;
+        range.offset = offset;
+        range.point_count = std::min(range.point_count, available);
+        range.spot_count = std::min(range.spot_count, available - range.point_count);
+        m_DroppedCount += requested - range.point_count - range.spot_count;
+        offset += range.point_count + range.spot_count;
+    }
+
+    // Count again while filling, assignments keep light order inside of a cluster
+    m_Indices.resize(offset);
+    std::vector<Range> filled(s_ClusterCount);
+    for (const Assignment& assignment: m_PointAssignments)
+    {
+        const Range& range = m_Ranges[assignment.cluster];
+        uint32_t& cursor = filled[assignment.cluster].point_count;
+        if (cursor < range.point_count)
+        {
+            m_Indices[range.offset + cursor++] = assignment.light;
+        }
+    }
+    for (const Assignment& assignment: m_SpotAssignments)
+    {
+        const Range& range = m_Ranges[assignment.cluster];
+        uint32_t& cursor = filled[assignment.cluster].spot_count;
+        if (cursor < range.spot_count)
+        {
+            m_Indices[range.offset + range.point_count + cursor++] = assignment.light;
+        }
+    }
+}
+
+float omp::LightClusters::getLightRange(float constant, float linear, float quadratic)
+{
+    constexpr float cut_off = 256.f;
+    if (constant >= cut_off)
+    {
+        return 0.f;
+    }
+    if (quadratic > 0.f)
+    {
+        return (-linear + std::sqrt(linear * linear - 4.f * quadratic * (constant - cut_off))) / (2.f * quadratic);
+    }
+    if (linear > 0.f)
+    {
+        return (cut_off - constant) / linear;
+    }
+    return std::numeric_limits<float>::infinity();
+}
+
+glm::vec4 omp::LightClusters::getSpotSphere(const glm::vec3& position, const glm::vec3& direction, float range,
+                                            float outerCutOff)
+{
+    const glm::vec3 axis = glm::normalize(direction);
+    // Wide cones are bounded by their cap, narrow ones by the sphere through apex and cap rim
+    if (outerCutOff <= 0.f)
+    {
+        return {position, range};
+    }
+    if (outerCutOff < std::sqrt(0.5f))
+    {
+        const float sine = std::sqrt(1.f - outerCutOff * outerCutOff);
+        return {position + axis * (range * outerCutOff), range * sine};
+    }
+    const float radius = range / (2.f * outerCutOff);
+    return {position + axis * radius, radius};
+}
+
+void omp::LightClusters::writeTo(void* outData) const
+{
+    auto* bytes = static_cast<uint8_t*>(outData);
+    std::memcpy(bytes, &m_Header, sizeof(Header));
+    bytes += sizeof(Header);
+    std::memcpy(bytes, m_Ranges.data(), m_Ranges.size() * sizeof(Range));
+    bytes += m_Ranges.size() * sizeof(Range);
+    std::memcpy(bytes, m_Indices.data(), m_Indices.size() * sizeof(uint32_t));
+}
+
+void omp::LightClusters::assignSphere(const omp::ClusterView& view, const glm::vec4& sphere, uint32_t light,
+                                      std::vector<Assignment>& outAssignments) const
+{
+    // Camera looks down -z in view space
+    const glm::vec3 center = glm::vec3(view.view * glm::vec4(glm::vec3(sphere), 1.f));
+    const float radius = sphere.w;
+    const float min_depth = std::max(-center.z - radius, view.near_plane);
+    const float max_depth = std::min(-center.z + radius, view.far_plane);
+    if (min_depth > max_depth)
+    {
+        return;
+    }
+
+    const uint32_t first_slice = getSlice(min_depth);
+    const uint32_t last_slice = getSlice(max_depth);
+    for (uint32_t slice = first_slice; slice <= last_slice; slice++)
+    {
+        // Screen rect of the bounding box part inside of the slice
+        const float slab_near = std::max(min_depth, getSliceDepth(slice));
+        const float slab_far = std::min(max_depth, getSliceDepth(slice + 1));
+        glm::vec2 min_uv{std::numeric_limits<float>::max()};
+        glm::vec2 max_uv{std::numeric_limits<float>::lowest()};
+        for (const float depth: {slab_near, slab_far})
+        {
+            for (const float x: {center.x - radius, center.x + radius})
+            {
+                for (const float y: {center.y - radius, center.y + radius})
+                {
+                    const glm::vec2 uv{view.projection[0][0] * x / depth * 0.5f + 0.5f,
+                                       view.projection[1][1] * y / depth * 0.5f + 0.5f};
+                    min_uv = glm::min(min_uv, uv);
+                    max_uv = glm::max(max_uv, uv);
+                }
+            }
+        }
+        if (max_uv.x < 0.f || max_uv.y < 0.f || min_uv.x > 1.f || min_uv.y > 1.f)
+        {
+            continue;
+        }
+
+        const uint32_t last_x = toTile(max_uv.x, s_TilesX);
+        const uint32_t last_y = toTile(max_uv.y, s_TilesY);
+        for (uint32_t tile_y = toTile(min_uv.y, s_TilesY); tile_y <= last_y; tile_y++)
+        {
+            for (uint32_t tile_x = toTile(min_uv.x, s_TilesX); tile_x <= last_x; tile_x++)
+            {
+                outAssignments.push_back({getClusterIndex(tile_x, tile_y, slice), light});
+            }
+        }
+    }
+}
+
+uint32_t omp::LightClusters::getSlice(float viewDepth) const
+{
+    const float slice = std::log(viewDepth) * m_Header.depth_params.z + m_Header.depth_params.w;
+    return std::min(static_cast<uint32_t>(std::max(slice, 0.f)), s_Slices - 1);
+}
+
+float omp::LightClusters::getSliceDepth(uint32_t slice) const
+{
+    const float near_plane = m_Header.depth_params.x;
+    const float far_plane = m_Header.depth_params.y;
+    return near_plane * std::pow(far_plane / near_plane, static_cast<float>(slice) / static_cast<float>(s_Slices));
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace omp
+{
+    // Camera the grid is built for, projection is the one of the frame ubo
+    struct ClusterView
+    {
+        glm::mat4 view{1.f};
+        glm::mat4 projection{1.f};
+        float near_plane = 0.1f;
+        float far_plane = 100.f;
+        glm::vec2 screen_size{1.f};
+    };
+
+    /**
+     * Bins point and spot lights into a view space froxel grid.
+     * Screen is split into tiles, depth into slices growing exponentially from near to far plane.
+     * Every cluster gets a range in one index list, point lights go first, spot lights after them.
+     * Lights are approximated with bounding spheres, so assignment is conservative.
+     */
+    class LightClusters
+    {
+    public:
+        // Grid size is baked into shaders, see LightClusters block in shaderLight.frag
+        static constexpr uint32_t s_TilesX = 16;
+        static constexpr uint32_t s_TilesY = 9;
+        static constexpr uint32_t s_Slices = 24;
+        static constexpr uint32_t s_ClusterCount = s_TilesX * s_TilesY * s_Slices;
+        static constexpr uint32_t s_MaxIndices = 64 * 1024;
+
+        // Gpu layout, header goes first, then ranges of every cluster, then indices
+        struct Header
+        {
+            glm::uvec4 grid;
+            // Near, far, scale and bias of the slice from log of view depth
+            glm::vec4 depth_params;
+            glm::vec4 screen_size;
+        };
+
+        struct Range
+        {
+            uint32_t offset = 0;
+            uint32_t point_count = 0;
+            uint32_t spot_count = 0;
+            uint32_t padding = 0;
+        };
+
+    private:
+        struct Assignment
+        {
+            uint32_t cluster;
+            uint32_t light;
+        };
+
+        // State //
+        // ===== //
+        Header m_Header{};
+        std::vector<Range> m_Ranges = std::vector<Range>(s_ClusterCount);
+        std::vector<uint32_t> m_Indices;
+        std::vector<Assignment> m_PointAssignments;
+        std::vector<Assignment> m_SpotAssignments;
+        uint32_t m_DroppedCount = 0;
+
+        // Methods //
+        // ======= //
+    public:
+        // Spheres are world space center and radius
+        void build(const omp::ClusterView& view, std::span<const glm::vec4> pointSpheres,
+                   std::span<const glm::vec4> spotSpheres);
+
+        // Distance where attenuation falls under 1/256, light is invisible past it
+        static float getLightRange(float constant, float linear, float quadratic);
+        // Tight sphere around the cone, outer cut off is cosine of the half angle
+        static glm::vec4 getSpotSphere(const glm::vec3& position, const glm::vec3& direction, float range,
+                                       float outerCutOff);
+
+        static size_t getBufferSize()
+        {
+            return sizeof(Header) + s_ClusterCount * sizeof(Range) + s_MaxIndices * sizeof(uint32_t);
+        }
+        void writeTo(void* outData) const;
+
+        uint32_t getClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const
+        {
+            return tileX + s_TilesX * (tileY + s_TilesY * slice);
+        }
+        const Range& getRange(uint32_t cluster) const { return m_Ranges[cluster]; }
+        const std::vector<uint32_t>& getIndices() const { return m_Indices; }
+        // Assignments past index capacity, their lights are missing in some clusters
+        uint32_t getDroppedCount() const { return m_DroppedCount; }
+
+    private:
+        void assignSphere(const omp::ClusterView& view, const glm::vec4& sphere, uint32_t light,
+                          std::vector<Assignment>& outAssignments) const;
+        uint32_t getSlice(float viewDepth) const;
+        float getSliceDepth(uint32_t slice) const;
+    };
+}
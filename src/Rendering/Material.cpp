@@ -6,7 +6,7 @@
 
 void omp::Material::addTextureInternal(TextureData&& data)
 {
-    clearDescriptorSets();
+    clearTextureIndices();
     m_RenderInfo->textures[data.binding_index] = std::move(data);
 }
 
@@ -19,7 +19,7 @@ void omp::Material::addTexture(ETextureType type, const std::shared_ptr<Texture>
              "Specular_map"
             };
 
-    clearDescriptorSets();
+    clearTextureIndices();
 
     addTextureInternal({static_cast<uint32_t>(type), texture, names[static_cast<uint32_t>(type)]});
 }
@@ -34,7 +34,7 @@ void omp::Material::removeTexture(const TextureData& data)
             break;
         }
     }
-    clearDescriptorSets();
+    clearTextureIndices();
 }
 
 void omp::Material::addTexture(const std::shared_ptr<omp::TextureSrc>& texture)
@@ -55,14 +55,27 @@ void omp::Material::addSpecularTexture(const std::shared_ptr<omp::TextureSrc>& t
     addTexture(ETextureType::SpecularMap, texture_inst);
 }
 
-void omp::Material::setDescriptorSet(const std::vector<VkDescriptorSet>& ds)
+void omp::Material::setTextureIndices(const glm::uvec4& indices)
 {
-    m_DescriptorSets = ds;
+    m_TextureIndices = indices;
+    m_TextureIndicesValid = true;
 }
 
-std::vector<VkDescriptorSet>& omp::Material::getDescriptorSet()
+bool omp::Material::isPotentiallyReadyForRendering() const
 {
-    return m_DescriptorSets;
+    if (!m_TextureIndicesValid)
+    {
+        return false;
+    }
+    for (const TextureData& data: m_RenderInfo->textures)
+    {
+        if (data.texture && data.binding_index < MaterialRenderInfo::MAX_TEXTURES &&
+            data.texture->getBindlessIndex() != m_TextureIndices[data.binding_index])
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 std::vector<omp::TextureData> omp::Material::getTextureData() const
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <memory>
+#include <glm/glm.hpp>
 #include "Texture.h"
 #include "TextureSrc.h"
 #include "IO/SerializableObject.h"
@@ -47,7 +48,9 @@ namespace omp
 
         omp::MaterialManager* m_Manager = nullptr;
 
-        std::vector<VkDescriptorSet> m_DescriptorSets;
+        // Bindless slots in ETextureType order, w is unused
+        glm::uvec4 m_TextureIndices{0};
+        bool m_TextureIndicesValid = false;
 
         void addTextureInternal(TextureData&& data);
 
@@ -75,11 +78,12 @@ namespace omp
 
         const omp::MaterialRenderInfo* const getRenderInfo() const { return m_RenderInfo.get(); }
 
-        void setDescriptorSet(const std::vector<VkDescriptorSet>& ds);
-        std::vector<VkDescriptorSet>& getDescriptorSet();
-        void clearDescriptorSets() { m_DescriptorSets.clear(); }
+        void setTextureIndices(const glm::uvec4& indices);
+        const glm::uvec4& getTextureIndices() const { return m_TextureIndices; }
+        void clearTextureIndices() { m_TextureIndicesValid = false; }
 
-        bool isPotentiallyReadyForRendering() { return !m_DescriptorSets.empty(); }
+        // Cached indices are stale once any texture lost its bindless slot, e.g. on reload
+        bool isPotentiallyReadyForRendering() const;
 
         void enableBlending(bool enable);
         bool isBlendingEnabled() const { return m_EnableBlending; }
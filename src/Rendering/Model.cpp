@@ -1,4 +1,5 @@
 #include "Model.h"
+#include <algorithm>
 #include "Rendering/ModelStatics.h"
 
 omp::Model::Model()
@@ -48,79 +49,39 @@ void omp::Model::addIndices(const std::vector<uint32_t>& inIndices)
     m_Indices = inIndices;
 }
 
-void omp::Model::loadVertexToMemory(const std::shared_ptr<omp::VulkanContext>& inContext)
+void omp::Model::loadToGeometryPool(const std::shared_ptr<omp::GeometryPool>& inPool)
 {
-    VkDeviceSize buffer_size = sizeof(getVertices()[0]) * getVertices().size();
-
-    m_Context = inContext;
-
-    // Vertex buffer
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_memory;
-
-    m_Context->createBuffer(
-            buffer_size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            staging_buffer, staging_memory);
-
-    void* data;
-    vkMapMemory(m_Context->logical_device, staging_memory, 0, buffer_size, 0, &data);
-    memcpy(data, getVertices().data(), (size_t) buffer_size);
-    vkUnmapMemory(m_Context->logical_device, staging_memory);
-
-    m_Context->createBuffer(
-            buffer_size,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            m_VertexBuffer, m_VertexMemory);
-
-    m_Context->copyBuffer(staging_buffer, m_VertexBuffer, buffer_size);
-
-    vkDestroyBuffer(m_Context->logical_device, staging_buffer, nullptr);
-    vkFreeMemory(m_Context->logical_device, staging_memory, nullptr);
-}
-
-void omp::Model::loadIndexToMemory(const std::shared_ptr<omp::VulkanContext>& inContext)
-{
-    // Index buffer
-    VkDeviceSize buffer_size = sizeof(getIndices()[0]) * getIndices().size();
-
-    m_Context = inContext;
-
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_memory;
-
-    m_Context->createBuffer(
-            buffer_size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            staging_buffer, staging_memory);
-
-    void* data;
-    vkMapMemory(m_Context->logical_device, staging_memory, 0, buffer_size, 0, &data);
-    memcpy(data, getIndices().data(), (size_t) buffer_size);
-    vkUnmapMemory(m_Context->logical_device, staging_memory);
-
-    m_Context->createBuffer(
-            buffer_size,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            m_IndexBuffer, m_IndexMemory);
-
-    m_Context->copyBuffer(staging_buffer, m_IndexBuffer, buffer_size);
+    if (m_Geometry.isValid())
+    {
+        return;
+    }
+    m_GeometryPool = inPool;
+    m_Geometry = m_GeometryPool->upload(getVertices(), getIndices());
 
-    vkDestroyBuffer(m_Context->logical_device, staging_buffer, nullptr);
-    vkFreeMemory(m_Context->logical_device, staging_memory, nullptr);
+    // Sphere around bounding box center, loose but cheap to build
+    if (!m_Vertices.empty())
+    {
+        glm::vec3 min = m_Vertices[0].pos;
+        glm::vec3 max = m_Vertices[0].pos;
+        for (const omp::Vertex& vertex: m_Vertices)
+        {
+            min = glm::min(min, vertex.pos);
+            max = glm::max(max, vertex.pos);
+        }
+        const glm::vec3 center = (min + max) * 0.5f;
+        float radius = 0.f;
+        for (const omp::Vertex& vertex: m_Vertices)
+        {
+            radius = std::max(radius, glm::length(vertex.pos - center));
+        }
+        m_BoundingSphere = glm::vec4(center, radius);
+    }
 }
 
 omp::Model::~Model()
 {
-    if (m_Context)
+    if (m_GeometryPool)
     {
-        vkDestroyBuffer(m_Context->logical_device, m_IndexBuffer, nullptr);
-        vkDestroyBuffer(m_Context->logical_device, m_VertexBuffer, nullptr);
-        vkFreeMemory(m_Context->logical_device, m_IndexMemory, nullptr);
-        vkFreeMemory(m_Context->logical_device, m_VertexMemory, nullptr);
+        m_GeometryPool->free(m_Geometry);
     }
 }
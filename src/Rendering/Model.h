@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include "GeometryPool.h"
 #include "Math/GlmHash.h"
 #include "Material.h"
 #include "MaterialInstance.h"
@@ -14,6 +15,7 @@ namespace omp
 
     struct Vertex;
     struct ModelPushConstant;
+    struct InstanceData;
 }
 
 struct omp::ModelPushConstant
@@ -38,6 +40,70 @@ struct omp::ModelPushConstant
     }
 };
 
+// Per instance vertex data, leading fields match ModelPushConstant
+struct omp::InstanceData
+{
+    glm::mat4 model;
+
+    glm::vec4 ambient;
+    glm::vec4 diffusive;
+    glm::vec4 specular;
+
+    int32_t id;
+
+    // Bindless slots of material textures
+    glm::uvec4 textures;
+
+    static VkVertexInputBindingDescription GetBindingDescription()
+    {
+        VkVertexInputBindingDescription binding_description{};
+        binding_description.binding = 1;
+        binding_description.stride = sizeof(InstanceData);
+        binding_description.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        return binding_description;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 9> GetAttributeDescriptions()
+    {
+        std::array<VkVertexInputAttributeDescription, 9> attribute_descriptions{};
+        // mat4 takes four consecutive locations
+        for (uint32_t column = 0; column < 4; column++)
+        {
+            attribute_descriptions[column].binding = 1;
+            attribute_descriptions[column].location = 4 + column;
+            attribute_descriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attribute_descriptions[column].offset = offsetof(InstanceData, model) + sizeof(glm::vec4) * column;
+        }
+
+        attribute_descriptions[4].binding = 1;
+        attribute_descriptions[4].location = 8;
+        attribute_descriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attribute_descriptions[4].offset = offsetof(InstanceData, ambient);
+
+        attribute_descriptions[5].binding = 1;
+        attribute_descriptions[5].location = 9;
+        attribute_descriptions[5].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attribute_descriptions[5].offset = offsetof(InstanceData, diffusive);
+
+        attribute_descriptions[6].binding = 1;
+        attribute_descriptions[6].location = 10;
+        attribute_descriptions[6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attribute_descriptions[6].offset = offsetof(InstanceData, specular);
+
+        attribute_descriptions[7].binding = 1;
+        attribute_descriptions[7].location = 11;
+        attribute_descriptions[7].format = VK_FORMAT_R32_SINT;
+        attribute_descriptions[7].offset = offsetof(InstanceData, id);
+
+        attribute_descriptions[8].binding = 1;
+        attribute_descriptions[8].location = 12;
+        attribute_descriptions[8].format = VK_FORMAT_R32G32B32A32_UINT;
+        attribute_descriptions[8].offset = offsetof(InstanceData, textures);
+
+        return attribute_descriptions;
+    }
+};
+
 struct omp::Vertex
 {
     glm::vec3 pos;
@@ -124,13 +190,10 @@ private:
 
     std::vector<uint32_t> m_Indices;
 
-    VkBuffer m_IndexBuffer;
-    VkDeviceMemory m_IndexMemory;
-
-    VkBuffer m_VertexBuffer;
-    VkDeviceMemory m_VertexMemory;
-
-    std::shared_ptr<omp::VulkanContext> m_Context = nullptr;
+    omp::GeometryAllocation m_Geometry;
+    // Local space, xyz is center, w is radius
+    glm::vec4 m_BoundingSphere{0.f};
+    std::shared_ptr<omp::GeometryPool> m_GeometryPool = nullptr;
 
 public:
     // Methods //
@@ -138,8 +201,7 @@ public:
     void setName(const std::string& inName) { m_Name = inName; }
     void setPath(const std::string& inPath) { m_Path = inPath; }
 
-    void loadVertexToMemory(const std::shared_ptr<omp::VulkanContext>& inContext);
-    void loadIndexToMemory(const std::shared_ptr<omp::VulkanContext>& inContext);
+    void loadToGeometryPool(const std::shared_ptr<omp::GeometryPool>& inPool);
 
     void addVertex(const omp::Vertex& inVertex);
     void addVertices(const std::vector<Vertex>& inVertices);
@@ -152,8 +214,9 @@ public:
 
     const std::vector<uint32_t>& getIndices() const { return m_Indices; }
 
-    VkBuffer& getVertexBuffer() { return m_VertexBuffer; }
-    VkBuffer& getIndexBuffer() { return m_IndexBuffer; }
+    const omp::GeometryAllocation& getGeometry() const { return m_Geometry; }
+
+    const glm::vec4& getBoundingSphere() const { return m_BoundingSphere; }
 
     friend class ModelImporter;
 };
@@ -0,0 +1,109 @@
+#include "OitTargets.h"
+#include <array>
+#include <stdexcept>
+
+omp::OitTargets::OitTargets(const std::shared_ptr<omp::VulkanContext>& inVulkanContext,
+                            VkSampleCountFlagBits samples)
+    : m_VulkanContext(inVulkanContext)
+    , m_Samples(samples)
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t binding = 0; binding < bindings.size(); binding++)
+    {
+        bindings[binding].binding = binding;
+        bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(m_VulkanContext->logical_device, &layout_info, nullptr, &m_SetLayout) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create transparency set layout");
+    }
+
+    VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, static_cast<uint32_t>(bindings.size())};
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    if (vkCreateDescriptorPool(m_VulkanContext->logical_device, &pool_info, nullptr, &m_DescriptorPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create transparency descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = m_DescriptorPool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &m_SetLayout;
+    if (vkAllocateDescriptorSets(m_VulkanContext->logical_device, &allocate_info, &m_DescriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate transparency descriptor set");
+    }
+}
+
+omp::OitTargets::~OitTargets()
+{
+    destroyTargets();
+    // Set is freed with the pool
+    vkDestroyDescriptorPool(m_VulkanContext->logical_device, m_DescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_VulkanContext->logical_device, m_SetLayout, nullptr);
+}
+
+void omp::OitTargets::resize(VkExtent2D extent)
+{
+    destroyTargets();
+
+    // Only read inside of the render pass, contents never have to reach memory
+    const VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+                                    VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    m_VulkanContext->createImage(extent.width, extent.height, 1, s_AccumFormat, VK_IMAGE_TILING_OPTIMAL, usage,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_AccumImage, m_AccumMemory, m_Samples,
+                                 omp::EMemoryCategory::RenderTargets);
+    m_AccumView = m_VulkanContext->createImageView(m_AccumImage, s_AccumFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+    m_VulkanContext->createImage(extent.width, extent.height, 1, s_RevealageFormat, VK_IMAGE_TILING_OPTIMAL, usage,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_RevealageImage, m_RevealageMemory,
+                                 m_Samples, omp::EMemoryCategory::RenderTargets);
+    m_RevealageView = m_VulkanContext->createImageView(m_RevealageImage, s_RevealageFormat,
+                                                       VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+    std::array<VkDescriptorImageInfo, 2> image_infos{};
+    image_infos[0].imageView = m_AccumView;
+    image_infos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    image_infos[1].imageView = m_RevealageView;
+    image_infos[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t binding = 0; binding < writes.size(); binding++)
+    {
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet = m_DescriptorSet;
+        writes[binding].dstBinding = binding;
+        writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        writes[binding].descriptorCount = 1;
+        writes[binding].pImageInfo = &image_infos[binding];
+    }
+    vkUpdateDescriptorSets(m_VulkanContext->logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0,
+                           nullptr);
+}
+
+void omp::OitTargets::destroyTargets()
+{
+    if (m_AccumImage == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDestroyImageView(m_VulkanContext->logical_device, m_AccumView, nullptr);
+    m_VulkanContext->destroyImage(m_AccumImage, m_AccumMemory);
+    vkDestroyImageView(m_VulkanContext->logical_device, m_RevealageView, nullptr);
+    m_VulkanContext->destroyImage(m_RevealageImage, m_RevealageMemory);
+    m_AccumImage = VK_NULL_HANDLE;
+    m_RevealageImage = VK_NULL_HANDLE;
+}
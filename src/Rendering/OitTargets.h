@@ -0,0 +1,65 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include "VulkanContext.h"
+
+namespace omp
+{
+    /**
+     * Attachments of weighted blended order independent transparency.
+     * Transparent draws add weighted premultiplied color into accumulation
+     * and multiply revealage by one minus their alpha, in any order.
+     * Composite subpass reads both as input attachments and blends the average over opaque color.
+     */
+    class OitTargets
+    {
+    public:
+        static constexpr VkFormat s_AccumFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+        static constexpr VkFormat s_RevealageFormat = VK_FORMAT_R16_SFLOAT;
+
+        // Multisampled composite averages every sample of the pixel
+        struct CompositePushConstant
+        {
+            int32_t sample_count;
+        };
+
+        OitTargets(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, VkSampleCountFlagBits samples);
+        OitTargets(const OitTargets&) = delete;
+        OitTargets& operator=(const OitTargets&) = delete;
+        ~OitTargets();
+
+    private:
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        VkSampleCountFlagBits m_Samples;
+
+        VkImage m_AccumImage = VK_NULL_HANDLE;
+        omp::GpuAllocation m_AccumMemory;
+        VkImageView m_AccumView = VK_NULL_HANDLE;
+        VkImage m_RevealageImage = VK_NULL_HANDLE;
+        omp::GpuAllocation m_RevealageMemory;
+        VkImageView m_RevealageView = VK_NULL_HANDLE;
+
+        // Outlives targets, composite pipeline is created once against it
+        VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+
+        // Methods //
+        // ======= //
+    public:
+        // Recreates both targets and points the composite set at them, old ones must be out of use
+        void resize(VkExtent2D extent);
+
+        VkImageView getAccumView() const { return m_AccumView; }
+        VkImageView getRevealageView() const { return m_RevealageView; }
+        VkDescriptorSetLayout getSetLayout() const { return m_SetLayout; }
+        VkDescriptorSet getDescriptorSet() const { return m_DescriptorSet; }
+        CompositePushConstant getCompositeConstant() const { return {static_cast<int32_t>(m_Samples)}; }
+        bool isMultisampled() const { return m_Samples != VK_SAMPLE_COUNT_1_BIT; }
+
+    private:
+        void destroyTargets();
+    };
+}
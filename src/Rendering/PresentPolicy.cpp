@@ -0,0 +1,67 @@
+#include "PresentPolicy.h"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    bool isAvailable(const std::vector<VkPresentModeKHR>& availableModes, VkPresentModeKHR mode)
+    {
+        return std::find(availableModes.begin(), availableModes.end(), mode) != availableModes.end();
+    }
+
+    // Most wanted first, fifo is last as the only guaranteed one
+    std::array<VkPresentModeKHR, 3> getPolicyModes(omp::PresentPolicy policy)
+    {
+        switch (policy)
+        {
+            case omp::PresentPolicy::VSync:
+                return {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR};
+            case omp::PresentPolicy::LowLatency:
+                return {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR};
+            case omp::PresentPolicy::Uncapped:
+                return {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+        }
+        return {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    }
+}
+
+omp::PresentChoice omp::choosePresentation(const PresentSettings& settings,
+                                           const std::vector<VkPresentModeKHR>& availableModes,
+                                           uint32_t minImageCount, uint32_t maxImageCount)
+{
+    PresentChoice choice;
+    if (settings.mode && isAvailable(availableModes, settings.mode.value()))
+    {
+        choice.mode = settings.mode.value();
+    }
+    else
+    {
+        for (VkPresentModeKHR mode: getPolicyModes(settings.policy))
+        {
+            if (isAvailable(availableModes, mode))
+            {
+                choice.mode = mode;
+                break;
+            }
+        }
+    }
+
+    // Extra image lets cpu record the next frame while one is shown and one waits, except for low latency
+    // fifo where every extra image is another frame of queued latency
+    choice.image_count = minImageCount + 1;
+    if (settings.policy == PresentPolicy::LowLatency && choice.mode == VK_PRESENT_MODE_FIFO_KHR)
+    {
+        choice.image_count = minImageCount;
+    }
+    if (settings.image_count > 0)
+    {
+        choice.image_count = settings.image_count;
+    }
+
+    choice.image_count = std::max(choice.image_count, minImageCount);
+    if (maxImageCount > 0)
+    {
+        choice.image_count = std::min(choice.image_count, maxImageCount);
+    }
+    return choice;
+}
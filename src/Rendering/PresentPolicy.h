@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace omp
+{
+    // What presentation is tuned for when no explicit mode is given
+    enum class PresentPolicy
+    {
+        // Fifo, never tears, frames queue behind vertical blank
+        VSync,
+        // Mailbox, or fifo with the fewest images so that queue stays short
+        LowLatency,
+        // Immediate, tears but never blocks, for benchmarks
+        Uncapped
+    };
+
+    struct PresentSettings
+    {
+        PresentPolicy policy = PresentPolicy::LowLatency;
+        // Replaces mode of the policy when surface supports it
+        std::optional<VkPresentModeKHR> mode;
+        // Zero takes count of the policy, anything is clamped to surface limits
+        uint32_t image_count = 0;
+
+        bool operator==(const PresentSettings&) const = default;
+    };
+
+    struct PresentChoice
+    {
+        VkPresentModeKHR mode = VK_PRESENT_MODE_FIFO_KHR;
+        uint32_t image_count = 0;
+    };
+
+    // Max image count of zero means no limit, as in surface capabilities
+    PresentChoice choosePresentation(const PresentSettings& settings,
+                                     const std::vector<VkPresentModeKHR>& availableModes,
+                                     uint32_t minImageCount, uint32_t maxImageCount);
+}
@@ -0,0 +1,200 @@
+#include "RenderQueue.h"
+#include <array>
+#include <cstring>
+#include "Logs.h"
+
+namespace
+{
+    constexpr uint64_t g_PipelineMask = 0x7fff;
+    constexpr uint64_t g_MaterialMask = 0xffff;
+    constexpr uint64_t g_ModelMask = 0xffff;
+    // Builds an id may go unused before it is given to another owner
+    constexpr uint64_t g_IdRetireBuilds = 256;
+
+    constexpr size_t g_RadixBits = 8;
+    constexpr size_t g_RadixBuckets = 1 << g_RadixBits;
+    constexpr size_t g_RadixPasses = 64 / g_RadixBits;
+
+    uint32_t depthToBits(float depth)
+    {
+        // Bit pattern of non negative floats grows with the value
+        if (!(depth > 0.0f))
+        {
+            return 0;
+        }
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits;
+    }
+}
+
+uint64_t omp::RenderQueue::makeKey(bool transparent, uint16_t pipelineId, uint16_t materialId, uint16_t modelId, float depth)
+{
+    const uint64_t pipeline = pipelineId & g_PipelineMask;
+    const uint64_t material = materialId & g_MaterialMask;
+    const uint64_t model = modelId & g_ModelMask;
+
+    if (transparent)
+    {
+        return (uint64_t(1) << 63) | (pipeline << 48) | (material << 32) | (model << 16);
+    }
+    // Sign, exponent and top of mantissa are enough to order opaque draws
+    const uint64_t depth_bucket = depthToBits(depth) >> 16;
+    return (pipeline << 48) | (material << 32) | (model << 16) | depth_bucket;
+}
+
+uint16_t omp::RenderQueue::getPipelineId(const std::string& pipelineName)
+{
+    return acquireId(m_PipelineIds, pipelineName, g_PipelineMask, "pipeline");
+}
+
+uint16_t omp::RenderQueue::getMaterialId(const omp::Material* material)
+{
+    return acquireId(m_MaterialIds, material, g_MaterialMask, "material");
+}
+
+uint16_t omp::RenderQueue::getModelId(const omp::Model* model)
+{
+    return acquireId(m_ModelIds, model, g_ModelMask, "model");
+}
+
+template<typename Key>
+uint16_t omp::RenderQueue::acquireId(IdTable<Key>& table, const Key& owner, uint64_t mask, const char* kind)
+{
+    auto it = table.slots.find(owner);
+    if (it != table.slots.end())
+    {
+        it->second.last_build = m_Build;
+        return it->second.id;
+    }
+
+    uint16_t id;
+    if (!table.free_ids.empty())
+    {
+        id = table.free_ids.back();
+        table.free_ids.pop_back();
+    }
+    else if (table.next_id <= mask)
+    {
+        id = static_cast<uint16_t>(table.next_id++);
+    }
+    else
+    {
+        // Shared id only costs sorting quality, batches still compare the state itself
+        if (!table.overflow_reported)
+        {
+            ERROR(LogRendering, "Render queue ran out of {} ids, {} are in use", kind, table.slots.size());
+            table.overflow_reported = true;
+        }
+        id = static_cast<uint16_t>(mask);
+    }
+    table.slots.insert({owner, {id, m_Build}});
+    return id;
+}
+
+template<typename Key>
+void omp::RenderQueue::retireIds(IdTable<Key>& table)
+{
+    for (auto it = table.slots.begin(); it != table.slots.end();)
+    {
+        if (m_Build - it->second.last_build > g_IdRetireBuilds)
+        {
+            table.free_ids.push_back(it->second.id);
+            it = table.slots.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void omp::RenderQueue::clear()
+{
+    m_Items.clear();
+    m_Entries.clear();
+    m_Batches.clear();
+
+    // Owners are referenced by address only, so those not asked for in a while are taken as gone
+    m_Build++;
+    if (m_Build % g_IdRetireBuilds == 0)
+    {
+        retireIds(m_PipelineIds);
+        retireIds(m_MaterialIds);
+        retireIds(m_ModelIds);
+    }
+}
+
+void omp::RenderQueue::add(uint64_t key, const DrawItem& item)
+{
+    m_Entries.push_back({key, static_cast<uint32_t>(m_Items.size())});
+    m_Items.push_back(item);
+}
+
+void omp::RenderQueue::sort()
+{
+    radixSort(m_Entries, m_Scratch);
+    buildBatches();
+}
+
+void omp::RenderQueue::buildBatches()
+{
+    m_Batches.clear();
+    for (uint32_t index = 0; index < m_Entries.size(); index++)
+    {
+        const DrawItem& item = getItem(index);
+        if (!m_Batches.empty())
+        {
+            DrawBatch& last = m_Batches.back();
+            if (last.pipeline == item.pipeline && last.material == item.material && last.model == item.model)
+            {
+                last.count++;
+                continue;
+            }
+        }
+        m_Batches.push_back({index, 1, item.pipeline, item.material, item.model});
+    }
+}
+
+void omp::RenderQueue::radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    const size_t count = entries.size();
+    if (count < 2)
+    {
+        return;
+    }
+    scratch.resize(count);
+
+    // LSD radix sort, stable on every pass
+    std::array<size_t, g_RadixBuckets> offsets{};
+    for (size_t pass = 0; pass < g_RadixPasses; pass++)
+    {
+        const size_t shift = pass * g_RadixBits;
+
+        offsets.fill(0);
+        for (const SortEntry& entry: entries)
+        {
+            offsets[(entry.key >> shift) & (g_RadixBuckets - 1)]++;
+        }
+
+        // All keys share this digit, nothing to reorder
+        if (offsets[(entries[0].key >> shift) & (g_RadixBuckets - 1)] == count)
+        {
+            continue;
+        }
+
+        size_t sum = 0;
+        for (size_t& offset: offsets)
+        {
+            size_t bucket_size = offset;
+            offset = sum;
+            sum += bucket_size;
+        }
+
+        for (const SortEntry& entry: entries)
+        {
+            scratch[offsets[(entry.key >> shift) & (g_RadixBuckets - 1)]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
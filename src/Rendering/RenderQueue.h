@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omp
+{
+    class SceneEntity;
+    class GraphicsPipeline;
+    class Material;
+    class Model;
+
+    struct DrawItem
+    {
+        omp::SceneEntity* entity = nullptr;
+        omp::GraphicsPipeline* pipeline = nullptr;
+        omp::Material* material = nullptr;
+        omp::Model* model = nullptr;
+    };
+
+    // Without instancing every entity is a draw call
+    struct DrawStats
+    {
+        uint32_t entities = 0;
+        uint32_t draw_calls = 0;
+
+        // Gpu culling of the previous use of the frame
+        uint32_t frustum_culled = 0;
+        uint32_t occlusion_culled = 0;
+        uint32_t occluded_triangles = 0;
+        // Gpu time of culling and main pass, zero if timestamps are not supported
+        float main_pass_ms = 0.f;
+        // Fragment shader invocations of the main pass and their ratio to its pixels,
+        // zero unless overdraw statistics are enabled
+        uint64_t fragment_invocations = 0;
+        float overdraw = 0.f;
+    };
+
+    // Run of sorted items sharing pipeline, material and model
+    struct DrawBatch
+    {
+        uint32_t first = 0;
+        uint32_t count = 0;
+
+        omp::GraphicsPipeline* pipeline = nullptr;
+        omp::Material* material = nullptr;
+        omp::Model* model = nullptr;
+
+        // Equal batches record equal commands, instance data aside
+        bool operator==(const DrawBatch& other) const = default;
+    };
+
+    /**
+     * Per frame list of draw items ordered by packed 64 bit keys.
+     * Opaque:      [1 bit 0][15 bits pipeline][16 bits material][16 bits model][16 bits depth bucket] front to back
+     * Transparent: [1 bit 1][15 bits pipeline][16 bits material][16 bits model][16 bits zero]
+     * Items with equal state end up next to each other and can be drawn instanced,
+     * transparent ones need no order as they are blended order independently
+     */
+    class RenderQueue
+    {
+    public:
+        static uint64_t makeKey(bool transparent, uint16_t pipelineId, uint16_t materialId, uint16_t modelId, float depth);
+
+        // Ids are stable between frames, so equal state gives equal key bits.
+        // Ids of owners that were not asked for during the last builds, destroyed ones included, are recycled
+        uint16_t getPipelineId(const std::string& pipelineName);
+        uint16_t getMaterialId(const omp::Material* material);
+        uint16_t getModelId(const omp::Model* model);
+
+        void clear();
+        void add(uint64_t key, const DrawItem& item);
+        void sort();
+
+        size_t size() const { return m_Entries.size(); }
+        bool empty() const { return m_Entries.empty(); }
+
+        // Valid after sort, index is position in sorted order
+        const DrawItem& getItem(size_t index) const { return m_Items[m_Entries[index].item_index]; }
+        uint64_t getKey(size_t index) const { return m_Entries[index].key; }
+        const std::vector<DrawBatch>& getBatches() const { return m_Batches; }
+
+    private:
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t item_index;
+        };
+
+        // State //
+        // ===== //
+        std::vector<DrawItem> m_Items;
+        std::vector<SortEntry> m_Entries;
+        std::vector<SortEntry> m_Scratch;
+        std::vector<DrawBatch> m_Batches;
+
+        struct IdSlot
+        {
+            uint16_t id;
+            uint64_t last_build;
+        };
+
+        template<typename Key>
+        struct IdTable
+        {
+            std::unordered_map<Key, IdSlot> slots;
+            std::vector<uint16_t> free_ids;
+            uint32_t next_id = 0;
+            bool overflow_reported = false;
+        };
+
+        uint64_t m_Build = 0;
+        IdTable<std::string> m_PipelineIds;
+        IdTable<const omp::Material*> m_MaterialIds;
+        IdTable<const omp::Model*> m_ModelIds;
+
+        template<typename Key>
+        uint16_t acquireId(IdTable<Key>& table, const Key& owner, uint64_t mask, const char* kind);
+        template<typename Key>
+        void retireIds(IdTable<Key>& table);
+
+        void buildBatches();
+        static void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+
+namespace omp
+{
+    /**
+     * Graphics commands of one frame, counted on cpu while they are recorded.
+     * Main pass buffers reused from an earlier frame bring the counts they were recorded with.
+     * Compute dispatches of culling and the depth pyramid are not counted.
+     */
+    struct RenderStats
+    {
+        // Every indirect call counts once, whatever its draw count
+        uint32_t draw_calls = 0;
+        uint32_t indirect_draw_calls = 0;
+        // Of every instance, indirect draws count their batches as they were before gpu culling
+        uint64_t indices = 0;
+        uint64_t triangles = 0;
+
+        uint32_t pipeline_binds = 0;
+        // Sets, not calls
+        uint32_t descriptor_set_binds = 0;
+        uint32_t vertex_buffer_binds = 0;
+        uint32_t index_buffer_binds = 0;
+        uint64_t push_constant_bytes = 0;
+
+        // Culled by gpu culling in the previous use of the frame, everything is visible without it
+        uint32_t visible_entities = 0;
+        uint32_t culled_entities = 0;
+
+        void addIndexedDraw(uint32_t indexCount, uint32_t instanceCount)
+        {
+            draw_calls++;
+            indices += uint64_t{indexCount} * instanceCount;
+            triangles += uint64_t{indexCount / 3} * instanceCount;
+        }
+
+        void addDraw(uint32_t vertexCount, uint32_t instanceCount)
+        {
+            draw_calls++;
+            triangles += uint64_t{vertexCount / 3} * instanceCount;
+        }
+
+        void addIndirectDraws(uint32_t calls, uint64_t indexCount)
+        {
+            draw_calls += calls;
+            indirect_draw_calls += calls;
+            indices += indexCount;
+            triangles += indexCount / 3;
+        }
+
+        RenderStats& operator+=(const RenderStats& other)
+        {
+            draw_calls += other.draw_calls;
+            indirect_draw_calls += other.indirect_draw_calls;
+            indices += other.indices;
+            triangles += other.triangles;
+            pipeline_binds += other.pipeline_binds;
+            descriptor_set_binds += other.descriptor_set_binds;
+            vertex_buffer_binds += other.vertex_buffer_binds;
+            index_buffer_binds += other.index_buffer_binds;
+            push_constant_bytes += other.push_constant_bytes;
+            visible_entities += other.visible_entities;
+            culled_entities += other.culled_entities;
+            return *this;
+        }
+    };
+}
@@ -65,12 +65,8 @@ bool omp::Shader::load()
     }
 
     auto vert_shader_code = readFile(m_VertexPath);
-    auto frag_shader_code = readFile(m_FragmentPath);
-
     VkShaderModule vert_shader_module = m_Context->createShaderModule(vert_shader_code);
-    VkShaderModule frag_shader_module = m_Context->createShaderModule(frag_shader_code);
     m_ShaderModules[0] = vert_shader_module;
-    m_ShaderModules[1] = frag_shader_module;
 
     // Vertex shader
     VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
@@ -80,7 +76,18 @@ bool omp::Shader::load()
     vert_shader_stage_info.module = vert_shader_module;
     vert_shader_stage_info.pName = "main";
 
+    // Depth only shaders have no fragment stage
+    if (m_FragmentPath.empty())
+    {
+        m_ShaderStages = {vert_shader_stage_info};
+        return true;
+    }
+
     // Fragment shader
+    auto frag_shader_code = readFile(m_FragmentPath);
+    VkShaderModule frag_shader_module = m_Context->createShaderModule(frag_shader_code);
+    m_ShaderModules[1] = frag_shader_module;
+
     VkPipelineShaderStageCreateInfo frag_shader_stage_info{};
     frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -13,6 +13,7 @@ namespace omp
     {
     public:
         Shader() = default;
+        // Empty fragment path makes a vertex only shader
         Shader(
             const std::shared_ptr<VulkanContext>& context,
             const std::string& vertexPath,
@@ -38,7 +39,7 @@ namespace omp
 
         std::shared_ptr<VulkanContext> m_Context = nullptr;
 
-        std::array<VkShaderModule, STAGE_COUNT> m_ShaderModules;
+        std::array<VkShaderModule, STAGE_COUNT> m_ShaderModules{};
 
         std::string m_VertexPath;
         std::string m_FragmentPath;
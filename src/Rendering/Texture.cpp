@@ -21,10 +21,25 @@ void omp::Texture::destroyVkObjects()
 {
     if (hasVulkanContext() && hasFlags(LOADED_TO_GPU))
     {
+        // Transfer queue must not write into a destroyed image, returns at once for finished uploads
+        if (omp::UploadManager* uploads = m_VulkanContext.lock()->getUploadManager())
+        {
+            uploads->wait(m_UploadTicket);
+        }
+        if (hasFlags(LOADED_TO_UI))
+        {
+            ImGui_ImplVulkan_RemoveTexture(m_Id);
+        }
+        // Materials see the index change and register the reloaded image again
+        if (omp::BindlessTextures* bindless = m_VulkanContext.lock()->getBindlessTextures())
+        {
+            bindless->releaseTexture(*this);
+        }
+        m_BindlessIndex = UINT32_MAX;
         vkDestroySampler(m_VulkanContext.lock()->logical_device, m_TextureSampler, nullptr);
         vkDestroyImageView(m_VulkanContext.lock()->logical_device, m_TextureImageView, nullptr);
-        vkDestroyImage(m_VulkanContext.lock()->logical_device, m_TextureImage, nullptr);
-        vkFreeMemory(m_VulkanContext.lock()->logical_device, m_TextureImageMemory, nullptr);
+        m_VulkanContext.lock()->destroyImage(m_TextureImage, m_TextureImageMemory);
+        removeFlags(LOADED_TO_GPU | LOADED_TO_UI);
     }
 }
 
@@ -93,18 +108,8 @@ void omp::Texture::createSampler()
 
 void omp::Texture::createImage()
 {
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
     // TODO: Layer amount 
     size_t size_to_alloc = m_TextureSource->getSize();
-    m_VulkanContext.lock()->createBuffer(size_to_alloc, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                         staging_buffer, staging_buffer_memory);
-
-    char* data;
-    vkMapMemory(m_VulkanContext.lock()->logical_device, staging_buffer_memory, 0, size_to_alloc, 0, reinterpret_cast<void**>(&data));
-    memcpy(data, m_TextureSource->getPixels(), size_to_alloc);
-    vkUnmapMemory(m_VulkanContext.lock()->logical_device, staging_buffer_memory);
 
     VkImageCreateFlags flags = 0;
     uint32_t array_layers = 1;
@@ -120,21 +125,23 @@ void omp::Texture::createImage()
                                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                                         VK_IMAGE_USAGE_SAMPLED_BIT,
                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_TextureImage, m_TextureImageMemory,
-                                        VK_SAMPLE_COUNT_1_BIT,
+                                        VK_SAMPLE_COUNT_1_BIT, omp::EMemoryCategory::Textures,
                                         flags, array_layers);
 
-    m_VulkanContext.lock()->transitionImageLayout(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-                                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_levels);
-
-    m_VulkanContext.lock()->copyBufferToImage(staging_buffer,
-                                              m_TextureImage,
-                                              width,
-                                              height);
-
-    m_VulkanContext.lock()->generateMipmaps(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, width, height, mip_levels);
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
 
-    vkDestroyBuffer(m_VulkanContext.lock()->logical_device, staging_buffer, nullptr);
-    vkFreeMemory(m_VulkanContext.lock()->logical_device, staging_buffer_memory, nullptr);
+    // Materials and imgui check isReadyForSampling before the texture is used
+    omp::UploadManager* uploads = m_VulkanContext.lock()->getUploadManager();
+    m_UploadTicket = uploads->uploadImage(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB,
+                                          m_TextureSource->getPixels(), size_to_alloc, {region},
+                                          mip_levels, array_layers,
+                                          static_cast<int32_t>(width), static_cast<int32_t>(height));
 }
 
 void omp::Texture::createImageView()
@@ -210,3 +217,12 @@ void omp::Texture::specifyVulkanContext(const std::shared_ptr<VulkanContext>& in
 {
     m_VulkanContext = inHelper;
 }
+
+bool omp::Texture::isReadyForSampling()
+{
+    if (!hasFlags(LOADED_TO_GPU))
+    {
+        loadToGpu();
+    }
+    return hasFlags(LOADED_TO_GPU) && m_VulkanContext.lock()->getUploadManager()->isReady(m_UploadTicket);
+}
@@ -22,7 +22,7 @@ namespace omp
         // Vulkan //
         // ====== //
         VkImage m_TextureImage;
-        VkDeviceMemory m_TextureImageMemory;
+        omp::GpuAllocation m_TextureImageMemory;
         VkImageView m_TextureImageView;
         VkSampler m_TextureSampler;
 
@@ -33,6 +33,10 @@ namespace omp
         std::shared_ptr<omp::TextureSrc> m_TextureSource;
         std::weak_ptr<VulkanContext> m_VulkanContext;
         uint16_t m_Flags = 0;
+        // Slot in bindless texture array, UINT32_MAX until registered
+        uint32_t m_BindlessIndex = UINT32_MAX;
+        // Image must not be sampled before the upload manager reports the ticket ready
+        omp::UploadTicket m_UploadTicket = 0;
 
     public:
         Texture() = default;
@@ -49,7 +53,11 @@ namespace omp
         VkImageView getImageView();
         VkImage getImage();
         VkSampler getSampler();
+        // Starts the upload on first call, true once the image can be sampled by a frame
+        bool isReadyForSampling();
         TextureSrc* getTextureSrc() const { return m_TextureSource.get(); }
+        uint32_t getBindlessIndex() const { return m_BindlessIndex; }
+        void setBindlessIndex(uint32_t index) { m_BindlessIndex = index; }
 
     protected:
         // Subroutines //
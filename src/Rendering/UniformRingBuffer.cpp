@@ -0,0 +1,44 @@
+#include "UniformRingBuffer.h"
+#include <stdexcept>
+#include "Logs.h"
+
+omp::UniformRingBuffer::UniformRingBuffer(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesNum, VkDeviceSize frameCapacity, VkDeviceSize alignment)
+    : m_VulkanContext(inVulkanContext)
+    , m_Alignment(alignment > 0 ? alignment : 1)
+    , m_FramesNum(framesNum)
+{
+    // Vulkan alignment limits are powers of two
+    m_FrameCapacity = alignUp(frameCapacity);
+
+    m_VulkanContext->createBuffer(m_FrameCapacity * m_FramesNum,
+                                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  m_Buffer, m_Memory, omp::EMemoryCategory::Uniforms);
+
+    m_Mapped = static_cast<uint8_t*>(m_Memory.mapped);
+}
+
+omp::UniformRingBuffer::~UniformRingBuffer()
+{
+    m_VulkanContext->destroyBuffer(m_Buffer, m_Memory);
+}
+
+void omp::UniformRingBuffer::beginFrame(uint32_t frame)
+{
+    m_Head = m_FrameCapacity * frame;
+    m_FrameEnd = m_Head + m_FrameCapacity;
+}
+
+uint32_t omp::UniformRingBuffer::allocate(VkDeviceSize size, void** outData)
+{
+    const VkDeviceSize offset = m_Head;
+    if (offset + size > m_FrameEnd)
+    {
+        ERROR(LogRendering, "Uniform ring buffer is out of space for this frame");
+        throw std::runtime_error("Uniform ring buffer overflow");
+    }
+    m_Head = alignUp(offset + size);
+
+    *outData = m_Mapped + offset;
+    return static_cast<uint32_t>(offset);
+}
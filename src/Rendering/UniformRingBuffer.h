@@ -0,0 +1,52 @@
+#pragma once
+#include <cstring>
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include "VulkanContext.h"
+
+namespace omp
+{
+    /**
+     * One persistently mapped host coherent buffer with a region per frame in flight.
+     * Each frame allocates linearly from its own region, data is bound with dynamic offsets.
+     */
+    class UniformRingBuffer
+    {
+    private:
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        VkBuffer m_Buffer = VK_NULL_HANDLE;
+        omp::GpuAllocation m_Memory;
+        uint8_t* m_Mapped = nullptr;
+
+        VkDeviceSize m_Alignment = 1;
+        VkDeviceSize m_FrameCapacity = 0;
+        uint32_t m_FramesNum = 0;
+
+        VkDeviceSize m_FrameEnd = 0;
+        VkDeviceSize m_Head = 0;
+
+    public:
+        UniformRingBuffer(const std::shared_ptr<omp::VulkanContext>& inVulkanContext, uint32_t framesNum, VkDeviceSize frameCapacity, VkDeviceSize alignment);
+        UniformRingBuffer(const UniformRingBuffer&) = delete;
+        UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+        ~UniformRingBuffer();
+
+        // Previous allocations of this frame are discarded, gpu must be done with them
+        void beginFrame(uint32_t frame);
+
+        // Returns offset from the start of the buffer, to be used as dynamic offset
+        uint32_t allocate(VkDeviceSize size, void** outData);
+
+        template<class T>
+        uint32_t push(const T& data)
+        {
+            void* memory = nullptr;
+            uint32_t offset = allocate(sizeof(T), &memory);
+            std::memcpy(memory, &data, sizeof(T));
+            return offset;
+        }
+
+        VkBuffer getBuffer() const { return m_Buffer; }
+        VkDeviceSize alignUp(VkDeviceSize size) const { return (size + m_Alignment - 1) & ~(m_Alignment - 1); }
+    };
+}
@@ -0,0 +1,423 @@
+#include "UploadManager.h"
+#include <cstring>
+#include <stdexcept>
+#include "VulkanContext.h"
+#include "Logs.h"
+
+namespace
+{
+    constexpr VkDeviceSize g_StagingAlignment = 16;
+
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+omp::UploadManager::UploadManager(const std::shared_ptr<omp::VulkanContext>& inVulkanContext,
+                                  VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily,
+                                  VkDeviceSize stagingCapacity)
+    : m_VulkanContext(inVulkanContext)
+    , m_TransferQueue(transferQueue)
+    , m_TransferFamily(transferFamily)
+    , m_GraphicsFamily(graphicsFamily)
+    , m_StagingCapacity(stagingCapacity)
+{
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = m_TransferFamily;
+    if (vkCreateCommandPool(m_VulkanContext->logical_device, &pool_info, nullptr, &m_CommandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create upload command pool");
+    }
+
+    m_VulkanContext->createBuffer(m_StagingCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  m_StagingBuffer, m_StagingMemory, omp::EMemoryCategory::Staging);
+
+    INFO(LogRendering, "Uploads go through queue family {}, graphics family {}", m_TransferFamily, m_GraphicsFamily);
+}
+
+omp::UploadManager::~UploadManager()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    submitOpenBatch();
+    vkQueueWaitIdle(m_TransferQueue);
+
+    auto destroy_batch = [this](Batch& batch)
+    {
+        if (batch.fence != VK_NULL_HANDLE)
+        {
+            vkDestroyFence(m_VulkanContext->logical_device, batch.fence, nullptr);
+        }
+        for (auto& [buffer, memory]: batch.oversized_staging)
+        {
+            m_VulkanContext->destroyBuffer(buffer, memory);
+        }
+    };
+    for (Batch& batch: m_Batches)
+    {
+        destroy_batch(batch);
+    }
+    for (Batch& batch: m_FreeBatches)
+    {
+        destroy_batch(batch);
+    }
+
+    // Command buffers are freed with the pool
+    vkDestroyCommandPool(m_VulkanContext->logical_device, m_CommandPool, nullptr);
+    m_VulkanContext->destroyBuffer(m_StagingBuffer, m_StagingMemory);
+}
+
+omp::UploadManager::Batch& omp::UploadManager::getOpenBatch()
+{
+    if (!m_Batches.empty() && !m_Batches.back().submitted)
+    {
+        return m_Batches.back();
+    }
+
+    Batch batch{};
+    if (!m_FreeBatches.empty())
+    {
+        batch.command_buffer = m_FreeBatches.back().command_buffer;
+        batch.fence = m_FreeBatches.back().fence;
+        m_FreeBatches.pop_back();
+    }
+    else
+    {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandPool = m_CommandPool;
+        alloc_info.commandBufferCount = 1;
+        vkAllocateCommandBuffers(m_VulkanContext->logical_device, &alloc_info, &batch.command_buffer);
+
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        vkCreateFence(m_VulkanContext->logical_device, &fence_info, nullptr, &batch.fence);
+    }
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch.command_buffer, &begin_info);
+
+    batch.ticket = m_NextTicket++;
+    batch.ring_end = m_StagingHead;
+    m_Batches.push_back(std::move(batch));
+    return m_Batches.back();
+}
+
+void omp::UploadManager::submitOpenBatch()
+{
+    if (m_Batches.empty() || m_Batches.back().submitted)
+    {
+        return;
+    }
+    Batch& batch = m_Batches.back();
+    vkEndCommandBuffer(batch.command_buffer);
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &batch.command_buffer;
+
+    vkResetFences(m_VulkanContext->logical_device, 1, &batch.fence);
+    if (vkQueueSubmit(m_TransferQueue, 1, &submit_info, batch.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit upload batch");
+    }
+    batch.submitted = true;
+}
+
+void omp::UploadManager::collectFinished(bool waitOldest)
+{
+    while (!m_Batches.empty() && m_Batches.front().submitted)
+    {
+        Batch& batch = m_Batches.front();
+        if (vkGetFenceStatus(m_VulkanContext->logical_device, batch.fence) != VK_SUCCESS)
+        {
+            if (!waitOldest)
+            {
+                break;
+            }
+            vkWaitForFences(m_VulkanContext->logical_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+            waitOldest = false;
+        }
+
+        m_StagingTail = batch.ring_end;
+        for (auto& [buffer, memory]: batch.oversized_staging)
+        {
+            m_VulkanContext->destroyBuffer(buffer, memory);
+        }
+        batch.oversized_staging.clear();
+
+        Batch recycled{};
+        recycled.command_buffer = batch.command_buffer;
+        recycled.fence = batch.fence;
+        m_FreeBatches.push_back(recycled);
+
+        batch.command_buffer = VK_NULL_HANDLE;
+        batch.fence = VK_NULL_HANDLE;
+        m_FinishedBatches.push_back(std::move(batch));
+        m_Batches.pop_front();
+    }
+
+    // Nothing in flight, ring starts over
+    if (m_Batches.empty())
+    {
+        m_StagingHead = 0;
+        m_StagingTail = 0;
+    }
+}
+
+std::optional<VkDeviceSize> omp::UploadManager::tryAllocateRing(VkDeviceSize size)
+{
+    // Head never catches up with tail, so equal head and tail always mean an empty ring
+    if (m_StagingHead >= m_StagingTail)
+    {
+        const VkDeviceSize offset = alignUp(m_StagingHead, g_StagingAlignment);
+        if (offset + size <= m_StagingCapacity)
+        {
+            m_StagingHead = offset + size;
+            return offset;
+        }
+        // Wrap, tail end of the ring is skipped
+        if (size < m_StagingTail)
+        {
+            m_StagingHead = size;
+            return 0;
+        }
+        return std::nullopt;
+    }
+
+    const VkDeviceSize offset = alignUp(m_StagingHead, g_StagingAlignment);
+    if (offset + size < m_StagingTail)
+    {
+        m_StagingHead = offset + size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void* omp::UploadManager::allocateStaging(VkDeviceSize size, VkBuffer& outBuffer, VkDeviceSize& outOffset)
+{
+    if (size > m_StagingCapacity / 2)
+    {
+        VkBuffer buffer;
+        omp::GpuAllocation memory;
+        m_VulkanContext->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      buffer, memory, omp::EMemoryCategory::Staging);
+        getOpenBatch().oversized_staging.emplace_back(buffer, memory);
+        outBuffer = buffer;
+        outOffset = 0;
+        return memory.mapped;
+    }
+
+    std::optional<VkDeviceSize> offset = tryAllocateRing(size);
+    while (!offset)
+    {
+        // Ring is full, make room by waiting for the oldest batch
+        submitOpenBatch();
+        collectFinished(true);
+        offset = tryAllocateRing(size);
+    }
+
+    Batch& batch = getOpenBatch();
+    batch.ring_end = m_StagingHead;
+
+    outBuffer = m_StagingBuffer;
+    outOffset = offset.value();
+    return static_cast<uint8_t*>(m_StagingMemory.mapped) + offset.value();
+}
+
+omp::UploadTicket omp::UploadManager::uploadBuffer(
+        VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VkBuffer staging_buffer;
+    VkDeviceSize staging_offset;
+    void* staging = allocateStaging(size, staging_buffer, staging_offset);
+    std::memcpy(staging, data, size);
+
+    Batch& batch = getOpenBatch();
+
+    VkBufferCopy region{};
+    region.srcOffset = staging_offset;
+    region.dstOffset = dstOffset;
+    region.size = size;
+    vkCmdCopyBuffer(batch.command_buffer, staging_buffer, dstBuffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.buffer = dstBuffer;
+    barrier.offset = dstOffset;
+    barrier.size = size;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccess;
+
+    if (m_TransferFamily != m_GraphicsFamily)
+    {
+        // Release half of ownership transfer, acquire is recorded on graphics queue
+        barrier.srcQueueFamilyIndex = m_TransferFamily;
+        barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+        VkBufferMemoryBarrier release = barrier;
+        release.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.command_buffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 1, &release, 0, nullptr);
+        barrier.srcAccessMask = 0;
+    }
+
+    batch.buffers.push_back(barrier);
+    batch.dst_stages |= dstStage;
+    return batch.ticket;
+}
+
+omp::UploadTicket omp::UploadManager::uploadImage(
+        VkImage image, VkFormat format, const void* data, VkDeviceSize size,
+        const std::vector<VkBufferImageCopy>& regions,
+        uint32_t mipLevels, uint32_t layerCount, int32_t width, int32_t height)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VkBuffer staging_buffer;
+    VkDeviceSize staging_offset;
+    void* staging = allocateStaging(size, staging_buffer, staging_offset);
+    std::memcpy(staging, data, size);
+
+    Batch& batch = getOpenBatch();
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = image;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = layerCount;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(batch.command_buffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    std::vector<VkBufferImageCopy> staged_regions = regions;
+    for (VkBufferImageCopy& region: staged_regions)
+    {
+        region.bufferOffset += staging_offset;
+    }
+    vkCmdCopyBufferToImage(batch.command_buffer, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(staged_regions.size()), staged_regions.data());
+
+    if (m_TransferFamily != m_GraphicsFamily)
+    {
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = m_TransferFamily;
+        barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.command_buffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    batch.images.push_back({image, format, mipLevels, layerCount, width, height});
+    return batch.ticket;
+}
+
+void omp::UploadManager::recordAcquires(VkCommandBuffer commandBuffer)
+{
+    const bool transfers_ownership = m_TransferFamily != m_GraphicsFamily;
+    // Transfer queue work is done by now, fence was waited on host
+    const VkPipelineStageFlags src_stage = transfers_ownership
+                                           ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+                                           : VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    for (Batch& batch: m_FinishedBatches)
+    {
+        if (!batch.buffers.empty())
+        {
+            vkCmdPipelineBarrier(commandBuffer, src_stage, batch.dst_stages, 0,
+                                 0, nullptr,
+                                 static_cast<uint32_t>(batch.buffers.size()), batch.buffers.data(),
+                                 0, nullptr);
+        }
+
+        for (const ImageUpload& upload: batch.images)
+        {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.image = upload.image;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = transfers_ownership ? m_TransferFamily : VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = transfers_ownership ? m_GraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = upload.mip_levels;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = upload.layer_count;
+            barrier.srcAccessMask = transfers_ownership ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(commandBuffer, src_stage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                 0, nullptr, 0, nullptr, 1, &barrier);
+
+            // Blits need graphics queue, so mips are generated after acquire
+            m_VulkanContext->recordGenerateMipmaps(commandBuffer, upload.image, upload.format,
+                                                   upload.width, upload.height, upload.mip_levels);
+        }
+        m_AcquiredTicket = batch.ticket;
+    }
+    m_FinishedBatches.clear();
+}
+
+void omp::UploadManager::flush()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    submitOpenBatch();
+}
+
+void omp::UploadManager::acquireFinished(VkCommandBuffer graphicsCommandBuffer)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    submitOpenBatch();
+    collectFinished(false);
+    recordAcquires(graphicsCommandBuffer);
+}
+
+void omp::UploadManager::wait(omp::UploadTicket ticket)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (ticket <= m_AcquiredTicket)
+    {
+        return;
+    }
+
+    submitOpenBatch();
+    while (!m_Batches.empty() && m_Batches.front().ticket <= ticket)
+    {
+        collectFinished(true);
+    }
+
+    VkCommandBuffer command_buffer = m_VulkanContext->beginSingleTimeCommands();
+    recordAcquires(command_buffer);
+    m_VulkanContext->endSingleTimeCommands(command_buffer);
+}
+
+bool omp::UploadManager::isReady(omp::UploadTicket ticket) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return ticket <= m_AcquiredTicket;
+}
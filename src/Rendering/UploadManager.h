@@ -0,0 +1,119 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "GpuMemoryAllocator.h"
+
+namespace omp
+{
+    class VulkanContext;
+
+    // Uploads recorded into the same batch share a ticket, tickets grow in submission order
+    using UploadTicket = uint64_t;
+
+    /**
+     * Streams data into device local buffers and images through a persistently mapped staging ring.
+     * Copies are batched into one submit on the transfer queue and tracked with a fence per batch.
+     * With a dedicated transfer family ownership is released by the transfer queue
+     * and acquired on graphics queue by the first frame that sees the batch finished.
+     */
+    class UploadManager
+    {
+    public:
+        UploadManager(const std::shared_ptr<omp::VulkanContext>& inVulkanContext,
+                      VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily,
+                      VkDeviceSize stagingCapacity = 32ull * 1024 * 1024);
+        UploadManager(const UploadManager&) = delete;
+        UploadManager& operator=(const UploadManager&) = delete;
+        ~UploadManager();
+
+    private:
+        struct ImageUpload
+        {
+            VkImage image = VK_NULL_HANDLE;
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            uint32_t mip_levels = 1;
+            uint32_t layer_count = 1;
+            int32_t width = 0;
+            int32_t height = 0;
+        };
+
+        struct Batch
+        {
+            VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            omp::UploadTicket ticket = 0;
+            bool submitted = false;
+            VkPipelineStageFlags dst_stages = 0;
+            // Staging ring is free up to here once the batch is finished
+            VkDeviceSize ring_end = 0;
+
+            std::vector<VkBufferMemoryBarrier> buffers;
+            std::vector<ImageUpload> images;
+            // Uploads too big for the ring get their own staging buffer
+            std::vector<std::pair<VkBuffer, omp::GpuAllocation>> oversized_staging;
+        };
+
+        // State //
+        // ===== //
+        std::shared_ptr<omp::VulkanContext> m_VulkanContext;
+        VkQueue m_TransferQueue;
+        uint32_t m_TransferFamily;
+        uint32_t m_GraphicsFamily;
+        VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+
+        VkBuffer m_StagingBuffer = VK_NULL_HANDLE;
+        omp::GpuAllocation m_StagingMemory;
+        VkDeviceSize m_StagingCapacity;
+        VkDeviceSize m_StagingHead = 0;
+        VkDeviceSize m_StagingTail = 0;
+
+        // Open batch is at the back, submitted ones are in submission order
+        std::deque<Batch> m_Batches;
+        // Finished on transfer queue, waiting for graphics queue acquire
+        std::vector<Batch> m_FinishedBatches;
+        std::vector<Batch> m_FreeBatches;
+
+        omp::UploadTicket m_NextTicket = 1;
+        omp::UploadTicket m_AcquiredTicket = 0;
+
+        mutable std::mutex m_Mutex;
+
+        // Methods //
+        // ======= //
+    public:
+        omp::UploadTicket uploadBuffer(
+                VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+                VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                VkAccessFlags dstAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+
+        // Regions are relative to data, image ends in shader read only layout with generated mips
+        omp::UploadTicket uploadImage(
+                VkImage image, VkFormat format, const void* data, VkDeviceSize size,
+                const std::vector<VkBufferImageCopy>& regions,
+                uint32_t mipLevels, uint32_t layerCount, int32_t width, int32_t height);
+
+        // Submits open batch, does not wait
+        void flush();
+
+        // Records acquire of every finished batch, must precede commands that use uploaded data
+        void acquireFinished(VkCommandBuffer graphicsCommandBuffer);
+
+        // Blocks until ticket is finished and acquired with a single time graphics command
+        void wait(omp::UploadTicket ticket);
+
+        bool isReady(omp::UploadTicket ticket) const;
+
+    private:
+        Batch& getOpenBatch();
+        void submitOpenBatch();
+        // Moves finished batches out of flight, frees their staging space
+        void collectFinished(bool waitOldest);
+        void* allocateStaging(VkDeviceSize size, VkBuffer& outBuffer, VkDeviceSize& outOffset);
+        std::optional<VkDeviceSize> tryAllocateRing(VkDeviceSize size);
+        void recordAcquires(VkCommandBuffer commandBuffer);
+    };
+}
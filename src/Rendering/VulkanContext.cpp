@@ -1,20 +1,23 @@
 #include "VulkanContext.h"
+#include <fstream>
 #include <stdexcept>
 #include <vector>
+#include "Logs.h"
 
 omp::VulkanContext::VulkanContext(
-        VkDevice device, VkPhysicalDevice physDevice, VkCommandPool pool, VkQueue graphicsQueue)
+        VkDevice device, VkPhysicalDevice physDevice, VkCommandPool pool, VkQueue graphicsQueue, bool memoryBudget)
         : logical_device(device)
         , phys_device(physDevice)
         , command_pools(pool)
         , graphics_queue(graphicsQueue)
+        , m_MemoryAllocator(std::make_unique<omp::GpuMemoryAllocator>(device, physDevice, memoryBudget))
 {
 
 }
 
 void omp::VulkanContext::createBuffer(
         VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory)
+        omp::GpuAllocation& bufferMemory, omp::EMemoryCategory category)
 {
     VkBufferCreateInfo buffer_info{};
     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -30,40 +33,33 @@ void omp::VulkanContext::createBuffer(
     VkMemoryRequirements memory_requirements;
     vkGetBufferMemoryRequirements(logical_device, buffer, &memory_requirements);
 
-    VkMemoryAllocateInfo allocate_info{};
-    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocate_info.allocationSize = memory_requirements.size;
-    allocate_info.memoryTypeIndex = findMemoryType(memory_requirements.memoryTypeBits, properties);
+    bufferMemory = m_MemoryAllocator->allocate(memory_requirements, properties, omp::EAllocationKind::Linear, category);
 
-    if (vkAllocateMemory(logical_device, &allocate_info, nullptr, &bufferMemory) != VK_SUCCESS)
+    vkBindBufferMemory(logical_device, buffer, bufferMemory.memory, bufferMemory.offset);
+}
+
+void omp::VulkanContext::destroyBuffer(VkBuffer buffer, omp::GpuAllocation& bufferMemory)
+{
+    vkDestroyBuffer(logical_device, buffer, nullptr);
+    if (m_MemoryAllocator)
     {
-        throw std::runtime_error("failed to allocate vertex buffer memory");
+        m_MemoryAllocator->free(bufferMemory);
     }
-
-    vkBindBufferMemory(logical_device, buffer, bufferMemory, 0);
+    bufferMemory = {};
 }
 
 uint32_t omp::VulkanContext::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
-    VkPhysicalDeviceMemoryProperties memory_properties;
-    vkGetPhysicalDeviceMemoryProperties(phys_device, &memory_properties);
-    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
-    {
-        if ((typeFilter & (1 << i))
-            && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
-        {
-            return i;
-        }
-    }
-    throw std::runtime_error("failed to find suitable memory type");
+    return m_MemoryAllocator->findMemoryType(typeFilter, properties);
 }
 
 void omp::VulkanContext::createImage(
         uint32_t width, uint32_t height, uint32_t mipLevels,
         VkFormat format, VkImageTiling tiling,
         VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-        VkImage& image, VkDeviceMemory& imageMemory,
+        VkImage& image, omp::GpuAllocation& imageMemory,
         VkSampleCountFlagBits numSamples,
+        omp::EMemoryCategory category,
         VkImageCreateFlags flags,
         uint32_t arrayLayers)
 {
@@ -91,17 +87,57 @@ void omp::VulkanContext::createImage(
     VkMemoryRequirements mem_req;
     vkGetImageMemoryRequirements(logical_device, image, &mem_req);
 
-    VkMemoryAllocateInfo allocate_info{};
-    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocate_info.allocationSize = mem_req.size;
-    allocate_info.memoryTypeIndex = findMemoryType(mem_req.memoryTypeBits, properties);
+    imageMemory = m_MemoryAllocator->allocate(
+            mem_req, properties,
+            tiling == VK_IMAGE_TILING_OPTIMAL ? omp::EAllocationKind::Optimal : omp::EAllocationKind::Linear,
+            category);
+
+    vkBindImageMemory(logical_device, image, imageMemory.memory, imageMemory.offset);
+}
+
+void omp::VulkanContext::destroyImage(VkImage image, omp::GpuAllocation& imageMemory)
+{
+    vkDestroyImage(logical_device, image, nullptr);
+    if (m_MemoryAllocator)
+    {
+        m_MemoryAllocator->free(imageMemory);
+    }
+    imageMemory = {};
+}
+
+omp::GpuMemoryStats omp::VulkanContext::getMemoryStats() const
+{
+    return m_MemoryAllocator ? m_MemoryAllocator->getStats() : omp::GpuMemoryStats{};
+}
 
-    if (vkAllocateMemory(logical_device, &allocate_info, nullptr, &imageMemory) != VK_SUCCESS)
+void omp::VulkanContext::updateMemoryBudget()
+{
+    if (!m_MemoryAllocator)
     {
-        throw std::runtime_error("Failed to allocate image memory!");
+        return;
     }
+    const std::vector<uint32_t> rising = m_BudgetMonitor.update(m_MemoryAllocator->getHeapBudgets());
+    for (uint32_t heap: rising)
+    {
+        const omp::GpuHeapBudget& budget = m_BudgetMonitor.getHeaps()[heap];
+        WARN(LogRendering, "Memory heap {} is {} budget: {} of {} MiB used, {} MiB reserved by renderer", heap,
+             m_BudgetMonitor.getPressure(heap) == omp::EBudgetPressure::Over ? "over" : "near",
+             budget.usage >> 20, budget.budget >> 20, budget.reserved >> 20);
+    }
+    // Blocks kept empty for reuse are the only memory that can go back without evicting anything
+    if (!rising.empty())
+    {
+        const size_t released = m_MemoryAllocator->releaseEmptyBlocks();
+        if (released > 0)
+        {
+            INFO(LogRendering, "Released {} empty memory blocks under budget pressure", released);
+        }
+    }
+}
 
-    vkBindImageMemory(logical_device, image, imageMemory, 0);
+void omp::VulkanContext::destroyMemoryAllocator()
+{
+    m_MemoryAllocator.reset();
 }
 
 void omp::VulkanContext::transitionImageLayout(
@@ -167,6 +203,14 @@ void omp::VulkanContext::transitionImageLayout(
         source_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
         destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
     }
+    else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_GENERAL)
+    {
+        // Storage images written and sampled by compute
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        destination_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
     else
     {
         throw std::invalid_argument("Unsupported layout transition!");
@@ -180,38 +224,16 @@ void omp::VulkanContext::transitionImageLayout(
     endSingleTimeCommands(command_buffer);
 }
 
-void omp::VulkanContext::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
-{
-    VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {width, height, 1};
-
-    vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    endSingleTimeCommands(command_buffer);
-}
-
-void omp::VulkanContext::copyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions)
+void omp::VulkanContext::generateMipmaps(
+        VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 {
     VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
-    vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data());
-
+    recordGenerateMipmaps(command_buffer, image, imageFormat, texWidth, texHeight, mipLevels);
     endSingleTimeCommands(command_buffer);
 }
 
-void omp::VulkanContext::generateMipmaps(
+void omp::VulkanContext::recordGenerateMipmaps(
+        VkCommandBuffer commandBuffer,
         VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 {
     VkFormatProperties format_properties;
@@ -221,8 +243,6 @@ void omp::VulkanContext::generateMipmaps(
         throw std::runtime_error("Texture image format does not support linear blitting");
     }
 
-    VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -244,7 +264,7 @@ void omp::VulkanContext::generateMipmaps(
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
-        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
                              0,
                              0, nullptr,
                              0, nullptr,
@@ -266,7 +286,7 @@ void omp::VulkanContext::generateMipmaps(
         blit.dstSubresource.baseArrayLayer = 0;
         blit.dstSubresource.layerCount = 1;
 
-        vkCmdBlitImage(command_buffer,
+        vkCmdBlitImage(commandBuffer,
                        image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                        image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                        1, &blit, VK_FILTER_LINEAR
@@ -277,7 +297,7 @@ void omp::VulkanContext::generateMipmaps(
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-        vkCmdPipelineBarrier(command_buffer,
+        vkCmdPipelineBarrier(commandBuffer,
                              VK_PIPELINE_STAGE_TRANSFER_BIT,
                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
                              0, nullptr,
@@ -297,15 +317,13 @@ void omp::VulkanContext::generateMipmaps(
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-    vkCmdPipelineBarrier(command_buffer,
+    vkCmdPipelineBarrier(commandBuffer,
                          VK_PIPELINE_STAGE_TRANSFER_BIT,
                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
                          0, nullptr,
                          0, nullptr,
                          1, &barrier
     );
-
-    endSingleTimeCommands(command_buffer);
 }
 
 VkCommandBuffer omp::VulkanContext::beginSingleTimeCommands()
@@ -393,13 +411,35 @@ void omp::VulkanContext::destroyShaderModule(VkShaderModule inModule)
     vkDestroyShaderModule(logical_device, inModule, nullptr);
 }
 
-void omp::VulkanContext::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+VkPipeline omp::VulkanContext::createComputePipeline(const std::string& path, VkPipelineLayout layout)
 {
-    VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
-    VkBufferCopy copy_region{};
-    copy_region.size = size;
-    vkCmdCopyBuffer(command_buffer, srcBuffer, dstBuffer, 1, &copy_region);
-
-    endSingleTimeCommands(command_buffer);
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        ERROR(LogRendering, "Failed to open file: {}", path);
+        throw std::runtime_error("Failed to open file");
+    }
+    std::vector<char> code(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(code.data(), static_cast<std::streamsize>(code.size()));
+
+    VkShaderModule module = createShaderModule(code);
+
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = layout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    const VkResult result = vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
+                                                     &pipeline);
+    destroyShaderModule(module);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create compute pipeline");
+    }
+    return pipeline;
 }
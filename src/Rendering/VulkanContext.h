@@ -1,7 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <string>
 #include "vulkan/vulkan.h"
+#include "GpuMemoryAllocator.h"
+#include "UploadManager.h"
+#include "BindlessTextures.h"
 
 namespace omp
 {
@@ -16,31 +21,51 @@ namespace omp
         VkCommandPool command_pools;
         VkQueue graphics_queue;
         // TODO replace occurences in Renderer.cpp
-        VulkanContext(VkDevice device, VkPhysicalDevice physDevice, VkCommandPool pool, VkQueue graphicsQueue);
+        // Memory budget tells whether VK_EXT_memory_budget is enabled on the device
+        VulkanContext(VkDevice device, VkPhysicalDevice physDevice, VkCommandPool pool, VkQueue graphicsQueue,
+                      bool memoryBudget);
 
         void createBuffer(
                 VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer,
-                VkDeviceMemory& bufferMemory);
+                omp::GpuAllocation& bufferMemory, omp::EMemoryCategory category);
+        void destroyBuffer(VkBuffer buffer, omp::GpuAllocation& bufferMemory);
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         void createImage(
                 uint32_t width, uint32_t height, uint32_t mipLevels,
                 VkFormat format, VkImageTiling tiling,
                 VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-                VkImage& image, VkDeviceMemory& imageMemory,
+                VkImage& image, omp::GpuAllocation& imageMemory,
                 VkSampleCountFlagBits numSamples,
+                omp::EMemoryCategory category,
                 VkImageCreateFlags flags = 0,
                 uint32_t arrayLayers = 1
         );
+        void destroyImage(VkImage image, omp::GpuAllocation& imageMemory);
+
+        omp::GpuMemoryStats getMemoryStats() const;
+        // Queries heap budgets once per frame, warns when a heap gets near or over its budget
+        void updateMemoryBudget();
+        const std::vector<omp::GpuHeapBudget>& getHeapBudgets() const { return m_BudgetMonitor.getHeaps(); }
+        // For eviction policies, of the latest update
+        const omp::MemoryBudgetMonitor& getBudgetMonitor() const { return m_BudgetMonitor; }
+        // Must be called before device is destroyed, later frees only release handles
+        void destroyMemoryAllocator();
         void transitionImageLayout(
                 VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
-        void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-        void copyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions);
         void generateMipmaps(
                 VkImage image,
                 VkFormat imageFormat,
                 int32_t texWidth,
                 int32_t texHeight,
                 uint32_t mipLevels);
+        // All levels are expected in transfer dst layout, ends in shader read only
+        void recordGenerateMipmaps(
+                VkCommandBuffer commandBuffer,
+                VkImage image,
+                VkFormat imageFormat,
+                int32_t texWidth,
+                int32_t texHeight,
+                uint32_t mipLevels);
 
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
@@ -49,11 +74,27 @@ namespace omp
 
         VkShaderModule createShaderModule(const std::vector<char>& code);
         void destroyShaderModule(VkShaderModule inModule);
+        // Loads spir-v from path, module is destroyed right after pipeline creation
+        VkPipeline createComputePipeline(const std::string& path, VkPipelineLayout layout);
 
         void setCommandPool(VkCommandPool pool) { command_pools = pool; }
 
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void setUploadManager(std::unique_ptr<omp::UploadManager> inUploadManager) { m_UploadManager = std::move(inUploadManager); }
+        omp::UploadManager* getUploadManager() const { return m_UploadManager.get(); }
+        // Waits for pending uploads, must be called before memory allocator is destroyed
+        void destroyUploadManager() { m_UploadManager.reset(); }
+
+        // Textures give their slots back on destruction, so the array is reachable from the context
+        void setBindlessTextures(std::unique_ptr<omp::BindlessTextures> inBindlessTextures) { m_BindlessTextures = std::move(inBindlessTextures); }
+        omp::BindlessTextures* getBindlessTextures() const { return m_BindlessTextures.get(); }
+        void destroyBindlessTextures() { m_BindlessTextures.reset(); }
 
         friend class MaterialManager;
+
+    private:
+        std::unique_ptr<omp::GpuMemoryAllocator> m_MemoryAllocator;
+        std::unique_ptr<omp::UploadManager> m_UploadManager;
+        std::unique_ptr<omp::BindlessTextures> m_BindlessTextures;
+        omp::MemoryBudgetMonitor m_BudgetMonitor;
     };
 } // omp
@@ -54,7 +54,7 @@ namespace omp
 
         void confirmRendering()
         {
-            m_StateDirty = true;
+            m_StateDirty = false;
         };
     };
 } // omp
@@ -16,7 +16,12 @@ void omp::MaterialPanel::renderUi(float /*deltaTime*/)
             if (ImGui::TreeNode(texture.name.c_str()))
             {
                 ImGui::BulletText("%s", "TODO TEXTURE PATH, or something");
-                if (ImGui::ImageButton((ImTextureID)texture.texture->getTextureId(), {100, 100}))
+                // Image is in transfer until then, imgui would sample it in this frame
+                if (!texture.texture->isReadyForSampling())
+                {
+                    ImGui::Button("Loading", {100, 100});
+                }
+                else if (ImGui::ImageButton((ImTextureID)texture.texture->getTextureId(), {100, 100}))
                 {
                     INFO(LogRendering, "Pressed");
                 }
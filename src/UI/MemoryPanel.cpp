@@ -0,0 +1,71 @@
+#include "MemoryPanel.h"
+#include "imgui.h"
+
+namespace
+{
+    float toMiB(VkDeviceSize bytes)
+    {
+        return static_cast<float>(static_cast<double>(bytes) / (1024.0 * 1024.0));
+    }
+}
+
+omp::MemoryPanel::MemoryPanel(const omp::GpuMemoryStats* inStats, const omp::MemoryBudgetMonitor* inBudget)
+        : ImguiUnit()
+        , m_Stats(inStats)
+        , m_Budget(inBudget)
+{
+
+}
+
+void omp::MemoryPanel::renderUi(float /*deltaTime*/)
+{
+    ImGui::Begin("Memory");
+
+    if (ImGui::BeginTable("Categories", 3, ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("MiB");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableHeadersRow();
+        for (size_t category = 0; category < omp::g_MemoryCategoryCount; category++)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(omp::getMemoryCategoryName(static_cast<omp::EMemoryCategory>(category)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", toMiB(m_Stats->category_bytes[category]));
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", m_Stats->category_count[category]);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Used %.1f of %.1f MiB reserved", toMiB(m_Stats->used_bytes), toMiB(m_Stats->reserved_bytes));
+
+    ImGui::Separator();
+    const std::vector<omp::GpuHeapBudget>& heaps = m_Budget->getHeaps();
+    for (uint32_t heap = 0; heap < heaps.size(); heap++)
+    {
+        const omp::GpuHeapBudget& budget = heaps[heap];
+        const omp::EBudgetPressure pressure = m_Budget->getPressure(heap);
+        ImGui::Text("Heap %u%s: %.0f / %.0f MiB budget, %.0f MiB reserved by renderer", heap,
+                    budget.device_local ? " (device local)" : "", toMiB(budget.usage), toMiB(budget.budget),
+                    toMiB(budget.reserved));
+
+        const float fraction = budget.budget > 0 ? toMiB(budget.usage) / toMiB(budget.budget) : 0.f;
+        const ImVec4 color = pressure == omp::EBudgetPressure::Over ? ImVec4(0.8f, 0.2f, 0.2f, 1.f)
+                             : pressure == omp::EBudgetPressure::Near ? ImVec4(0.85f, 0.6f, 0.2f, 1.f)
+                             : ImGui::GetStyleColorVec4(ImGuiCol_PlotHistogram);
+        ImGui::PushID(static_cast<int>(heap));
+        ImGui::PushStyleColor(ImGuiCol_PlotHistogram, color);
+        ImGui::ProgressBar(fraction, ImVec2(-1.f, 0.f));
+        ImGui::PopStyleColor();
+        ImGui::PopID();
+        if (pressure != omp::EBudgetPressure::Normal)
+        {
+            ImGui::Text("Free %.1f MiB to get below %.0f%% of budget", toMiB(m_Budget->getEvictionBytes(heap)),
+                        omp::MemoryBudgetMonitor::s_NearRatio * 100.0);
+        }
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ImguiUnit.h"
+#include "Rendering/GpuMemoryAllocator.h"
+
+namespace omp
+{
+    /**
+     * Gpu memory of the renderer per category and usage of every heap against its budget.
+     * Heaps near or over budget are highlighted.
+     */
+    class MemoryPanel : public ImguiUnit
+    {
+    private:
+        const omp::GpuMemoryStats* m_Stats = nullptr;
+        const omp::MemoryBudgetMonitor* m_Budget = nullptr;
+
+    public:
+        MemoryPanel(const omp::GpuMemoryStats* inStats, const omp::MemoryBudgetMonitor* inBudget);
+        virtual void renderUi(float deltaTime) override;
+    };
+}
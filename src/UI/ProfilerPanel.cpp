@@ -0,0 +1,239 @@
+#include "ProfilerPanel.h"
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "imgui.h"
+
+namespace
+{
+    constexpr float g_RowHeight = 18.f;
+
+    ImU32 getEventColor(const char* name)
+    {
+        const size_t hash = std::hash<std::string_view>{}(name);
+        const float hue = static_cast<float>(hash % 360) / 360.f;
+        return ImColor::HSV(hue, 0.45f, 0.75f);
+    }
+
+    float toMs(int64_t nanoseconds)
+    {
+        return static_cast<float>(static_cast<double>(nanoseconds) / 1e6);
+    }
+
+    // Rect of one event, name is drawn when it fits, tooltip on hover
+    void drawEvent(ImDrawList* drawList, const char* name, ImVec2 min, ImVec2 max, float ms)
+    {
+        max.x = std::max(max.x, min.x + 1.f);
+        drawList->AddRectFilled(min, max, getEventColor(name));
+        drawList->PushClipRect(min, max, true);
+        drawList->AddText(ImVec2(min.x + 2.f, min.y + 1.f), IM_COL32(20, 20, 20, 255), name);
+        drawList->PopClipRect();
+        if (ImGui::IsMouseHoveringRect(min, max))
+        {
+            ImGui::SetTooltip("%s: %.3f ms", name, ms);
+        }
+    }
+}
+
+omp::ProfilerPanel::ProfilerPanel(omp::Profiler* inProfiler)
+        : ImguiUnit()
+        , m_Profiler(inProfiler)
+{
+
+}
+
+void omp::ProfilerPanel::renderUi(float /*deltaTime*/)
+{
+    ImGui::Begin("Profiler");
+
+    bool enabled = m_Profiler->isEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+    {
+        m_Profiler->setEnabled(enabled);
+        m_Paused = false;
+    }
+    ImGui::SameLine();
+    bool paused = m_Paused;
+    if (ImGui::Checkbox("Pause", &paused))
+    {
+        const omp::FrameProfile* shown = paused ? getShownFrame() : nullptr;
+        if (shown)
+        {
+            m_PausedFrame = *shown;
+        }
+        m_Paused = shown != nullptr;
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.f);
+    ImGui::SliderFloat("Zoom", &m_Zoom, 1.f, 50.f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace"))
+    {
+        const std::string path = "trace_" + std::to_string(m_Profiler->getFrameIndex()) + ".json";
+        m_ExportStatus = m_Profiler->writeHistory(path) ? "Written " + path : "Failed to write " + path;
+    }
+    if (!m_ExportStatus.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(m_ExportStatus.c_str());
+    }
+
+    if (!enabled && !m_Paused)
+    {
+        ImGui::TextUnformatted("Scopes are recorded only while enabled");
+        ImGui::End();
+        return;
+    }
+
+    renderFrameTimes();
+    if (const omp::FrameProfile* frame = getShownFrame())
+    {
+        renderTimeline(*frame);
+    }
+
+    ImGui::End();
+}
+
+const omp::FrameProfile* omp::ProfilerPanel::getShownFrame() const
+{
+    if (m_Paused)
+    {
+        return &m_PausedFrame;
+    }
+    if (m_Profiler->getHistoryCount() == 0)
+    {
+        return nullptr;
+    }
+    // Gpu results come frames in flight later, newest frame which already has them is shown
+    const size_t last_age = std::min<size_t>(m_Profiler->getHistoryCount(), 4);
+    for (size_t age = 0; age < last_age; age++)
+    {
+        if (!m_Profiler->getFrame(age).gpu_events.empty())
+        {
+            return &m_Profiler->getFrame(age);
+        }
+    }
+    return &m_Profiler->getFrame(0);
+}
+
+void omp::ProfilerPanel::renderFrameTimes()
+{
+    const size_t count = m_Profiler->getHistoryCount();
+    std::vector<float> frame_ms(count);
+    float max_ms = 0.f;
+    for (size_t age = 0; age < count; age++)
+    {
+        const omp::FrameProfile& frame = m_Profiler->getFrame(age);
+        frame_ms[count - 1 - age] = toMs(frame.end_ns - frame.start_ns);
+        max_ms = std::max(max_ms, frame_ms[count - 1 - age]);
+    }
+
+    ImGui::PlotHistogram("##FrameTimes", frame_ms.data(), static_cast<int>(count), 0, "Frame ms", 0.f,
+                         max_ms * 1.1f, ImVec2(-1.f, 60.f));
+    if (ImGui::IsItemClicked() && count > 0)
+    {
+        const float left = ImGui::GetItemRectMin().x;
+        const float width = std::max(ImGui::GetItemRectSize().x, 1.f);
+        const float ratio = std::clamp((ImGui::GetMousePos().x - left) / width, 0.f, 1.f);
+        const auto index = std::min(static_cast<size_t>(ratio * static_cast<float>(count)), count - 1);
+        m_PausedFrame = m_Profiler->getFrame(count - 1 - index);
+        m_Paused = true;
+    }
+}
+
+void omp::ProfilerPanel::renderTimeline(const omp::FrameProfile& frame)
+{
+    const int64_t frame_ns = std::max<int64_t>(frame.end_ns - frame.start_ns, 1);
+    ImGui::Text("Frame %llu: %.3f ms, %zu cpu scopes", static_cast<unsigned long long>(frame.index),
+                toMs(frame_ns), frame.cpu_events.size());
+
+    ImGui::BeginChild("Timeline", ImVec2(0.f, 0.f), true, ImGuiWindowFlags_HorizontalScrollbar);
+    const float width = std::max(ImGui::GetContentRegionAvail().x * m_Zoom, 1.f);
+    const float ns_to_px = width / static_cast<float>(frame_ns);
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const ImU32 label_color = ImGui::GetColorU32(ImGuiCol_Text);
+    float y = origin.y;
+
+    std::vector<uint32_t> threads;
+    for (const omp::CpuProfileEvent& event: frame.cpu_events)
+    {
+        if (std::find(threads.begin(), threads.end(), event.thread) == threads.end())
+        {
+            threads.push_back(event.thread);
+        }
+    }
+    std::sort(threads.begin(), threads.end());
+
+    for (uint32_t thread: threads)
+    {
+        draw_list->AddText(ImVec2(origin.x, y), label_color, m_Profiler->getThreadName(thread).c_str());
+        y += g_RowHeight;
+        uint32_t rows = 0;
+        for (const omp::CpuProfileEvent& event: frame.cpu_events)
+        {
+            if (event.thread != thread)
+            {
+                continue;
+            }
+            rows = std::max(rows, event.depth + 1);
+            // Scopes still running at previous frame boundary start at the left edge
+            const int64_t start = std::max(event.start_ns, frame.start_ns) - frame.start_ns;
+            const int64_t end = event.end_ns - frame.start_ns;
+            const float row_y = y + static_cast<float>(event.depth) * g_RowHeight;
+            drawEvent(draw_list, event.name,
+                      ImVec2(origin.x + static_cast<float>(start) * ns_to_px, row_y),
+                      ImVec2(origin.x + static_cast<float>(end) * ns_to_px, row_y + g_RowHeight - 1.f),
+                      toMs(event.end_ns - event.start_ns));
+        }
+        y += static_cast<float>(rows) * g_RowHeight + 4.f;
+    }
+
+    if (!frame.gpu_events.empty())
+    {
+        // Calibrated gpu clock is mapped onto cpu one, otherwise lane starts at the first timestamp of the frame
+        draw_list->AddText(ImVec2(origin.x, y), label_color, "GPU");
+        y += g_RowHeight;
+        int64_t gpu_to_frame = 0;
+        if (frame.gpu_to_cpu_ns)
+        {
+            gpu_to_frame = *frame.gpu_to_cpu_ns - frame.start_ns;
+        }
+        else
+        {
+            uint64_t gpu_start = frame.gpu_events[0].start_ns;
+            for (const omp::GpuProfileEvent& event: frame.gpu_events)
+            {
+                gpu_start = std::min(gpu_start, event.start_ns);
+            }
+            gpu_to_frame = -static_cast<int64_t>(gpu_start);
+        }
+
+        // Scopes are written in begin order, nesting follows from ends
+        std::vector<uint64_t> open_ends;
+        uint32_t rows = 0;
+        for (const omp::GpuProfileEvent& event: frame.gpu_events)
+        {
+            while (!open_ends.empty() && open_ends.back() <= event.start_ns)
+            {
+                open_ends.pop_back();
+            }
+            const auto depth = static_cast<uint32_t>(open_ends.size());
+            open_ends.push_back(event.end_ns);
+            rows = std::max(rows, depth + 1);
+
+            const float row_y = y + static_cast<float>(depth) * g_RowHeight;
+            const auto start = static_cast<float>(static_cast<int64_t>(event.start_ns) + gpu_to_frame);
+            const auto end = static_cast<float>(static_cast<int64_t>(event.end_ns) + gpu_to_frame);
+            drawEvent(draw_list, event.name, ImVec2(origin.x + start * ns_to_px, row_y),
+                      ImVec2(origin.x + end * ns_to_px, row_y + g_RowHeight - 1.f),
+                      static_cast<float>(static_cast<double>(event.end_ns - event.start_ns) / 1e6));
+        }
+        y += static_cast<float>(rows) * g_RowHeight;
+    }
+
+    // Scroll range of the child
+    ImGui::Dummy(ImVec2(width, y - origin.y));
+    ImGui::EndChild();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ImguiUnit.h"
+#include <string>
+#include "Core/Profiler.h"
+
+namespace omp
+{
+    /**
+     * Frame time history and timeline of one frame, a lane per thread and one for gpu.
+     * Clicking a bar of the history pauses on that frame, whole history can be exported as chrome trace.
+     */
+    class ProfilerPanel : public ImguiUnit
+    {
+    private:
+        omp::Profiler* m_Profiler = nullptr;
+
+        bool m_Paused = false;
+        // Copy, so it outlives the history
+        omp::FrameProfile m_PausedFrame;
+        float m_Zoom = 1.f;
+        std::string m_ExportStatus;
+
+    public:
+        explicit ProfilerPanel(omp::Profiler* inProfiler);
+        virtual void renderUi(float deltaTime) override;
+
+    private:
+        const omp::FrameProfile* getShownFrame() const;
+        void renderFrameTimes();
+        void renderTimeline(const omp::FrameProfile& frame);
+    };
+}
@@ -14,6 +14,32 @@ void omp::ScenePanel::renderUi(float /*deltaTime*/)
 
     ImGui::Begin("Scene Panel");
 
+    if (m_DrawStats)
+    {
+        ImGui::Text("Entities: %u, draw calls: %u", m_DrawStats->entities, m_DrawStats->draw_calls);
+        const float occluded_percent = m_DrawStats->entities > 0
+                ? 100.f * m_DrawStats->occlusion_culled / m_DrawStats->entities : 0.f;
+        ImGui::Text("Frustum culled: %u, occluded: %u (%.1f%%)",
+                    m_DrawStats->frustum_culled, m_DrawStats->occlusion_culled, occluded_percent);
+        ImGui::Text("Occluded triangles: %u, main pass: %.3f ms",
+                    m_DrawStats->occluded_triangles, m_DrawStats->main_pass_ms);
+        if (m_DrawStats->fragment_invocations > 0)
+        {
+            ImGui::Text("Fragments: %llu, overdraw: %.2fx",
+                        static_cast<unsigned long long>(m_DrawStats->fragment_invocations), m_DrawStats->overdraw);
+        }
+    }
+    if (m_MemoryStats)
+    {
+        constexpr float mebibyte = 1024.f * 1024.f;
+        ImGui::Text("GPU memory: %.1f / %.1f MiB in %u blocks, %u dedicated",
+                    m_MemoryStats->used_bytes / mebibyte, m_MemoryStats->reserved_bytes / mebibyte,
+                    m_MemoryStats->block_count, m_MemoryStats->dedicated_count);
+        ImGui::Text("Allocations: %u, free ranges: %u, largest free: %.1f MiB",
+                    m_MemoryStats->allocation_count, m_MemoryStats->free_range_count,
+                    m_MemoryStats->largest_free_range / mebibyte);
+    }
+
     if (m_Scene)
     {
         if (ImGui::TreeNode("Scene items"))
@@ -5,6 +5,8 @@
 #include "Scene.h"
 #include "EntityPanel.h"
 #include "MaterialPanel.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/GpuMemoryAllocator.h"
 
 namespace omp
 {
@@ -14,6 +16,8 @@ namespace omp
         bool m_ClickedFromViewport = false;
 
         Scene* m_Scene = nullptr;
+        const omp::DrawStats* m_DrawStats = nullptr;
+        const omp::GpuMemoryStats* m_MemoryStats = nullptr;
         std::shared_ptr<EntityPanel> m_EntityUi;
         std::shared_ptr<MaterialPanel> m_MaterialPanel;
 
@@ -22,6 +26,8 @@ namespace omp
         virtual void renderUi(float deltaTime) override;
 
         void setScene(Scene* inScene) { m_Scene = inScene; }
+        void setDrawStats(const omp::DrawStats* inStats) { m_DrawStats = inStats; }
+        void setMemoryStats(const omp::GpuMemoryStats* inStats) { m_MemoryStats = inStats; }
     };
 }
 
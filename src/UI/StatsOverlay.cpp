@@ -0,0 +1,34 @@
+#include "StatsOverlay.h"
+#include "imgui.h"
+
+omp::StatsOverlay::StatsOverlay(const omp::RenderStats* inStats)
+        : ImguiUnit()
+        , m_Stats(inStats)
+{
+
+}
+
+void omp::StatsOverlay::renderUi(float /*deltaTime*/)
+{
+    constexpr float padding = 10.f;
+    const ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - padding, viewport->WorkPos.y + padding),
+                            ImGuiCond_Always, ImVec2(1.f, 0.f));
+    ImGui::SetNextWindowViewport(viewport->ID);
+    ImGui::SetNextWindowBgAlpha(0.35f);
+    const ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                   ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+                                   ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoDocking;
+    if (ImGui::Begin("Render stats", nullptr, flags))
+    {
+        ImGui::Text("Draws: %u (%u indirect)", m_Stats->draw_calls, m_Stats->indirect_draw_calls);
+        ImGui::Text("Triangles: %llu, indices: %llu", static_cast<unsigned long long>(m_Stats->triangles),
+                    static_cast<unsigned long long>(m_Stats->indices));
+        ImGui::Text("Pipelines: %u, descriptor sets: %u", m_Stats->pipeline_binds, m_Stats->descriptor_set_binds);
+        ImGui::Text("Vertex buffers: %u, index buffers: %u", m_Stats->vertex_buffer_binds,
+                    m_Stats->index_buffer_binds);
+        ImGui::Text("Push constants: %llu B", static_cast<unsigned long long>(m_Stats->push_constant_bytes));
+        ImGui::Text("Entities: %u visible, %u culled", m_Stats->visible_entities, m_Stats->culled_entities);
+    }
+    ImGui::End();
+}
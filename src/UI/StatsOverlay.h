@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ImguiUnit.h"
+#include "Rendering/RenderStats.h"
+
+namespace omp
+{
+    /**
+     * Command counts of the latest frame in a corner of the window, above everything else.
+     * Click through, it never takes input.
+     */
+    class StatsOverlay : public ImguiUnit
+    {
+    private:
+        const omp::RenderStats* m_Stats = nullptr;
+
+    public:
+        explicit StatsOverlay(const omp::RenderStats* inStats);
+        virtual void renderUi(float deltaTime) override;
+    };
+}
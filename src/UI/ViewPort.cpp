@@ -43,7 +43,7 @@ void omp::ViewPort::renderUi(float /*deltaTime*/)
 
     ImGui::Image(m_ImageId, m_Size);
 
-    if (m_Info.id != -1)
+    if (m_Info.id != -1 && m_Camera)
     {
         //ImGuizmo::Enable(true);
 
@@ -58,7 +58,7 @@ void omp::ViewPort::renderUi(float /*deltaTime*/)
         float matrixTranslation[3], matrixRotation[3], matrixScale[3];
         ImGuizmo::DecomposeMatrixToComponents(value_ptr(m_Info.model), matrixTranslation, matrixRotation, matrixScale);
 
-        if (ImGuizmo::IsUsingAny())
+        if (ImGuizmo::IsUsingAny() && m_TranslationChange && m_RotationChange && m_ScaleChange)
         {
             m_TranslationChange(matrixTranslation);
             m_RotationChange(matrixRotation);
@@ -140,7 +140,10 @@ void omp::ViewPort::renderUi(float /*deltaTime*/)
         && !ImGuizmo::IsUsing() && !ImGuizmo::IsOver())
     {
         m_CursorPos = viewport_cursor;
-        m_MouseClick(m_CursorPos);
+        if (m_MouseClick)
+        {
+            m_MouseClick(m_CursorPos);
+        }
     }
 
     ImGui::End();
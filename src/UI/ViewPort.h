@@ -35,7 +35,7 @@ namespace omp
         std::function<void(float[3])> m_RotationChange;
         std::function<void(float[3])> m_ScaleChange;
 
-        std::shared_ptr<omp::Camera> m_Camera;
+        omp::Camera* m_Camera = nullptr;
 
     public:
         virtual void renderUi(float deltaTime) override;
@@ -44,8 +44,10 @@ namespace omp
         ImVec2 getLocalCursorPos() { return m_CursorPos; }
 
         bool isResized() const { return m_Resized; }
+        // Without ui nothing lays the viewport out, it keeps the size set here
+        void setSize(ImVec2 inSize) { m_Size = inSize; }
 
-        void setCamera(const std::shared_ptr<omp::Camera>& camera) { m_Camera = camera; };
+        void setCamera(omp::Camera* camera) { m_Camera = camera; };
         void sendPickingData(PickingInfo info);
         void setImageId(ImTextureID id) { m_ImageId = id; };
         void setMouseClickCallback(const std::function<void(ImVec2)> inFunc);
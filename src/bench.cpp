@@ -0,0 +1,30 @@
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include "Logs.h"
+#include "Core/Application.h"
+
+// Same application with benchmark defaults, arguments are appended and override them
+int main(int argc, char* argv[])
+{
+    omp::InitializeLogs();
+    std::string flags = "--headless --generate --camera-path --frame-limit=0 --frames=1200 --warmup=200 "
+                        "--bench=bench.json ";
+    for (int arg = 1; arg < argc; arg++)
+    {
+        flags += std::string(argv[arg]) + " ";
+    }
+
+    try
+    {
+        omp::Application application{ flags };
+        application.start();
+    }
+    catch (const std::exception& e)
+    {
+        ERROR(LogCore, e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
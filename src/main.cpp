@@ -7,14 +7,20 @@
 #include "Logs.h"
 #include "Core/Application.h"
 
-int main()
+int main(int argc, char* argv[])
 {
     omp::InitializeLogs();
     INFO(LogRendering, "=================Create Application=================");
-    omp::Application application{ "EMPTY FLAGS" };
+    std::string flags;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        flags += std::string(argv[arg]) + " ";
+    }
 
     try
     {
+        // Malformed flags throw too
+        omp::Application application{ flags };
         application.start();
     }
     catch (const std::exception& e)
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+#include <stdexcept>
+#include "Core/AppFlags.h"
+
+TEST(AppFlagsSuite, AppFlags_Defaults)
+{
+    const omp::AppFlags flags = omp::AppFlags::parse(omp::AppFlags::split("EMPTY FLAGS"));
+    EXPECT_EQ(flags.width, 1280u);
+    EXPECT_EQ(flags.height, 720u);
+    EXPECT_FALSE(flags.headless);
+    EXPECT_FALSE(flags.wait_before_input);
+    EXPECT_EQ(flags.present.policy, omp::PresentPolicy::LowLatency);
+    EXPECT_FALSE(flags.present.mode.has_value());
+    EXPECT_EQ(flags.present.image_count, 0u);
+    EXPECT_EQ(flags.frames_in_flight, 2u);
+    EXPECT_FALSE(flags.msaa_samples.has_value());
+    EXPECT_FALSE(flags.validation.has_value());
+    EXPECT_EQ(flags.frame_count, 0u);
+    EXPECT_TRUE(flags.stats_path.empty());
+    EXPECT_FALSE(flags.profiler);
+    EXPECT_TRUE(flags.trace_path.empty());
+    EXPECT_EQ(flags.trace_frames, 300u);
+    EXPECT_FALSE(flags.generate_scene);
+    EXPECT_FALSE(flags.camera_path);
+    EXPECT_TRUE(flags.bench_path.empty());
+    EXPECT_TRUE(flags.unknown.empty());
+}
+
+TEST(AppFlagsSuite, AppFlags_Benchmark)
+{
+    const omp::AppFlags flags = omp::AppFlags::parse(omp::AppFlags::split(
+            "--headless --width=640 --height=480 --threads=0 --frame-limit=60 --wait-before-input --present=immediate "
+            "--present-policy=uncapped --swapchain-images=2 --frames-in-flight=1 "
+            "--msaa=4 --validation=off --scene=../assets/bench.json --frames=500 --stats=out.csv --profiler --fancy "
+            "--trace=trace.json --trace-frames=120"));
+    EXPECT_TRUE(flags.headless);
+    EXPECT_EQ(flags.width, 640u);
+    EXPECT_EQ(flags.height, 480u);
+    EXPECT_EQ(flags.thread_count, 0);
+    EXPECT_EQ(flags.frame_limit, 60);
+    EXPECT_TRUE(flags.wait_before_input);
+    EXPECT_EQ(flags.present.policy, omp::PresentPolicy::Uncapped);
+    EXPECT_EQ(flags.present.mode, VK_PRESENT_MODE_IMMEDIATE_KHR);
+    EXPECT_EQ(flags.present.image_count, 2u);
+    EXPECT_EQ(flags.frames_in_flight, 1u);
+    EXPECT_EQ(flags.msaa_samples, VK_SAMPLE_COUNT_4_BIT);
+    EXPECT_EQ(flags.validation, false);
+    EXPECT_EQ(flags.scene_path, "../assets/bench.json");
+    EXPECT_EQ(flags.frame_count, 500u);
+    EXPECT_EQ(flags.stats_path, "out.csv");
+    EXPECT_TRUE(flags.profiler);
+    EXPECT_EQ(flags.trace_path, "trace.json");
+    EXPECT_EQ(flags.trace_frames, 120u);
+    ASSERT_EQ(flags.unknown.size(), 1u);
+    EXPECT_EQ(flags.unknown[0], "fancy");
+}
+
+TEST(AppFlagsSuite, AppFlags_GeneratedScene)
+{
+    const omp::AppFlags flags = omp::AppFlags::parse(omp::AppFlags::split(
+            "--generate --seed=42 --entities=10000 --models=3 --materials=5 --point-lights=512 --spot-lights=0 "
+            "--camera-path --bench=bench.json --warmup=50"));
+    EXPECT_TRUE(flags.generate_scene);
+    EXPECT_EQ(flags.generator.seed, 42u);
+    EXPECT_EQ(flags.generator.entities, 10000u);
+    EXPECT_EQ(flags.generator.models, 3u);
+    EXPECT_EQ(flags.generator.materials, 5u);
+    EXPECT_EQ(flags.generator.point_lights, 512u);
+    EXPECT_EQ(flags.generator.spot_lights, 0u);
+    EXPECT_TRUE(flags.camera_path);
+    EXPECT_EQ(flags.bench_path, "bench.json");
+    EXPECT_EQ(flags.warmup_frames, 50u);
+    EXPECT_TRUE(flags.unknown.empty());
+}
+
+TEST(AppFlagsSuite, AppFlags_Malformed)
+{
+    for (const char* commands: {"--width=-5", "--width=0", "--threads=four", "--msaa=3", "--msaa=128",
+                                "--present=vsync", "--present-policy=fast", "--swapchain-images=0",
+                                "--headless=maybe", "--scene", "--trace", "--trace-frames=0",
+                                "--frames=99999999999999999999", "--models=0", "--materials=5000",
+                                "--point-lights=513", "--seed=4294967296", "--bench",
+                                "--frames-in-flight=0", "--frames-in-flight=3"})
+    {
+        EXPECT_THROW(omp::AppFlags::parse(omp::AppFlags::split(commands)), std::invalid_argument) << commands;
+    }
+}
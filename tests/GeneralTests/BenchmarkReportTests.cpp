@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+#include "Core/BenchmarkReport.h"
+
+TEST(BenchmarkReportSuite, BenchmarkReport_Percentiles)
+{
+    std::vector<float> values;
+    for (int value = 100; value >= 1; value--)
+    {
+        values.push_back(static_cast<float>(value));
+    }
+    const omp::FrameTimeSummary summary = omp::BenchmarkReport::summarize(values);
+    EXPECT_FLOAT_EQ(summary.min_ms, 1.f);
+    EXPECT_FLOAT_EQ(summary.max_ms, 100.f);
+    EXPECT_FLOAT_EQ(summary.mean_ms, 50.5f);
+    EXPECT_FLOAT_EQ(summary.p50_ms, 50.f);
+    EXPECT_FLOAT_EQ(summary.p95_ms, 95.f);
+    EXPECT_FLOAT_EQ(summary.p99_ms, 99.f);
+
+    const omp::FrameTimeSummary single = omp::BenchmarkReport::summarize({7.f});
+    EXPECT_FLOAT_EQ(single.p50_ms, 7.f);
+    EXPECT_FLOAT_EQ(single.p99_ms, 7.f);
+    EXPECT_FLOAT_EQ(omp::BenchmarkReport::summarize({}).p99_ms, 0.f);
+}
+
+TEST(BenchmarkReportSuite, BenchmarkReport_Json)
+{
+    omp::BenchmarkReport report;
+    omp::RenderStats stats;
+    stats.draw_calls = 10;
+    stats.triangles = 1000;
+    report.addFrame(16.f, 8.f, stats);
+    stats.draw_calls = 20;
+    report.addFrame(20.f, 10.f, stats);
+    EXPECT_EQ(report.getFrameCount(), 2u);
+
+    const nlohmann::ordered_json json = report.toJson();
+    EXPECT_EQ(json["frames"], 2u);
+    EXPECT_FLOAT_EQ(json["frame_ms"]["p50"].get<float>(), 16.f);
+    EXPECT_FLOAT_EQ(json["frame_ms"]["max"].get<float>(), 20.f);
+    EXPECT_FLOAT_EQ(json["main_pass_ms"]["mean"].get<float>(), 9.f);
+    EXPECT_DOUBLE_EQ(json["render_stats"]["draw_calls"].get<double>(), 15.0);
+    EXPECT_DOUBLE_EQ(json["render_stats"]["triangles"].get<double>(), 1000.0);
+}
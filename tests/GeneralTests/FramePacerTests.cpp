@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "Core/FramePacer.h"
+
+namespace
+{
+    using Clock = omp::FramePacer::Clock;
+    using namespace std::chrono_literals;
+
+    // Time moves only when the pacer sleeps or spins, or when a test simulates work
+    struct FakeClock
+    {
+        Clock::time_point time = Clock::time_point(1h);
+        // Added to every sleep, like a scheduler tick
+        Clock::duration oversleep{0};
+        Clock::duration spin_step = 10us;
+        std::vector<Clock::time_point> sleeps;
+        size_t spins = 0;
+
+        omp::FramePacerClock makeClock()
+        {
+            return {[this] { return time; },
+                    [this](Clock::time_point until)
+                    {
+                        sleeps.push_back(until);
+                        time = std::max(time, until + oversleep);
+                    },
+                    [this]
+                    {
+                        time += spin_step;
+                        spins++;
+                    }};
+        }
+    };
+}
+
+TEST(FramePacerSuite, FramePacer_WaitUntil)
+{
+    FakeClock fake;
+    fake.oversleep = 500us;
+    omp::FramePacer pacer(fake.makeClock());
+
+    // Sleep wakes up before the deadline even when it overshoots, the rest is spun
+    const Clock::time_point deadline = fake.time + 5ms;
+    pacer.waitUntil(deadline);
+    ASSERT_EQ(fake.sleeps.size(), 1u);
+    EXPECT_EQ(fake.sleeps[0], deadline - omp::FramePacer::s_SpinThreshold);
+    EXPECT_GE(fake.time, deadline);
+    EXPECT_LT(fake.time, deadline + fake.spin_step);
+    EXPECT_EQ(fake.spins, 150u);
+
+    // Close deadline is only spun
+    pacer.waitUntil(fake.time + 1ms);
+    EXPECT_EQ(fake.sleeps.size(), 1u);
+    EXPECT_EQ(fake.spins, 250u);
+
+    // Passed deadline does not wait at all
+    pacer.waitUntil(fake.time - 1ms);
+    EXPECT_EQ(fake.sleeps.size(), 1u);
+    EXPECT_EQ(fake.spins, 250u);
+}
+
+TEST(FramePacerSuite, FramePacer_WaitUntilRealClock)
+{
+    // Loose, only catches a wait that returns early or hangs
+    omp::FramePacer pacer;
+    const Clock::time_point deadline = Clock::now() + 5ms;
+    pacer.waitUntil(deadline);
+    const auto overshoot = Clock::now() - deadline;
+    EXPECT_GE(overshoot.count(), 0);
+    EXPECT_LT(overshoot, 50ms);
+}
+
+TEST(FramePacerSuite, FramePacer_TargetRate)
+{
+    for (const bool wait_before_input: {false, true})
+    {
+        FakeClock fake;
+        omp::FramePacer pacer(fake.makeClock());
+        pacer.setTargetFps(200);
+        pacer.setWaitBeforeInput(wait_before_input);
+
+        std::vector<float> deltas;
+        for (size_t frame = 0; frame < 60; frame++)
+        {
+            deltas.push_back(pacer.beginFrame());
+            // Uneven work well below the 5 ms period should not show in frame times
+            const size_t sleeps = fake.sleeps.size();
+            fake.time += frame % 2 == 0 ? 500us : 1500us;
+            pacer.endFrame();
+            // Waiting before input leaves nothing to wait for after the work
+            EXPECT_EQ(fake.sleeps.size() == sleeps, wait_before_input) << frame;
+        }
+        deltas.push_back(pacer.beginFrame());
+
+        // Prediction of the work settles once both frame kinds were seen
+        for (size_t frame = 4; frame < deltas.size(); frame++)
+        {
+            EXPECT_NEAR(deltas[frame], 0.005f, 1e-5f) << wait_before_input << " " << frame;
+        }
+        const omp::FramePacingStats stats = pacer.getStats();
+        EXPECT_NEAR(stats.work_ms, 1.f, 1e-3f) << wait_before_input;
+        EXPECT_FLOAT_EQ(stats.max_frame_ms, *std::max_element(deltas.begin(), deltas.end()) * 1000.f);
+    }
+}
+
+TEST(FramePacerSuite, FramePacer_InputSampledLate)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    FakeClock fake;
+    const Clock::time_point start = fake.time;
+    omp::FramePacer pacer(fake.makeClock());
+    pacer.setTargetFps(100);
+    pacer.setWaitBeforeInput(true);
+
+    for (size_t frame = 0; frame < 20; frame++)
+    {
+        pacer.beginFrame();
+        fake.time += 2ms;
+        pacer.endFrame();
+    }
+    const Clock::time_point previous_end = fake.time;
+    pacer.beginFrame();
+
+    // Deadlines are whole periods from the start, frame begins the predicted 2.9 ms of work before its one
+    const Clock::duration to_deadline = 10ms - (fake.time - start) % 10ms;
+    EXPECT_NEAR(Milliseconds(to_deadline).count(), 2.9, 1e-3);
+    // Rest of the period is waited before the frame, not after the previous one
+    EXPECT_NEAR(Milliseconds(fake.time - previous_end).count(), 8.0, 1e-3);
+}
+
+TEST(FramePacerSuite, FramePacer_LateFrame)
+{
+    FakeClock fake;
+    omp::FramePacer pacer(fake.makeClock());
+    pacer.setTargetFps(200);
+
+    pacer.beginFrame();
+    fake.time += 1ms;
+    pacer.endFrame();
+    pacer.beginFrame();
+    fake.time += 12ms;
+    pacer.endFrame();
+    EXPECT_NEAR(pacer.beginFrame(), 0.012f, 1e-5f);
+
+    // Next frames get a whole period each instead of catching up with the missed deadlines
+    fake.time += 1ms;
+    pacer.endFrame();
+    EXPECT_NEAR(pacer.beginFrame(), 0.005f, 1e-5f);
+}
+
+TEST(FramePacerSuite, FramePacer_Unlimited)
+{
+    FakeClock fake;
+    omp::FramePacer pacer(fake.makeClock());
+    pacer.setTargetFps(0);
+    EXPECT_EQ(pacer.beginFrame(), 0.f);
+    fake.time += 2ms;
+    pacer.endFrame();
+    const float delta = pacer.beginFrame();
+    EXPECT_FLOAT_EQ(delta, 0.002f);
+    EXPECT_EQ(pacer.getStats().max_frame_ms, delta * 1000.f);
+    EXPECT_TRUE(fake.sleeps.empty());
+    EXPECT_EQ(fake.spins, 0u);
+}
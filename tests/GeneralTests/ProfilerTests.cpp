@@ -0,0 +1,176 @@
+#include "gtest/gtest.h"
+#include <fstream>
+#include <thread>
+#include "nlohmann/json.hpp"
+#include "Core/Profiler.h"
+
+TEST(ProfilerSuite, Profiler_Disabled)
+{
+    omp::Profiler profiler;
+    {
+        omp::ProfileScope scope("Disabled", profiler);
+    }
+    profiler.beginFrame();
+    EXPECT_EQ(profiler.getHistoryCount(), 0u);
+    EXPECT_EQ(profiler.getFrameIndex(), 1u);
+}
+
+TEST(ProfilerSuite, Profiler_NestedScopes)
+{
+    omp::Profiler profiler;
+    profiler.setEnabled(true);
+    {
+        omp::ProfileScope outer("Outer", profiler);
+        omp::ProfileScope inner("Inner", profiler);
+    }
+    profiler.beginFrame();
+
+    ASSERT_EQ(profiler.getHistoryCount(), 1u);
+    const omp::FrameProfile& frame = profiler.getFrame(0);
+    ASSERT_EQ(frame.cpu_events.size(), 2u);
+    EXPECT_STREQ(frame.cpu_events[0].name, "Outer");
+    EXPECT_EQ(frame.cpu_events[0].depth, 0u);
+    EXPECT_STREQ(frame.cpu_events[1].name, "Inner");
+    EXPECT_EQ(frame.cpu_events[1].depth, 1u);
+    EXPECT_LE(frame.cpu_events[0].start_ns, frame.cpu_events[1].start_ns);
+    EXPECT_GE(frame.cpu_events[0].end_ns, frame.cpu_events[1].end_ns);
+    EXPECT_LE(frame.start_ns, frame.cpu_events[0].start_ns);
+    EXPECT_GE(frame.end_ns, frame.cpu_events[0].end_ns);
+
+    // Next frame only has its own events
+    profiler.beginFrame();
+    EXPECT_TRUE(profiler.getFrame(0).cpu_events.empty());
+    EXPECT_EQ(profiler.getFrame(1).index, frame.index);
+}
+
+TEST(ProfilerSuite, Profiler_Threads)
+{
+    omp::Profiler profiler;
+    profiler.setEnabled(true);
+    profiler.setThreadName("Main");
+    {
+        omp::ProfileScope scope("Main work", profiler);
+    }
+    std::thread worker([&profiler]()
+                       {
+                           profiler.setThreadName("Worker");
+                           omp::ProfileScope scope("Worker work", profiler);
+                       });
+    worker.join();
+    profiler.beginFrame();
+
+    const omp::FrameProfile& frame = profiler.getFrame(0);
+    ASSERT_EQ(frame.cpu_events.size(), 2u);
+    for (const omp::CpuProfileEvent& event: frame.cpu_events)
+    {
+        EXPECT_EQ(event.depth, 0u);
+        const std::string thread_name = profiler.getThreadName(event.thread);
+        EXPECT_EQ(thread_name, std::string(event.name) == "Main work" ? "Main" : "Worker");
+    }
+    EXPECT_NE(frame.cpu_events[0].thread, frame.cpu_events[1].thread);
+}
+
+TEST(ProfilerSuite, Profiler_HistoryAndGpuEvents)
+{
+    omp::Profiler profiler;
+    profiler.setEnabled(true);
+    const uint64_t gpu_frame = profiler.getFrameIndex();
+    for (size_t frame = 0; frame < 3; frame++)
+    {
+        profiler.beginFrame();
+    }
+    profiler.addGpuEvents(gpu_frame, {{"Main pass", 100, 300}});
+    ASSERT_EQ(profiler.getFrame(2).gpu_events.size(), 1u);
+    EXPECT_EQ(profiler.getFrame(2).gpu_events[0].end_ns, 300u);
+    EXPECT_TRUE(profiler.getFrame(0).gpu_events.empty());
+
+    for (size_t frame = 0; frame < omp::Profiler::s_HistorySize; frame++)
+    {
+        profiler.beginFrame();
+    }
+    EXPECT_EQ(profiler.getHistoryCount(), omp::Profiler::s_HistorySize);
+    EXPECT_EQ(profiler.getFrame(0).index, profiler.getFrameIndex() - 1);
+    // Frame is gone, nothing to attach to
+    profiler.addGpuEvents(gpu_frame, {{"Main pass", 100, 300}});
+    for (size_t age = 0; age < profiler.getHistoryCount(); age++)
+    {
+        EXPECT_TRUE(profiler.getFrame(age).gpu_events.empty());
+    }
+}
+
+TEST(ProfilerSuite, Profiler_FullRingDrops)
+{
+    omp::Profiler profiler;
+    profiler.setEnabled(true);
+    for (uint64_t scope = 0; scope < omp::Profiler::s_RingSize + 10; scope++)
+    {
+        omp::ProfileScope profile_scope("Scope", profiler);
+    }
+    profiler.beginFrame();
+    EXPECT_EQ(profiler.getFrame(0).cpu_events.size(), omp::Profiler::s_RingSize);
+    EXPECT_EQ(profiler.getDroppedCount(), 10u);
+
+    // Drained ring takes events again
+    {
+        omp::ProfileScope profile_scope("Scope", profiler);
+    }
+    profiler.beginFrame();
+    EXPECT_EQ(profiler.getFrame(0).cpu_events.size(), 1u);
+    EXPECT_EQ(profiler.getDroppedCount(), 10u);
+}
+
+TEST(ProfilerSuite, Profiler_CaptureTrace)
+{
+    omp::Profiler profiler;
+    profiler.setEnabled(true);
+    profiler.setThreadName("Main");
+    profiler.startCapture(2);
+    const uint64_t first_frame = profiler.getFrameIndex();
+    while (!profiler.isCaptureComplete())
+    {
+        {
+            omp::ProfileScope scope("Work", profiler);
+        }
+        profiler.beginFrame();
+    }
+    EXPECT_EQ(profiler.getHistoryCount(), 2 + omp::Profiler::s_CaptureGpuLatency);
+    profiler.addGpuEvents(first_frame, {{"Main pass", 1000, 3000}}, 5000);
+
+    const std::string path = testing::TempDir() + "capture_trace.json";
+    ASSERT_TRUE(profiler.writeCapture(path));
+    EXPECT_FALSE(profiler.isCapturing());
+    std::ifstream file(path);
+    const nlohmann::json json = nlohmann::json::parse(file);
+
+    const int64_t origin = profiler.getFrame(profiler.getHistoryCount() - 1).start_ns;
+    size_t frames = 0;
+    size_t scopes = 0;
+    bool main_named = false;
+    for (const nlohmann::json& event: json["traceEvents"])
+    {
+        if (event["ph"] == "M" && event["name"] == "thread_name" && event["args"]["name"] == "Main")
+        {
+            main_named = true;
+        }
+        else if (event["ph"] == "X" && event["cat"] == "frame")
+        {
+            frames++;
+        }
+        else if (event["ph"] == "X" && event["name"] == "Work")
+        {
+            scopes++;
+        }
+        else if (event["ph"] == "X" && event["name"] == "Main pass")
+        {
+            // Calibrated offset moves gpu scope onto the cpu clock, microseconds from the first frame
+            const double start_us = static_cast<double>(6000 - origin) / 1000.0;
+            EXPECT_NEAR(event["ts"].get<double>(), start_us, 0.01);
+            EXPECT_NEAR(event["dur"].get<double>(), 2.0, 0.01);
+            scopes++;
+        }
+    }
+    EXPECT_TRUE(main_named);
+    // Frames waited for gpu results are not written
+    EXPECT_EQ(frames, 2u);
+    EXPECT_EQ(scopes, 3u);
+}
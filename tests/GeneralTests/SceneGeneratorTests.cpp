@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "Core/SceneGenerator.h"
+
+TEST(SceneGeneratorSuite, SceneGenerator_Deterministic)
+{
+    omp::SceneGeneratorSettings settings;
+    settings.entities = 300;
+    const omp::GeneratedScene first = omp::generateScene(settings);
+    const omp::GeneratedScene second = omp::generateScene(settings);
+
+    ASSERT_EQ(first.meshes.size(), settings.models);
+    ASSERT_EQ(first.materials.size(), settings.materials);
+    ASSERT_EQ(first.entities.size(), settings.entities);
+    ASSERT_EQ(first.point_lights.size(), settings.point_lights);
+    ASSERT_EQ(first.spot_lights.size(), settings.spot_lights);
+    for (size_t mesh = 0; mesh < first.meshes.size(); mesh++)
+    {
+        EXPECT_EQ(first.meshes[mesh].positions, second.meshes[mesh].positions);
+        EXPECT_EQ(first.meshes[mesh].indices, second.meshes[mesh].indices);
+    }
+    for (size_t entity = 0; entity < first.entities.size(); entity++)
+    {
+        EXPECT_EQ(first.entities[entity].model, second.entities[entity].model);
+        EXPECT_EQ(first.entities[entity].material, second.entities[entity].material);
+        EXPECT_EQ(first.entities[entity].position, second.entities[entity].position);
+    }
+    for (size_t light = 0; light < first.point_lights.size(); light++)
+    {
+        EXPECT_EQ(first.point_lights[light].position, second.point_lights[light].position);
+    }
+
+    settings.seed = 2;
+    const omp::GeneratedScene other = omp::generateScene(settings);
+    EXPECT_NE(first.entities[0].position, other.entities[0].position);
+}
+
+TEST(SceneGeneratorSuite, SceneGenerator_Meshes)
+{
+    omp::SceneGeneratorSettings settings;
+    settings.models = 16;
+    settings.entities = 100;
+    const omp::GeneratedScene scene = omp::generateScene(settings);
+    for (const omp::GeneratedMesh& mesh: scene.meshes)
+    {
+        ASSERT_FALSE(mesh.indices.empty());
+        EXPECT_EQ(mesh.indices.size() % 3, 0u);
+        EXPECT_EQ(mesh.normals.size(), mesh.positions.size());
+        EXPECT_EQ(mesh.tex_coords.size(), mesh.positions.size());
+        for (uint32_t index: mesh.indices)
+        {
+            ASSERT_LT(index, mesh.positions.size());
+        }
+        // Closed around origin, normals point outwards
+        for (size_t vertex = 0; vertex < mesh.positions.size(); vertex++)
+        {
+            EXPECT_GT(glm::dot(mesh.normals[vertex], mesh.positions[vertex]), 0.f) << vertex;
+        }
+    }
+    for (const omp::GeneratedEntity& entity: scene.entities)
+    {
+        EXPECT_LT(entity.model, settings.models);
+        EXPECT_LT(entity.material, settings.materials);
+        EXPECT_LE(std::abs(entity.position.x), settings.extent * 0.5f);
+        EXPECT_LE(std::abs(entity.position.z), settings.extent * 0.5f);
+    }
+}
+
+TEST(SceneGeneratorSuite, SceneGenerator_CameraPath)
+{
+    const omp::CameraPose start = omp::getBenchmarkCameraPose(0, 600, 200.f);
+    const omp::CameraPose loop = omp::getBenchmarkCameraPose(600, 600, 200.f);
+    const omp::CameraPose middle = omp::getBenchmarkCameraPose(300, 600, 200.f);
+    EXPECT_NEAR(glm::length(start.position - loop.position), 0.f, 1e-3f);
+    EXPECT_GT(glm::length(start.position - middle.position), 100.f);
+    EXPECT_GT(glm::length(start.position - start.target), 1.f);
+    EXPECT_GT(start.position.y, 0.f);
+}
@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "Math/Frustum.h"
+
+namespace
+{
+    // Camera at origin looking down -z, 90 degrees, square aspect
+    omp::Frustum makeTestFrustum(bool flipY)
+    {
+        glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(90.f), 1.f, 0.1f, 100.f);
+        if (flipY)
+        {
+            projection[1][1] *= -1;
+        }
+        const glm::mat4 view = glm::lookAt(glm::vec3{0.f}, glm::vec3{0.f, 0.f, -1.f}, glm::vec3{0.f, 1.f, 0.f});
+        return omp::Frustum::fromMatrix(projection * view);
+    }
+}
+
+TEST(FrustumSuite, Frustum_Planes)
+{
+    const omp::Frustum frustum = makeTestFrustum(false);
+
+    EXPECT_TRUE(frustum.intersectsSphere({0.f, 0.f, -10.f}, 1.f));
+    // Behind camera, in front of near plane, behind far plane
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, 0.f, 10.f}, 1.f));
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, 0.f, -0.05f}, 0.01f));
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, 0.f, -200.f}, 1.f));
+
+    // Outside of side planes
+    EXPECT_FALSE(frustum.intersectsSphere({20.f, 0.f, -10.f}, 1.f));
+    EXPECT_FALSE(frustum.intersectsSphere({-20.f, 0.f, -10.f}, 1.f));
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, 20.f, -10.f}, 1.f));
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, -20.f, -10.f}, 1.f));
+}
+
+TEST(FrustumSuite, Frustum_PartiallyInside)
+{
+    const omp::Frustum frustum = makeTestFrustum(false);
+
+    // Center is outside, but sphere crosses the plane
+    EXPECT_TRUE(frustum.intersectsSphere({10.5f, 0.f, -10.f}, 1.f));
+    EXPECT_TRUE(frustum.intersectsSphere({0.f, 0.f, -100.5f}, 1.f));
+    EXPECT_TRUE(frustum.intersectsSphere({0.f, 0.f, 0.5f}, 1.f));
+}
+
+TEST(FrustumSuite, Frustum_FlippedY)
+{
+    // Vulkan projection has y flipped, planes swap but the volume stays the same
+    const omp::Frustum frustum = makeTestFrustum(true);
+
+    EXPECT_TRUE(frustum.intersectsSphere({0.f, 5.f, -10.f}, 1.f));
+    EXPECT_TRUE(frustum.intersectsSphere({0.f, -5.f, -10.f}, 1.f));
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, 20.f, -10.f}, 1.f));
+    EXPECT_FALSE(frustum.intersectsSphere({0.f, -20.f, -10.f}, 1.f));
+}
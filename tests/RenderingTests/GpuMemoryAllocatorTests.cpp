@@ -0,0 +1,194 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <random>
+#include "Logs.h"
+#include "Rendering/GpuMemoryAllocator.h"
+
+class GpuMemoryAllocatorSuite : public ::testing::Test
+{
+protected:
+
+    static void SetUpTestSuite()
+    {
+        omp::InitializeTestLogs();
+    }
+};
+
+TEST_F(GpuMemoryAllocatorSuite, MemoryBlock_AllocateAndFree)
+{
+    omp::MemoryBlockMetadata block(1024, 1);
+
+    auto first = block.allocate(100, 16, omp::EAllocationKind::Linear);
+    auto second = block.allocate(100, 64, omp::EAllocationKind::Linear);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(first.value(), 0);
+    EXPECT_EQ(second.value() % 64, 0);
+    EXPECT_GE(second.value(), 100);
+    EXPECT_EQ(block.getAllocationCount(), 2);
+    EXPECT_EQ(block.getUsed(), 200);
+
+    EXPECT_FALSE(block.allocate(2048, 1, omp::EAllocationKind::Linear).has_value());
+
+    block.free(first.value());
+    block.free(second.value());
+    EXPECT_TRUE(block.empty());
+
+    // Freed neighbours are merged back into one range
+    EXPECT_EQ(block.getFreeRangeCount(), 1);
+    EXPECT_EQ(block.getLargestFreeRange(), 1024);
+}
+
+TEST_F(GpuMemoryAllocatorSuite, MemoryBlock_BestFit)
+{
+    omp::MemoryBlockMetadata block(1000, 1);
+
+    auto a = block.allocate(300, 1, omp::EAllocationKind::Linear);
+    auto b = block.allocate(100, 1, omp::EAllocationKind::Linear);
+    auto c = block.allocate(100, 1, omp::EAllocationKind::Linear);
+    auto d = block.allocate(100, 1, omp::EAllocationKind::Linear);
+    ASSERT_TRUE(a && b && c && d);
+
+    // Holes of 300 and 100 bytes, the smaller one fits
+    block.free(a.value());
+    block.free(c.value());
+    EXPECT_EQ(block.getFreeRangeCount(), 3);
+
+    auto small = block.allocate(80, 1, omp::EAllocationKind::Linear);
+    ASSERT_TRUE(small.has_value());
+    EXPECT_EQ(small.value(), c.value());
+}
+
+TEST_F(GpuMemoryAllocatorSuite, MemoryBlock_Granularity)
+{
+    constexpr VkDeviceSize granularity = 1024;
+    omp::MemoryBlockMetadata block(8 * granularity, granularity);
+
+    auto buffer = block.allocate(100, 4, omp::EAllocationKind::Linear);
+    auto image = block.allocate(100, 4, omp::EAllocationKind::Optimal);
+    ASSERT_TRUE(buffer && image);
+
+    // Different kinds never share a page
+    EXPECT_EQ(buffer.value(), 0);
+    EXPECT_EQ(image.value(), granularity);
+
+    // Same kind packs tightly
+    auto other_image = block.allocate(100, 4, omp::EAllocationKind::Optimal);
+    ASSERT_TRUE(other_image.has_value());
+    EXPECT_EQ(other_image.value(), image.value() + 100);
+
+    // Image takes the hole before images, buffer has to move to a page of its own
+    block.free(buffer.value());
+    auto small_image = block.allocate(16, 4, omp::EAllocationKind::Optimal);
+    ASSERT_TRUE(small_image.has_value());
+    auto small_buffer = block.allocate(16, 4, omp::EAllocationKind::Linear);
+    ASSERT_TRUE(small_buffer.has_value());
+
+    const VkDeviceSize page_mask = ~(granularity - 1);
+    EXPECT_NE(small_buffer.value() & page_mask, image.value() & page_mask);
+    EXPECT_NE((small_buffer.value() + 15) & page_mask, small_image.value() & page_mask);
+}
+
+TEST_F(GpuMemoryAllocatorSuite, MemoryBlock_RandomChurn)
+{
+    constexpr VkDeviceSize size = 1024 * 1024;
+    omp::MemoryBlockMetadata block(size, 256);
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<VkDeviceSize> sizes(1, 8 * 1024);
+    std::uniform_int_distribution<int> coin(0, 2);
+
+    // Offset to size and kind of live allocations
+    std::map<VkDeviceSize, std::pair<VkDeviceSize, omp::EAllocationKind>> live;
+    for (int step = 0; step < 5000; step++)
+    {
+        if (!live.empty() && coin(generator) == 0)
+        {
+            auto it = std::next(live.begin(), static_cast<long>(generator() % live.size()));
+            block.free(it->first);
+            live.erase(it);
+            continue;
+        }
+
+        const auto kind = coin(generator) == 0 ? omp::EAllocationKind::Optimal : omp::EAllocationKind::Linear;
+        const VkDeviceSize alignment = VkDeviceSize(1) << (generator() % 9);
+        const VkDeviceSize allocation_size = sizes(generator);
+        auto offset = block.allocate(allocation_size, alignment, kind);
+        if (!offset)
+        {
+            continue;
+        }
+        ASSERT_EQ(offset.value() % alignment, 0);
+        ASSERT_LE(offset.value() + allocation_size, size);
+        live[offset.value()] = {allocation_size, kind};
+    }
+
+    // Live allocations never overlap, different kinds never share a page
+    VkDeviceSize used = 0;
+    for (auto it = live.begin(); it != live.end(); ++it)
+    {
+        used += it->second.first;
+        auto next = std::next(it);
+        if (next == live.end())
+        {
+            break;
+        }
+        const VkDeviceSize end = it->first + it->second.first;
+        EXPECT_LE(end, next->first);
+        if (it->second.second != next->second.second)
+        {
+            EXPECT_NE((end - 1) / 256, next->first / 256);
+        }
+    }
+    EXPECT_EQ(block.getUsed(), used);
+    EXPECT_EQ(block.getAllocationCount(), live.size());
+
+    for (const auto& [offset, allocation]: live)
+    {
+        block.free(offset);
+    }
+    EXPECT_EQ(block.getFreeRangeCount(), 1);
+    EXPECT_EQ(block.getLargestFreeRange(), size);
+    EXPECT_EQ(block.allocate(size, 1, omp::EAllocationKind::Linear), 0);
+}
+
+TEST_F(GpuMemoryAllocatorSuite, BudgetMonitor_Hysteresis)
+{
+    omp::MemoryBudgetMonitor monitor;
+    auto heap = [](VkDeviceSize usage) { return std::vector<omp::GpuHeapBudget>{{1000, 1000, usage, 0, true}}; };
+
+    EXPECT_TRUE(monitor.update(heap(500)).empty());
+    EXPECT_EQ(monitor.getPressure(0), omp::EBudgetPressure::Normal);
+
+    EXPECT_EQ(monitor.update(heap(950)), std::vector<uint32_t>{0});
+    EXPECT_EQ(monitor.getPressure(0), omp::EBudgetPressure::Near);
+    EXPECT_EQ(monitor.getEvictionBytes(0), 50);
+    EXPECT_TRUE(monitor.isUnderPressure());
+
+    // Reported once while it stays near
+    EXPECT_TRUE(monitor.update(heap(960)).empty());
+    EXPECT_EQ(monitor.update(heap(1100)), std::vector<uint32_t>{0});
+    EXPECT_EQ(monitor.getPressure(0), omp::EBudgetPressure::Over);
+
+    // Between release and near threshold it is still near
+    EXPECT_TRUE(monitor.update(heap(850)).empty());
+    EXPECT_EQ(monitor.getPressure(0), omp::EBudgetPressure::Near);
+    EXPECT_EQ(monitor.getEvictionBytes(0), 0);
+
+    EXPECT_TRUE(monitor.update(heap(700)).empty());
+    EXPECT_EQ(monitor.getPressure(0), omp::EBudgetPressure::Normal);
+    EXPECT_TRUE(monitor.update(heap(850)).empty());
+    EXPECT_FALSE(monitor.isUnderPressure());
+}
+
+TEST_F(GpuMemoryAllocatorSuite, BudgetMonitor_HeapsAreIndependent)
+{
+    omp::MemoryBudgetMonitor monitor;
+    std::vector<omp::GpuHeapBudget> heaps{{1000, 800, 100, 100, true}, {1000, 800, 790, 0, false}};
+
+    EXPECT_EQ(monitor.update(heaps), std::vector<uint32_t>{1});
+    EXPECT_EQ(monitor.getPressure(0), omp::EBudgetPressure::Normal);
+    EXPECT_EQ(monitor.getPressure(1), omp::EBudgetPressure::Near);
+    EXPECT_EQ(monitor.getEvictionBytes(1), 70);
+    // Unknown heaps are never under pressure
+    EXPECT_EQ(monitor.getPressure(5), omp::EBudgetPressure::Normal);
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include <vector>
+#include "glm/gtc/matrix_transform.hpp"
+#include "Rendering/LightClusters.h"
+
+namespace
+{
+    // Camera at origin looking down -z, 90 degrees vertically, y flipped as in renderer
+    omp::ClusterView makeTestView()
+    {
+        omp::ClusterView view{};
+        view.projection = glm::perspectiveRH_ZO(glm::radians(90.f), 16.f / 9.f, 0.1f, 100.f);
+        view.projection[1][1] *= -1;
+        view.view = glm::lookAt(glm::vec3{0.f}, glm::vec3{0.f, 0.f, -1.f}, glm::vec3{0.f, 1.f, 0.f});
+        view.near_plane = 0.1f;
+        view.far_plane = 100.f;
+        view.screen_size = {1600.f, 900.f};
+        return view;
+    }
+}
+
+TEST(LightClustersSuite, LightClusters_CenterLight)
+{
+    omp::LightClusters clusters;
+    const std::vector<glm::vec4> points{{0.f, 0.f, -10.f, 0.5f}};
+    clusters.build(makeTestView(), points, {});
+
+    // Depth 9.5 to 10.5 covers slices 15 and 16, screen center is between tiles 7 and 8
+    const omp::LightClusters::Range& range = clusters.getRange(clusters.getClusterIndex(8, 4, 16));
+    ASSERT_EQ(range.point_count, 1u);
+    EXPECT_EQ(range.spot_count, 0u);
+    EXPECT_EQ(clusters.getIndices()[range.offset], 0u);
+    EXPECT_EQ(clusters.getRange(clusters.getClusterIndex(7, 4, 15)).point_count, 1u);
+
+    EXPECT_EQ(clusters.getRange(clusters.getClusterIndex(0, 0, 16)).point_count, 0u);
+    EXPECT_EQ(clusters.getRange(clusters.getClusterIndex(8, 4, 10)).point_count, 0u);
+    EXPECT_EQ(clusters.getRange(clusters.getClusterIndex(8, 4, 20)).point_count, 0u);
+    EXPECT_EQ(clusters.getIndices().size(), 4u);
+}
+
+TEST(LightClustersSuite, LightClusters_Culled)
+{
+    omp::LightClusters clusters;
+    // Behind camera, past far plane and far to the side
+    const std::vector<glm::vec4> points{{0.f, 0.f, 10.f, 1.f}, {0.f, 0.f, -200.f, 1.f}, {100.f, 0.f, -10.f, 1.f}};
+    clusters.build(makeTestView(), points, {});
+
+    EXPECT_TRUE(clusters.getIndices().empty());
+    EXPECT_EQ(clusters.getDroppedCount(), 0u);
+}
+
+TEST(LightClustersSuite, LightClusters_FlippedY)
+{
+    omp::LightClusters clusters;
+    const std::vector<glm::vec4> points{{0.f, 5.f, -10.f, 0.5f}};
+    clusters.build(makeTestView(), points, {});
+
+    // Up in view space is the top of framebuffer, where fragment y is small
+    EXPECT_EQ(clusters.getRange(clusters.getClusterIndex(8, 2, 16)).point_count, 1u);
+    EXPECT_EQ(clusters.getRange(clusters.getClusterIndex(8, 6, 16)).point_count, 0u);
+}
+
+TEST(LightClustersSuite, LightClusters_SpotAfterPoint)
+{
+    omp::LightClusters clusters;
+    const std::vector<glm::vec4> points{{0.f, 0.f, -10.f, 0.5f}, {0.f, 0.f, -10.f, 0.5f}};
+    const std::vector<glm::vec4> spots{{0.f, 0.f, -10.f, 0.5f}};
+    clusters.build(makeTestView(), points, spots);
+
+    const omp::LightClusters::Range& range = clusters.getRange(clusters.getClusterIndex(8, 4, 16));
+    ASSERT_EQ(range.point_count, 2u);
+    ASSERT_EQ(range.spot_count, 1u);
+    EXPECT_EQ(clusters.getIndices()[range.offset], 0u);
+    EXPECT_EQ(clusters.getIndices()[range.offset + 1], 1u);
+    EXPECT_EQ(clusters.getIndices()[range.offset + 2], 0u);
+}
+
+TEST(LightClustersSuite, LightClusters_Bounds)
+{
+    const float range = omp::LightClusters::getLightRange(1.f, 0.07f, 0.017f);
+    EXPECT_NEAR(1.f + 0.07f * range + 0.017f * range * range, 256.f, 0.1f);
+    EXPECT_NEAR(omp::LightClusters::getLightRange(1.f, 0.5f, 0.f), 510.f, 0.01f);
+
+    // Both apex and rim of the cone are inside of its sphere
+    for (const float cut_off: {0.95f, 0.5f})
+    {
+        const glm::vec4 sphere = omp::LightClusters::getSpotSphere({0.f, 0.f, 0.f}, {0.f, 0.f, -2.f}, 10.f, cut_off);
+        const float sine = std::sqrt(1.f - cut_off * cut_off);
+        const glm::vec3 rim{10.f * sine, 0.f, -10.f * cut_off};
+        EXPECT_LE(glm::length(glm::vec3(sphere)), sphere.w + 1e-4f);
+        EXPECT_LE(glm::length(rim - glm::vec3(sphere)), sphere.w + 1e-4f);
+        EXPECT_LT(sphere.w, 10.f);
+    }
+}
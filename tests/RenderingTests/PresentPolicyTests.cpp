@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+#include <vector>
+#include "Rendering/PresentPolicy.h"
+
+TEST(PresentPolicySuite, PresentPolicy_Policies)
+{
+    const std::vector<VkPresentModeKHR> all{VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+                                            VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+    omp::PresentSettings settings;
+
+    settings.policy = omp::PresentPolicy::VSync;
+    omp::PresentChoice choice = omp::choosePresentation(settings, all, 2, 8);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_FIFO_KHR);
+    EXPECT_EQ(choice.image_count, 3u);
+
+    settings.policy = omp::PresentPolicy::LowLatency;
+    choice = omp::choosePresentation(settings, all, 2, 8);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_MAILBOX_KHR);
+    EXPECT_EQ(choice.image_count, 3u);
+
+    settings.policy = omp::PresentPolicy::Uncapped;
+    choice = omp::choosePresentation(settings, all, 2, 8);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_IMMEDIATE_KHR);
+    EXPECT_EQ(choice.image_count, 3u);
+}
+
+TEST(PresentPolicySuite, PresentPolicy_Fallbacks)
+{
+    const std::vector<VkPresentModeKHR> fifo_only{VK_PRESENT_MODE_FIFO_KHR};
+    omp::PresentSettings settings;
+
+    // Fifo keeps the queue short instead
+    settings.policy = omp::PresentPolicy::LowLatency;
+    omp::PresentChoice choice = omp::choosePresentation(settings, fifo_only, 2, 0);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_FIFO_KHR);
+    EXPECT_EQ(choice.image_count, 2u);
+
+    settings.policy = omp::PresentPolicy::Uncapped;
+    choice = omp::choosePresentation(settings, {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR}, 2, 0);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_MAILBOX_KHR);
+
+    settings.mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    choice = omp::choosePresentation(settings, fifo_only, 2, 0);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_FIFO_KHR);
+}
+
+TEST(PresentPolicySuite, PresentPolicy_ExplicitSettings)
+{
+    const std::vector<VkPresentModeKHR> all{VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+                                            VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+    omp::PresentSettings settings;
+    settings.policy = omp::PresentPolicy::VSync;
+    settings.mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    settings.image_count = 5;
+    omp::PresentChoice choice = omp::choosePresentation(settings, all, 2, 8);
+    EXPECT_EQ(choice.mode, VK_PRESENT_MODE_FIFO_RELAXED_KHR);
+    EXPECT_EQ(choice.image_count, 5u);
+
+    // Surface limits win over requested count
+    settings.image_count = 1;
+    EXPECT_EQ(omp::choosePresentation(settings, all, 2, 8).image_count, 2u);
+    settings.image_count = 16;
+    EXPECT_EQ(omp::choosePresentation(settings, all, 2, 8).image_count, 8u);
+    EXPECT_EQ(omp::choosePresentation(settings, all, 2, 0).image_count, 16u);
+}
@@ -0,0 +1,152 @@
+#include "gtest/gtest.h"
+#include <random>
+#include "Logs.h"
+#include "Rendering/RenderQueue.h"
+
+class RenderQueueSuite : public ::testing::Test
+{
+protected:
+
+    static void SetUpTestSuite()
+    {
+        omp::InitializeTestLogs();
+    }
+};
+
+TEST_F(RenderQueueSuite, RenderQueue_KeyOrder)
+{
+    // Opaque always goes before transparent
+    EXPECT_LT(omp::RenderQueue::makeKey(false, 0x7fff, 0xffff, 0xffff, 1000.f),
+              omp::RenderQueue::makeKey(true, 0, 0, 0, 0.f));
+
+    // Opaque is grouped by pipeline, then material, then model, then front to back
+    EXPECT_LT(omp::RenderQueue::makeKey(false, 0, 5, 5, 100.f),
+              omp::RenderQueue::makeKey(false, 1, 0, 0, 1.f));
+    EXPECT_LT(omp::RenderQueue::makeKey(false, 1, 0, 5, 100.f),
+              omp::RenderQueue::makeKey(false, 1, 1, 0, 1.f));
+    EXPECT_LT(omp::RenderQueue::makeKey(false, 1, 1, 0, 100.f),
+              omp::RenderQueue::makeKey(false, 1, 1, 1, 1.f));
+    EXPECT_LT(omp::RenderQueue::makeKey(false, 1, 1, 1, 1.f),
+              omp::RenderQueue::makeKey(false, 1, 1, 1, 2.f));
+
+    // Transparent is grouped by state the same way, depth is ignored
+    EXPECT_LT(omp::RenderQueue::makeKey(true, 0, 3, 3, 10.f),
+              omp::RenderQueue::makeKey(true, 1, 0, 0, 50.f));
+    EXPECT_LT(omp::RenderQueue::makeKey(true, 1, 1, 0, 10.f),
+              omp::RenderQueue::makeKey(true, 1, 1, 1, 50.f));
+    EXPECT_EQ(omp::RenderQueue::makeKey(true, 3, 3, 3, 50.f),
+              omp::RenderQueue::makeKey(true, 3, 3, 3, 10.f));
+}
+
+TEST_F(RenderQueueSuite, RenderQueue_Sort)
+{
+    omp::RenderQueue queue;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> depth(0.f, 500.f);
+    std::uniform_int_distribution<int> state(0, 7);
+
+    const size_t count = 1000;
+    std::vector<omp::SceneEntity*> tags;
+    for (size_t i = 0; i < count; i++)
+    {
+        // Entity pointer is only used as a tag to check items follow their keys
+        auto tag = reinterpret_cast<omp::SceneEntity*>(i + 1);
+        uint64_t key = omp::RenderQueue::makeKey(state(generator) == 0, state(generator),
+                                                 state(generator), state(generator), depth(generator));
+        queue.add(key, {tag, nullptr, nullptr, nullptr});
+        tags.push_back(tag);
+    }
+    queue.sort();
+
+    ASSERT_EQ(queue.size(), count);
+    for (size_t i = 1; i < queue.size(); i++)
+    {
+        EXPECT_LE(queue.getKey(i - 1), queue.getKey(i));
+    }
+
+    std::vector<bool> seen(count, false);
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        size_t tag = reinterpret_cast<size_t>(queue.getItem(i).entity) - 1;
+        ASSERT_LT(tag, count);
+        EXPECT_FALSE(seen[tag]);
+        seen[tag] = true;
+    }
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(RenderQueueSuite, RenderQueue_StableIds)
+{
+    omp::RenderQueue queue;
+    uint16_t simple = queue.getPipelineId("Simple");
+    uint16_t light = queue.getPipelineId("Light");
+    EXPECT_NE(simple, light);
+    EXPECT_EQ(simple, queue.getPipelineId("Simple"));
+
+    auto material = reinterpret_cast<const omp::Material*>(0x10);
+    EXPECT_EQ(queue.getMaterialId(material), queue.getMaterialId(material));
+}
+
+TEST_F(RenderQueueSuite, RenderQueue_Batches)
+{
+    omp::RenderQueue queue;
+    auto pipeline = reinterpret_cast<omp::GraphicsPipeline*>(0x10);
+    auto material = reinterpret_cast<omp::Material*>(0x20);
+    auto first_model = reinterpret_cast<omp::Model*>(0x30);
+    auto second_model = reinterpret_cast<omp::Model*>(0x40);
+
+    uint16_t pipeline_id = queue.getPipelineId("Light");
+    uint16_t material_id = queue.getMaterialId(material);
+    uint16_t first_id = queue.getModelId(first_model);
+    uint16_t second_id = queue.getModelId(second_model);
+
+    // Interleaved models must still end up in one batch per model
+    queue.add(omp::RenderQueue::makeKey(false, pipeline_id, material_id, first_id, 3.f), {nullptr, pipeline, material, first_model});
+    queue.add(omp::RenderQueue::makeKey(false, pipeline_id, material_id, second_id, 2.f), {nullptr, pipeline, material, second_model});
+    queue.add(omp::RenderQueue::makeKey(false, pipeline_id, material_id, first_id, 1.f), {nullptr, pipeline, material, first_model});
+    queue.add(omp::RenderQueue::makeKey(false, pipeline_id, material_id, first_id, 5.f), {nullptr, pipeline, material, first_model});
+    queue.sort();
+
+    const auto& batches = queue.getBatches();
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[0].first, 0);
+    EXPECT_EQ(batches[0].count, 3);
+    EXPECT_EQ(queue.getItem(batches[0].first).model, first_model);
+    EXPECT_EQ(batches[1].first, 3);
+    EXPECT_EQ(batches[1].count, 1);
+    EXPECT_EQ(queue.getItem(batches[1].first).model, second_model);
+}
+
+TEST_F(RenderQueueSuite, RenderQueue_IdRecycling)
+{
+    omp::RenderQueue queue;
+    auto gone = reinterpret_cast<const omp::Model*>(0x10);
+    auto kept = reinterpret_cast<const omp::Model*>(0x20);
+    uint16_t gone_id = queue.getModelId(gone);
+    uint16_t kept_id = queue.getModelId(kept);
+
+    // Only one model keeps being drawn, the other one is destroyed
+    for (int frame = 0; frame < 1024; frame++)
+    {
+        queue.clear();
+        EXPECT_EQ(queue.getModelId(kept), kept_id);
+    }
+
+    auto created = reinterpret_cast<const omp::Model*>(0x30);
+    EXPECT_EQ(queue.getModelId(created), gone_id);
+    EXPECT_EQ(queue.getModelId(kept), kept_id);
+}
+
+TEST_F(RenderQueueSuite, RenderQueue_IdOverflow)
+{
+    omp::RenderQueue queue;
+    for (uint32_t index = 0; index <= 0x7fff; index++)
+    {
+        EXPECT_EQ(queue.getPipelineId(std::to_string(index)), index);
+    }
+    // Out of key bits, extra pipelines share the last id instead of wrapping onto the first
+    EXPECT_EQ(queue.getPipelineId("Overflow"), 0x7fff);
+    EXPECT_EQ(queue.getPipelineId("0"), 0);
+}